@@ -12,6 +12,19 @@
 #include "MeshComponent.h"
 #include "Buffer.h"
 #include "SamplerState.h"
+#include "NullBackend.h"
+#include "SoftwareRasterizer.h"
+#include "RenderQueue.h"
+#include "ConstantBufferRing.h"
+#include "InstanceBuffer.h"
+#include "ConstantBuffer.h"
+#include "SceneBvh.h"
+#include "OcclusionCuller.h"
+#include "JobSystem.h"
+#include "FramePipeline.h"
+#include "FrameArena.h"
+#include "ResourceRegistry.h"
+#include "MeshletBuilder.h"
 
 /**
  * @brief Clase principal que administra todo el ciclo de vida de la aplicacin.
@@ -24,11 +37,31 @@ public:
 
   int run(HINSTANCE hInst, int nCmdShow); // Loop principal de la aplicacin
 
+  /**
+   * @brief Corre @p frameCount cuadros de update/render sin ventana ni GPU
+   * (NullBackend) con paso fijo de 1/60 s, y reporta el tiempo de CPU por cuadro
+   * de cada etapa (FramePipeline) y las llamadas a la API. Si @p imageFile no est vaco, cada cuadro se
+   * rasteriza por software y el ltimo se guarda como TGA. Al terminar llama a
+   * destroy() y verifica que no queden objetos COM vivos.
+   * Devuelve 0 si todo sali bien (1 tambin si hubo fugas).
+   */
+  int runHeadless(unsigned int frameCount,
+                  unsigned int width = 1280,
+                  unsigned int height = 720,
+                  const std::string& imageFile = "");
+
+  /**
+   * @brief Cuadros que update() puede adelantarse al envo de comandos
+   * (FramePipeline): 0 = serial, 1 = doble buffer, 2 = triple buffer. Se aplica
+   * en init(); con ms de 0 el DeviceContext se usa solo desde el hilo de render.
+   */
+  void setFrameLatency(unsigned int latency) { m_frameLatency = latency; }
+
   HRESULT init(); // Inicializa todos los objetos grficos
 
   void update(float deltaTime); // Actualiza lgica y matrices por cuadro
 
-  void render(); // Dibuja el frame
+  void render(); // Arma el paquete del frame (culling y draws) y lo entrega al pipeline
 
   void destroy(); // Libera todos los recursos
 
@@ -36,42 +69,71 @@ private:
   // Procesa los mensajes de Windows (teclado, ratn, cierre, etc.)
   static LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
 
+  // Recalcula la proyeccin solo si cambi el tamao de la ventana
+  void updateProjection();
+
+  // Etapa de render de m_framePipeline: enva un paquete al DeviceContext y presenta
+  static void renderStage(void* app, const FramePipeline::FramePacket& frame);
+  void renderFrame(const FramePipeline::FramePacket& frame);
+
 private:
+  /// Copias chicas del cubo en rbita (los lotes instanciados de la escena).
+  static const unsigned int kSatelliteCount = 8;
+
   Window          m_window;            // Administra la ventana Win32
+  NullBackend     m_nullBackend;       // Backend headless (solo en runHeadless)
+  SoftwareRasterizer m_rasterizer;     // Pixeles del backend headless (runHeadless con imagen)
   Device          m_device;            // ID3D11Device (creacin de recursos)
   DeviceContext   m_deviceContext;     // ID3D11DeviceContext (comandos GPU)
   SwapChain       m_swapChain;         // Intercambio de buffers (VSync)
 
-  Texture         m_backBuffer;        // Back buffer obtenido del swap chain
+  ResourceRegistry m_resources;        // Dueo de buffers, texturas, samplers y shaders
+  TextureHandle   m_backBuffer;        // Back buffer obtenido del swap chain
   RenderTargetView m_renderTargetView; // Donde se dibuja el frame final
 
-  Texture         m_depthStencil;      // Textura usada para pruebas de profundidad
+  TextureHandle   m_depthStencil;      // Textura usada para pruebas de profundidad
   DepthStencilView m_depthStencilView; // Vista para habilitar depth testing
 
   Viewport        m_viewport;          // Regin visible donde se dibuja
 
-  ShaderProgram   m_shaderProgram;     // Vertex + Pixel Shaders + InputLayout
+  ShaderHandle    m_shaderProgram;     // Vertex + Pixel Shaders + InputLayout
+  ShaderHandle    m_instancedShader;   // VSInstanced/PSInstanced para los lotes de la cola
 
   MeshComponent   m_mesh;              // Geometra (vrtices + ndices)
-  Buffer          m_vertexBuffer;      // Buffer de vrtices
-  Buffer          m_indexBuffer;       // Buffer de ndices
-
-  Buffer          m_cbNeverChanges;     // Constant buffer fijo
-  Buffer          m_cbChangeOnResize;   // Constant buffer dependiente de ventana
-  Buffer          m_cbChangesEveryFrame;// Constant buffer animado por cuadro
-
-  Texture         m_textureCube;       // Textura aplicada al cubo
-  SamplerState    m_samplerState;      // Parmetros de muestreo de textura
+  std::vector<MeshletBuilder::IndexRange> m_meshletRanges; // Rangos de m_index visibles en el cuadro
+  BufferHandle    m_vertexBuffer;      // Buffer de vrtices
+  BufferHandle    m_indexBuffer;       // Buffer de ndices
+
+  ConstantBuffer<CBNeverChanges>   m_cbNeverChanges;    // Constant buffer fijo (UPDATE_STATIC)
+  ConstantBuffer<CBChangeOnResize> m_cbChangeOnResize;  // Constant buffer dependiente de ventana (UPDATE_ON_RESIZE)
+  ConstantBufferRing m_constantRing;   // Constantes por objeto (bloques por offset)
+  InstanceBuffer  m_instanceBuffer;    // Matriz y color por instancia de los lotes instanciados
+
+  TextureHandle   m_textureCube;       // Textura aplicada al cubo
+  SamplerHandle   m_samplerState;      // Parmetros de muestreo de textura
+
+  RenderQueue     m_renderQueue;       // Draws del cuadro ordenados por llave
+  SceneBvh        m_sceneBvh;          // Volmenes en espacio mundo de los objetos dibujables
+  int             m_cubeProxy = SceneBvh::kNullNode; // Proxy del cubo en m_sceneBvh
+  int             m_satelliteProxies[kSatelliteCount];  // Proxies de los satlites en m_sceneBvh
+  OcclusionCuller m_occlusionCuller;   // Profundidad de los oclusores en baja resolucin
+  JobSystem       m_jobSystem;         // Hilos de trabajo (el principal participa al esperar)
+  FramePipeline   m_framePipeline;     // Paquetes de update() hacia la etapa de render
+  unsigned int    m_frameLatency = 0;  // Latencia de m_framePipeline (0 = serial)
 
   // Matrices base de transformacin
   XMMATRIX        m_World;       // Transformacin del modelo
   XMMATRIX        m_View;        // Cmara
   XMMATRIX        m_Projection;  // Proyeccin en perspectiva
+  unsigned int    m_projectionWidth = 0;   // Tamao de ventana con el que se calcul m_Projection
+  unsigned int    m_projectionHeight = 0;
 
   XMFLOAT4        m_vMeshColor;  // Color del objeto (modificado en update)
 
-  // Estructuras para los constant buffers
-  CBChangeOnResize   cbChangesOnResize;
-  CBNeverChanges     cbNeverChanges;
+  // Constantes por objeto del cubo
   CBChangesEveryFrame cb;
+
+  // Constantes de los cubos chicos que orbitan al principal (mismo mesh, se
+  // dibujan en lotes con DrawIndexedInstanced)
+  CBChangesEveryFrame m_satellites[kSatelliteCount];
 };
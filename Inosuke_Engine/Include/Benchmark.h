@@ -0,0 +1,25 @@
+#pragma once
+#include "Prerequisites.h"
+
+/**
+ * @class Benchmark
+ * @brief Punto de entrada nico de los benchmarks estticos del motor
+ * (RenderQueue::benchmark, SceneBvh::benchmark, ...), para correrlos por nombre
+ * desde la lnea de comandos: "Inosuke_Engine.exe -bench <nombre> [archivo]".
+ *
+ * Los resultados salen por MESSAGE/ERROR; run() activa logToConsole() para que
+ * adems lleguen a stdout/stderr.
+ */
+class
+  Benchmark {
+public:
+  /**
+   * @brief Corre el benchmark @p name ("all" corre todos los que no necesitan archivo).
+   * @param file Modelo .obj para los benchmarks de carga y procesamiento de mallas.
+   * @return 0 si pas, 1 si fall, 2 si el nombre no existe o falta el archivo.
+   */
+  static int run(const std::string& name, const std::string& file = std::string());
+
+  /// Escribe en stdout los nombres disponibles.
+  static void list();
+};
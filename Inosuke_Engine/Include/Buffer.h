@@ -1,6 +1,7 @@
 #pragma once
 #include "Prerequisites.h"
 #include "MeshComponent.h"
+#include "VertexQuantizer.h"
 
 class Device;
 class DeviceContext;
@@ -38,6 +39,9 @@ public:
    *
    * Crea internamente un @c ID3D11Buffer con los datos del mesh (vrtices/ndices) segn @p bindFlag.
    * Debe usarse @c D3D11_BIND_VERTEX_BUFFER o @c D3D11_BIND_INDEX_BUFFER.
+   * Para Index Buffer se suben 16 o 32 bits por ndice segn @c mesh.m_indexFormat
+   * (la copia de 16 bits es temporal y se arma aqu), y ese formato se recuerda
+   * para @c render(). Si algn ndice no cabe en 16 bits se suben 32.
    *
    * @param device     Dispositivo con el que se crear el recurso.
    * @param mesh       Fuente de datos (vrtices/ndices) para poblar el buffer.
@@ -50,6 +54,19 @@ public:
   HRESULT
     init(Device& device, const MeshComponent& mesh, unsigned int bindFlag);
 
+  /**
+   * @brief Inicializa el buffer como Vertex Buffer con vrtices empaquetados.
+   *
+   * El stride se toma de @p vertices (ver VertexQuantizer::strideOf); el input layout
+   * correspondiente lo genera VertexQuantizer::inputLayout().
+   *
+   * @param device    Dispositivo con el que se crear el recurso.
+   * @param vertices  Resultado de VertexQuantizer::quantize().
+   * @return @c S_OK si la creacin fue exitosa; cdigo @c HRESULT en caso contrario.
+   */
+  HRESULT
+    init(Device& device, const VertexQuantizer::QuantizedMesh& vertices);
+
   /**
    * @brief Inicializa el buffer como Constant Buffer.
    *
@@ -102,7 +119,8 @@ public:
    * @param StartSlot       Primer slot de enlace (IA o VS/PS segn tipo).
    * @param NumBuffers      Nmero de buffers a enlazar (tpicamente 1 para esta clase).
    * @param setPixelShader  Si es @c true y el buffer es de constantes, tambin se enlaza a PS (adems de VS).
-   * @param format          Formato del ndice (@c DXGI_FORMAT_R16_UINT o @c DXGI_FORMAT_R32_UINT) cuando es Index Buffer.
+   * @param format          Formato del ndice cuando es Index Buffer. Con @c DXGI_FORMAT_UNKNOWN
+   *                        se usa el formato registrado en @c init() (R16 o R32 segn la malla).
    *
    * @pre @c m_buffer debe estar creado y @c m_bindFlag configurado correctamente.
    * @sa init()
@@ -124,6 +142,13 @@ public:
   void
     destroy();
 
+  /**
+   * @brief Tamao del buffer en bytes (@c ByteWidth de su descriptor).
+   * @return 0 si el buffer no est creado.
+   */
+  unsigned int
+    getByteWidth() const;
+
   /**
    * @brief Crea un buffer genrico con una @c D3D11_BUFFER_DESC y datos iniciales opcionales.
    *
@@ -161,4 +186,10 @@ private:
    * @brief Bandera de enlace (@c D3D11_BIND_* ) que define el rol del buffer.
    */
   unsigned int m_bindFlag = 0;
+
+  /**
+   * @brief Formato de ndice con el que se cre el buffer (solo Index Buffer).
+   * @details @c DXGI_FORMAT_R16_UINT o @c DXGI_FORMAT_R32_UINT; @c DXGI_FORMAT_UNKNOWN en otro caso.
+   */
+  DXGI_FORMAT m_indexFormat = DXGI_FORMAT_UNKNOWN;
 };
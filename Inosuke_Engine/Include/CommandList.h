@@ -0,0 +1,194 @@
+#pragma once
+#include "Prerequisites.h"
+
+class DeviceContext;
+
+/**
+ * @class CommandList
+ * @brief Lista de comandos grabada por un DeviceContext diferido para ejecutarla
+ * despus en el contexto inmediato (ver DeviceContext::beginRecording).
+ *
+ * Tiene dos formatos:
+ * - Del motor: cada llamada se guarda como un Command con sus arreglos (buffers,
+ *   strides, viewports, colores) y los datos de UpdateSubresource copiados en
+ *   m_data. No depende del backend: execute() la repite llamada por llamada en
+ *   cualquier DeviceContext (D3D11 o NullBackend).
+ * - Nativo: la grab un ID3D11DeviceContext diferido y queda en m_native
+ *   (ID3D11CommandList) para ID3D11DeviceContext::ExecuteCommandList.
+ *
+ * Los objetos enlazados no se referencian (AddRef): deben vivir hasta ejecutar la
+ * lista. Map/Unmap, queries y class instances no se pueden grabar; las constantes
+ * se suben con UpdateSubresource (la copia queda en la lista).
+ *
+ * Como los dems wrappers, el destructor no libera: destroy() suelta m_native.
+ */
+class
+  CommandList {
+public:
+  /// Llamadas que se pueden grabar.
+  enum CommandType {
+    CMD_CLEAR_STATE = 0,
+    CMD_UPDATE_SUBRESOURCE,
+    CMD_RS_SET_VIEWPORTS,
+    CMD_RS_SET_STATE,
+    CMD_IA_SET_INPUT_LAYOUT,
+    CMD_IA_SET_VERTEX_BUFFERS,
+    CMD_IA_SET_INDEX_BUFFER,
+    CMD_IA_SET_PRIMITIVE_TOPOLOGY,
+    CMD_VS_SET_SHADER,
+    CMD_VS_SET_CONSTANT_BUFFERS,
+    CMD_PS_SET_SHADER,
+    CMD_PS_SET_CONSTANT_BUFFERS,
+    CMD_PS_SET_SHADER_RESOURCES,
+    CMD_PS_SET_SAMPLERS,
+    CMD_OM_SET_RENDER_TARGETS,
+    CMD_OM_SET_BLEND_STATE,
+    CMD_CLEAR_RENDER_TARGET_VIEW,
+    CMD_CLEAR_DEPTH_STENCIL_VIEW,
+    CMD_DRAW_INDEXED,
+    CMD_DRAW_INDEXED_INSTANCED,
+    CMD_COUNT
+  };
+
+  /// Sin arreglo en m_data.
+  static const unsigned int kNoData = 0xffffffffu;
+
+  /**
+   * @brief Una llamada grabada. El significado de los campos depende del tipo:
+   * - Set* por rango: start = primer slot, count = elementos, data = arreglo de
+   *   punteros (y despus strides/offsets o primeras constantes/nmero de constantes).
+   * - Set* de un objeto: object = objeto, value = formato, offset o sample mask.
+   * - UpdateSubresource: object = recurso, start = subrecurso, count = bytes,
+   *   value = row pitch, data = D3D11_BOX (si lo hay) + datos.
+   * - DrawIndexed: count = ndices, start = ndice inicial, value = vrtice base.
+   * - DrawIndexedInstanced: count = ndices por instancia, start = ndice inicial,
+   *   value = vrtice base, data = instancias y primera instancia.
+   */
+  struct Command {
+    CommandType type;
+    unsigned int start;
+    unsigned int count;
+    int value;
+    unsigned int data;
+    const void* object;
+  };
+
+  CommandList() = default;
+  ~CommandList() = default;
+
+  /// Vaca la lista (conserva la memoria) y suelta la lista nativa.
+  void reset();
+
+  /// Libera la memoria y la lista nativa.
+  void destroy();
+
+  bool isNative() const { return m_native != nullptr; }
+
+  bool empty() const { return m_commands.empty() && !m_native; }
+
+  /// Comandos grabados en formato del motor.
+  size_t size() const { return m_commands.size(); }
+
+  /// Bytes de arreglos y datos copiados.
+  size_t dataBytes() const { return m_data.size(); }
+
+  unsigned int getDrawCount() const { return m_draws; }
+
+  /**
+   * @brief Repite los comandos en @p deviceContext, en el orden en que se grabaron.
+   * Las llamadas pasan por su cach de estado como si se hicieran en ese momento.
+   */
+  void execute(DeviceContext& deviceContext) const;
+
+  /// Nombre de la llamada de D3D11 que corresponde a @p type.
+  static const char* commandName(CommandType type);
+
+  // --- Grabacin: misma firma que ID3D11DeviceContext (la llama DeviceContext) -----------
+
+  void ClearState();
+
+  void UpdateSubresource(ID3D11Resource* pDstResource,
+    unsigned int DstSubresource,
+    const D3D11_BOX* pDstBox,
+    const void* pSrcData,
+    unsigned int SrcRowPitch,
+    unsigned int SrcDepthPitch);
+
+  void RSSetViewports(unsigned int NumViewports, const D3D11_VIEWPORT* pViewports);
+
+  void RSSetState(ID3D11RasterizerState* pRasterizerState);
+
+  void IASetInputLayout(ID3D11InputLayout* pInputLayout);
+
+  void IASetVertexBuffers(unsigned int StartSlot,
+    unsigned int NumBuffers,
+    ID3D11Buffer* const* ppVertexBuffers,
+    const unsigned int* pStrides,
+    const unsigned int* pOffsets);
+
+  void IASetIndexBuffer(ID3D11Buffer* pIndexBuffer, DXGI_FORMAT Format, unsigned int Offset);
+
+  void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY Topology);
+
+  void VSSetShader(ID3D11VertexShader* pVertexShader);
+
+  void PSSetShader(ID3D11PixelShader* pPixelShader);
+
+  /// VS/PSSetConstantBuffers; con @p pFirstConstant graba la variante con offsets (...1).
+  void SetConstantBuffers(bool pixelShader,
+    unsigned int StartSlot,
+    unsigned int NumBuffers,
+    ID3D11Buffer* const* ppConstantBuffers,
+    const unsigned int* pFirstConstant,
+    const unsigned int* pNumConstants);
+
+  void PSSetShaderResources(unsigned int StartSlot,
+    unsigned int NumViews,
+    ID3D11ShaderResourceView* const* ppShaderResourceViews);
+
+  void PSSetSamplers(unsigned int StartSlot, unsigned int NumSamplers, ID3D11SamplerState* const* ppSamplers);
+
+  void OMSetRenderTargets(unsigned int NumViews,
+    ID3D11RenderTargetView* const* ppRenderTargetViews,
+    ID3D11DepthStencilView* pDepthStencilView);
+
+  void OMSetBlendState(ID3D11BlendState* pBlendState, const float BlendFactor[4], unsigned int SampleMask);
+
+  void ClearRenderTargetView(ID3D11RenderTargetView* pRenderTargetView, const float ColorRGBA[4]);
+
+  void ClearDepthStencilView(ID3D11DepthStencilView* pDepthStencilView,
+    unsigned int ClearFlags,
+    float Depth,
+    UINT8 Stencil);
+
+  void DrawIndexed(unsigned int IndexCount, unsigned int StartIndexLocation, int BaseVertexLocation);
+
+  void DrawIndexedInstanced(unsigned int IndexCountPerInstance,
+    unsigned int InstanceCount,
+    unsigned int StartIndexLocation,
+    int BaseVertexLocation,
+    unsigned int StartInstanceLocation);
+
+public:
+  /// Lista grabada por un ID3D11DeviceContext diferido (formato nativo).
+  ID3D11CommandList* m_native = nullptr;
+
+private:
+  /// Agrega un comando y devuelve una referencia para completar sus campos.
+  Command& push(CommandType type, const void* object = nullptr);
+
+  /// Copia @p bytes a m_data (alineado a 8) y devuelve su offset.
+  unsigned int store(const void* source, size_t bytes);
+
+  /// Puntero a los datos guardados en @p offset.
+  template<typename T>
+  const T*
+  load(unsigned int offset) const {
+    return reinterpret_cast<const T*>(m_data.data() + offset);
+  }
+
+private:
+  std::vector<Command> m_commands;
+  std::vector<unsigned char> m_data;
+  unsigned int m_draws = 0;
+};
@@ -0,0 +1,121 @@
+#pragma once
+#include "Prerequisites.h"
+#include "Buffer.h"
+#include "DeviceContext.h"
+
+/**
+ * @brief Frecuencia con la que se espera que cambie el contenido de un constant buffer.
+ *
+ * - UPDATE_PER_FRAME: cambia en casi todos los cuadros; set() no compara y siempre marca sucio.
+ * - UPDATE_ON_RESIZE: cambia con el tamao de la ventana; set() compara con la copia local.
+ * - UPDATE_STATIC: se sube una vez; los cambios posteriores se suben pero se cuentan
+ *   en Stats::staticRewrites para detectar buffers mal clasificados.
+ */
+enum UpdateFrequency {
+  UPDATE_PER_FRAME = 0,
+  UPDATE_ON_RESIZE,
+  UPDATE_STATIC
+};
+
+/**
+ * @class ConstantBuffer
+ * @brief Constant buffer tipado sobre Buffer con copia local y seguimiento de cambios.
+ *
+ * set() guarda el contenido en la copia local y lo marca sucio solo si cambi;
+ * flush() lo sube con UpdateSubresource nicamente cuando est sucio. Los bytes
+ * subidos se acumulan en los contadores por cuadro de DeviceContext (ver
+ * DeviceContext::reportStateStats).
+ *
+ * @tparam T Estructura con el layout del cbuffer del shader (p. ej. CBNeverChanges).
+ */
+template<typename T>
+class
+  ConstantBuffer {
+public:
+  /// Contadores acumulados desde init().
+  struct Stats {
+    unsigned int sets = 0;
+    unsigned int unchangedSets = 0;   ///< set() con el mismo contenido: no marcan sucio
+    unsigned int uploads = 0;
+    unsigned int staticRewrites = 0;  ///< Subidas de un UPDATE_STATIC despus de la primera
+  };
+
+  ConstantBuffer() = default;
+  ~ConstantBuffer() = default;
+
+  /**
+   * @brief Crea el buffer de sizeof(T) bytes.
+   * @param frequency Clase de frecuencia (ver UpdateFrequency).
+   */
+  HRESULT
+  init(Device& device, UpdateFrequency frequency) {
+    static_assert(sizeof(T) % 16 == 0, "El tamao de un constant buffer debe ser mltiplo de 16 bytes");
+    m_frequency = frequency;
+    m_dirty = false;
+    m_hasData = false;
+    m_stats = Stats();
+    return m_buffer.init(device, sizeof(T));
+  }
+
+  /// Libera el buffer.
+  void
+  destroy() {
+    m_buffer.destroy();
+    m_dirty = false;
+    m_hasData = false;
+  }
+
+  /// Reemplaza el contenido; solo lo marca sucio si difiere del actual.
+  void
+  set(const T& data) {
+    ++m_stats.sets;
+    if (m_hasData && m_frequency != UPDATE_PER_FRAME && memcmp(&m_data, &data, sizeof(T)) == 0) {
+      ++m_stats.unchangedSets;
+      return;
+    }
+    m_data = data;
+    m_hasData = true;
+    m_dirty = true;
+  }
+
+  /// Contenido actual (la copia local, no lo que est en la GPU si est sucio).
+  const T& data() const { return m_data; }
+
+  bool isDirty() const { return m_dirty; }
+
+  UpdateFrequency frequency() const { return m_frequency; }
+
+  /**
+   * @brief Sube el contenido si cambi desde la ltima subida.
+   * @return true si hubo UpdateSubresource.
+   */
+  bool
+  flush(DeviceContext& deviceContext) {
+    if (!m_dirty) {
+      return false;
+    }
+    if (m_frequency == UPDATE_STATIC && m_stats.uploads > 0) {
+      ++m_stats.staticRewrites;
+    }
+    m_buffer.update(deviceContext, nullptr, 0, nullptr, &m_data, 0, 0);
+    ++m_stats.uploads;
+    m_dirty = false;
+    return true;
+  }
+
+  /// Enlaza el buffer en @p slot del Vertex Shader (y del Pixel Shader si se pide).
+  void
+  render(DeviceContext& deviceContext, unsigned int slot, bool setPixelShader = false) {
+    m_buffer.render(deviceContext, slot, 1, setPixelShader);
+  }
+
+public:
+  Stats m_stats;
+
+private:
+  Buffer m_buffer;
+  T m_data;
+  UpdateFrequency m_frequency = UPDATE_PER_FRAME;
+  bool m_dirty = false;
+  bool m_hasData = false;   ///< false hasta el primer set(): no hay con qu comparar
+};
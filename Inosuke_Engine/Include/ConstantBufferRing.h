@@ -0,0 +1,128 @@
+#pragma once
+#include "Prerequisites.h"
+
+class Device;
+class DeviceContext;
+
+/**
+ * @class ConstantBufferRing
+ * @brief Asignador lineal circular de constantes por objeto sobre un solo buffer dinmico.
+ *
+ * Cada push() reserva un bloque alineado a kAlignment bytes a continuacin del
+ * anterior, lo escribe con Map(WRITE_NO_OVERWRITE) y devuelve su primera
+ * constante para enlazarlo con bind() (VS/PSSetConstantBuffers1). As los
+ * objetos de un cuadro no se pisan entre s y no hay un UpdateSubresource por
+ * objeto.
+ *
+ * Los bloques de un cuadro quedan "en vuelo" hasta que la GPU termina ese cuadro:
+ * endFrame() pone un query de evento (fence) y beginFrame() libera los cuadros
+ * cuyo fence ya se complet. Si el siguiente bloque pisara memoria en vuelo, el
+ * buffer se mapea con WRITE_DISCARD: el driver entrega memoria nueva y todo lo
+ * anterior se considera libre. Nunca se espera a la GPU.
+ *
+ * Sin soporte de offsets (D3D 11.0, ver DeviceContext::supportsConstantBufferOffsets)
+ * o sin NO_OVERWRITE sobre constant buffers (ver supportsConstantBufferNoOverwrite)
+ * el anillo no se usa: cada push() escribe en un buffer aparte de kAlignment bytes
+ * con WRITE_DISCARD y bind() lo enlaza desde el inicio. Renombrar 256 bytes por
+ * draw es barato; renombrar el anillo entero no.
+ */
+class
+  ConstantBufferRing {
+public:
+  /// Alineacin de cada bloque: VSSetConstantBuffers1 exige mltiplos de 16 constantes.
+  static const unsigned int kAlignment = 256;
+
+  /// Fences que se pueden tener pendientes a la vez.
+  static const unsigned int kMaxFramesInFlight = 3;
+
+  /// Bloque reservado, en constantes de 16 bytes.
+  struct Allocation {
+    unsigned int firstConstant = 0;
+    unsigned int numConstants = 0;
+  };
+
+  /// Contadores acumulados desde init().
+  struct Stats {
+    unsigned long long allocations = 0;
+    unsigned long long bytesRequested = 0;
+    unsigned long long bytesAllocated = 0;   ///< Con relleno de alineacin
+    unsigned long long bytesWrapped = 0;     ///< Final del buffer saltado al dar la vuelta
+    unsigned int wraps = 0;
+    unsigned int discards = 0;               ///< Map DISCARD del anillo (primer uso o anillo lleno)
+    unsigned int fallbackUploads = 0;        ///< push() al buffer por draw (sin offsets o NO_OVERWRITE)
+    unsigned int ringFull = 0;               ///< Veces que la memoria en vuelo forz un DISCARD
+    unsigned int fenceOverflows = 0;         ///< Cuadros cerrados con los kMaxFramesInFlight fences ocupados
+    unsigned int frames = 0;
+    unsigned int framesRetired = 0;
+    unsigned int peakBytesInFlight = 0;
+  };
+
+  ConstantBufferRing() = default;
+  ~ConstantBufferRing() = default;
+
+  /**
+   * @brief Crea el buffer dinmico de @p byteWidth bytes, el buffer por draw y
+   * los queries de fence.
+   * @param byteWidth Se redondea a kAlignment.
+   */
+  HRESULT init(Device& device, unsigned int byteWidth);
+
+  /// Libera el buffer y los queries.
+  void destroy();
+
+  bool isValid() const { return m_buffer != nullptr; }
+
+  /// Libera la memoria de los cuadros cuyo fence ya se complet.
+  void beginFrame(DeviceContext& deviceContext);
+
+  /// Pone el fence del cuadro actual (llamar despus del ltimo draw que lo usa).
+  void endFrame(DeviceContext& deviceContext);
+
+  /**
+   * @brief Reserva un bloque, copia @p bytes de @p data y lo describe en @p out.
+   * @return false si @p bytes es 0, excede el buffer (kAlignment sin offsets) o
+   *         el Map falla.
+   */
+  bool push(DeviceContext& deviceContext, const void* data, unsigned int bytes, Allocation& out);
+
+  /// Enlaza @p allocation en @p slot del Vertex Shader (y del Pixel Shader si se pide).
+  void bind(DeviceContext& deviceContext,
+    unsigned int slot,
+    const Allocation& allocation,
+    bool setPixelShader = false);
+
+  /// Reporta los contadores por la salida de depuracin.
+  void report(const std::string& label) const;
+
+public:
+  ID3D11Buffer* m_buffer = nullptr;
+  ID3D11Buffer* m_drawBuffer = nullptr;   ///< kAlignment bytes, para contextos que no usan el anillo
+  Stats m_stats;
+
+private:
+  struct FrameFence {
+    ID3D11Query* query = nullptr;
+    unsigned int bytes = 0;          ///< Memoria del anillo que us el cuadro
+    bool inFlight = false;
+  };
+
+  /// Revisa los fences del ms viejo al ms nuevo sin esperar.
+  void retireFrames(DeviceContext& deviceContext);
+
+  /// Olvida toda la memoria en vuelo (despus de un DISCARD).
+  void forgetInFlight();
+
+  /// true si el contexto enlaza por offset y acepta NO_OVERWRITE sobre constant buffers.
+  static bool usesRing(const DeviceContext& deviceContext);
+
+private:
+  unsigned int m_size = 0;
+  unsigned int m_head = 0;           ///< Prximo byte libre
+  unsigned int m_inFlight = 0;       ///< Bytes de cuadros sin fence completado, incluido el actual
+  unsigned int m_frameBytes = 0;     ///< Bytes del cuadro actual
+  bool m_needsDiscard = true;        ///< El primer Map de un buffer dinmico debe ser DISCARD
+
+  FrameFence m_fences[kMaxFramesInFlight];
+  unsigned int m_nextFence = 0;
+  unsigned int m_fencesInFlight = 0;
+};
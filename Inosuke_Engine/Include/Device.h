@@ -1,6 +1,8 @@
 #pragma once
 #include "Prerequisites.h"
 
+class NullBackend;
+
 /**
  * Clase que encapsula un ID3D11Device de Direct3D 11.
  *
@@ -8,6 +10,9 @@
  * como vistas, texturas, shaders, buffers y estados de muestreo.
  *
  * Nota: esta clase solo gestiona el dispositivo, no el contexto.
+ *
+ * Si m_nullBackend no es nulo, las llamadas se desvan a ese backend headless
+ * (ver NullBackend) y m_device queda en nullptr.
  */
 class Device {
 public:
@@ -29,6 +34,9 @@ public:
   /// Libera los recursos del dispositivo.
   void destroy();
 
+  /// true si hay un dispositivo D3D11 creado o un backend headless asignado.
+  bool isValid() const { return m_device != nullptr || m_nullBackend != nullptr; }
+
   /**
    * Crea una Render Target View (RTV).
    *
@@ -123,7 +131,39 @@ public:
   HRESULT CreateSamplerState(const D3D11_SAMPLER_DESC* pSamplerDesc,
                               ID3D11SamplerState** ppSamplerState);
 
+  /**
+   * Crea un Query (p. ej. D3D11_QUERY_EVENT para saber cundo la GPU termin un cuadro).
+   *
+   * @param pQueryDesc Descriptor del query.
+   * @param ppQuery    Puntero de salida con el query creado.
+   */
+  HRESULT CreateQuery(const D3D11_QUERY_DESC* pQueryDesc,
+                      ID3D11Query** ppQuery);
+
+  /**
+   * Crea una Shader Resource View (SRV).
+   *
+   * @param pResource Recurso base, normalmente una textura.
+   * @param pDesc     Descriptor opcional de la SRV.
+   * @param ppSRView  Puntero de salida con la SRV creada.
+   */
+  HRESULT CreateShaderResourceView(ID3D11Resource* pResource,
+                                    const D3D11_SHADER_RESOURCE_VIEW_DESC* pDesc,
+                                    ID3D11ShaderResourceView** ppSRView);
+
+  /**
+   * Carga una imagen (DDS, PNG, ...) y crea su Shader Resource View.
+   *
+   * @param fileName Ruta del archivo.
+   * @param ppSRView Puntero de salida con la SRV creada.
+   */
+  HRESULT CreateShaderResourceViewFromFile(const std::string& fileName,
+                                            ID3D11ShaderResourceView** ppSRView);
+
 public:
   /// Puntero al dispositivo Direct3D 11. Se crea en init() y se libera en destroy().
   ID3D11Device* m_device = nullptr;
+
+  /// Backend headless; no es dueo (lo administra quien lo asigna, p. ej. BaseApp).
+  NullBackend* m_nullBackend = nullptr;
 };
@@ -1,16 +1,64 @@
 #pragma once
 #include "Prerequisites.h"
 
+class NullBackend;
+class CommandList;
+class Device;
+
 /**
  * Clase que encapsula un ID3D11DeviceContext de Direct3D 11.
  *
  * Su funcin principal es administrar las operaciones del pipeline grfico,
  * como asignacin de recursos, estados, shaders y envo de comandos de dibujo.
  *
- * Nota: representa el contexto inmediato; no maneja mltiples contextos en paralelo.
+ * Por defecto representa el contexto inmediato. Con initDeferred() es un contexto
+ * diferido: entre beginRecording() y finishRecording() sus llamadas se graban en
+ * una CommandList (en un ID3D11DeviceContext diferido o, sin D3D11, en el formato
+ * del motor) que despus se ejecuta en el inmediato con ExecuteCommandList().
+ * Cada hilo debe grabar en su propio contexto diferido.
+ *
+ * Si m_nullBackend no es nulo, cada llamada se registra en ese backend headless
+ * en lugar de enviarse a D3D11 (ver NullBackend).
+ *
+ * Guarda una copia del estado enlazado (input layout, shaders, buffers, constant
+ * buffers, SRVs, samplers, viewport, rasterizer/blend state y render targets) y
+ * no enva las llamadas Set* que no cambian nada. En llamadas por rango solo se
+ * enva el sub-rango de slots que cambi. ClearState() y destroy() olvidan la copia.
+ * Los contadores por cuadro (enviadas vs. filtradas y bytes de constantes subidos)
+ * se reinician en beginFrame().
  */
 class DeviceContext {
 public:
+  /// Llamadas de estado que pasan por la cach.
+  enum StateCall {
+    STATE_RS_SET_VIEWPORTS = 0,
+    STATE_RS_SET_STATE,
+    STATE_IA_SET_INPUT_LAYOUT,
+    STATE_IA_SET_VERTEX_BUFFERS,
+    STATE_IA_SET_INDEX_BUFFER,
+    STATE_IA_SET_PRIMITIVE_TOPOLOGY,
+    STATE_VS_SET_SHADER,
+    STATE_VS_SET_CONSTANT_BUFFERS,
+    STATE_PS_SET_SHADER,
+    STATE_PS_SET_CONSTANT_BUFFERS,
+    STATE_PS_SET_SHADER_RESOURCES,
+    STATE_PS_SET_SAMPLERS,
+    STATE_OM_SET_RENDER_TARGETS,
+    STATE_OM_SET_BLEND_STATE,
+    STATE_COUNT
+  };
+
+  /// Llamadas de estado enviadas al backend y filtradas por redundantes, y datos subidos.
+  struct StateStats {
+    unsigned int issued[STATE_COUNT] = {};
+    unsigned int filtered[STATE_COUNT] = {};
+    unsigned int uploads = 0;              ///< UpdateSubresource/Map de constantes e instancias
+    unsigned long long uploadBytes = 0;
+
+    unsigned int totalIssued() const;
+    unsigned int totalFiltered() const;
+  };
+
   /// Constructor por defecto: no asocia ningn contexto an.
   DeviceContext() = default;
 
@@ -29,6 +77,59 @@ public:
   /// Libera el recurso de contexto de dispositivo.
   void destroy();
 
+  /// true si hay un contexto D3D11 creado, un backend headless asignado o es diferido.
+  bool isValid() const { return m_deviceContext != nullptr || m_nullBackend != nullptr || m_deferred; }
+
+  /**
+   * @brief Convierte este wrapper en un contexto diferido para grabar listas.
+   * @param native Con un Device de D3D11, graba en un ID3D11DeviceContext diferido;
+   *               si es false o el Device es headless, graba en el formato del motor.
+   */
+  HRESULT initDeferred(Device& device, bool native = true);
+
+  bool isDeferred() const { return m_deferred; }
+
+  bool isRecording() const { return m_commandList != nullptr || m_nativeList != nullptr; }
+
+  /**
+   * @brief Empieza a grabar en @p commandList (que se vaca). La cach de estado
+   * arranca vaca, como el estado de un contexto diferido de D3D11: la lista
+   * debe enlazar todo lo que use. Map, Unmap, End y GetData no se pueden grabar.
+   */
+  void beginRecording(CommandList& commandList);
+
+  /// Termina la grabacin; en D3D11 la lista queda en CommandList::m_native.
+  HRESULT finishRecording();
+
+  /**
+   * @brief Ejecuta @p commandList en este contexto inmediato. Como
+   * ExecuteCommandList(..., FALSE) de D3D11, el estado queda como tras ClearState().
+   * Para un orden determinista, ejecutar las listas siempre en el mismo orden
+   * (no en el que terminan de grabarse).
+   */
+  void ExecuteCommandList(const CommandList& commandList);
+
+  /// Restablece todo el estado del pipeline (ID3D11DeviceContext::ClearState).
+  void ClearState();
+
+  /// Empieza los contadores de un cuadro (si haba uno abierto, lo cierra antes).
+  void beginFrame();
+
+  /// Cierra el cuadro abierto: pasa sus contadores a m_lastFrameStats y al promedio.
+  void endFrame();
+
+  /// Nombre de la llamada de D3D11 que corresponde a @p call.
+  static const char* stateCallName(StateCall call);
+
+  /**
+   * @brief Reporta por la salida de depuracin las llamadas de estado enviadas y
+   * filtradas del ltimo cuadro y el promedio por cuadro desde el inicio.
+   */
+  void reportStateStats(const std::string& label) const;
+
+  /// Suma una subida de @p bytes (constantes o instancias) a los contadores del cuadro.
+  void countUpload(unsigned int bytes) { ++m_frameStats.uploads; m_frameStats.uploadBytes += bytes; }
+
   /**
    * Configura los viewports activos en el rasterizador.
    * @param NumViewports Nmero de viewports.
@@ -147,6 +248,74 @@ public:
                             unsigned int NumBuffers,
                             ID3D11Buffer* const* ppConstantBuffers);
 
+  /**
+   * true si se pueden enlazar constant buffers por offset (VSSetConstantBuffers1).
+   * Requiere ID3D11DeviceContext1 con ConstantBufferOffsetting (D3D 11.1, ver
+   * queryFeatures()) o un NullBackend que lo emule.
+   */
+  bool supportsConstantBufferOffsets() const;
+
+  /**
+   * true si un constant buffer dinmico se puede mapear con WRITE_NO_OVERWRITE
+   * (MapNoOverwriteOnDynamicConstantBuffer, ver queryFeatures()). Es una capacidad
+   * aparte de los offsets: sin ella ConstantBufferRing no escribe en el anillo.
+   */
+  bool supportsConstantBufferNoOverwrite() const;
+
+  /**
+   * Pide ID3D11DeviceContext1 al contexto D3D11 y revisa si el driver enlaza
+   * constant buffers por offset y si acepta NO_OVERWRITE sobre ellos. Lo llaman
+   * SwapChain::init() e initDeferred().
+   */
+  void queryFeatures(Device& device);
+
+  /**
+   * Asigna constant buffers al Vertex Shader leyendo cada uno desde
+   * pFirstConstant[i] (constantes de 16 bytes, mltiplo de 16) con
+   * pNumConstants[i] constantes. Sin soporte de offsets solo acepta offsets 0.
+   */
+  void VSSetConstantBuffers1(unsigned int StartSlot,
+                             unsigned int NumBuffers,
+                             ID3D11Buffer* const* ppConstantBuffers,
+                             const unsigned int* pFirstConstant,
+                             const unsigned int* pNumConstants);
+
+  /**
+   * Igual que VSSetConstantBuffers1 para el Pixel Shader.
+   */
+  void PSSetConstantBuffers1(unsigned int StartSlot,
+                             unsigned int NumBuffers,
+                             ID3D11Buffer* const* ppConstantBuffers,
+                             const unsigned int* pFirstConstant,
+                             const unsigned int* pNumConstants);
+
+  /**
+   * Mapea un recurso dinmico para escribirlo desde CPU.
+   */
+  HRESULT Map(ID3D11Resource* pResource,
+              unsigned int Subresource,
+              D3D11_MAP MapType,
+              unsigned int MapFlags,
+              D3D11_MAPPED_SUBRESOURCE* pMappedResource);
+
+  /**
+   * Termina la escritura de un recurso mapeado con Map().
+   */
+  void Unmap(ID3D11Resource* pResource, unsigned int Subresource);
+
+  /**
+   * Marca el fin de un query (para D3D11_QUERY_EVENT: todos los comandos anteriores).
+   */
+  void End(ID3D11Asynchronous* pAsync);
+
+  /**
+   * Lee el resultado de un query. S_OK si ya est listo, S_FALSE si sigue pendiente.
+   */
+  HRESULT GetData(ID3D11Asynchronous* pAsync,
+                  void* pData,
+                  unsigned int DataSize,
+                  unsigned int GetDataFlags);
+
   /**
    * Enva un comando para dibujar primitivas indexadas.
    */
@@ -154,7 +323,110 @@ public:
                     unsigned int StartIndexLocation,
                     int BaseVertexLocation);
 
+  /**
+   * Dibuja @p InstanceCount instancias de primitivas indexadas. Los atributos por
+   * instancia se leen desde @p StartInstanceLocation en los slots marcados
+   * D3D11_INPUT_PER_INSTANCE_DATA del input layout (ver InstanceBuffer).
+   */
+  void DrawIndexedInstanced(unsigned int IndexCountPerInstance,
+                            unsigned int InstanceCount,
+                            unsigned int StartIndexLocation,
+                            int BaseVertexLocation,
+                            unsigned int StartInstanceLocation);
+
 public:
   /// Puntero al contexto inmediato de Direct3D 11 (vlido tras init()).
   ID3D11DeviceContext* m_deviceContext = nullptr;
+
+  /// Backend headless; no es dueo (lo administra quien lo asigna, p. ej. BaseApp).
+  NullBackend* m_nullBackend = nullptr;
+
+#if INOSUKE_D3D11_1
+  /// Interfaz D3D 11.1 de m_deviceContext; nula si el runtime o el driver no enlazan por offset.
+  ID3D11DeviceContext1* m_deviceContext1 = nullptr;
+
+  /// D3D11_FEATURE_DATA_D3D11_OPTIONS::MapNoOverwriteOnDynamicConstantBuffer.
+  bool m_constantBufferNoOverwrite = false;
+#endif
+
+  /// Si es false todas las llamadas se envan (para comparar con y sin cach).
+  bool m_filterRedundantState = true;
+
+  /// Contadores del cuadro en curso, del ltimo cuadro cerrado y acumulados.
+  StateStats m_frameStats;
+  StateStats m_lastFrameStats;
+  StateStats m_totalStats;
+  unsigned int m_frameCount = 0;
+
+private:
+  /// Slots que sigue la cach; los de ms arriba se envan siempre.
+  static const unsigned int kMaxVertexBuffers = 4;
+  static const unsigned int kMaxConstantBuffers = D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT;
+  static const unsigned int kMaxShaderResources = 16;
+  static const unsigned int kMaxSamplers = D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT;
+  static const unsigned int kMaxRenderTargets = 8;
+
+  /// Copia del estado enlazado; los valores iniciales son los de ClearState().
+  struct BoundState {
+    D3D11_VIEWPORT viewport = {};
+    unsigned int numViewports = 0;
+    ID3D11RasterizerState* rasterizerState = nullptr;
+    ID3D11InputLayout* inputLayout = nullptr;
+    ID3D11Buffer* vertexBuffers[kMaxVertexBuffers] = {};
+    unsigned int vertexStrides[kMaxVertexBuffers] = {};
+    unsigned int vertexOffsets[kMaxVertexBuffers] = {};
+    ID3D11Buffer* indexBuffer = nullptr;
+    DXGI_FORMAT indexFormat = DXGI_FORMAT_UNKNOWN;
+    unsigned int indexOffset = 0;
+    D3D11_PRIMITIVE_TOPOLOGY topology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+    ID3D11VertexShader* vertexShader = nullptr;
+    ID3D11Buffer* vsConstantBuffers[kMaxConstantBuffers] = {};
+    unsigned int vsFirstConstants[kMaxConstantBuffers] = {};
+    unsigned int vsNumConstants[kMaxConstantBuffers] = {};
+    ID3D11PixelShader* pixelShader = nullptr;
+    ID3D11Buffer* psConstantBuffers[kMaxConstantBuffers] = {};
+    unsigned int psFirstConstants[kMaxConstantBuffers] = {};
+    unsigned int psNumConstants[kMaxConstantBuffers] = {};
+    ID3D11ShaderResourceView* psShaderResources[kMaxShaderResources] = {};
+    ID3D11SamplerState* psSamplers[kMaxSamplers] = {};
+    ID3D11RenderTargetView* renderTargets[kMaxRenderTargets] = {};
+    unsigned int numRenderTargets = 0;
+    ID3D11DepthStencilView* depthStencilView = nullptr;
+    ID3D11BlendState* blendState = nullptr;
+    float blendFactor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    unsigned int sampleMask = 0xffffffff;
+    /// OMSetRenderTargets puede desenlazar SRVs (hazard de D3D11): hasta el prximo
+    /// PSSetShaderResources no se sabe qu qued enlazado.
+    bool shaderResourcesKnown = true;
+  };
+
+  /// true (y ERROR) si es un contexto diferido sin lista en grabacin.
+  bool rejectIdleDeferred(const char* method) const;
+
+  /// Cuenta la llamada; devuelve true si es redundante y debe omitirse.
+  bool filterCall(StateCall call, bool redundant);
+
+  /**
+   * VS/PSSetConstantBuffers y sus variantes con offset. Sin @p pFirstConstant se
+   * enlaza el buffer completo (offset 0, D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT).
+   */
+  void setConstantBuffers(bool pixelShader,
+                          unsigned int StartSlot,
+                          unsigned int NumBuffers,
+                          ID3D11Buffer* const* ppConstantBuffers,
+                          const unsigned int* pFirstConstant,
+                          const unsigned int* pNumConstants);
+
+  BoundState m_bound;
+
+  /// Lista en grabacin en formato del motor: las llamadas van aqu y no al backend.
+  CommandList* m_commandList = nullptr;
+
+  /// Lista que recibe FinishCommandList() del contexto diferido de D3D11.
+  CommandList* m_nativeList = nullptr;
+
+  bool m_deferred = false;
+
+  /// true entre beginFrame() y endFrame(): lo de fuera (init) no entra en m_totalStats.
+  bool m_frameOpen = false;
 };
@@ -0,0 +1,181 @@
+#pragma once
+#include "Prerequisites.h"
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @class FrameArena
+ * @brief Asignador lineal (bump) para datos que viven un solo cuadro: listas de
+ * visibles, tablas temporales, resultados de consultas.
+ *
+ * allocate() solo avanza un offset dentro del bloque actual; cuando no alcanza
+ * pide otro bloque al heap (del doble de tamao). reset() libera todo de una vez
+ * y, si el cuadro us varios bloques, los junta en uno solo: despus del primer
+ * cuadro de cada tamao ya no se toca el heap.
+ *
+ * Cada hilo tiene su arena (local()), as que reservar no toma locks. El hilo
+ * que maneja el cuadro (BaseApp::run) llama a endFrame() al terminarlo; cada
+ * arena se reinicia sola la primera vez que su hilo la pide en el cuadro
+ * siguiente. Lo reservado con local() vale hasta el prximo endFrame() y no
+ * debe pasar a otro cuadro (p. ej. dentro de un FramePipeline::FramePacket).
+ * Un hilo que no sigue los cuadros de BaseApp (el de render con latencia) debe
+ * usar la arena dentro de un Scope: mientras haya uno abierto no se reinicia.
+ *
+ * Con setTracking(true), endFrame() reporta por la salida de depuracin los
+ * bytes usados en el cuadro y el mximo alcanzado (high-water mark).
+ */
+class
+  FrameArena {
+public:
+  /// Tamao del primer bloque de cada arena.
+  static const size_t kBlockSize = 64 * 1024;
+
+  /// Acumulados desde la creacin de la arena.
+  struct Stats {
+    unsigned long long frames = 0;        ///< Veces que se reinici
+    unsigned long long allocations = 0;
+    unsigned long long blockAllocations = 0;  ///< Bloques pedidos al heap
+    size_t lastFrameBytes = 0;            ///< Mximo de bytes en uso en el ltimo cuadro
+    size_t peakBytes = 0;                 ///< Mximo de bytes en uso en un cuadro
+    size_t capacity = 0;                  ///< Bytes en bloques ahora
+  };
+
+  /**
+   * @brief Guarda la posicin de la arena y la restaura al salir: lo reservado
+   * dentro del Scope se libera al cerrarlo (orden de pila).
+   */
+  class
+    Scope {
+  public:
+    explicit Scope(FrameArena& arena);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    FrameArena& m_arena;
+    size_t m_block;
+    size_t m_offset;
+    size_t m_used;
+  };
+
+  FrameArena() = default;
+  ~FrameArena() { destroy(); }
+  FrameArena(const FrameArena&) = delete;
+  FrameArena& operator=(const FrameArena&) = delete;
+
+  /**
+   * @brief Reserva @p bytes alineados a @p alignment (potencia de 2). Nunca
+   * devuelve nullptr: si el bloque no alcanza pide otro.
+   */
+  void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+  /**
+   * @brief Solo recupera la memoria si es la ltima reserva (as un vector que
+   * crece al final no deja huecos); el resto se libera en reset().
+   */
+  void deallocate(void* pointer, size_t bytes);
+
+  /// Libera todo lo reservado y junta los bloques en uno.
+  void reset();
+
+  /// Devuelve los bloques al heap.
+  void destroy();
+
+  /// Bytes en uso desde el ltimo reset() (con el relleno de alineacin).
+  size_t bytesUsed() const { return m_used.load(std::memory_order_relaxed); }
+
+  /// Mximo de bytesUsed() desde el ltimo reset() (high-water mark del cuadro).
+  size_t highWater() const { return m_high.load(std::memory_order_relaxed); }
+
+  const Stats& stats() const { return m_stats; }
+
+  /// Arena del hilo actual; la reinicia si hubo un endFrame() desde su ltimo uso.
+  static FrameArena& local();
+
+  /**
+   * @brief Cierra el cuadro: la memoria de local() de todos los hilos queda libre
+   * para el siguiente. La arena del hilo que llama se reinicia en el momento.
+   */
+  static void endFrame();
+
+  /// Cuadros cerrados por endFrame().
+  static unsigned long long frameNumber();
+
+  /// Modo de depuracin: reporte de bytes por cuadro en endFrame().
+  static void setTracking(bool tracking);
+  static bool isTracking();
+
+  /// Reporta el mximo por cuadro y los bloques pedidos al heap de cada hilo.
+  static void report(const std::string& label);
+
+  /**
+   * @brief Arma @p lists listas temporales por cuadro (push_back de tamao
+   * variable) durante @p frames cuadros con std::vector y con FrameVector, y
+   * reporta ns por lista, el mximo de la arena y los bloques que pidi al heap.
+   * @return false si las dos versiones no dan el mismo resultado.
+   */
+  static bool benchmark(unsigned int frames = 240, unsigned int lists = 2000);
+
+private:
+  struct Block {
+    unsigned char* data;
+    size_t size;
+  };
+
+  /// Pasa a un bloque con lugar para @p bytes alineados; lo pide al heap si no hay.
+  void* allocateSlow(size_t bytes, size_t alignment);
+
+  /// Suma @p bytes a m_used y actualiza m_high.
+  void addUsed(size_t bytes);
+
+private:
+  std::vector<Block> m_blocks;
+  size_t m_block = 0;                       ///< Bloque actual
+  size_t m_offset = 0;                      ///< Primer byte libre del bloque actual
+  std::atomic<size_t> m_used{ 0 };          ///< Lo lee endFrame() desde otro hilo
+  std::atomic<size_t> m_high{ 0 };
+  std::atomic<unsigned long long> m_frame{ 0 };  ///< Cuadro de endFrame() al que pertenece lo reservado
+  unsigned int m_scopes = 0;
+  Stats m_stats;
+};
+
+/**
+ * @brief Adaptador de asignador de la STL sobre una FrameArena (la del hilo que
+ * lo construye, si no se indica otra). Los contenedores no liberan memoria en
+ * el heap: se descartan con la arena.
+ */
+template<typename T>
+class
+  FrameAllocator {
+public:
+  typedef T value_type;
+
+  FrameAllocator() : m_arena(&FrameArena::local()) {}
+  explicit FrameAllocator(FrameArena& arena) : m_arena(&arena) {}
+
+  template<typename U>
+  FrameAllocator(const FrameAllocator<U>& other) : m_arena(other.m_arena) {}
+
+  T*
+  allocate(size_t count) {
+    return static_cast<T*>(m_arena->allocate(sizeof(T) * count, alignof(T)));
+  }
+
+  void
+  deallocate(T* pointer, size_t count) {
+    m_arena->deallocate(pointer, sizeof(T) * count);
+  }
+
+  template<typename U>
+  bool operator==(const FrameAllocator<U>& other) const { return m_arena == other.m_arena; }
+
+  template<typename U>
+  bool operator!=(const FrameAllocator<U>& other) const { return m_arena != other.m_arena; }
+
+  FrameArena* m_arena;
+};
+
+/// Vector de un cuadro en la arena del hilo.
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
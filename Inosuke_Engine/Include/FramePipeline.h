@@ -0,0 +1,141 @@
+#pragma once
+#include "Prerequisites.h"
+#include "RenderQueue.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+/**
+ * @class FramePipeline
+ * @brief Separa el cuadro en dos etapas que se solapan: la simulacin (update,
+ * culling) llena un FramePacket y un hilo de render lo consume (RenderQueue,
+ * DeviceContext, Present).
+ *
+ * Un FramePacket tiene todo lo que el render necesita del cuadro (cmara,
+ * constantes y draws visibles) y no se modifica despus de submit(): la
+ * simulacin del cuadro N+1 corre mientras el render enva el N, sin compartir
+ * estado.
+ *
+ * La latencia es el nmero de cuadros que la simulacin puede adelantarse al
+ * render: 0 = serial (submit() renderiza en el hilo que llama), 1 = doble buffer,
+ * 2 = triple buffer. Con latencia L hay L + 1 paquetes; beginFrame() espera a que
+ * el render libere el ms viejo.
+ *
+ * Todo lo que toca el DeviceContext debe quedar en la funcin de render: con
+ * latencia mayor que 0 corre en otro hilo.
+ */
+class
+  FramePipeline {
+public:
+  /// Latencia mxima (triple buffer).
+  static const unsigned int kMaxLatency = 2;
+
+  /// Draw visible del cuadro: lo que recibe RenderQueue::submit().
+  struct Draw {
+    RenderQueue::DrawPacket packet;
+    float viewDepth = 0.0f;
+    RenderQueue::Pass pass = RenderQueue::PASS_OPAQUE;
+  };
+
+  /// Lo que la simulacin le deja al render. Los punteros de los draws deben vivir hasta flush().
+  struct FramePacket {
+    unsigned long long frame = 0;    ///< Nmero de cuadro (lo asigna beginFrame())
+    float deltaTime = 0.0f;
+    unsigned int width = 0;          ///< Tamao con el que se calcul la proyeccin
+    unsigned int height = 0;
+    CBNeverChanges view;             ///< Cmara (ya transpuesta para el shader)
+    CBChangeOnResize projection;
+    std::vector<Draw> draws;
+  };
+
+  /// Etapa de render: recibe el paquete de solo lectura.
+  typedef void (*RenderFunction)(void* data, const FramePacket& packet);
+
+  /// Tiempos acumulados desde init() o resetStats().
+  struct Stats {
+    unsigned long long frames = 0;   ///< Paquetes renderizados
+    unsigned long long draws = 0;
+    double updateMs = 0.0;           ///< Entre beginFrame() y submit()
+    double updateWaitMs = 0.0;       ///< beginFrame() esperando un paquete libre
+    double renderMs = 0.0;           ///< Dentro de la funcin de render
+    double renderWaitMs = 0.0;       ///< Hilo de render sin paquete para consumir
+    double wallMs = 0.0;             ///< Del primer beginFrame() al ltimo paquete renderizado
+    unsigned int maxInFlight = 0;    ///< Paquetes enviados y no terminados a la vez
+  };
+
+  FramePipeline() = default;
+  ~FramePipeline() { destroy(); }
+
+  /**
+   * @brief Reserva los paquetes y, con @p latency mayor que 0, arranca el hilo
+   * de render.
+   * @param latency Cuadros de adelanto de la simulacin (se limita a kMaxLatency).
+   */
+  HRESULT init(unsigned int latency, RenderFunction render, void* data);
+
+  /// Renderiza los paquetes pendientes y detiene el hilo.
+  void destroy();
+
+  bool isValid() const { return m_render != nullptr; }
+
+  unsigned int getLatency() const { return m_latency; }
+
+  /**
+   * @brief Devuelve el paquete del prximo cuadro, vaco de draws (la capacidad
+   * se conserva). Espera si ya hay getLatency() paquetes sin terminar.
+   */
+  FramePacket& beginFrame();
+
+  /// Entrega el paquete de beginFrame() al render; con latencia 0 lo renderiza aqu.
+  void submit();
+
+  /// Espera a que el render termine todos los paquetes enviados.
+  void flush();
+
+  /// Copia de los tiempos (toma el lock del hilo de render).
+  Stats stats() const;
+
+  void resetStats();
+
+  /// Paquetes que el render termin: el cuadro N ya no se usa si es mayor que N.
+  unsigned long long renderedFrames() const;
+
+  /// Reporta ms por cuadro de cada etapa por la salida de depuracin.
+  void report(const std::string& label) const;
+
+  /**
+   * @brief Corre @p frames cuadros con @p updateUs microsegundos de trabajo de
+   * CPU en la simulacin y @p renderUs en el render, con latencia 0, 1 y 2, y
+   * reporta ms por cuadro y por etapa.
+   * @return false si el render recibe un paquete fuera de orden o con datos de
+   *         otro cuadro.
+   */
+  static bool benchmark(unsigned int frames = 240, unsigned int updateUs = 2000, unsigned int renderUs = 2000);
+
+private:
+  void renderLoop();
+
+  /// Renderiza @p packet y suma sus tiempos (sin el lock tomado).
+  void renderPacket(FramePacket& packet);
+
+private:
+  unsigned int m_latency = 0;
+  RenderFunction m_render = nullptr;
+  void* m_data = nullptr;
+
+  std::vector<FramePacket> m_packets;          ///< m_latency + 1 paquetes en anillo
+  unsigned long long m_begun = 0;              ///< Paquetes entregados por beginFrame()
+  unsigned long long m_submitted = 0;          ///< Paquetes entregados por submit()
+  unsigned long long m_rendered = 0;           ///< Paquetes que el render termin
+  bool m_open = false;                         ///< Entre beginFrame() y submit()
+  bool m_quit = false;
+
+  std::chrono::high_resolution_clock::time_point m_firstFrame;
+  std::chrono::high_resolution_clock::time_point m_updateStart;
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_packetReady;       ///< submit() -> hilo de render
+  std::condition_variable m_packetFree;        ///< Hilo de render -> beginFrame() y flush()
+  std::thread m_thread;
+  Stats m_stats;
+};
@@ -0,0 +1,130 @@
+#pragma once
+#include "Prerequisites.h"
+
+class MeshComponent;
+class JobSystem;
+
+/**
+ * @class FrustumCuller
+ * @brief Descarta objetos fuera del frustum de la cmara probando sus volmenes
+ * envolventes en espacio mundo.
+ *
+ * Los volmenes se guardan como estructura de arreglos (centro x/y/z, semiejes
+ * x/y/z y radio en arreglos separados) para probar 4 objetos por instruccin con
+ * SSE o 8 con AVX contra los 6 planos. cull() escribe de forma compacta los
+ * ndices visibles, en orden creciente.
+ *
+ * Un objeto es invisible si su volumen queda por completo detrs de algn plano
+ * (prueba conservadora: cerca de las esquinas del frustum puede aceptar objetos
+ * que no se ven, nunca descarta uno visible).
+ */
+class
+  FrustumCuller {
+public:
+  /// Volumen que se prueba contra los planos.
+  enum Test {
+    TEST_SPHERE = 0,   ///< Centro y radio: 1 producto punto por plano
+    TEST_AABB          ///< Caja alineada a los ejes: ms ajustada para objetos alargados
+  };
+
+  /// Implementacin de cull().
+  enum Path {
+    PATH_AUTO = 0,     ///< AVX si el CPU lo soporta, si no SSE
+    PATH_SCALAR,
+    PATH_SSE,
+    PATH_AVX
+  };
+
+  /// Plano a*x + b*y + c*z + d con (a, b, c) normalizado apuntando hacia adentro.
+  struct Frustum {
+    XMFLOAT4 planes[6];   ///< Izquierdo, derecho, inferior, superior, cercano, lejano
+  };
+
+  FrustumCuller() = default;
+  ~FrustumCuller() = default;
+
+  /**
+   * @brief Extrae los planos de @p viewProjection (vista * proyeccin, convencin
+   * de XNA con vector fila y profundidad de D3D en [0, w]).
+   */
+  static Frustum extractFrustum(const XMMATRIX& viewProjection);
+
+  /**
+   * @brief Volumen de @p mesh (ver MeshComponent::computeBounds) transformado por
+   * @p world: caja alineada a los ejes que envuelve la caja rotada y esfera
+   * escalada por el mayor factor de escala.
+   */
+  static void transformBounds(const MeshComponent& mesh,
+    const XMMATRIX& world,
+    XMFLOAT3& center,
+    XMFLOAT3& extents,
+    float& radius);
+
+  /// Agrega un objeto y devuelve su ndice.
+  unsigned int add(const XMFLOAT3& center, const XMFLOAT3& extents, float radius);
+
+  /// Reemplaza el volumen del objeto @p index.
+  void set(unsigned int index, const XMFLOAT3& center, const XMFLOAT3& extents, float radius);
+
+  /// Olvida todos los objetos.
+  void clear();
+
+  unsigned int size() const { return (unsigned int)m_centerX.size(); }
+
+  /**
+   * @brief Llena @p visible con los ndices de los objetos que intersectan @p frustum.
+   * @return Nmero de objetos visibles.
+   */
+  unsigned int cull(const Frustum& frustum,
+    std::vector<unsigned int>& visible,
+    Test test = TEST_SPHERE,
+    Path path = PATH_AUTO) const;
+
+  /**
+   * @brief Igual que cull(), repartiendo los objetos en bloques contiguos entre
+   * @p threads hilos (0 = hardware_concurrency()). El resultado es idntico.
+   */
+  unsigned int cullParallel(const Frustum& frustum,
+    std::vector<unsigned int>& visible,
+    unsigned int threads = 0,
+    Test test = TEST_SPHERE,
+    Path path = PATH_AUTO) const;
+
+  /// Igual que cullParallel(), con los bloques repartidos en los hilos de @p jobs.
+  unsigned int cullParallel(const Frustum& frustum,
+    std::vector<unsigned int>& visible,
+    JobSystem& jobs,
+    Test test = TEST_SPHERE,
+    Path path = PATH_AUTO) const;
+
+  /// true si el CPU y el sistema operativo soportan AVX.
+  static bool avxSupported();
+
+  /**
+   * @brief Prueba @p objectCount esferas/cajas aleatorias durante @p iterations
+   * repeticiones con cada implementacin (escalar, SSE, AVX, multihilo y con
+   * JobSystem) y reporta ns por objeto.
+   * @return false si alguna implementacin produce una lista visible distinta.
+   */
+  static bool benchmark(unsigned int objectCount = 1000000, int iterations = 10);
+
+private:
+  /// Prueba [begin, end) y escribe los visibles en @p out; devuelve cuntos.
+  unsigned int cullRange(const Frustum& frustum,
+    unsigned int begin,
+    unsigned int end,
+    unsigned int* out,
+    Test test,
+    Path path) const;
+
+  static Path resolvePath(Path path);
+
+private:
+  std::vector<float> m_centerX;
+  std::vector<float> m_centerY;
+  std::vector<float> m_centerZ;
+  std::vector<float> m_extentX;
+  std::vector<float> m_extentY;
+  std::vector<float> m_extentZ;
+  std::vector<float> m_radius;
+};
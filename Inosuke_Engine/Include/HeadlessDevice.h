@@ -0,0 +1,28 @@
+#pragma once
+#include "Prerequisites.h"
+#include "NullBackend.h"
+#include "Device.h"
+#include "DeviceContext.h"
+
+/**
+ * @class HeadlessDevice
+ * @brief Device y DeviceContext enlazados a un NullBackend propio: el entorno
+ * sin GPU que comparten los benchmarks (ver Benchmark).
+ *
+ * Por omisin no graba el stream de comandos (solo los contadores), para que
+ * medir no llene m_commands.
+ */
+class
+  HeadlessDevice {
+public:
+  explicit HeadlessDevice(bool recordCommands = false);
+  ~HeadlessDevice() = default;
+
+  HeadlessDevice(const HeadlessDevice&) = delete;
+  HeadlessDevice& operator=(const HeadlessDevice&) = delete;
+
+public:
+  NullBackend   m_backend;
+  Device        m_device;
+  DeviceContext m_deviceContext;
+};
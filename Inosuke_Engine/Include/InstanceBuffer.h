@@ -0,0 +1,73 @@
+#pragma once
+#include "Prerequisites.h"
+
+class Device;
+class DeviceContext;
+
+/**
+ * @class InstanceBuffer
+ * @brief Stream de vrtices por instancia (slot 1) para DrawIndexedInstanced.
+ *
+ * Cada instancia ocupa un CBChangesEveryFrame (mWorld transpuesta y vMeshColor,
+ * 80 bytes): el mismo bloque que un draw sin instancias sube a b2. appendLayout()
+ * agrega al input layout los elementos INSTANCE_WORLD0..3 e INSTANCE_COLOR con
+ * D3D11_INPUT_PER_INSTANCE_DATA. Inosuke_Engine_Instanced.fx tiene los shaders
+ * que los leen: "VSInstanced" rearma la matriz con esas filas y pasa el color, y
+ * "PSInstanced" lo usa en lugar de vMeshColor (b2 no se sube en los lotes).
+ *
+ * push() agrega las instancias de un lote a continuacin de las anteriores con
+ * Map(WRITE_NO_OVERWRITE); cuando no caben, el buffer se mapea con WRITE_DISCARD
+ * y se vuelve al inicio (el driver renombra la memoria que la GPU an lee).
+ */
+class
+  InstanceBuffer {
+public:
+  /// Slot de entrada del stream por instancia.
+  static const unsigned int kSlot = 1;
+
+  /// Contadores acumulados desde init().
+  struct Stats {
+    unsigned long long instances = 0;
+    unsigned long long bytes = 0;
+    unsigned int batches = 0;         ///< Llamadas a push()
+    unsigned int discards = 0;        ///< Map DISCARD (primer uso o buffer lleno)
+  };
+
+  InstanceBuffer() = default;
+  ~InstanceBuffer() = default;
+
+  /// Crea un buffer dinmico para @p maxInstances instancias.
+  HRESULT init(Device& device, unsigned int maxInstances);
+
+  /// Libera el buffer.
+  void destroy();
+
+  bool isValid() const { return m_buffer != nullptr; }
+
+  unsigned int capacity() const { return m_capacity; }
+
+  /// Agrega al input layout los elementos por instancia (slot kSlot).
+  static void appendLayout(std::vector<D3D11_INPUT_ELEMENT_DESC>& layout);
+
+  /**
+   * @brief Copia @p count instancias y devuelve en @p firstInstance la primera,
+   * para StartInstanceLocation de DrawIndexedInstanced.
+   * @return false si @p count es 0, excede capacity() o el Map falla.
+   */
+  bool push(DeviceContext& deviceContext,
+    const CBChangesEveryFrame* instances,
+    unsigned int count,
+    unsigned int& firstInstance);
+
+  /// Enlaza el buffer en el slot kSlot de IA.
+  void render(DeviceContext& deviceContext);
+
+public:
+  ID3D11Buffer* m_buffer = nullptr;
+  Stats m_stats;
+
+private:
+  unsigned int m_capacity = 0;
+  unsigned int m_head = 0;           ///< Prxima instancia libre
+  bool m_needsDiscard = true;        ///< El primer Map de un buffer dinmico debe ser DISCARD
+};
@@ -0,0 +1,225 @@
+#pragma once
+#include "Prerequisites.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+/**
+ * @class JobSystem
+ * @brief Planificador de trabajos con robo de tareas (work stealing).
+ *
+ * Cada hilo tiene una cola doble de Chase-Lev: el dueo agrega y saca trabajos
+ * por abajo (LIFO, datos an en cach) y los hilos sin trabajo roban por arriba
+ * (FIFO, los trabajos ms grandes de una divisin recursiva). El hilo que llama
+ * a init() es el hilo 0 y participa: wait() ejecuta trabajos mientras espera.
+ *
+ * Un trabajo es una funcin, un puntero a datos y un rango [begin, end). Cada
+ * trabajo pertenece a un Counter que cuenta los pendientes; wait() vuelve cuando
+ * llega a 0 y spawnAfter() deja un trabajo en espera hasta que otro Counter
+ * llegue a 0 (dependencias). parallelFor() parte un rango en mitades hasta
+ * llegar al grano y reparte las mitades por robo.
+ *
+ * Los trabajos se guardan en un anillo de kMaxJobsPerThread por hilo; una
+ * ranura se reutiliza recin cuando execute() copi su trabajo. Si no hay
+ * ranura libre o la cola del hilo est llena, spawn() ejecuta el trabajo en el
+ * momento; spawnAfter() no puede (espera otro Counter) y lo reserva en el heap.
+ *
+ * Desde un hilo que no es del sistema, spawn() ejecuta el trabajo en el momento.
+ */
+class
+  JobSystem {
+public:
+  /// Trabajos por hilo (potencia de 2): tamao del anillo y de la cola.
+  static const unsigned int kMaxJobsPerThread = 4096;
+
+  /// Cuerpo de un trabajo.
+  typedef void (*JobFunction)(void* data, unsigned int begin, unsigned int end);
+
+  struct Job;
+
+  /**
+   * @brief Trabajos pendientes de un grupo. Se puede reutilizar despus de que
+   * wait() vuelva; no se copia.
+   */
+  class
+    Counter {
+  public:
+    Counter() = default;
+    Counter(const Counter&) = delete;
+    Counter& operator=(const Counter&) = delete;
+
+    bool isDone() const { return m_value.load(std::memory_order_acquire) == 0; }
+
+  private:
+    friend class JobSystem;
+    std::atomic<int> m_value{ 0 };
+    std::mutex m_mutex;                ///< Protege m_continuations
+    std::vector<Job*> m_continuations; ///< Trabajos de spawnAfter() que esperan el 0
+  };
+
+  /// Trabajo en el anillo de su hilo.
+  struct Job {
+    JobFunction function = nullptr;
+    void* data = nullptr;
+    unsigned int begin = 0;
+    unsigned int end = 0;
+    Counter* counter = nullptr;
+    std::atomic<bool> busy{ false };   ///< Ocupada desde que se toma hasta que execute() la copia
+    bool heap = false;                 ///< Reservado con new (spawnAfter() sin ranura libre)
+  };
+
+  /// Contadores por hilo (sumados en stats()).
+  struct Stats {
+    unsigned long long spawned = 0;
+    unsigned long long executed = 0;
+    unsigned long long stolen = 0;          ///< Ejecutados tras robarlos de otro hilo
+    unsigned long long stealAttempts = 0;
+    unsigned long long inlined = 0;         ///< Ejecutados en spawn() por cola llena o hilo ajeno
+    unsigned long long sleeps = 0;
+  };
+
+  JobSystem() = default;
+  ~JobSystem() { destroy(); }
+
+  /**
+   * @brief Arranca los hilos.
+   * @param threads Hilos totales (incluye al que llama); 0 = hardware_concurrency().
+   */
+  HRESULT init(unsigned int threads = 0);
+
+  /// Detiene los hilos. Los trabajos pendientes deben haber terminado (wait()).
+  void destroy();
+
+  bool isValid() const { return !m_workers.empty(); }
+
+  unsigned int getThreadCount() const { return (unsigned int)m_workers.size(); }
+
+  /// Encola function(data, begin, end) en el hilo actual y suma 1 a @p counter.
+  void spawn(Counter& counter, JobFunction function, void* data, unsigned int begin = 0, unsigned int end = 0);
+
+  /**
+   * @brief Como spawn(), pero el trabajo no empieza hasta que @p dependency
+   * llegue a 0. @p counter suma 1 desde ahora.
+   */
+  void spawnAfter(Counter& dependency,
+    Counter& counter,
+    JobFunction function,
+    void* data,
+    unsigned int begin = 0,
+    unsigned int end = 0);
+
+  /**
+   * @brief Ejecuta trabajos (propios o robados) hasta que @p counter llegue a 0.
+   * Al volver, ningn hilo usa ya @p counter: se puede destruir.
+   */
+  void wait(Counter& counter);
+
+  /**
+   * @brief Llama body(begin, end) sobre rangos de a lo sumo @p grain elementos
+   * que cubren [0, @p count). Vuelve cuando terminaron todos.
+   */
+  template<typename Body>
+  void
+  parallelFor(unsigned int count, unsigned int grain, const Body& body) {
+    if (count == 0) {
+      return;
+    }
+    Counter counter;
+    ParallelFor range = { this, &counter, (std::max)(grain, 1u), &invokeBody<Body>, &body };
+    spawn(counter, &JobSystem::splitRange, &range, 0, count);
+    wait(counter);
+  }
+
+  /// Suma de los contadores de todos los hilos.
+  Stats stats() const;
+
+  void resetStats();
+
+  /// Reporta los contadores por la salida de depuracin.
+  void report(const std::string& label) const;
+
+  /**
+   * @brief Mide el costo de spawn() + ejecucin de trabajos vacos (contra crear
+   * un std::thread), la latencia de robo de un trabajo recin encolado y la
+   * escala de parallelFor con 1, 2, 4... hasta @p maxThreads hilos
+   * (0 = todos los ncleos).
+   * @return false si algn resultado paralelo difiere del serial o una
+   *         dependencia se ejecuta antes de tiempo.
+   */
+  static bool benchmark(unsigned int maxThreads = 0);
+
+private:
+  /// Cola doble de Chase-Lev de capacidad fija.
+  class
+    WorkQueue {
+  public:
+    bool push(Job* job);               ///< Solo el dueo; false si est llena
+    Job* pop();                        ///< Solo el dueo
+    Job* steal();                      ///< Cualquier hilo
+    bool empty() const;
+
+  private:
+    std::atomic<long long> m_top{ 0 };
+    std::atomic<long long> m_bottom{ 0 };
+    std::atomic<Job*> m_jobs[kMaxJobsPerThread];
+  };
+
+  struct Worker {
+    WorkQueue queue;
+    Job ring[kMaxJobsPerThread];
+    unsigned int nextJob = 0;
+    unsigned int random = 0;           ///< xorshift para elegir vctima
+    Stats stats;
+    std::thread thread;
+  };
+
+  struct ParallelFor {
+    JobSystem* system;
+    Counter* counter;
+    unsigned int grain;
+    void (*invoke)(const void* body, unsigned int begin, unsigned int end);
+    const void* body;
+  };
+
+  template<typename Body>
+  static void
+  invokeBody(const void* body, unsigned int begin, unsigned int end) {
+    (*static_cast<const Body*>(body))(begin, end);
+  }
+
+  /// Trabajo de parallelFor: encola la mitad derecha hasta llegar al grano.
+  static void splitRange(void* data, unsigned int begin, unsigned int end);
+
+  /// ndice del hilo actual en m_workers o -1 si no es del sistema.
+  int currentWorker() const;
+
+  /// Toma un trabajo de la cola propia o roba uno.
+  Job* findJob(unsigned int worker);
+
+  /// Toma una ranura libre del anillo de @p owner; nullptr si estn todas ocupadas.
+  Job* acquireJob(Worker& owner);
+
+  /// Encola @p job (o lo ejecuta si la cola est llena) y despierta a un hilo dormido.
+  void submit(Job* job, unsigned int worker);
+
+  /// Copia @p job, libera su ranura y lo ejecuta.
+  void execute(Job& job);
+
+  /**
+   * @brief Resta 1 a @p counter y, si llega a 0, encola sus trabajos en espera.
+   * La bajada a 0 y la entrega se hacen con el mutex del Counter tomado.
+   */
+  void finish(Counter& counter);
+
+  void workerLoop(unsigned int worker);
+
+private:
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  std::thread::id m_mainThread;
+  std::atomic<int> m_queued{ 0 };      ///< Trabajos en colas (para dormir sin perder avisos)
+  std::atomic<int> m_sleeping{ 0 };
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::atomic<bool> m_quit{ false };
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include "Prerequisites.h"
+
+/**
+ * @class MappedFile
+ * @brief Proyecta un archivo de solo lectura en memoria (CreateFileMapping / MapViewOfFile).
+ *
+ * Permite a los loaders recorrer el contenido del archivo directamente desde
+ * las pginas del sistema operativo, sin copiarlo a un buffer intermedio
+ * ni pasar por streams.
+ *
+ * @note La vista es vlida hasta llamar a destroy(); los punteros obtenidos con
+ *       data() no deben conservarse despus de eso.
+ */
+class
+  MappedFile {
+public:
+  MappedFile() = default;
+
+  /**
+   * @brief Libera la proyeccin si sigue abierta.
+   */
+  ~MappedFile() { destroy(); }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /**
+   * @brief Abre y proyecta el archivo completo en memoria.
+   *
+   * @param fileName Ruta del archivo a proyectar.
+   * @return @c S_OK si la proyeccin fue exitosa; @c E_FAIL si el archivo no existe
+   *         o est vaco.
+   *
+   * @post Si retorna @c S_OK, data() != nullptr y size() > 0.
+   */
+  HRESULT
+    init(const std::string& fileName);
+
+  /**
+   * @brief Cierra la vista, el objeto de mapeo y el handle del archivo.
+   *
+   * Idempotente.
+   */
+  void
+    destroy();
+
+  /// Inicio de la vista proyectada (nullptr si no hay archivo abierto).
+  const char*
+    data() const { return m_data; }
+
+  /// Tamao del archivo en bytes.
+  size_t
+    size() const { return m_size; }
+
+private:
+  HANDLE m_file = INVALID_HANDLE_VALUE;  ///< Handle del archivo abierto
+  HANDLE m_mapping = nullptr;            ///< Objeto de mapeo de Win32
+  const char* m_data = nullptr;          ///< Vista de solo lectura
+  size_t m_size = 0;                     ///< Tamao de la vista en bytes
+};
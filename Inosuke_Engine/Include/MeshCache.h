@@ -0,0 +1,69 @@
+#pragma once
+#include "Prerequisites.h"
+
+class MeshComponent;
+
+/**
+ * Cach binaria de mallas ya procesadas ("baked mesh", extensin .imesh).
+ *
+ * Formato (little endian, todas las secciones alineadas a 16 bytes):
+ * - MeshCacheHeader: magia, versin, sello del archivo fuente, conteos,
+ *   bounds y checksum (del header con checksum = 0 y del contenido).
+ * - Descriptor del layout de vrtice (MeshCacheElement x numElements).
+ * - Tabla de LODs (MeshCacheLod x lodCount), sub-rangos del arreglo de ndices.
+ * - Tabla de meshlets (MeshCacheMeshlet x meshletCount) sobre el nivel 0.
+ * - Arreglo de SimpleVertex.
+ * - Arreglo de ndices (nivel 0 seguido de los LODs).
+ *
+ * La carga proyecta el archivo en memoria y copia los arreglos directo a
+ * MeshComponent::m_vertex / m_index / m_lods / m_meshlets, sin parsear nada;
+ * los bounds se toman del header en lugar de recalcularse.
+ */
+class MeshCache {
+public:
+  /// Identifica la versin del archivo fuente con la que se gener la cach.
+  struct SourceStamp {
+    unsigned long long size = 0;       // Tamao en bytes del archivo fuente
+    unsigned long long writeTime = 0;  // ltima escritura (FILETIME)
+    unsigned long long hash = 0;       // Hash de los primeros y ltimos 64 KB
+  };
+
+  static const unsigned int kMagic = 0x48534D49;  // "IMSH"
+  static const unsigned int kVersion = 5;  // 2: tabla de LODs; 3: checksum incluye el header; 4: meshlets; 5: radio
+
+  /// La malla ya pas por MeshOptimizer::optimize (cachs viejas tienen flags = 0).
+  static const unsigned int kFlagOptimized = 1u << 0;
+  /// Adems se reordenaron los clusters contra overdraw (MeshOptimizer::optimizeOverdraw).
+  static const unsigned int kFlagOverdrawOptimized = 1u << 1;
+
+  /// Ruta de cach asociada a un archivo fuente (mismo nombre + ".imesh").
+  static std::string cachePathFor(const std::string& sourceFile);
+
+  /// Calcula el sello del archivo fuente. Retorna false si no existe.
+  static bool stampSource(const std::string& sourceFile, SourceStamp& outStamp);
+
+  /**
+   * Escribe la malla en @p cacheFile (va archivo temporal + renombrado,
+   * para no dejar una cach a medias si el proceso se interrumpe).
+   * @p flags (kFlag*) se guarda en el header.
+   */
+  static bool save(const std::string& cacheFile,
+    const MeshComponent& mesh,
+    const SourceStamp& stamp,
+    unsigned int flags = 0);
+
+  /**
+   * Carga la malla desde @p cacheFile si la versin, el layout, el sello
+   * y el checksum coinciden. Retorna false (sin modificar @p outMesh) si la
+   * cach no existe, est obsoleta o corrupta. Si @p outFlags no es nulo
+   * recibe los flags con los que se guard.
+   */
+  static bool load(const std::string& cacheFile,
+    const SourceStamp& stamp,
+    MeshComponent& outMesh,
+    unsigned int* outFlags = nullptr);
+
+  /// Hash de 64 bits sobre bloques de 8 bytes (checksum de la cach).
+  static unsigned long long hashBytes(const void* data, size_t size,
+    unsigned long long seed = 0);
+};
@@ -3,6 +3,30 @@
 //#include "ECS\Component.h"
 class DeviceContext;
 
+/**
+ * @brief Cluster de tringulos contiguos en MeshComponent::m_index (ver MeshletBuilder).
+ *
+ * Se dibuja como sub-rango: DrawIndexed(triangleCount * 3, indexOffset, 0).
+ */
+struct Meshlet {
+  unsigned int indexOffset;    ///< Primer ndice dentro de m_index
+  unsigned int triangleCount;  ///< Tringulos del cluster
+  unsigned int vertexCount;    ///< Vrtices nicos que referencia
+  XMFLOAT3 center;             ///< Esfera envolvente (espacio objeto)
+  float radius;
+  XMFLOAT3 coneAxis;           ///< Cono de normales: eje promedio
+  float coneCutoff;            ///< sin(semingulo) del cono; 1 = no se puede descartar por cono
+};
+
+/**
+ * @brief Nivel de detalle: sub-rango de MeshComponent::m_index sobre el mismo vertex buffer.
+ */
+struct MeshLod {
+  unsigned int indexOffset;  ///< Primer ndice dentro de m_index
+  unsigned int indexCount;   ///< ndices del nivel
+  float error;               ///< Error geomtrico estimado, en unidades del espacio objeto
+};
+
 /**
  * @class MeshComponent
  * @brief Contiene los vrtices e ndices que forman una malla 3D.
@@ -11,7 +35,8 @@ class DeviceContext;
 class MeshComponent /*: public Component*/ {
 public:
   MeshComponent()
-    : m_numVertex(0), m_numIndex(0) /* Inicializa contadores a cero */ {}
+    : m_numVertex(0), m_numIndex(0), m_indexFormat(DXGI_FORMAT_R32_UINT),
+      m_boundsCenter(0.0f, 0.0f, 0.0f), m_boundsExtents(0.0f, 0.0f, 0.0f), m_boundsRadius(0.0f) /* Inicializa contadores a cero */ {}
 
   virtual ~MeshComponent() = default; // Destructor simple
 
@@ -38,10 +63,42 @@ public:
    */
   void destroy() /*override {}*/;
 
+  /**
+   * @brief Elige el ancho de ndice ms pequeo que alcanza para la malla.
+   *
+   * Con 65536 vrtices o menos usa @c DXGI_FORMAT_R16_UINT (mitad de memoria de
+   * GPU y ancho de banda); si no, @c DXGI_FORMAT_R32_UINT. @c m_index sigue en 32
+   * bits: Buffer::init lo reduce a 16 al subirlo. Debe llamarse cada vez que
+   * cambie @c m_vertex.
+   */
+  void selectIndexFormat();
+
+  /**
+   * @brief Calcula la caja (centro y semiejes) y la esfera envolventes de m_vertex
+   * en espacio objeto. Debe llamarse cada vez que cambien las posiciones.
+   */
+  void computeBounds();
+
+  /**
+   * @brief Descarta los LODs 1..n y deja en m_index solo el nivel 0.
+   */
+  void clearLods();
+
+  /// Bytes por ndice segn @c m_indexFormat (2 o 4).
+  unsigned int indexStride() const {
+    return m_indexFormat == DXGI_FORMAT_R16_UINT ? 2u : 4u;
+  }
+
 public:
   std::string m_name;                    // Nombre opcional de la malla
   std::vector<SimpleVertex> m_vertex;    // Lista de vrtices (pos, uv, normal...)
   std::vector<unsigned int> m_index;     // Lista de ndices (tringulos)
   int m_numVertex;                       // Total de vrtices
-  int m_numIndex;                        // Total de ndices
+  int m_numIndex;                        // ndices del nivel 0 (m_index puede tener adems los LODs)
+  DXGI_FORMAT m_indexFormat;             // Formato del index buffer (R16_UINT o R32_UINT)
+  std::vector<Meshlet> m_meshlets;       // Clusters sobre el nivel 0 de m_index (vaco si no se construyeron)
+  std::vector<MeshLod> m_lods;           // LOD 0..n (vaco = solo la malla completa)
+  XMFLOAT3 m_boundsCenter;               // Centro de la caja envolvente (espacio objeto, ver computeBounds)
+  XMFLOAT3 m_boundsExtents;              // Semiejes de la caja envolvente
+  float m_boundsRadius;                  // Radio de la esfera envolvente centrada en m_boundsCenter
 };
@@ -0,0 +1,98 @@
+#pragma once
+#include "Prerequisites.h"
+
+class MeshComponent;
+
+/**
+ * @class MeshOptimizer
+ * @brief Reordena ndices y vrtices de una malla para aprovechar mejor la GPU.
+ *
+ * - optimizeVertexCache(): reordena los tringulos con el algoritmo de Tom Forsyth
+ *   (puntaje por posicin en un cach LRU simulado + bono por valencia restante),
+ *   para que los vrtices recin transformados se reutilicen antes de salir del
+ *   cach post-transform.
+ * - optimizeVertexFetch(): renumera los vrtices en orden de primer uso, de modo
+ *   que el input assembler lea el vertex buffer casi secuencialmente.
+ * - optimizeOverdraw(): parte la lista ya optimizada en clusters y los ordena de
+ *   "afuera hacia adentro" (Sander et al., "Fast Triangle Reordering for Vertex
+ *   Locality and Reduced Overdraw"), para que el early-z descarte ms pxeles.
+ * - analyzeVertexCache(): simula un cach FIFO y reporta ACMR/ATVR, sin GPU.
+ * - analyzeOverdraw(): rasteriza la malla en CPU desde 6 vistas y reporta el overdraw.
+ *
+ * @note Ninguna operacin cambia la geometra: solo el orden de tringulos y vrtices.
+ */
+class
+  MeshOptimizer {
+public:
+  /// Resultado de simular el cach post-transform sobre una lista de ndices.
+  struct CacheStats {
+    unsigned int transformed = 0;  // Vrtices que el vertex shader tendra que procesar
+    float acmr = 0.0f;             // Average Cache Miss Ratio: transformados / tringulos (ideal ~0.5)
+    float atvr = 0.0f;             // Average Transformed Vertex Ratio: transformados / vrtices nicos (ideal 1.0)
+  };
+
+  /// Resultado de rasterizar la malla en CPU desde varias vistas.
+  struct OverdrawStats {
+    unsigned long long covered = 0;  // Pxeles cubiertos al final de cada vista
+    unsigned long long shaded = 0;   // Pxeles que pasaron el depth test (invocaciones de PS con early-z)
+    float overdraw = 0.0f;           // shaded / covered (ideal 1.0)
+  };
+
+  /// Tamao del cach FIFO usado por analyzeVertexCache() en los reportes.
+  static const unsigned int kReportCacheSize = 16;
+
+  /// Resolucin (por lado) del rasterizador de analyzeOverdraw().
+  static const unsigned int kOverdrawResolution = 256;
+
+  /**
+   * @brief Aplica optimizeVertexCache(), optimizeOverdraw() (si @p overdrawThreshold > 0)
+   * y optimizeVertexFetch() a la malla.
+   *
+   * Actualiza m_numVertex/m_numIndex y el index buffer de 16 bits
+   * (MeshComponent::selectIndexFormat), y reporta ACMR/ATVR (y el overdraw, si se
+   * pidi esa etapa) antes y despus por la salida de depuracin.
+   * Descarta los LODs (MeshComponent::clearLods) y los meshlets existentes; generarlos despus.
+   *
+   * @return false si la malla est vaca o tiene ndices fuera de rango.
+   */
+  static bool optimize(MeshComponent& mesh, float overdrawThreshold = 0.0f);
+
+  /**
+   * @brief Reordena los tringulos de @p indices (listas de 3) para el cach post-transform.
+   * @param vertexCount Nmero de vrtices referenciables (todos los ndices deben ser menores).
+   */
+  static void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount);
+
+  /**
+   * @brief Reordena clusters de tringulos de @p indices para reducir el overdraw.
+   *
+   * Debe aplicarse despus de optimizeVertexCache(). Cada cluster se corta donde el
+   * ACMR acumulado baja a @p threshold veces el de su tramo, as que el ACMR final
+   * empeora como mucho en ese factor (1.05 = 5%).
+   */
+  static void optimizeOverdraw(std::vector<unsigned int>& indices,
+    const std::vector<SimpleVertex>& vertices,
+    float threshold = 1.05f);
+
+  /**
+   * @brief Renumera los vrtices en orden de primer uso y descarta los no referenciados.
+   * @return Nmero de vrtices resultante.
+   */
+  static size_t optimizeVertexFetch(std::vector<SimpleVertex>& vertices,
+    std::vector<unsigned int>& indices);
+
+  /**
+   * @brief Simula un cach FIFO de @p cacheSize entradas sobre @p indices.
+   */
+  static CacheStats analyzeVertexCache(const std::vector<unsigned int>& indices,
+    size_t vertexCount,
+    unsigned int cacheSize = kReportCacheSize);
+
+  /**
+   * @brief Rasteriza la malla con proyeccin ortogrfica desde X, Y y Z
+   * (culling de caras traseras y depth test LESS, como el estado por defecto
+   * de D3D11) y cuenta pxeles sombreados contra pxeles cubiertos.
+   */
+  static OverdrawStats analyzeOverdraw(const std::vector<unsigned int>& indices,
+    const std::vector<SimpleVertex>& vertices);
+};
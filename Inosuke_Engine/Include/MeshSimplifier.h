@@ -0,0 +1,73 @@
+#pragma once
+#include "Prerequisites.h"
+
+class MeshComponent;
+
+/**
+ * @class MeshSimplifier
+ * @brief Simplificacin por colapso de aristas con mtricas cuadrticas (Garland-Heckbert)
+ * y generacin de cadenas de LOD.
+ *
+ * - Los LODs reutilizan el vertex buffer del nivel 0: cada colapso mueve un vrtice
+ *   sobre un vecino existente, as que un LOD es solo otra lista de ndices
+ *   (MeshLod = sub-rango de MeshComponent::m_index).
+ * - Costuras de UV y bordes se preservan: un vrtice cuya posicin comparten
+ *   varias esquinas con distinto UV, o que est en un borde abierto o en una arista
+ *   no manifold, nunca se mueve (aunque otros s pueden colapsar sobre l).
+ * - Es determinista: los colapsos se ordenan por (costo, origen, destino) y se
+ *   aplican en pasadas sin dependencias de hilos ni de direcciones de memoria.
+ */
+class
+  MeshSimplifier {
+public:
+  /**
+   * @brief Simplifica @p indices hasta @p targetIndexCount ndices o hasta que el
+   * siguiente colapso supere @p targetError.
+   *
+   * @param targetError  Error mximo relativo a la extensin de la malla (0.01 = 1%).
+   * @param outError     Si no es nulo, recibe el error alcanzado (misma escala relativa).
+   * @return false si la entrada no es una lista de tringulos vlida.
+   */
+  static bool simplify(const std::vector<SimpleVertex>& vertices,
+    const std::vector<unsigned int>& indices,
+    size_t targetIndexCount,
+    float targetError,
+    std::vector<unsigned int>& outIndices,
+    float* outError = nullptr);
+
+  /**
+   * @brief Genera hasta @p levels niveles (incluido el 0) en MeshComponent::m_lods.
+   *
+   * Cada nivel parte del anterior y apunta a @p ratio de sus tringulos; se detiene
+   * antes si ya no hay colapsos por debajo de @p maxError (relativo). Los ndices
+   * de cada nivel se anexan a m_index y se optimizan para el cach post-transform.
+   */
+  static bool buildLods(MeshComponent& mesh,
+    unsigned int levels = 4,
+    float ratio = 0.5f,
+    float maxError = 0.05f);
+
+  /**
+   * @brief Elige el LOD ms simple cuyo error proyectado no pase de @p maxPixelError pxeles.
+   *
+   * @param viewDepth       Profundidad en espacio de vista del centro del objeto.
+   * @param projection      Matriz de proyeccin de BaseApp (se usa el trmino _22).
+   * @param viewportHeight  Alto del viewport en pxeles.
+   * @note Asume escala de mundo 1; con escala s, pasar viewDepth / s.
+   */
+  static unsigned int selectLod(const MeshComponent& mesh,
+    float viewDepth,
+    const XMMATRIX& projection,
+    float viewportHeight,
+    float maxPixelError = 1.0f);
+
+  /**
+   * @brief Genera la cadena de LODs de @p filename dos veces, verifica que sea
+   * idntica (determinismo) y reporta por nivel tringulos, error estimado,
+   * error medido (distancia de vrtices originales muestreados a la superficie
+   * del LOD) y tiempo.
+   */
+  static bool benchmark(const std::string& filename,
+    unsigned int levels = 4,
+    float ratio = 0.5f);
+};
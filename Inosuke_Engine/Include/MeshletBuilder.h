@@ -0,0 +1,78 @@
+#pragma once
+#include "Prerequisites.h"
+
+class MeshComponent;
+struct Meshlet;
+
+/**
+ * @class MeshletBuilder
+ * @brief Parte los tringulos de una malla en clusters pequeos para culling por cluster.
+ *
+ * build() hace crecer cada cluster desde un tringulo semilla agregando el
+ * tringulo vecino que menos vrtices nuevos aporta (y, a igualdad, el ms
+ * cercano al centro del cluster), hasta llegar a maxVertices o maxTriangles.
+ * Reordena MeshComponent::m_index para que cada cluster sea un sub-rango
+ * contiguo y llena MeshComponent::m_meshlets con su esfera envolvente y su
+ * cono de normales.
+ * Si la malla tiene LODs solo se parte el nivel 0.
+ *
+ * Sobre una malla ya optimizada (MeshOptimizer::optimize) el orden de los
+ * clusters reemplaza al de la malla: dentro de cada cluster los tringulos se
+ * vuelven a ordenar para el cach post-transform (el ACMR sube poco, ver
+ * benchmark()), pero el orden de clusters contra overdraw se pierde.
+ *
+ * En D3D11 no hay mesh shaders: el renderer descarta clusters en CPU con
+ * cullMeshlets() y dibuja los sub-rangos que quedan con DrawIndexed.
+ */
+class
+  MeshletBuilder {
+public:
+  /// Lmites por defecto (los recomendados para mesh shaders; tambin sirven aqu).
+  static const unsigned int kDefaultMaxVertices = 64;
+  static const unsigned int kDefaultMaxTriangles = 124;
+
+  /// Sub-rango de m_index listo para DrawIndexed(count, start, 0).
+  struct IndexRange {
+    unsigned int start;
+    unsigned int count;
+  };
+
+  /**
+   * @brief Construye los meshlets de @p mesh.
+   * @return false si la malla est vaca, no es una lista de tringulos o los lmites son invlidos.
+   */
+  static bool build(MeshComponent& mesh,
+    unsigned int maxVertices = kDefaultMaxVertices,
+    unsigned int maxTriangles = kDefaultMaxTriangles);
+
+  /**
+   * @brief true si el cluster queda completamente de espaldas a la cmara.
+   * @param cameraPosition Posicin de la cmara en el espacio objeto de la malla.
+   */
+  static bool isBackfacing(const Meshlet& meshlet, const XMFLOAT3& cameraPosition);
+
+  /**
+   * @brief Descarta los clusters de espaldas y junta los visibles consecutivos en rangos.
+   * @return Nmero de meshlets visibles.
+   */
+  static size_t cullMeshlets(const MeshComponent& mesh,
+    const XMFLOAT3& cameraPosition,
+    std::vector<IndexRange>& outRanges);
+
+  /**
+   * @brief Carga @p filename (optimizado), construye meshlets @p iterations veces y
+   * reporta el mejor tiempo, la calidad de los clusters (ocupacin, radio medio,
+   * conos tiles y porcentaje descartado por cono desde 6 cmaras) y el ACMR de
+   * la malla optimizada contra el de la partida en meshlets.
+   */
+  static bool benchmark(const std::string& filename,
+    int iterations = 3,
+    unsigned int maxVertices = kDefaultMaxVertices,
+    unsigned int maxTriangles = kDefaultMaxTriangles);
+
+private:
+  static void computeBounds(const std::vector<SimpleVertex>& vertices,
+    const unsigned int* triangles,
+    const std::vector<unsigned int>& meshletVertices,
+    Meshlet& meshlet);
+};
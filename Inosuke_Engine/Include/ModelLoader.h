@@ -2,34 +2,104 @@
 #include "Prerequisites.h"
 #include <unordered_map>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <sstream>
 #include <fstream>
 #include <algorithm>
 
 class MeshComponent;
+class VertexDedupTable;
+class JobSystem;
+struct VertexKey;
 
 /**
  * Loader manual de OBJ (v, vt, vn, f).
  * - Soporta ndices positivos y negativos.
  * - Soporta "v", "v/vt", "v//vn", "v/vt/vn".
  * - Triangulacin por fan para n-gons (tri/quad/...).
+ * - Deduplica esquinas por la tripleta resuelta (pos, uv, normal), no por el
+ *   texto del token: "1/2/3" y "-5/-4/-1" al mismo vrtice comparten ndice.
  * - Genera SimpleVertex { Pos, Tex } para tu layout actual.
+ * - Elige ndices de 16 bits cuando la malla tiene <= 65536 vrtices
+ *   (MeshComponent::selectIndexFormat).
+ * - Por defecto proyecta el archivo en memoria y tokeniza en sitio
+ *   (sin streams ni copias por lnea); la ruta con streams se conserva
+ *   como referencia para benchmark().
+ * - Con Options::threads > 1 (o con Options::jobs) parsea bloques del archivo
+ *   en paralelo y los fusiona en orden, generando la misma malla que la carga
+ *   serial.
+ * - Con Options::useCache guarda la malla en una cach binaria tras el primer
+ *   parseo y en las siguientes cargas la lee directo de ella (MeshCache).
+ * - Con Options::optimize reordena tringulos y vrtices (MeshOptimizer); con
+ *   cach activa la malla optimizada es la que se hornea.
+ * - Con Options::lodLevels genera la cadena de LODs (MeshSimplifier) y, con
+ *   cach activa, la guarda en el .imesh.
+ * - Con Options::buildMeshlets parte la malla final en meshlets para culling
+ *   por cluster y, con cach activa, los guarda en el .imesh.
  */
 class ModelLoader {
 public:
   struct Options {
     bool flipV = true;         
     bool allowNegative = true; 
+    bool memoryMapped = true;  // false = ruta original getline/istringstream
+    unsigned int threads = 1;  // >1 = parseo por bloques en paralelo (0 = todos los ncleos)
+    JobSystem* jobs = nullptr; // Si no es nulo, los bloques se reparten en sus hilos (ignora threads)
+    bool useCache = false;     // Lee/escribe la cach binaria <archivo>.imesh (ver MeshCache)
+    bool optimize = false;     // Reordena para el cach post-transform y el vertex fetch (ver MeshOptimizer)
+    float overdrawThreshold = 0.0f; // Con optimize: >0 ordena clusters contra overdraw (p. ej. 1.05)
+    unsigned int lodLevels = 0; // >1 = genera esa cantidad de niveles de detalle y los hornea (ver MeshSimplifier)
+    bool buildMeshlets = false; // Llena MeshComponent::m_meshlets con los lmites por defecto (ver MeshletBuilder)
   };
 
   static bool loadFromFile(const std::string& filename,
     MeshComponent& outMesh,
     const Options& opts = {});
 
+  /**
+   * Carga el archivo @p iterations veces con cada ruta (streams y memoria
+   * proyectada), reporta el mejor tiempo y los MB/s de cada una por la
+   * salida de depuracin y verifica que ambas generen la misma malla.
+   */
+  static bool benchmark(const std::string& filename, int iterations = 3);
+
+  /**
+   * Carga el archivo en memoria proyectada con 1, 2, 4, ... @p maxThreads hilos,
+   * reporta tiempo, MB/s y aceleracin respecto a 1 hilo, y verifica que todas
+   * las corridas generen exactamente la misma malla que la serial.
+   */
+  static bool benchmarkScaling(const std::string& filename, unsigned int maxThreads = 32);
+
+  /**
+   * Compara el parseo en fro del OBJ contra la carga en caliente desde la
+   * cach binaria (.imesh) y verifica que ambas den la misma malla.
+   */
+  static bool benchmarkCache(const std::string& filename, int iterations = 3);
+
 private:
-  static void processFace(const std::vector<std::string>& faceTokens,
-    std::unordered_map<std::string, unsigned>& uniqueMap,
+  static bool parseStream(const std::string& filename,
+    std::vector<SimpleVertex>& outVertices,
+    std::vector<unsigned>& outIndices,
+    size_t& outBytes,
+    const Options& opts);
+
+  static bool parseMapped(const std::string& filename,
+    std::vector<SimpleVertex>& outVertices,
+    std::vector<unsigned>& outIndices,
+    size_t& outBytes,
+    const Options& opts);
+
+  static void parseChunks(const char* data,
+    size_t size,
+    unsigned int threads,
+    std::vector<SimpleVertex>& outVertices,
+    std::vector<unsigned>& outIndices,
+    const Options& opts);
+
+  static void processFace(const std::vector<std::string_view>& faceTokens,
+    VertexDedupTable& uniqueMap,
+    std::vector<unsigned>& scratch,
     std::vector<SimpleVertex>& outVertices,
     std::vector<unsigned>& outIndices,
     const std::vector<XMFLOAT3>& pos,
@@ -37,7 +107,25 @@ private:
     const std::vector<XMFLOAT3>& norms,
     const Options& opts);
 
+  static bool parseCorner(std::string_view token, int values[3]);
+  static bool resolveCorner(const int values[3],
+    int posCount,
+    int uvCount,
+    int normalCount,
+    bool allowNegative,
+    VertexKey& key);
+  static void addCorner(const VertexKey& key,
+    VertexDedupTable& uniqueMap,
+    std::vector<unsigned>& vidx,
+    std::vector<SimpleVertex>& outVertices,
+    const std::vector<XMFLOAT3>& pos,
+    const std::vector<XMFLOAT2>& uvs,
+    const Options& opts);
+  static void emitFan(const std::vector<unsigned>& vidx, std::vector<unsigned>& outIndices);
+
+  static bool parseFloat(const char*& p, const char* end, float& out);
+  static bool parseInt(const char*& p, const char* end, int& out);
+
   static int  resolveIndex(int idx, int count, bool allowNegative);
-  static void split(const std::string& s, char delim, std::vector<std::string>& out);
   static std::string trim(const std::string& s);
 };
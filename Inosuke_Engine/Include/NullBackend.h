@@ -0,0 +1,382 @@
+#pragma once
+#include "Prerequisites.h"
+#include <chrono>
+
+class SoftwareRasterizer;
+
+/**
+ * @class NullBackend
+ * @brief Backend sin GPU (headless) para Device, DeviceContext y SwapChain.
+ *
+ * Cuando Device::m_nullBackend / DeviceContext::m_nullBackend apuntan a una
+ * instancia, los wrappers no llaman a ID3D11 sino a esta clase, que:
+ * - Crea objetos nulos que implementan las interfaces COM (ID3D11Buffer,
+ *   ID3D11Texture2D, vistas, shaders, input layout, sampler), as que el resto
+ *   del motor los guarda, enlaza y libera igual que los reales.
+ * - Registra cada llamada en m_commands (creacin, UpdateSubresource, Map,
+ *   cambios de estado, clears, draws, Present y queries) con el cuadro en
+ *   que ocurri.
+ * - Emula VSSetConstantBuffers1/PSSetConstantBuffers1 de D3D 11.1 (constant
+ *   buffers enlazados por offset) y queries de evento que se completan
+ *   m_gpuFrameLatency Present() despus de su End(), como una GPU atrasada.
+ * - Mide el costo de CPU de cada cuadro entre beginFrame() y endFrame().
+ * - Opcionalmente ejecuta los draws en un SoftwareRasterizer (m_rasterizer) para
+ *   obtener pixeles sin GPU (pruebas de imagen de referencia).
+ *
+ * No necesita ventana, adaptador ni d3dx11 en tiempo de ejecucin: sirve para
+ * correr BaseApp::update/render en CI y medir llamadas a la API y tiempo de CPU
+ * (ver BaseApp::runHeadless).
+ */
+class
+  NullBackend {
+public:
+  /// Tipos de llamada registrados en el stream de comandos.
+  enum CommandType {
+    CMD_CREATE_BUFFER = 0,
+    CMD_CREATE_TEXTURE2D,
+    CMD_CREATE_RENDER_TARGET_VIEW,
+    CMD_CREATE_DEPTH_STENCIL_VIEW,
+    CMD_CREATE_SHADER_RESOURCE_VIEW,
+    CMD_CREATE_VERTEX_SHADER,
+    CMD_CREATE_PIXEL_SHADER,
+    CMD_CREATE_INPUT_LAYOUT,
+    CMD_CREATE_SAMPLER_STATE,
+    CMD_CREATE_QUERY,
+    CMD_COMPILE_SHADER,
+    CMD_UPDATE_SUBRESOURCE,
+    CMD_MAP,
+    CMD_UNMAP,
+    CMD_RS_SET_VIEWPORTS,
+    CMD_RS_SET_STATE,
+    CMD_IA_SET_INPUT_LAYOUT,
+    CMD_IA_SET_VERTEX_BUFFERS,
+    CMD_IA_SET_INDEX_BUFFER,
+    CMD_IA_SET_PRIMITIVE_TOPOLOGY,
+    CMD_VS_SET_SHADER,
+    CMD_VS_SET_CONSTANT_BUFFERS,
+    CMD_PS_SET_SHADER,
+    CMD_PS_SET_CONSTANT_BUFFERS,
+    CMD_PS_SET_SHADER_RESOURCES,
+    CMD_PS_SET_SAMPLERS,
+    CMD_OM_SET_RENDER_TARGETS,
+    CMD_OM_SET_BLEND_STATE,
+    CMD_CLEAR_RENDER_TARGET_VIEW,
+    CMD_CLEAR_DEPTH_STENCIL_VIEW,
+    CMD_CLEAR_STATE,
+    CMD_DRAW_INDEXED,
+    CMD_DRAW_INDEXED_INSTANCED,
+    CMD_PRESENT,
+    CMD_END_QUERY,
+    CMD_GET_DATA,
+    CMD_COUNT
+  };
+
+  /// Cuadro asignado a los comandos registrados fuera de beginFrame()/endFrame().
+  static const unsigned int kNoFrame = 0xffffffffu;
+
+  /**
+   * @brief Una llamada registrada. El significado de start/count/value depende del tipo:
+   * - Set*: start = primer slot, count = nmero de elementos.
+   * - DrawIndexed: count = ndices, start = ndice inicial, value = vrtice base.
+   * - DrawIndexedInstanced: count = ndices por instancia x instancias, start = primera
+   *   instancia, value = instancias.
+   * - UpdateSubresource / Create*: bytes = tamao de los datos.
+   * - Map: value = D3D11_MAP.
+   * - VS/PSSetConstantBuffers1: value = primera constante del primer buffer.
+   */
+  struct Command {
+    CommandType type;
+    unsigned int frame;
+    const void* object;       ///< Primer objeto enlazado, o el objeto creado
+    unsigned int start;
+    unsigned int count;
+    int value;
+    unsigned long long bytes;
+  };
+
+  /// Totales de un cuadro.
+  struct FrameStats {
+    double cpuMs = 0.0;
+    unsigned int apiCalls = 0;
+    unsigned int stateCalls = 0;
+    unsigned int drawCalls = 0;
+    unsigned long long indexCount = 0;
+    unsigned long long bytesUploaded = 0;
+  };
+
+  NullBackend() = default;
+  ~NullBackend() = default;
+
+  // --- Lado Device: misma firma que ID3D11Device -------------------------------------
+
+  HRESULT CreateBuffer(const D3D11_BUFFER_DESC* pDesc,
+    const D3D11_SUBRESOURCE_DATA* pInitialData,
+    ID3D11Buffer** ppBuffer);
+
+  HRESULT CreateTexture2D(const D3D11_TEXTURE2D_DESC* pDesc,
+    const D3D11_SUBRESOURCE_DATA* pInitialData,
+    ID3D11Texture2D** ppTexture2D);
+
+  HRESULT CreateRenderTargetView(ID3D11Resource* pResource,
+    const D3D11_RENDER_TARGET_VIEW_DESC* pDesc,
+    ID3D11RenderTargetView** ppRTView);
+
+  HRESULT CreateDepthStencilView(ID3D11Resource* pResource,
+    const D3D11_DEPTH_STENCIL_VIEW_DESC* pDesc,
+    ID3D11DepthStencilView** ppDepthStencilView);
+
+  HRESULT CreateShaderResourceView(ID3D11Resource* pResource,
+    const D3D11_SHADER_RESOURCE_VIEW_DESC* pDesc,
+    ID3D11ShaderResourceView** ppSRView);
+
+  HRESULT CreateVertexShader(const void* pShaderBytecode,
+    unsigned int BytecodeLength,
+    ID3D11ClassLinkage* pClassLinkage,
+    ID3D11VertexShader** ppVertexShader);
+
+  HRESULT CreatePixelShader(const void* pShaderBytecode,
+    unsigned int BytecodeLength,
+    ID3D11ClassLinkage* pClassLinkage,
+    ID3D11PixelShader** ppPixelShader);
+
+  HRESULT CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC* pInputElementDescs,
+    unsigned int NumElements,
+    const void* pShaderBytecodeWithInputSignature,
+    unsigned int BytecodeLength,
+    ID3D11InputLayout** ppInputLayout);
+
+  HRESULT CreateSamplerState(const D3D11_SAMPLER_DESC* pSamplerDesc,
+    ID3D11SamplerState** ppSamplerState);
+
+  /// Solo D3D11_QUERY_EVENT.
+  HRESULT CreateQuery(const D3D11_QUERY_DESC* pQueryDesc, ID3D11Query** ppQuery);
+
+  /**
+   * @brief Sustituto de D3DX11CreateShaderResourceViewFromFile: decodifica el
+   * primer mip de un DDS (RGBA/BGRA de 32 bits o DXT1/3/5) a RGBA8. Si el formato
+   * no se reconoce crea una textura blanca 1x1. Falla si el archivo no existe.
+   */
+  HRESULT CreateShaderResourceViewFromFile(const std::string& fileName,
+    ID3D11ShaderResourceView** ppSRView);
+
+  /**
+   * @brief Sustituto de D3DX11CompileFromFile: devuelve un blob con el texto del
+   * archivo como "bytecode". Falla si el archivo no existe.
+   */
+  HRESULT CompileShaderFromFile(const std::string& fileName,
+    const char* szEntryPoint,
+    const char* szShaderModel,
+    ID3DBlob** ppBlobOut);
+
+  // --- Lado DeviceContext / SwapChain: misma firma que ID3D11DeviceContext ---------
+  // Cada llamada se registra y actualiza el estado del pipeline que lee el
+  // rasterizador por software (si hay uno asignado en m_rasterizer).
+
+  void RSSetViewports(unsigned int NumViewports, const D3D11_VIEWPORT* pViewports);
+
+  void RSSetState(ID3D11RasterizerState* pRasterizerState);
+
+  void IASetInputLayout(ID3D11InputLayout* pInputLayout);
+
+  void IASetVertexBuffers(unsigned int StartSlot,
+    unsigned int NumBuffers,
+    ID3D11Buffer* const* ppVertexBuffers,
+    const unsigned int* pStrides,
+    const unsigned int* pOffsets);
+
+  void IASetIndexBuffer(ID3D11Buffer* pIndexBuffer, DXGI_FORMAT Format, unsigned int Offset);
+
+  void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY Topology);
+
+  void VSSetShader(ID3D11VertexShader* pVertexShader);
+
+  void VSSetConstantBuffers(unsigned int StartSlot,
+    unsigned int NumBuffers,
+    ID3D11Buffer* const* ppConstantBuffers);
+
+  /// Como ID3D11DeviceContext1: cada buffer se lee desde pFirstConstant (en constantes de 16 bytes).
+  void VSSetConstantBuffers1(unsigned int StartSlot,
+    unsigned int NumBuffers,
+    ID3D11Buffer* const* ppConstantBuffers,
+    const unsigned int* pFirstConstant,
+    const unsigned int* pNumConstants);
+
+  void PSSetShader(ID3D11PixelShader* pPixelShader);
+
+  void PSSetConstantBuffers(unsigned int StartSlot,
+    unsigned int NumBuffers,
+    ID3D11Buffer* const* ppConstantBuffers);
+
+  void PSSetConstantBuffers1(unsigned int StartSlot,
+    unsigned int NumBuffers,
+    ID3D11Buffer* const* ppConstantBuffers,
+    const unsigned int* pFirstConstant,
+    const unsigned int* pNumConstants);
+
+  void PSSetShaderResources(unsigned int StartSlot,
+    unsigned int NumViews,
+    ID3D11ShaderResourceView* const* ppShaderResourceViews);
+
+  void PSSetSamplers(unsigned int StartSlot,
+    unsigned int NumSamplers,
+    ID3D11SamplerState* const* ppSamplers);
+
+  void OMSetRenderTargets(unsigned int NumViews,
+    ID3D11RenderTargetView* const* ppRenderTargetViews,
+    ID3D11DepthStencilView* pDepthStencilView);
+
+  void OMSetBlendState(ID3D11BlendState* pBlendState, unsigned int SampleMask);
+
+  /// Copia los datos al recurso nulo (buffers y texturas RGBA8 conservan su contenido).
+  void UpdateSubresource(ID3D11Resource* pDstResource,
+    unsigned int DstSubresource,
+    const D3D11_BOX* pDstBox,
+    const void* pSrcData,
+    unsigned int SrcRowPitch,
+    unsigned int SrcDepthPitch);
+
+  /**
+   * @brief Solo buffers D3D11_USAGE_DYNAMIC con CPU_ACCESS_WRITE y WRITE_DISCARD o
+   * WRITE_NO_OVERWRITE; pData apunta al contenido del buffer nulo. Como no hay GPU
+   * real, DISCARD no renombra memoria: los draws ya ejecutados no la leen otra vez.
+   * NO_OVERWRITE sobre un constant buffer requiere m_constantBufferNoOverwrite.
+   */
+  HRESULT Map(ID3D11Resource* pResource,
+    unsigned int Subresource,
+    D3D11_MAP MapType,
+    unsigned int MapFlags,
+    D3D11_MAPPED_SUBRESOURCE* pMappedResource);
+
+  void Unmap(ID3D11Resource* pResource, unsigned int Subresource);
+
+  void ClearRenderTargetView(ID3D11RenderTargetView* pRenderTargetView, const float ColorRGBA[4]);
+
+  void ClearDepthStencilView(ID3D11DepthStencilView* pDepthStencilView,
+    unsigned int ClearFlags,
+    float Depth,
+    UINT8 Stencil);
+
+  void ClearState();
+
+  void DrawIndexed(unsigned int IndexCount, unsigned int StartIndexLocation, int BaseVertexLocation);
+
+  /**
+   * @brief El rasterizador dibuja cada instancia leyendo mWorld y vMeshColor del
+   * slot 1 (ver InstanceBuffer) en lugar de b2.
+   */
+  void DrawIndexedInstanced(unsigned int IndexCountPerInstance,
+    unsigned int InstanceCount,
+    unsigned int StartIndexLocation,
+    int BaseVertexLocation,
+    unsigned int StartInstanceLocation);
+
+  void Present();
+
+  /// Marca el query: se completa m_gpuFrameLatency Present() despus.
+  void End(ID3D11Asynchronous* pAsync);
+
+  /// S_OK y TRUE en pData si el query ya se complet; S_FALSE si sigue pendiente.
+  HRESULT GetData(ID3D11Asynchronous* pAsync, void* pData, unsigned int DataSize, unsigned int GetDataFlags);
+
+  // --- Cuadros y reporte ---------------------------------------------------------------
+
+  /// Abre un cuadro: los comandos siguientes se cuentan en l y empieza el reloj.
+  void beginFrame();
+
+  /// Cierra el cuadro actual y guarda su tiempo de CPU.
+  void endFrame();
+
+  /// Olvida comandos, cuadros y contadores (los objetos vivos se conservan).
+  void reset();
+
+  /// Nmero total de llamadas de @p type registradas.
+  unsigned int callCount(CommandType type) const { return m_callCounts[type]; }
+
+  /// Nombre de la llamada de D3D11 que corresponde a @p type.
+  static const char* commandName(CommandType type);
+
+  /**
+   * @brief Reporta por la salida de depuracin: tiempo de CPU por cuadro
+   * (promedio, mnimo, mximo y p95), llamadas por cuadro y totales por tipo.
+   */
+  void report(const std::string& label) const;
+
+  /**
+   * @brief Reporta los objetos COM que siguen vivos; llamarlo despus de liberar
+   * todo (p. ej. BaseApp::destroy). Si queda alguno, sale como ERROR.
+   * @return true si no queda ninguno.
+   */
+  bool reportLiveObjects(const std::string& label) const;
+
+public:
+  /// Stream de comandos en orden de llamada.
+  std::vector<Command> m_commands;
+
+  /// Estadsticas de cada cuadro cerrado con endFrame().
+  std::vector<FrameStats> m_frames;
+
+  /// Si es false solo se actualizan los contadores (til para corridas largas).
+  bool m_recordCommands = true;
+
+  /// Objetos nulos creados y an no liberados (detecta fugas en destroy()).
+  int m_liveObjects = 0;
+
+  /// Si no es nulo, los draws y los Clear* se ejecutan en este rasterizador (no es dueo).
+  SoftwareRasterizer* m_rasterizer = nullptr;
+
+  /// Cuadros que la "GPU" va atrasada: Present() que tarda en completarse un query de evento.
+  unsigned int m_gpuFrameLatency = 2;
+
+  /// Emula VS/PSSetConstantBuffers1 (D3D 11.1); en false se comporta como un runtime 11.0.
+  bool m_constantBufferOffsets = true;
+
+  /// Emula MapNoOverwriteOnDynamicConstantBuffer; en false Map() rechaza
+  /// WRITE_NO_OVERWRITE sobre constant buffers, como un driver sin esa capacidad.
+  bool m_constantBufferNoOverwrite = true;
+
+private:
+  /// Slots de constant buffers que se siguen (los que usa el motor).
+  static const unsigned int kConstantBufferSlots = 4;
+
+  /// Estado enlazado que lee el rasterizador. No toma referencias: ClearState() lo olvida.
+  struct PipelineState {
+    ID3D11Buffer* vertexBuffer = nullptr;
+    unsigned int vertexStride = 0;
+    unsigned int vertexOffset = 0;
+    ID3D11Buffer* instanceBuffer = nullptr;   ///< Slot 1: atributos por instancia
+    unsigned int instanceStride = 0;
+    unsigned int instanceOffset = 0;
+    ID3D11Buffer* indexBuffer = nullptr;
+    DXGI_FORMAT indexFormat = DXGI_FORMAT_UNKNOWN;
+    unsigned int indexOffset = 0;
+    ID3D11Buffer* vsConstantBuffers[kConstantBufferSlots] = {};
+    unsigned int vsFirstConstants[kConstantBufferSlots] = {};
+    ID3D11Buffer* psConstantBuffers[kConstantBufferSlots] = {};
+    unsigned int psFirstConstants[kConstantBufferSlots] = {};
+    ID3D11ShaderResourceView* psResource = nullptr;
+    D3D11_VIEWPORT viewport = {};
+  };
+
+  void record(CommandType type,
+    const void* object = nullptr,
+    unsigned int start = 0,
+    unsigned int count = 0,
+    int value = 0,
+    unsigned long long bytes = 0);
+
+  /// Con @p InstanceCount = 0 es un draw sin instancias (constantes de objeto en b2).
+  void rasterize(unsigned int IndexCount,
+    unsigned int StartIndexLocation,
+    int BaseVertexLocation,
+    unsigned int InstanceCount = 0,
+    unsigned int StartInstanceLocation = 0);
+
+  HRESULT checkFile(const std::string& fileName, const char* method, unsigned long long* outSize);
+
+  PipelineState m_state;
+
+  unsigned int m_callCounts[CMD_COUNT] = {};
+  unsigned int m_frame = kNoFrame;
+  unsigned long long m_presentCount = 0;
+  std::chrono::high_resolution_clock::time_point m_frameStart;
+};
@@ -0,0 +1,149 @@
+#pragma once
+#include "Prerequisites.h"
+
+class MeshComponent;
+class JobSystem;
+
+/**
+ * @class OcclusionCuller
+ * @brief Descarte por oclusin en CPU con un buffer de profundidad de baja
+ * resolucin.
+ *
+ * En cada cuadro se rasterizan unos pocos oclusores grandes (mallas de
+ * MeshComponent, opcionalmente un LOD simplificado) y despus se prueban las
+ * cajas de los objetos que pasaron el frustum: un objeto est oculto si en todos
+ * los pixeles que cubre su caja hay un oclusor ms cercano que el punto ms
+ * cercano de la caja.
+ *
+ * Para que la prueba sea conservadora (nunca descarta algo que se ve), un
+ * oclusor escribe solo en los pixeles que cubre por completo y con la
+ * profundidad ms lejana del tringulo dentro del pixel.
+ *
+ * El buffer se divide en franjas de kTileHeight filas que se rasterizan en
+ * paralelo, 4 pixeles por instruccin SSE. Al terminar cada franja se guarda la
+ * profundidad mxima de cada tile de kTileWidth x kTileHeight: si el punto ms
+ * cercano de la caja queda detrs de ese mximo, el tile entero la tapa y no hay
+ * que mirar sus pixeles.
+ *
+ * Profundidad como en D3D: 0 cerca, 1 lejos.
+ */
+class
+  OcclusionCuller {
+public:
+  /// Ancho de un tile del buffer jerrquico en pixeles.
+  static const unsigned int kTileWidth = 32;
+
+  /// Alto de un tile y de una franja de trabajo en pixeles.
+  static const unsigned int kTileHeight = 8;
+
+  /// Implementacin de rasterize() e isVisible().
+  enum Path {
+    PATH_SSE = 0,
+    PATH_SCALAR
+  };
+
+  /// Contadores acumulados desde init() o resetStats().
+  struct Stats {
+    unsigned long long occluders = 0;
+    unsigned long long triangles = 0;            ///< Tringulos de entrada de los oclusores
+    unsigned long long trianglesRasterized = 0;  ///< Frontales y dentro de pantalla (tras recortar)
+    unsigned long long occludeesTested = 0;
+    unsigned long long occludeesCulled = 0;
+    unsigned long long tilesRejected = 0;        ///< Tiles resueltos solo con la profundidad mxima
+    unsigned long long frames = 0;               ///< Llamadas a rasterize()
+    double rasterMs = 0.0;
+  };
+
+  OcclusionCuller() = default;
+  ~OcclusionCuller() = default;
+
+  /**
+   * @brief Reserva el buffer de profundidad.
+   * @param threads Hilos de rasterize() (incluye al que llama); 0 = hardware_concurrency().
+   */
+  HRESULT init(unsigned int width, unsigned int height, unsigned int threads = 0);
+
+  /// Libera los buffers.
+  void destroy();
+
+  bool isValid() const { return m_width != 0; }
+
+  /// Empieza un cuadro con la cmara @p viewProjection y olvida los oclusores anteriores.
+  void beginFrame(const XMMATRIX& viewProjection);
+
+  /**
+   * @brief Agrega los tringulos de @p mesh transformados por @p world.
+   * @param lod ndice en MeshComponent::m_lods (se limita al ltimo); sin LODs se
+   *            usa el nivel 0. Un LOD simplificado puede salirse un poco de la
+   *            malla original y tapar de ms.
+   */
+  void addOccluder(const MeshComponent& mesh, const XMMATRIX& world, unsigned int lod = 0);
+
+  /**
+   * @brief Rasteriza los oclusores agregados desde beginFrame() y arma el buffer
+   * jerrquico. Con @p jobs las franjas se reparten en sus hilos en lugar de los
+   * de init().
+   */
+  void rasterize(Path path = PATH_SSE, JobSystem* jobs = nullptr);
+
+  /**
+   * @brief Prueba la caja (@p center, @p extents) en espacio mundo contra el
+   * buffer. Una caja que cruza el plano cercano siempre es visible. Solo lee el
+   * buffer, pero actualiza m_stats: no llamarla desde varios hilos a la vez.
+   */
+  bool isVisible(const XMFLOAT3& center, const XMFLOAT3& extents, Path path = PATH_SSE) const;
+
+  /// Olvida los contadores.
+  void resetStats() { m_stats = Stats(); }
+
+  /// Reporta los contadores por la salida de depuracin.
+  void report(const std::string& label) const;
+
+  unsigned int getWidth() const { return m_width; }
+  unsigned int getHeight() const { return m_height; }
+
+  /// Profundidad del pixel (x, y) tras rasterize().
+  float depth(unsigned int x, unsigned int y) const { return m_depth[y * m_pitch + x]; }
+
+  /**
+   * @brief Rasteriza paredes como oclusores y prueba @p occludeeCount cajas
+   * aleatorias (tras el frustum) durante @p iterations repeticiones con cada
+   * implementacin; reporta ms de raster y ns por caja.
+   * @return false si SSE difiere del escalar o si alguna caja descartada tiene un
+   *         punto que se ve desde la cmara.
+   */
+  static bool benchmark(unsigned int occludeeCount = 100000, int iterations = 10);
+
+public:
+  mutable Stats m_stats;
+
+private:
+  /// Tringulo en pixeles listo para la prueba de cobertura completa.
+  struct Triangle {
+    float edgeA[3], edgeB[3], edgeC[3];   ///< E = A*px + B*py + C; cubre el pixel si E >= 0 en las 3
+    float zA, zB, zC;                     ///< Profundidad ms lejana dentro del pixel (px, py)
+    float zMax;
+    int minX, minY, maxX, maxY;
+  };
+
+  /// Agrega el tringulo (espacio de recorte, ya recortado al plano cercano) si es frontal.
+  void addTriangle(const XMFLOAT4& v0, const XMFLOAT4& v1, const XMFLOAT4& v2);
+
+  /// Limpia, rasteriza y arma los tiles de la franja @p band.
+  void rasterizeBand(unsigned int band, Path path);
+
+private:
+  unsigned int m_width = 0;
+  unsigned int m_height = 0;
+  unsigned int m_pitch = 0;            ///< Ancho con relleno a mltiplo de kTileWidth
+  unsigned int m_tilesX = 0;
+  unsigned int m_bands = 0;
+  unsigned int m_threads = 1;
+
+  XMFLOAT4X4 m_viewProjection;
+  std::vector<XMFLOAT4> m_clip;        ///< Vrtices del oclusor actual en espacio de recorte
+  std::vector<float> m_depth;
+  std::vector<float> m_tileMax;        ///< Profundidad mxima por tile
+  std::vector<Triangle> m_triangles;
+  std::vector<std::vector<unsigned int>> m_bins;   ///< Tringulos por franja
+};
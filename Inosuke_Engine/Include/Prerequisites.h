@@ -9,6 +9,7 @@
 #include <Windows.h>
 #include <xnamath.h>
 #include <thread>
+#include <cstdio>
 
 //--------------------------------------------------------------------------------------
 // Libreras de DirectX necesarias para renderizado y compilacin de shaders
@@ -16,6 +17,18 @@
 #include <d3d11.h>
 #include <d3dx11.h>
 #include <d3dcompiler.h>
+
+// D3D 11.1 (ID3D11DeviceContext1: constant buffers por offset) solo est en el
+// Windows SDK 8 o posterior; con el DirectX SDK de junio 2010 solo queda D3D 11.0.
+#if defined(__has_include)
+#if __has_include(<d3d11_1.h>)
+#include <d3d11_1.h>
+#define INOSUKE_D3D11_1 1
+#endif
+#endif
+#ifndef INOSUKE_D3D11_1
+#define INOSUKE_D3D11_1 0
+#endif
 #include "Resource.h"
 #include "resource.h"
 
@@ -30,6 +43,13 @@
 /// Libera de forma segura un recurso COM y lo establece en nullptr.
 #define SAFE_RELEASE(x) if(x != nullptr) x->Release(); x = nullptr;
 
+/// Con true, MESSAGE y ERROR adems escriben en stdout/stderr (-bench, -headless).
+inline bool&
+logToConsole() {
+  static bool enabled = false;
+  return enabled;
+}
+
 /// Macro para mostrar un mensaje informativo en la salida de depuracin.
 #define MESSAGE(classObj, method, state)                       \
 {                                                              \
@@ -37,6 +57,8 @@
    os_ << classObj << "::" << method                           \
        << " : " << "[CREATION OF RESOURCE : " << state << "]\n"; \
    OutputDebugStringW(os_.str().c_str());                      \
+   if (logToConsole())                                         \
+       fputws(os_.str().c_str(), stdout);                      \
 }
 
 /// Macro para mostrar un mensaje de error en la salida de depuracin.
@@ -48,6 +70,8 @@
         os_ << L"ERROR : " << classObj << L"::" << method        \
             << L" : " << errorMSG << L"\n";                      \
         OutputDebugStringW(os_.str().c_str());                   \
+        if (logToConsole())                                      \
+            fputws(os_.str().c_str(), stderr);                   \
     } catch (...) {                                              \
         OutputDebugStringW(L"Failed to log error message.\n");   \
     }                                                            \
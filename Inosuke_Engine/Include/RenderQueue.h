@@ -0,0 +1,262 @@
+#pragma once
+#include "Prerequisites.h"
+#include <unordered_map>
+
+class Buffer;
+class CommandList;
+class ConstantBufferRing;
+class DeviceContext;
+class InstanceBuffer;
+class JobSystem;
+class SamplerState;
+class ShaderProgram;
+class Texture;
+
+/**
+ * @class RenderQueue
+ * @brief Cola de draws ordenada por llave de 64 bits.
+ *
+ * Los sistemas llaman a submit() con un DrawPacket (malla, ShaderProgram,
+ * Texture, SamplerState y constantes por objeto) y su profundidad en vista.
+ * sort() ordena los paquetes por su llave con radix sort (LSD, estable, 8 bits
+ * por pasada) y execute() los dibuja enlazando solo lo que cambia entre un
+ * paquete y el anterior.
+ *
+ * Llave de PASS_OPAQUE (bits altos a bajos):
+ *   pass(4) | cubeta de profundidad(4) | shader(12) | textura(12) | sampler(4) | malla(12) | profundidad fina(16)
+ * Las 16 cubetas dan un orden grueso de adelante hacia atrs (early-z); dentro
+ * de una cubeta los paquetes quedan agrupados por estado y, con el mismo
+ * estado, de adelante hacia atrs.
+ *
+ * Llave de PASS_TRANSPARENT:
+ *   pass(4) | profundidad invertida(20) | shader(12) | textura(12) | sampler(4) | malla(12)
+ * De atrs hacia adelante; el estado solo desempata.
+ *
+ * Con un InstanceBuffer, execute() agrupa los paquetes consecutivos (ya
+ * ordenados) con la misma malla, material e instancedShader en un solo
+ * DrawIndexedInstanced. Agrupar solo vecinos respeta el orden de la llave, as
+ * que tambin vale para la pasada transparente.
+ *
+ * executeDeferred() parte los paquetes ordenados en rangos contiguos que se
+ * graban en paralelo en contextos diferidos y ejecuta las listas en orden de
+ * rango, as que los draws salen en el mismo orden que con execute().
+ *
+ * Los ids de shader, textura, sampler y malla se asignan en el primer submit()
+ * de cada objeto y se conservan entre cuadros. Si hay ms objetos que ids
+ * posibles, los ids se repiten: el orden agrupa peor, pero execute() compara
+ * punteros y el resultado es correcto.
+ */
+class
+  RenderQueue {
+public:
+  /// Paquetes consecutivos necesarios para usar DrawIndexedInstanced.
+  static const unsigned int kMinBatchSize = 2;
+
+  enum Pass {
+    PASS_OPAQUE = 0,
+    PASS_TRANSPARENT = 1,
+    PASS_COUNT
+  };
+
+  /// Todo lo necesario para un DrawIndexed. Los punteros deben vivir hasta execute().
+  struct DrawPacket {
+    Buffer* vertexBuffer = nullptr;
+    Buffer* indexBuffer = nullptr;
+    ShaderProgram* shader = nullptr;
+    ShaderProgram* instancedShader = nullptr;   ///< Variante "VSInstanced"; nula = el paquete no se agrupa
+    Texture* texture = nullptr;
+    SamplerState* sampler = nullptr;
+    unsigned int indexCount = 0;
+    unsigned int startIndex = 0;
+    int baseVertex = 0;
+    CBChangesEveryFrame constants;   ///< Se sube al buffer de objeto antes del draw
+  };
+
+  /// Contadores del ltimo sort()/execute().
+  struct Stats {
+    unsigned int packets = 0;
+    unsigned int shaderChanges = 0;
+    unsigned int textureChanges = 0;
+    unsigned int samplerChanges = 0;
+    unsigned int meshChanges = 0;     ///< Vertex o index buffer distinto
+    unsigned int drawCalls = 0;
+    unsigned int instancedBatches = 0;
+    unsigned int instancedPackets = 0;  ///< Paquetes dibujados dentro de un lote
+    unsigned int sortPasses = 0;      ///< Pasadas de radix que no se pudieron omitir
+    double sortMs = 0.0;
+    double executeMs = 0.0;
+    double recordMs = 0.0;            ///< executeDeferred(): grabacin en paralelo (pared)
+    double recordThreadMs = 0.0;      ///< executeDeferred(): suma del tiempo de grabacin de cada lista
+    double mergeMs = 0.0;             ///< executeDeferred(): ExecuteCommandList de todas las listas
+  };
+
+  /// Enlaza en un contexto diferido el estado que comparte el cuadro.
+  typedef void (*BindFunction)(void* data, DeviceContext& deviceContext);
+
+  RenderQueue() = default;
+  ~RenderQueue() = default;
+
+  /// Rango de profundidad en vista que se cuantiza en la llave; fuera de l se satura.
+  void setDepthRange(float nearZ, float farZ);
+
+  /// Vaca los paquetes del cuadro anterior (los ids se conservan).
+  void begin();
+
+  /**
+   * @brief Agrega un paquete.
+   * @param viewDepth Profundidad del objeto en espacio de vista (z de su centro).
+   */
+  void submit(const DrawPacket& packet, float viewDepth, Pass pass = PASS_OPAQUE);
+
+  /// Ordena los paquetes por llave.
+  void sort();
+
+  /**
+   * @brief Dibuja los paquetes en orden.
+   *
+   * Enlaza @p objectConstants en el slot 2 de VS y PS y lo actualiza con las
+   * constantes de cada paquete antes de su DrawIndexed. Los constant buffers del
+   * cuadro (b0, b1), render targets y viewport son responsabilidad del llamador.
+   */
+  void execute(DeviceContext& deviceContext, Buffer& objectConstants);
+
+  /**
+   * @brief Igual que execute(), pero las constantes de cada paquete se reservan
+   * en @p ring y se enlazan por offset en el slot 2 de VS y PS.
+   */
+  void execute(DeviceContext& deviceContext, ConstantBufferRing& ring);
+
+  /**
+   * @brief Igual que execute() con @p ring, pero los grupos de al menos
+   * kMinBatchSize paquetes agrupables se copian a @p instances y se dibujan con
+   * DrawIndexedInstanced y su instancedShader.
+   */
+  void execute(DeviceContext& deviceContext, ConstantBufferRing& ring, InstanceBuffer& instances);
+
+  /**
+   * @brief Igual que execute() con @p objectConstants, pero grabando en paralelo.
+   *
+   * Los paquetes ordenados se parten en contexts.size() rangos contiguos; el
+   * rango i se graba en contexts[i] (creado con DeviceContext::initDeferred) y
+   * lists[i] desde los hilos de @p jobs. Despus las listas se ejecutan en
+   * @p deviceContext en orden de rango, sin importar qu hilo grab cada una.
+   *
+   * Cada lista empieza sin estado: @p bindFrameState enlaza en cada contexto lo
+   * que comparte el cuadro (render targets, viewport, constant buffers b0/b1).
+   * Las constantes por objeto se suben con UpdateSubresource, porque los
+   * contextos diferidos no permiten los Map de ConstantBufferRing.
+   */
+  void executeDeferred(DeviceContext& deviceContext,
+    std::vector<DeviceContext>& contexts,
+    std::vector<CommandList>& lists,
+    Buffer& objectConstants,
+    JobSystem& jobs,
+    BindFunction bindFrameState = nullptr,
+    void* data = nullptr);
+
+  /// Olvida los paquetes y los ids asignados.
+  void clear();
+
+  size_t size() const { return m_packets.size(); }
+
+  /// Llave del i-simo paquete despus de sort().
+  unsigned long long
+  sortedKey(size_t i) const { return m_entries[i].key; }
+
+  /// Arma una llave a partir de sus campos (ya recortados a su nmero de bits).
+  static unsigned long long makeKey(Pass pass,
+    unsigned int depth,
+    unsigned int shaderId,
+    unsigned int textureId,
+    unsigned int samplerId,
+    unsigned int meshId);
+
+  /**
+   * @brief Enva @p packetCount paquetes (8 shaders, 64 texturas, 2 samplers y
+   * 16 mallas, en orden aleatorio) durante @p frames cuadros sobre NullBackend
+   * y reporta por cuadro el costo de submit, sort y execute (con UpdateSubresource
+   * por objeto y con ConstantBufferRing), y los cambios de estado contra el orden
+   * de envo.
+   * @return false si algn cuadro queda mal ordenado.
+   */
+  static bool benchmark(unsigned int packetCount = 100000, int frames = 10);
+
+  /**
+   * @brief Enva @p packetCount copias de 4 mallas con 4 texturas durante
+   * @p frames cuadros y compara execute() con ConstantBufferRing contra el camino
+   * instanciado (draws, bytes subidos y tiempo). Antes dibuja una escena chica
+   * de las dos formas en un SoftwareRasterizer.
+   * @return false si las dos imgenes difieren.
+   */
+  static bool benchmarkInstancing(unsigned int packetCount = 100000, int frames = 10);
+
+  /**
+   * @brief Graba @p packetCount paquetes (la escena de benchmark()) con
+   * executeDeferred() en listas del motor sobre NullBackend, con 1, 2, 4...
+   * hasta @p maxThreads hilos (0 = todos los ncleos) y una lista por hilo, y
+   * reporta por cuadro el tiempo de grabacin, los comandos por ms de cada hilo
+   * y el costo de ejecutar las listas, contra execute().
+   * @return false si los draws ejecutados difieren de execute() o el stream de
+   *         comandos cambia segn cuntos hilos grabaron las mismas listas.
+   */
+  static bool benchmarkDeferred(unsigned int packetCount = 100000, unsigned int maxThreads = 0, int frames = 10);
+
+public:
+  Stats m_stats;
+
+private:
+  /// Ids asignados por objeto; recuerda el ltimo para envos consecutivos.
+  struct IdTable {
+    std::unordered_map<const void*, unsigned int> ids;
+    const void* last = nullptr;
+    unsigned int lastId = 0;
+  };
+
+  struct SortEntry {
+    unsigned long long key;
+    unsigned int index;
+  };
+
+  static unsigned int lookupId(IdTable& table, const void* object, unsigned int mask);
+
+  /// true si @p b se puede dibujar en el mismo lote instanciado que @p a.
+  static bool canBatch(const DrawPacket& a, const DrawPacket& b);
+
+  /**
+   * Sube las constantes con @p objectConstants o, si es nulo, con @p ring. Si
+   * @p instances no es nulo agrupa paquetes en lotes instanciados.
+   */
+  void executePackets(DeviceContext& deviceContext,
+    Buffer* objectConstants,
+    ConstantBufferRing* ring,
+    InstanceBuffer* instances);
+
+  /**
+   * Dibuja los paquetes ordenados [@p begin, @p end) como executePackets() y suma
+   * los cambios y draws en @p stats. Solo escribe en @p instanceData (con
+   * @p instances), as que rangos distintos se pueden grabar a la vez.
+   */
+  void recordPackets(DeviceContext& deviceContext,
+    size_t begin,
+    size_t end,
+    Buffer* objectConstants,
+    ConstantBufferRing* ring,
+    InstanceBuffer* instances,
+    Stats& stats,
+    std::vector<CBChangesEveryFrame>& instanceData) const;
+
+private:
+  float m_nearZ = 0.1f;
+  float m_depthScale = 1.0f / 100.0f;   ///< 1 / (far - near)
+
+  std::vector<DrawPacket> m_packets;
+  std::vector<SortEntry> m_entries;
+  std::vector<SortEntry> m_scratch;
+  std::vector<CBChangesEveryFrame> m_instanceData;   ///< Constantes del lote en armado
+  std::vector<Stats> m_rangeStats;                   ///< Por lista en executeDeferred()
+
+  IdTable m_shaderIds;
+  IdTable m_textureIds;
+  IdTable m_samplerIds;
+  IdTable m_meshIds;
+};
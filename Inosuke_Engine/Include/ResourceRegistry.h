@@ -0,0 +1,384 @@
+#pragma once
+#include "Prerequisites.h"
+#include "Buffer.h"
+#include "Texture.h"
+#include "SamplerState.h"
+#include "ShaderProgram.h"
+#include <deque>
+#include <memory>
+
+/**
+ * @brief Referencia de 32 bits a un recurso de un ResourcePool: 20 bits de
+ * ndice y 12 de generacin. La generacin cambia cuando el recurso se libera,
+ * as que un handle viejo no resuelve al objeto que reutilice su lugar.
+ * El valor 0 es el handle nulo (las generaciones empiezan en 1).
+ */
+template<typename T>
+struct ResourceHandle {
+  static const unsigned int kIndexBits = 20;
+  static const unsigned int kIndexMask = (1u << kIndexBits) - 1;
+  static const unsigned int kGenerationMask = (1u << (32 - kIndexBits)) - 1;
+
+  unsigned int value = 0;
+
+  bool isNull() const { return value == 0; }
+  unsigned int index() const { return value & kIndexMask; }
+  unsigned int generation() const { return value >> kIndexBits; }
+
+  bool operator==(const ResourceHandle& other) const { return value == other.value; }
+  bool operator!=(const ResourceHandle& other) const { return value != other.value; }
+};
+
+typedef ResourceHandle<Buffer> BufferHandle;
+typedef ResourceHandle<Texture> TextureHandle;
+typedef ResourceHandle<SamplerState> SamplerHandle;
+typedef ResourceHandle<ShaderProgram> ShaderHandle;
+
+/**
+ * @class ResourcePool
+ * @brief Guarda los wrappers de un tipo en bloques contiguos de kChunkSize que
+ * no se mueven al crecer: los punteros de get() siguen vlidos hasta que el
+ * recurso se destruye (los usan RenderQueue::DrawPacket y FramePipeline).
+ *
+ * release() invalida el handle en el momento, pero la destruccin (destroy()
+ * del wrapper) queda en espera hasta que collect() reciba que ya se renderiz
+ * el cuadro en que se liber: los paquetes en vuelo pueden seguir usndolo. El
+ * lugar se reutiliza despus, en orden FIFO para que una misma generacin
+ * tarde en repetirse.
+ *
+ * No es seguro entre hilos: se crea, libera y recolecta desde el hilo de update().
+ */
+template<typename T>
+class
+  ResourcePool {
+public:
+  /// Objetos por bloque.
+  static const unsigned int kChunkSize = 256;
+
+  /// Bytes de memoria (de GPU, estimados) del recurso; se mide al crearlo.
+  typedef size_t (*MemoryFunction)(const T& object);
+
+  struct Stats {
+    unsigned int live = 0;              ///< Recursos con handle vlido
+    unsigned int pending = 0;           ///< Liberados, esperando a que se retire su cuadro
+    unsigned long long created = 0;
+    unsigned long long destroyed = 0;
+    unsigned long long staleLookups = 0;  ///< get() con un handle viejo
+    size_t bytes = 0;                   ///< Memoria de los vivos y pendientes
+    size_t peakBytes = 0;
+  };
+
+  ResourcePool(const char* name, MemoryFunction memory) : m_name(name), m_memory(memory) {}
+  ~ResourcePool() = default;
+  ResourcePool(const ResourcePool&) = delete;
+  ResourcePool& operator=(const ResourcePool&) = delete;
+
+  /**
+   * @brief Reserva un lugar y llama a T::init(args...). Si init() falla el lugar
+   * se devuelve y @p handle queda nulo.
+   */
+  template<typename... Args>
+  HRESULT
+  create(ResourceHandle<T>& handle, Args&&... args) {
+    T* object = add(handle);
+    if (!object) {
+      return E_OUTOFMEMORY;
+    }
+    HRESULT hr = object->init(std::forward<Args>(args)...);
+    if (FAILED(hr)) {
+      discard(handle);
+      return hr;
+    }
+    updateMemory(handle);
+    return S_OK;
+  }
+
+  /**
+   * @brief Reserva un lugar con un T sin inicializar, para recursos que llena
+   * otra clase (p. ej. el back buffer de SwapChain::init). Despus hay que llamar
+   * a updateMemory().
+   * @return nullptr si el pool est lleno.
+   */
+  T*
+  add(ResourceHandle<T>& handle) {
+    handle = ResourceHandle<T>();
+    unsigned int index;
+    if (!m_free.empty()) {
+      index = m_free.front();
+      m_free.pop_front();
+    }
+    else {
+      index = (unsigned int)m_slots.size();
+      if (index > ResourceHandle<T>::kIndexMask) {
+        ERROR("ResourcePool", "add", "Pool is full");
+        return nullptr;
+      }
+      if (index % kChunkSize == 0) {
+        m_chunks.emplace_back(new T[kChunkSize]);
+      }
+      m_slots.push_back(Slot());
+    }
+    Slot& slot = m_slots[index];
+    slot.alive = true;
+    slot.bytes = 0;
+    handle.value = (slot.generation << ResourceHandle<T>::kIndexBits) | index;
+    ++m_stats.live;
+    ++m_stats.created;
+    return &object(index);
+  }
+
+  /// Objeto de @p handle o nullptr si es nulo, ya se liber o es de otra generacin.
+  T*
+  get(ResourceHandle<T> handle) {
+    if (!isValid(handle)) {
+      m_stats.staleLookups += handle.isNull() ? 0 : 1;
+      return nullptr;
+    }
+    return &object(handle.index());
+  }
+
+  bool
+  isValid(ResourceHandle<T> handle) const {
+    const unsigned int index = handle.index();
+    return !handle.isNull() && index < m_slots.size() && m_slots[index].alive &&
+           m_slots[index].generation == handle.generation();
+  }
+
+  /// Vuelve a medir la memoria del recurso (despus de add() o de recrearlo).
+  void
+  updateMemory(ResourceHandle<T> handle) {
+    if (!isValid(handle)) {
+      return;
+    }
+    Slot& slot = m_slots[handle.index()];
+    m_stats.bytes -= slot.bytes;
+    slot.bytes = m_memory(object(handle.index()));
+    m_stats.bytes += slot.bytes;
+    m_stats.peakBytes = (std::max)(m_stats.peakBytes, m_stats.bytes);
+  }
+
+  /**
+   * @brief Invalida @p handle y deja el recurso pendiente de destruir hasta que
+   * collect() reciba un nmero de cuadros renderizados mayor que @p frame.
+   */
+  void
+  release(ResourceHandle<T> handle, unsigned long long frame) {
+    if (!isValid(handle)) {
+      ERROR("ResourcePool", "release", "Stale or null handle");
+      return;
+    }
+    invalidate(handle.index());
+    Pending pending = { handle.index(), frame };
+    m_pending.push_back(pending);
+    ++m_stats.pending;
+  }
+
+  /**
+   * @brief Destruye los recursos liberados en cuadros menores que
+   * @p renderedFrames. @return Recursos destruidos.
+   */
+  unsigned int
+  collect(unsigned long long renderedFrames) {
+    unsigned int collected = 0;
+    while (!m_pending.empty() && m_pending.front().frame < renderedFrames) {
+      destroySlot(m_pending.front().index);
+      m_pending.pop_front();
+      --m_stats.pending;
+      ++collected;
+    }
+    return collected;
+  }
+
+  /// Destruye todo (vivo o pendiente). Los handles dejan de valer.
+  void
+  destroy() {
+    for (unsigned int index = 0; index < m_slots.size(); ++index) {
+      if (m_slots[index].alive) {
+        invalidate(index);
+        destroySlot(index);
+      }
+    }
+    for (const Pending& pending : m_pending) {
+      destroySlot(pending.index);
+    }
+    m_pending.clear();
+    m_free.clear();
+    m_slots.clear();
+    m_chunks.clear();
+    m_stats.live = 0;
+    m_stats.pending = 0;
+    m_stats.bytes = 0;
+  }
+
+  /// Llama function(handle, objeto) por cada recurso vivo, en orden de memoria.
+  template<typename Function>
+  void
+  forEach(const Function& function) {
+    for (unsigned int index = 0; index < m_slots.size(); ++index) {
+      const Slot& slot = m_slots[index];
+      if (slot.alive) {
+        ResourceHandle<T> handle;
+        handle.value = (slot.generation << ResourceHandle<T>::kIndexBits) | index;
+        function(handle, object(index));
+      }
+    }
+  }
+
+  const Stats& stats() const { return m_stats; }
+
+  const char* name() const { return m_name; }
+
+private:
+  struct Slot {
+    unsigned int generation = 1;
+    bool alive = false;
+    size_t bytes = 0;
+  };
+
+  struct Pending {
+    unsigned int index;
+    unsigned long long frame;         ///< ltimo cuadro que pudo usar el recurso
+  };
+
+  T& object(unsigned int index) { return m_chunks[index / kChunkSize][index % kChunkSize]; }
+
+  /// Deja el lugar sin handle vlido (nueva generacin, nunca 0).
+  void
+  invalidate(unsigned int index) {
+    Slot& slot = m_slots[index];
+    slot.alive = false;
+    slot.generation = (slot.generation + 1) & ResourceHandle<T>::kGenerationMask;
+    slot.generation += slot.generation == 0 ? 1 : 0;
+    --m_stats.live;
+  }
+
+  /// add() sin init() vlido: se devuelve el lugar sin esperar a ningn cuadro.
+  void
+  discard(ResourceHandle<T>& handle) {
+    const unsigned int index = handle.index();
+    invalidate(index);
+    destroySlot(index);
+    --m_stats.created;
+    --m_stats.destroyed;
+    handle = ResourceHandle<T>();
+  }
+
+  void
+  destroySlot(unsigned int index) {
+    T& resource = object(index);
+    resource.destroy();
+    resource = T();
+    m_stats.bytes -= m_slots[index].bytes;
+    m_slots[index].bytes = 0;
+    m_free.push_back(index);
+    ++m_stats.destroyed;
+  }
+
+private:
+  const char* m_name;
+  MemoryFunction m_memory;
+  std::vector<std::unique_ptr<T[]>> m_chunks;
+  std::vector<Slot> m_slots;
+  std::deque<unsigned int> m_free;
+  std::deque<Pending> m_pending;       ///< En orden de cuadro
+  Stats m_stats;
+};
+
+/**
+ * @class ResourceRegistry
+ * @brief Dueo de los buffers, texturas, samplers y programas de shaders de la
+ * aplicacin. Se referencian por handle (BufferHandle, TextureHandle...); el
+ * puntero de get() sirve para armar los paquetes del cuadro.
+ *
+ * La destruccin es diferida: release() en el cuadro N deja el recurso vivo
+ * hasta que collect() reciba que el render termin el cuadro N (con
+ * FramePipeline, el render puede ir hasta kMaxLatency cuadros atrs).
+ */
+class
+  ResourceRegistry {
+public:
+  ResourceRegistry()
+    : m_buffers("Buffer", &bufferBytes),
+      m_textures("Texture", &textureBytes),
+      m_samplers("SamplerState", &samplerBytes),
+      m_shaders("ShaderProgram", &shaderBytes) {}
+  ~ResourceRegistry() = default;
+
+  /// Pool de cada tipo (especializaciones al final del archivo).
+  template<typename T>
+  ResourcePool<T>& pool();
+
+  template<typename T, typename... Args>
+  HRESULT
+  create(ResourceHandle<T>& handle, Args&&... args) {
+    return pool<T>().create(handle, std::forward<Args>(args)...);
+  }
+
+  template<typename T>
+  T* add(ResourceHandle<T>& handle) { return pool<T>().add(handle); }
+
+  template<typename T>
+  T* get(ResourceHandle<T> handle) { return pool<T>().get(handle); }
+
+  template<typename T>
+  void updateMemory(ResourceHandle<T> handle) { pool<T>().updateMemory(handle); }
+
+  /// Libera en el cuadro actual (ver beginFrame()) y deja @p handle nulo.
+  template<typename T>
+  void
+  release(ResourceHandle<T>& handle) {
+    pool<T>().release(handle, m_frame);
+    handle = ResourceHandle<T>();
+  }
+
+  /// Nmero del cuadro que se est armando (FramePipeline::FramePacket::frame).
+  void beginFrame(unsigned long long frame) { m_frame = frame; }
+
+  /**
+   * @brief Destruye lo liberado en cuadros que el render ya termin.
+   * @param renderedFrames FramePipeline::renderedFrames().
+   * @return Recursos destruidos.
+   */
+  unsigned int collect(unsigned long long renderedFrames);
+
+  /// Destruye todos los recursos.
+  void destroy();
+
+  /// Reporta recursos vivos, pendientes y memoria de cada tipo.
+  void report(const std::string& label) const;
+
+  /**
+   * @brief Crea y libera @p count buffers por cuadro en NullBackend con latencia
+   * de 2 cuadros y mide create/release/collect, get() contra un puntero y el
+   * recorrido de forEach(). Verifica que un handle viejo no resuelva aunque su
+   * lugar se haya reutilizado y que nada se destruya antes de retirar su cuadro.
+   */
+  static bool benchmark(unsigned int count = 10000, unsigned int frames = 60);
+
+  /// Memoria estimada de cada tipo (MemoryFunction de los pools).
+  static size_t bufferBytes(const Buffer& buffer);
+  static size_t textureBytes(const Texture& texture);
+  static size_t samplerBytes(const SamplerState& sampler);
+  static size_t shaderBytes(const ShaderProgram& shader);
+
+public:
+  ResourcePool<Buffer> m_buffers;
+  ResourcePool<Texture> m_textures;
+  ResourcePool<SamplerState> m_samplers;
+  ResourcePool<ShaderProgram> m_shaders;
+
+private:
+  unsigned long long m_frame = 0;
+};
+
+template<>
+inline ResourcePool<Buffer>& ResourceRegistry::pool<Buffer>() { return m_buffers; }
+
+template<>
+inline ResourcePool<Texture>& ResourceRegistry::pool<Texture>() { return m_textures; }
+
+template<>
+inline ResourcePool<SamplerState>& ResourceRegistry::pool<SamplerState>() { return m_samplers; }
+
+template<>
+inline ResourcePool<ShaderProgram>& ResourceRegistry::pool<ShaderProgram>() { return m_shaders; }
@@ -0,0 +1,170 @@
+#pragma once
+#include "Prerequisites.h"
+#include "FrustumCuller.h"
+#include "FrameArena.h"
+#include <functional>
+
+/**
+ * @class SceneBvh
+ * @brief rbol dinmico de cajas alineadas a los ejes (AABB) con los volmenes en
+ * espacio mundo de los objetos de la escena.
+ *
+ * Cada objeto es una hoja ("proxy") con una caja "gorda": su caja real agrandada
+ * por m_margin y estirada en la direccin del desplazamiento del cuadro. Mientras
+ * la caja real quede dentro de la gorda, moveProxy() no toca el rbol; si sale,
+ * la hoja se quita y se vuelve a insertar.
+ *
+ * La insercin baja por el rbol eligiendo el hijo que menos aumenta el rea de
+ * superficie (costo SAH con el costo heredado de los ancestros) y al subir
+ * reajusta las cajas y rota los nodos cuyos hijos difieren en ms de 1 de altura
+ * (al estilo de un rbol AVL), as que la altura se mantiene cerca de O(log n)
+ * aunque los objetos se muevan.
+ *
+ * Consultas: frustum jerrquico (un nodo completamente dentro agrega su subrbol
+ * sin ms pruebas), rayo con el impacto ms cercano y caja. Los resultados usan
+ * las cajas gordas: son conservadores (pueden incluir objetos que apenas no se
+ * tocan, nunca omiten uno que s).
+ */
+class
+  SceneBvh {
+public:
+  /// ndice nulo de nodo o proxy.
+  static const int kNullNode = -1;
+
+  /// Resultado de rayCast().
+  struct RayHit {
+    unsigned int userData = 0;
+    float distance = 0.0f;   ///< En unidades de la direccin (normalizada = unidades de mundo)
+  };
+
+  /// Contadores acumulados desde el ltimo resetStats().
+  struct Stats {
+    unsigned int moves = 0;          ///< Llamadas a moveProxy()
+    unsigned int reinserts = 0;      ///< Moves que sacaron la caja de su caja gorda
+    unsigned int rotations = 0;
+    unsigned long long nodesVisited = 0;   ///< Nodos probados en consultas
+  };
+
+  /**
+   * @brief Prueba exacta opcional para rayCast(): recibe el userData de una hoja
+   * cuya caja toca el rayo y la distancia de entrada a esa caja; devuelve la
+   * distancia del impacto real o un valor negativo si no hay impacto.
+   */
+  typedef std::function<float(unsigned int userData, float boxDistance)> RayTest;
+
+  SceneBvh() = default;
+  ~SceneBvh() = default;
+
+  /**
+   * @brief Agrega un objeto con caja (@p center, @p extents) en espacio mundo.
+   * @return Id del proxy, estable hasta destroyProxy().
+   */
+  int createProxy(const XMFLOAT3& center, const XMFLOAT3& extents, unsigned int userData);
+
+  /// Quita el proxy y libera su hoja.
+  void destroyProxy(int proxy);
+
+  /**
+   * @brief Actualiza la caja de @p proxy.
+   * @param displacement Movimiento esperado hasta el prximo cuadro: la caja gorda
+   *                     se estira en esa direccin para evitar reinserciones.
+   * @return true si el proxy se reinsert en el rbol.
+   */
+  bool moveProxy(int proxy,
+    const XMFLOAT3& center,
+    const XMFLOAT3& extents,
+    const XMFLOAT3& displacement = XMFLOAT3(0.0f, 0.0f, 0.0f));
+
+  /// Olvida todos los proxies.
+  void clear();
+
+  unsigned int proxyCount() const { return m_proxyCount; }
+
+  /// Altura del rbol (0 con una sola hoja, -1 vaco).
+  int height() const;
+
+  /// Cociente entre la suma de reas de los nodos internos y el rea de la raz.
+  float areaRatio() const;
+
+  /**
+   * @brief Agrega a @p out el userData de los proxies que intersectan @p frustum.
+   * Acepta std::vector y FrameVector (instanciados en SceneBvh.cpp).
+   */
+  template<typename Allocator>
+  void queryFrustum(const FrustumCuller::Frustum& frustum, std::vector<unsigned int, Allocator>& out) const;
+
+  /// Agrega a @p out el userData de los proxies cuya caja toca [minimum, maximum].
+  void queryBox(const XMFLOAT3& minimum, const XMFLOAT3& maximum, std::vector<unsigned int>& out) const;
+
+  /**
+   * @brief Busca el impacto ms cercano del rayo @p origin + t * @p direction con
+   * t en [0, @p maxDistance]. Sin @p exactTest el impacto es la entrada a la caja.
+   * @return false si no hay impacto.
+   */
+  bool rayCast(const XMFLOAT3& origin,
+    const XMFLOAT3& direction,
+    float maxDistance,
+    RayHit& hit,
+    const RayTest& exactTest = RayTest()) const;
+
+  /// Valida padres, alturas y cajas de todo el rbol (para depuracin).
+  bool validate() const;
+
+  void resetStats() { m_stats = Stats(); }
+
+  /**
+   * @brief Mueve @p objectCount objetos aleatorios durante @p frames cuadros y
+   * reporta el costo de moveProxy() por cuadro, las reinserciones, la altura y el
+   * costo de las consultas de frustum y de rayo contra FrustumCuller y una
+   * bsqueda lineal.
+   * @return false si alguna consulta omite un objeto que deba encontrar.
+   */
+  static bool benchmark(unsigned int objectCount = 100000, int frames = 60);
+
+public:
+  /// Crecimiento de la caja gorda en cada eje.
+  float m_margin = 0.2f;
+
+  /// Factor con que se estira la caja gorda en la direccin del desplazamiento.
+  float m_displacementScale = 4.0f;
+
+  mutable Stats m_stats;
+
+private:
+  struct Node {
+    XMFLOAT3 minimum;
+    XMFLOAT3 maximum;
+    int parent;            ///< En la lista libre: siguiente nodo libre
+    int child1;
+    int child2;
+    int height;            ///< Hoja = 0; nodo libre = -1
+    unsigned int userData;
+
+    bool isLeaf() const { return child1 == kNullNode; }
+  };
+
+  int allocateNode();
+  void freeNode(int node);
+  void insertLeaf(int leaf);
+  void removeLeaf(int leaf);
+
+  /// Rota @p node si sus hijos difieren en ms de 1 de altura; devuelve la nueva raz del subrbol.
+  int balance(int node);
+
+  /// Recalcula caja y altura de @p node a partir de sus hijos.
+  void refit(int node);
+
+  int computeHeight(int node) const;
+  bool validateNode(int node) const;
+
+  /// Agrega a @p out el userData de todas las hojas bajo @p node.
+  template<typename Allocator>
+  void collectLeaves(int node, std::vector<unsigned int, Allocator>& out) const;
+
+private:
+  std::vector<Node> m_nodes;
+  int m_root = kNullNode;
+  int m_freeList = kNullNode;
+  unsigned int m_proxyCount = 0;
+  mutable std::vector<int> m_stack;   ///< Pila de recorrido reutilizada por las consultas
+};
@@ -36,6 +36,9 @@ public:
    * @param device   Dispositivo con el que se crearn los recursos.
    * @param fileName Nombre del archivo HLSL que contiene los shaders.
    * @param Layout   Vector con la descripcin de los elementos de entrada (para VS).
+   * @param vertexEntryPoint Funcin del Vertex Shader (p. ej. "VSInstanced" con
+   *                 los atributos por instancia de InstanceBuffer::appendLayout()).
+   * @param pixelEntryPoint Funcin del Pixel Shader (p. ej. "PSInstanced").
    * @return @c S_OK si fue exitoso; cdigo @c HRESULT en caso de error.
    *
    * @post Si retorna @c S_OK, los punteros a shaders y el input layout sern vlidos.
@@ -43,7 +46,9 @@ public:
   HRESULT
     init(Device& device,
       const std::string& fileName,
-      std::vector<D3D11_INPUT_ELEMENT_DESC> Layout);
+      std::vector<D3D11_INPUT_ELEMENT_DESC> Layout,
+      const std::string& vertexEntryPoint = "VS",
+      const std::string& pixelEntryPoint = "PS");
 
   /**
    * @brief Actualiza parmetros internos de los shaders.
@@ -156,12 +161,28 @@ public:
    */
   InputLayout m_inputLayout;
 
+  /**
+   * @brief Bytes de bytecode de los shaders creados (VS + PS).
+   */
+  size_t
+    getBytecodeSize() const { return m_bytecodeSize; }
+
 private:
   /**
    * @brief Nombre del archivo HLSL asociado a este programa de shaders.
    */
   std::string m_shaderFileName;
 
+  /**
+   * @brief Punto de entrada del Vertex Shader dentro de @c m_shaderFileName.
+   */
+  std::string m_vertexEntryPoint = "VS";
+
+  /**
+   * @brief Punto de entrada del Pixel Shader dentro de @c m_shaderFileName.
+   */
+  std::string m_pixelEntryPoint = "PS";
+
   /**
    * @brief Bytecode compilado del Vertex Shader.
    */
@@ -171,4 +192,9 @@ private:
    * @brief Bytecode compilado del Pixel Shader.
    */
   ID3DBlob* m_pixelShaderData = nullptr;
+
+  /**
+   * @brief Suma de @c GetBufferSize() de los shaders creados.
+   */
+  size_t m_bytecodeSize = 0;
 };
\ No newline at end of file
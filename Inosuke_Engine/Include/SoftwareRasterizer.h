@@ -0,0 +1,195 @@
+#pragma once
+#include "Prerequisites.h"
+#include <functional>
+
+class JobSystem;
+
+/**
+ * @class SoftwareRasterizer
+ * @brief Rasterizador por software, multihilo y por tiles, para DrawIndexed sin GPU.
+ *
+ * Emula el pipeline de Inosuke_Engine.fx: transforma SimpleVertex con
+ * CBNeverChanges (b0), CBChangeOnResize (b1) y CBChangesEveryFrame (b2), recorta
+ * contra el plano cercano, descarta caras traseras (frente = horario, como D3D11)
+ * y pinta textura (bilineal, wrap) * vMeshColor con prueba de profundidad LESS.
+ *
+ * Cada draw se ejecuta en tres fases:
+ * 1. Setup en paralelo por grupos de tringulos: ecuaciones de arista y planos
+ *    de z, 1/w, u/w y v/w.
+ * 2. Binning en orden: cada tringulo se agrega a los tiles de kTileSize pixeles
+ *    que toca su caja.
+ * 3. Raster en paralelo por tile: cada tile recorre sus tringulos en orden de
+ *    draw por bloques de kBlockSize x kBlockSize. Un bloque se descarta, se
+ *    acepta completo o se evala pixel a pixel con aristas SSE (4 pixeles a la
+ *    vez). El buffer de profundidad jerrquico (profundidad mxima por bloque)
+ *    descarta bloques ocultos antes de tocar pixeles.
+ *
+ * Las aristas compartidas se evalan siempre en la misma direccin y con la
+ * regla top-left, as que dos tringulos vecinos no pintan ni dejan huecos en
+ * el mismo pixel. Rasteriza una muestra por pixel aunque el depth stencil de la
+ * app use 4x MSAA.
+ *
+ * Las fases en paralelo se reparten con JobSystem::parallelFor; sin JobSystem,
+ * o llamado desde un hilo que no es del sistema (p. ej. la etapa de render de
+ * FramePipeline con latencia), todo corre en el hilo que llama.
+ *
+ * Lo usa NullBackend (m_rasterizer) para obtener la imagen de BaseApp::runHeadless.
+ */
+class
+  SoftwareRasterizer {
+public:
+  /// Lado de un tile en pixeles (unidad de trabajo de un job).
+  static const unsigned int kTileSize = 64;
+
+  /// Lado de un bloque en pixeles (unidad del buffer de profundidad jerrquico).
+  static const unsigned int kBlockSize = 8;
+
+  /// Textura RGBA8 de solo lectura (no es dueo de los texels).
+  struct Texture {
+    const unsigned char* texels = nullptr;
+    unsigned int width = 0;
+    unsigned int height = 0;
+  };
+
+  /// Todo lo que necesita un DrawIndexed; los punteros son del llamador durante el draw.
+  struct DrawCall {
+    const SimpleVertex* vertices = nullptr;
+    unsigned int vertexCount = 0;
+    const void* indices = nullptr;
+    bool indices16 = false;                      ///< DXGI_FORMAT_R16_UINT o R32_UINT
+    unsigned int indexCount = 0;                 ///< ndices disponibles en el buffer
+    unsigned int drawCount = 0;                  ///< IndexCount de DrawIndexed
+    unsigned int startIndex = 0;
+    int baseVertex = 0;
+    const void* neverChanges = nullptr;          ///< Contenido de CBNeverChanges (b0)
+    const void* changeOnResize = nullptr;        ///< Contenido de CBChangeOnResize (b1)
+    const void* changesEveryFrame = nullptr;     ///< Contenido de CBChangesEveryFrame (b2)
+    Texture texture;                             ///< Sin texels se usa blanco
+    D3D11_VIEWPORT viewport = {};
+  };
+
+  /// Contadores acumulados desde init() o resetStats().
+  struct Stats {
+    unsigned long long draws = 0;
+    unsigned long long triangles = 0;            ///< Tringulos de entrada
+    unsigned long long trianglesCulled = 0;      ///< Traseros, degenerados o fuera de pantalla
+    unsigned long long trianglesClipped = 0;     ///< Recortados por el plano cercano
+    unsigned long long binEntries = 0;           ///< Pares (tringulo, tile)
+    unsigned long long blocksHiZRejected = 0;
+    unsigned long long blocksFull = 0;
+    unsigned long long blocksPartial = 0;
+    unsigned long long pixelsWritten = 0;
+    double drawMs = 0.0;
+    double clearMs = 0.0;
+  };
+
+  SoftwareRasterizer() = default;
+  ~SoftwareRasterizer() { destroy(); }
+
+  /**
+   * @brief Reserva color, profundidad y el buffer jerrquico.
+   * @param jobs Hilos para las fases en paralelo (no es dueo; puede iniciarse
+   *             despus); nulo = todo en el hilo que llama.
+   */
+  HRESULT init(unsigned int width, unsigned int height, JobSystem* jobs = nullptr);
+
+  /// Libera los buffers.
+  void destroy();
+
+  /// Llena el color con @p colorRGBA (0..1).
+  void clearColor(const float colorRGBA[4]);
+
+  /// Llena la profundidad con @p depth y reinicia el buffer jerrquico.
+  void clearDepth(float depth);
+
+  /// Ejecuta un DrawIndexed de lista de tringulos. Regresa cuando termin.
+  void drawIndexed(const DrawCall& draw);
+
+  /// Guarda el color como TGA de 24 bits (sin compresin, origen arriba a la izquierda).
+  bool saveTGA(const std::string& fileName) const;
+
+  /// Hash FNV-1a de los pixeles visibles (para comparar contra una imagen de referencia).
+  unsigned long long checksum() const;
+
+  /// Olvida los contadores.
+  void resetStats() { m_stats = Stats(); }
+
+  /// Reporta los contadores por la salida de depuracin.
+  void report(const std::string& label) const;
+
+  unsigned int getWidth() const { return m_width; }
+  unsigned int getHeight() const { return m_height; }
+  /// Hilos de m_jobs (1 sin JobSystem).
+  unsigned int getThreadCount() const;
+
+  /// Color RGBA8 de un pixel (R en el byte bajo).
+  unsigned int
+  pixel(unsigned int x, unsigned int y) const { return m_color[y * m_pitch + x]; }
+
+public:
+  Stats m_stats;
+
+private:
+  /// Vrtice en espacio de recorte con sus coordenadas de textura.
+  struct ClipVertex {
+    float x, y, z, w;
+    float u, v;
+  };
+
+  /**
+   * Tringulo listo para rasterizar. Pixel (px, py) tiene su centro en
+   * coordenadas enteras. Cada arista guarda su vrtice inicial y su direccin
+   * cannicas (las mismas para los dos tringulos que la comparten) y el signo
+   * que la orienta hacia adentro de este tringulo.
+   */
+  struct Triangle {
+    float edgeX[3], edgeY[3];        ///< Vrtice inicial cannico
+    float edgeDx[3], edgeDy[3];      ///< Direccin cannica (b - a)
+    float edgeSign[3];               ///< +1 o -1
+    bool edgeTopLeft[3];             ///< Regla top-left: E == 0 cuenta como adentro
+    float zPlane[3];                 ///< f = a*px + b*py + c para z, 1/w, u/w y v/w
+    float invWPlane[3];
+    float uPlane[3];
+    float vPlane[3];
+    float zMin, zMax;
+    int minX, minY, maxX, maxY;      ///< Caja en pixeles, ya recortada al viewport
+  };
+
+  /// Recorta y arma los tringulos [first, first + count) del draw a partir de m_clip.
+  void setupTriangles(const DrawCall& draw, unsigned int first, unsigned int count,
+    std::vector<Triangle>& out, Stats& stats) const;
+
+  /// Agrega el tringulo (ya en pantalla) si es frontal y toca el viewport.
+  bool addTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2,
+    const D3D11_VIEWPORT& viewport, std::vector<Triangle>& out) const;
+
+  void rasterizeTile(unsigned int tile, Stats& stats);
+
+  /// Ejecuta job(0..jobCount-1) con m_jobs->parallelFor (en orden sin JobSystem).
+  void runParallel(unsigned int jobCount, const std::function<void(unsigned int)>& job);
+
+private:
+  unsigned int m_width = 0;
+  unsigned int m_height = 0;
+  unsigned int m_pitch = 0;          ///< Ancho con relleno a mltiplo de kTileSize
+  unsigned int m_paddedHeight = 0;
+  unsigned int m_tilesX = 0;
+  unsigned int m_tilesY = 0;
+  unsigned int m_blocksX = 0;
+
+  std::vector<unsigned int> m_color;
+  std::vector<float> m_depth;
+  std::vector<float> m_hiZ;          ///< Profundidad mxima por bloque
+
+  int m_scissor[4] = {};             ///< Viewport del draw actual en pixeles (x0, y0, x1, y1)
+  float m_meshColor[4] = {};
+  Texture m_texture;
+
+  std::vector<ClipVertex> m_clip;                   ///< Vrtices transformados del draw actual
+  std::vector<std::vector<Triangle>> m_setup;       ///< Tringulos por grupo de setup
+  std::vector<std::vector<unsigned int>> m_bins;    ///< Tringulos (ndice global) por tile
+  std::vector<const Triangle*> m_triangles;         ///< ndice global -> tringulo
+  std::vector<Stats> m_jobStats;                    ///< Contadores por trabajo de la fase actual
+
+  JobSystem* m_jobs = nullptr;                      ///< No es dueo
+};
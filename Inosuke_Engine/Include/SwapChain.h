@@ -8,6 +8,7 @@ class Device;
 class DeviceContext;
 class Window;
 class Texture;
+class NullBackend;
 
 /**
  * Clase que encapsula un IDXGISwapChain en Direct3D 11.
@@ -34,6 +35,8 @@ public:
    * @return              S_OK si fue exitoso; HRESULT de error en caso contrario.
    *
    * Tras una inicializacin exitosa, m_swapChain ser vlido.
+   * Si device.m_nullBackend est asignado no se crea device, contexto ni swap
+   * chain: solo un back buffer nulo de window.m_width x window.m_height.
    */
   HRESULT init(Device& device,
     DeviceContext& deviceContext,
@@ -86,4 +89,7 @@ private:
 
   /// Interfaz DXGI para la fbrica (creacin de swap chains).
   IDXGIFactory* m_dxgiFactory = nullptr;
+
+  /// Backend headless tomado de Device en init(); Present solo se registra.
+  NullBackend* m_nullBackend = nullptr;
 };
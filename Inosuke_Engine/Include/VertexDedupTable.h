@@ -0,0 +1,108 @@
+#pragma once
+#include "Prerequisites.h"
+
+/**
+ * @brief Esquina de cara ya resuelta a ndices absolutos (base 0).
+ *
+ * @c uv y @c normal valen -1 cuando la esquina no los referencia o el ndice
+ * queda fuera de rango; as "1/2/3" y "-5/-4/-1" que apuntan a los mismos
+ * atributos producen la misma clave.
+ */
+struct VertexKey {
+  int pos;
+  int uv;
+  int normal;
+
+  bool operator==(const VertexKey& other) const {
+    return pos == other.pos && uv == other.uv && normal == other.normal;
+  }
+};
+
+/**
+ * @class VertexDedupTable
+ * @brief Tabla hash plana (direccionamiento abierto, sondeo lineal) de VertexKey a ndice de vrtice.
+ *
+ * Reemplaza al @c std::unordered_map<std::string, unsigned> del loader: las claves son
+ * tres enteros, las ranuras viven en un solo arreglo contiguo y no hay una reserva
+ * de memoria por vrtice nico.
+ *
+ * @note La capacidad siempre es potencia de 2 y la tabla crece al superar el 70% de ocupacin.
+ */
+class
+  VertexDedupTable {
+public:
+  VertexDedupTable() = default;
+  ~VertexDedupTable() = default;
+
+  /**
+   * @brief Reserva espacio para @p expectedKeys claves sin volver a crecer.
+   */
+  void
+    reserve(size_t expectedKeys);
+
+  /**
+   * @brief Busca @p key; si no existe la inserta con el valor @p newIndex.
+   *
+   * @param key       Esquina resuelta (key.pos >= 0).
+   * @param newIndex  ndice a guardar si la clave es nueva.
+   * @param inserted  Salida: true si la clave no exista.
+   * @return ndice asociado a la clave (existente o @p newIndex).
+   */
+  unsigned int
+    findOrInsert(const VertexKey& key, unsigned int newIndex, bool& inserted) {
+    if ((m_count + 1) * 10 > m_slots.size() * 7) grow();
+
+    size_t mask = m_slots.size() - 1;
+    for (size_t i = hash(key) & mask;; i = (i + 1) & mask) {
+      Slot& slot = m_slots[i];
+      if (slot.key.pos == kEmpty) {
+        slot.key = key;
+        slot.value = newIndex;
+        ++m_count;
+        inserted = true;
+        return newIndex;
+      }
+      if (slot.key == key) {
+        inserted = false;
+        return slot.value;
+      }
+    }
+  }
+
+  /// Nmero de claves almacenadas.
+  size_t
+    size() const { return m_count; }
+
+  /// Memoria ocupada por las ranuras, en bytes.
+  size_t
+    memoryBytes() const { return m_slots.size() * sizeof(Slot); }
+
+private:
+  struct Slot {
+    VertexKey key;
+    unsigned int value;
+  };
+
+  static const int kEmpty = -1;
+
+  static size_t
+    hash(const VertexKey& key) {
+    // Mezcla multiplicativa de los tres enteros (constantes de xxHash/Murmur).
+    unsigned long long h = (unsigned int)key.pos * 0x9E3779B97F4A7C15ull
+                         + (unsigned int)key.uv * 0xC2B2AE3D27D4EB4Full
+                         + (unsigned int)key.normal * 0x165667B19E3779F9ull;
+    h ^= h >> 32;
+    h *= 0xD6E8FEB86659FD93ull;
+    h ^= h >> 29;
+    return (size_t)h;
+  }
+
+  void
+    grow();
+
+  void
+    rehash(size_t capacity);
+
+  std::vector<Slot> m_slots;
+  size_t m_count = 0;
+};
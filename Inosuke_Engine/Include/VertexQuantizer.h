@@ -0,0 +1,95 @@
+#pragma once
+#include "Prerequisites.h"
+
+class MeshComponent;
+
+/**
+ * @class VertexQuantizer
+ * @brief Convierte los vrtices de un MeshComponent a formatos empaquetados.
+ *
+ * Formatos disponibles (stride en bytes):
+ * - FORMAT_FLOAT (20): SimpleVertex tal cual (referencia).
+ * - FORMAT_COMPACT (12): posicin R16G16B16A16_UNORM relativa a los bounds de la
+ *   malla + UV R16G16_FLOAT (half).
+ * - FORMAT_COMPACT_NORMAL (16): FORMAT_COMPACT + normal octadrica R16G16_SNORM.
+ *   SimpleVertex no guarda normales, as que se calculan suavizadas a partir de
+ *   los tringulos (promedio ponderado por rea).
+ *
+ * El vertex shader reconstruye la posicin con DequantConstants:
+ * @code
+ *   float3 pos = input.Pos.xyz * PosScale.xyz + PosOffset.xyz;
+ *   float3 n   = OctDecode(input.Normal); // ver decodeOctahedral()
+ * @endcode
+ */
+class
+  VertexQuantizer {
+public:
+  enum Format {
+    FORMAT_FLOAT = 0,
+    FORMAT_COMPACT,
+    FORMAT_COMPACT_NORMAL,
+    FORMAT_COUNT
+  };
+
+  /// Constantes de descuantizacin, alineadas para un constant buffer.
+  struct DequantConstants {
+    XMFLOAT4 PosScale;   // xyz = tamao de los bounds (w sin uso)
+    XMFLOAT4 PosOffset;  // xyz = esquina mnima de los bounds (w sin uso)
+  };
+
+  /// Vrtices ya empaquetados, listos para un vertex buffer.
+  struct QuantizedMesh {
+    Format format = FORMAT_FLOAT;
+    unsigned int stride = 0;
+    unsigned int vertexCount = 0;
+    std::vector<unsigned char> data;
+    DequantConstants constants = {};
+  };
+
+  /// Error mximo de reconstruccin respecto a la malla original.
+  struct ErrorStats {
+    float maxPositionError = 0.0f;  // En unidades de la malla
+    float maxUvError = 0.0f;
+    float maxNormalErrorDeg = 0.0f; // Solo FORMAT_COMPACT_NORMAL
+  };
+
+  /**
+   * @brief Empaqueta los vrtices de @p mesh en @p format.
+   * @return false si la malla no tiene vrtices.
+   */
+  static bool quantize(const MeshComponent& mesh, Format format, QuantizedMesh& out);
+
+  /**
+   * @brief Descripcin de entrada de D3D11 que coincide con @p format (slot 0).
+   */
+  static std::vector<D3D11_INPUT_ELEMENT_DESC> inputLayout(Format format);
+
+  /// Bytes por vrtice de @p format.
+  static unsigned int strideOf(Format format);
+
+  /**
+   * @brief Desempaqueta @p quantized y lo compara con @p mesh.
+   */
+  static ErrorStats measure(const MeshComponent& mesh, const QuantizedMesh& quantized);
+
+  /**
+   * @brief Empaqueta @p mesh en todos los formatos y reporta memoria por vrtice,
+   * memoria total y error mximo por la salida de depuracin.
+   */
+  static bool report(const MeshComponent& mesh);
+
+  /**
+   * @brief Carga @p filename, corre report() y sube cada formato como vertex
+   * buffer (Buffer::init) en un HeadlessDevice para verificar su tamao en GPU.
+   */
+  static bool benchmark(const std::string& filename);
+
+  /// Codifica una normal unitaria en el octaedro (resultado en [-1, 1]^2).
+  static XMFLOAT2 encodeOctahedral(const XMFLOAT3& normal);
+
+  /// Inversa de encodeOctahedral(); devuelve una normal unitaria.
+  static XMFLOAT3 decodeOctahedral(const XMFLOAT2& encoded);
+
+private:
+  static void computeNormals(const MeshComponent& mesh, std::vector<XMFLOAT3>& outNormals);
+};
@@ -1,5 +1,19 @@
 #include "Prerequisites.h"
 #include "BaseApp.h"
+#include "Benchmark.h"
+
+//--------------------------------------------------------------------------------------
+// La aplicacin es de subsistema Windows: para que stdout/stderr lleguen a la
+// terminal que la lanz hay que engancharse a su consola (o crear una).
+//--------------------------------------------------------------------------------------
+static void
+attachConsole() {
+	if (!AttachConsole(ATTACH_PARENT_PROCESS) && !AllocConsole())
+		return;
+	FILE* stream = nullptr;
+	freopen_s(&stream, "CONOUT$", "w", stdout);
+	freopen_s(&stream, "CONOUT$", "w", stderr);
+}
 
 //--------------------------------------------------------------------------------------
 // Entry point to the program. Initializes everything and goes into a message processing 
@@ -7,6 +21,63 @@
 //--------------------------------------------------------------------------------------
 int WINAPI
 wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLine, int nCmdShow) {
+	// "-bench [nombre] [archivo.obj]": corre un benchmark del motor (sin nombre, los lista)
+	const wchar_t* bench = lpCmdLine ? wcsstr(lpCmdLine, L"-bench") : nullptr;
+	if (bench) {
+		attachConsole();
+		wchar_t name[64] = {};
+		wchar_t file[MAX_PATH] = {};
+		const int fields = swscanf_s(bench, L"-bench %63s %259s", name, (unsigned)_countof(name),
+			file, (unsigned)_countof(file));
+		if (fields < 1) {
+			Benchmark::list();
+			return 0;
+		}
+		char narrowName[64] = {};
+		char narrowFile[MAX_PATH] = {};
+		size_t converted = 0;
+		wcstombs_s(&converted, narrowName, name, _TRUNCATE);
+		// Lo que sigue al nombre solo es el modelo si no es otra opcin
+		if (fields == 2 && file[0] != L'-')
+			wcstombs_s(&converted, narrowFile, file, _TRUNCATE);
+		return Benchmark::run(narrowName, narrowFile);
+	}
+
 	BaseApp app(hInstance, nCmdShow);
+	// "-latency n": update() puede adelantarse n cuadros al render (0 = serial, hasta 2)
+	const wchar_t* latency = lpCmdLine ? wcsstr(lpCmdLine, L"-latency") : nullptr;
+	if (latency) {
+		int frames = 0;
+		swscanf_s(latency, L"-latency %d", &frames);
+		app.setFrameLatency(frames > 0 ? (unsigned int)frames : 0u);
+	}
+
+	// "-arenastats": reporta los bytes de FrameArena de cada cuadro (modo de depuracin)
+	if (lpCmdLine && wcsstr(lpCmdLine, L"-arenastats")) {
+		FrameArena::setTracking(true);
+	}
+
+	// "-headless [cuadros]": corre sin ventana ni GPU y reporta costo de CPU y llamadas
+	// "-image archivo.tga": adems rasteriza por software a 1200x950 y guarda el ltimo cuadro
+	const wchar_t* headless = lpCmdLine ? wcsstr(lpCmdLine, L"-headless") : nullptr;
+	if (headless) {
+		// Los reportes (MESSAGE/ERROR) tambin van a la consola
+		attachConsole();
+		logToConsole() = true;
+		int frames = 600;
+		swscanf_s(headless, L"-headless %d", &frames);
+		if (frames <= 0)
+			frames = 600;
+
+		const wchar_t* image = wcsstr(lpCmdLine, L"-image");
+		wchar_t imageFile[MAX_PATH] = {};
+		if (image && swscanf_s(image, L"-image %259s", imageFile, (unsigned)_countof(imageFile)) == 1) {
+			char narrowFile[MAX_PATH] = {};
+			size_t converted = 0;
+			wcstombs_s(&converted, narrowFile, imageFile, _TRUNCATE);
+			return app.runHeadless((unsigned int)frames, 1200, 950, narrowFile);
+		}
+		return app.runHeadless((unsigned int)frames);
+	}
 	return app.run(hInstance, nCmdShow);
 }
\ No newline at end of file
@@ -0,0 +1,70 @@
+//--------------------------------------------------------------------------------------
+// File: Inosuke_Engine_Instanced.fx
+//
+// Variante instanciada de Inosuke_Engine.fx para los lotes de RenderQueue
+// (DrawIndexedInstanced). La matriz de mundo y el color de cada objeto llegan
+// por instancia desde InstanceBuffer (slot 1) en lugar del constant buffer b2.
+//--------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------
+// Constant Buffer Variables
+//--------------------------------------------------------------------------------------
+Texture2D txDiffuse : register( t0 );
+SamplerState samLinear : register( s0 );
+
+cbuffer cbNeverChanges : register( b0 )
+{
+    matrix View;
+};
+
+cbuffer cbChangeOnResize : register( b1 )
+{
+    matrix Projection;
+};
+
+//--------------------------------------------------------------------------------------
+struct VS_INSTANCED_INPUT
+{
+    float4 Pos : POSITION;
+    float2 Tex : TEXCOORD0;
+    // Filas de mWorld ya transpuesta (el mismo bloque que CBChangesEveryFrame)
+    float4 World0 : INSTANCE_WORLD0;
+    float4 World1 : INSTANCE_WORLD1;
+    float4 World2 : INSTANCE_WORLD2;
+    float4 World3 : INSTANCE_WORLD3;
+    float4 Color : INSTANCE_COLOR0;
+};
+
+struct PS_INSTANCED_INPUT
+{
+    float4 Pos : SV_POSITION;
+    float2 Tex : TEXCOORD0;
+    float4 Color : COLOR0;
+};
+
+//--------------------------------------------------------------------------------------
+// Vertex Shader
+//--------------------------------------------------------------------------------------
+PS_INSTANCED_INPUT VSInstanced( VS_INSTANCED_INPUT input )
+{
+    PS_INSTANCED_INPUT output = (PS_INSTANCED_INPUT)0;
+    // float4x4(filas) da la matriz transpuesta: se vuelve a transponer para
+    // usarla igual que World en b2
+    float4x4 world = transpose( float4x4( input.World0, input.World1, input.World2, input.World3 ) );
+    output.Pos = mul( input.Pos, world );
+    output.Pos = mul( output.Pos, View );
+    output.Pos = mul( output.Pos, Projection );
+    output.Tex = input.Tex;
+    output.Color = input.Color;
+
+    return output;
+}
+
+//--------------------------------------------------------------------------------------
+// Pixel Shader
+//--------------------------------------------------------------------------------------
+float4 PSInstanced( PS_INSTANCED_INPUT input ) : SV_Target
+{
+    // Color por instancia en lugar de vMeshColor (b2 no se sube en los lotes)
+    return txDiffuse.Sample( samLinear, input.Tex ) * input.Color;
+}
@@ -1,4 +1,9 @@
 #include "BaseApp.h"
+#include "MeshSimplifier.h"
+
+// userData del cubo en m_sceneBvh; los satlites usan kFirstSatellite + i
+static const unsigned int kCubeObject = 0;
+static const unsigned int kFirstSatellite = 1;
 
 BaseApp::BaseApp(HINSTANCE hInst, int nCmdShow)
 {
@@ -29,19 +34,82 @@ BaseApp::run(HINSTANCE hInst, int nCmdShow) {
 			QueryPerformanceCounter(&curr);
 			float deltaTime = static_cast<float>(curr.QuadPart - prev.QuadPart) / freq.QuadPart;
 			prev = curr;
+			// El paquete se abre antes de update() para que su tiempo cuente en la simulacin
+			m_framePipeline.beginFrame();
 			update(deltaTime);
 			render();
+			// Fin del cuadro: se libera todo lo temporal de los hilos
+			FrameArena::endFrame();
 		}
 	}
 	return (int)msg.wParam;
 }
 
+int
+BaseApp::runHeadless(unsigned int frameCount,
+										 unsigned int width,
+										 unsigned int height,
+										 const std::string& imageFile) {
+	// Sin ventana: el swap chain nulo solo usa las dimensiones
+	m_window.m_width = width;
+	m_window.m_height = height;
+	m_device.m_nullBackend = &m_nullBackend;
+	m_deviceContext.m_nullBackend = &m_nullBackend;
+
+	// Con imagen, los clears y draws tambin se ejecutan en el rasterizador por software
+	if (!imageFile.empty()) {
+		// Las fases en paralelo usan m_jobSystem (se inicia en init())
+		if (FAILED(m_rasterizer.init(width, height, &m_jobSystem)))
+			return 1;
+		m_nullBackend.m_rasterizer = &m_rasterizer;
+	}
+
+	if (FAILED(init()))
+		return 1;
+
+	// Paso fijo para que el stream de comandos sea reproducible entre corridas
+	const float deltaTime = 1.0f / 60.0f;
+	for (unsigned int frame = 0; frame < frameCount; ++frame)
+	{
+		m_framePipeline.beginFrame();
+		update(deltaTime);
+		render();
+		FrameArena::endFrame();
+	}
+	m_framePipeline.flush();
+	m_framePipeline.report("BaseApp::runHeadless");
+	FrameArena::report("BaseApp::runHeadless");
+	m_resources.report("BaseApp::runHeadless");
+	m_nullBackend.report("BaseApp::runHeadless");
+	m_deviceContext.reportStateStats("BaseApp::runHeadless");
+	m_constantRing.report("BaseApp::runHeadless");
+	std::wostringstream instanceReport;
+	instanceReport << L"BaseApp::runHeadless: " << m_instanceBuffer.m_stats.instances << L" instances in "
+		<< m_instanceBuffer.m_stats.batches << L" instanced batches, " << m_instanceBuffer.m_stats.discards
+		<< L" discards";
+	MESSAGE(L"InstanceBuffer", L"report", instanceReport.str());
+	m_occlusionCuller.report("BaseApp::runHeadless");
+	m_jobSystem.report("BaseApp::runHeadless");
+
+	bool imageSaved = true;
+	if (m_nullBackend.m_rasterizer) {
+		m_rasterizer.report("BaseApp::runHeadless");
+		imageSaved = m_rasterizer.saveTGA(imageFile);
+	}
+
+	// Los objetos COM se cuentan despus de liberar todo: lo que quede es una fuga
+	destroy();
+	const bool noLeaks = m_nullBackend.reportLiveObjects("BaseApp::runHeadless");
+	return imageSaved && noLeaks ? 0 : 1;
+}
+
 HRESULT
 BaseApp::init() {
 	HRESULT hr = S_OK;
 
-	// Crear swapchain
-	hr = m_swapChain.init(m_device, m_deviceContext, m_backBuffer, m_window);
+	// Crear swapchain (el back buffer lo llena el swap chain; el registro solo lo guarda)
+	Texture* backBuffer = m_resources.add(m_backBuffer);
+	hr = m_swapChain.init(m_device, m_deviceContext, *backBuffer, m_window);
 
 	if (FAILED(hr)) {
 		ERROR("Main", "InitDevice",
@@ -50,7 +118,8 @@ BaseApp::init() {
 	}
 
 	// Crear render target view
-	hr = m_renderTargetView.init(m_device, m_backBuffer, DXGI_FORMAT_R8G8B8A8_UNORM);
+	m_resources.updateMemory(m_backBuffer);
+	hr = m_renderTargetView.init(m_device, *backBuffer, DXGI_FORMAT_R8G8B8A8_UNORM);
 
 	if (FAILED(hr)) {
 		ERROR("Main", "InitDevice",
@@ -59,7 +128,8 @@ BaseApp::init() {
 	}
 
 	// Crear textura de depth stencil
-	hr = m_depthStencil.init(m_device,
+	hr = m_resources.create(m_depthStencil,
+		m_device,
 		m_window.m_width,
 		m_window.m_height,
 		DXGI_FORMAT_D24_UNORM_S8_UINT,
@@ -75,7 +145,7 @@ BaseApp::init() {
 
 	// Crear el depth stencil view
 	hr = m_depthStencilView.init(m_device,
-		m_depthStencil,
+		*m_resources.get(m_depthStencil),
 		DXGI_FORMAT_D24_UNORM_S8_UINT);
 
 	if (FAILED(hr)) {
@@ -86,7 +156,7 @@ BaseApp::init() {
 
 
 	// Crear el m_viewport
-	hr = m_viewport.init(m_window);
+	hr = m_viewport.init(m_window.m_width, m_window.m_height);
 
 	if (FAILED(hr)) {
 		ERROR("Main", "InitDevice",
@@ -120,13 +190,24 @@ BaseApp::init() {
 	Layout.push_back(texcoord);
 
 	// Create the Shader Program
-	hr = m_shaderProgram.init(m_device, "Inosuke_Engine.fx", Layout);
+	hr = m_resources.create(m_shaderProgram, m_device, "Inosuke_Engine.fx", Layout);
 	if (FAILED(hr)) {
 		ERROR("Main", "InitDevice",
 			("Failed to initialize ShaderProgram. HRESULT: " + std::to_string(hr)).c_str());
 		return hr;
 	}
 
+	// Variante instanciada: el mismo layout ms el stream por instancia (slot 1)
+	std::vector<D3D11_INPUT_ELEMENT_DESC> instancedLayout = Layout;
+	InstanceBuffer::appendLayout(instancedLayout);
+	hr = m_resources.create(m_instancedShader, m_device, "Inosuke_Engine_Instanced.fx", instancedLayout,
+		"VSInstanced", "PSInstanced");
+	if (FAILED(hr)) {
+		ERROR("Main", "InitDevice",
+			("Failed to initialize instanced ShaderProgram. HRESULT: " + std::to_string(hr)).c_str());
+		return hr;
+	}
+
 	// Create vertex buffer
 	SimpleVertex vertices[] =
 	{
@@ -193,9 +274,18 @@ BaseApp::init() {
 		m_mesh.m_index.push_back(indices[i]);
 	}
 	m_mesh.m_numIndex = 36;
+	m_mesh.selectIndexFormat();
+	m_mesh.computeBounds();
+	// Clusters para descartar por cono las caras que quedan de espaldas (reordena m_index)
+	MeshletBuilder::build(m_mesh);
+	m_sceneBvh.clear();
+	m_cubeProxy = m_sceneBvh.createProxy(m_mesh.m_boundsCenter, m_mesh.m_boundsExtents, kCubeObject);
+	for (unsigned int i = 0; i < kSatelliteCount; ++i) {
+		m_satelliteProxies[i] = m_sceneBvh.createProxy(m_mesh.m_boundsCenter, m_mesh.m_boundsExtents, kFirstSatellite + i);
+	}
 
 	// Create vertex buffer
-	hr = m_vertexBuffer.init(m_device, m_mesh, D3D11_BIND_VERTEX_BUFFER);
+	hr = m_resources.create(m_vertexBuffer, m_device, m_mesh, D3D11_BIND_VERTEX_BUFFER);
 
 	if (FAILED(hr)) {
 		ERROR("Main", "InitDevice",
@@ -204,7 +294,7 @@ BaseApp::init() {
 	}
 
 	// Create index buffer
-	hr = m_indexBuffer.init(m_device, m_mesh, D3D11_BIND_INDEX_BUFFER);
+	hr = m_resources.create(m_indexBuffer, m_device, m_mesh, D3D11_BIND_INDEX_BUFFER);
 
 	if (FAILED(hr)) {
 		ERROR("Main", "InitDevice",
@@ -216,28 +306,37 @@ BaseApp::init() {
 	m_deviceContext.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 	// Create the constant buffers
-	hr = m_cbNeverChanges.init(m_device, sizeof(CBNeverChanges));
+	hr = m_cbNeverChanges.init(m_device, UPDATE_STATIC);
 	if (FAILED(hr)) {
 		ERROR("Main", "InitDevice",
 			("Failed to initialize NeverChanges Buffer. HRESULT: " + std::to_string(hr)).c_str());
 		return hr;
 	}
 
-	hr = m_cbChangeOnResize.init(m_device, sizeof(CBChangeOnResize));
+	hr = m_cbChangeOnResize.init(m_device, UPDATE_ON_RESIZE);
 	if (FAILED(hr)) {
 		ERROR("Main", "InitDevice",
 			("Failed to initialize ChangeOnResize Buffer. HRESULT: " + std::to_string(hr)).c_str());
 		return hr;
 	}
 
-	hr = m_cbChangesEveryFrame.init(m_device, sizeof(CBChangesEveryFrame));
+	// Las constantes por objeto (CBChangesEveryFrame) van al anillo dinmico
+	hr = m_constantRing.init(m_device, 64 * 1024);
+	if (FAILED(hr)) {
+		ERROR("Main", "InitDevice",
+			("Failed to initialize ConstantBufferRing. HRESULT: " + std::to_string(hr)).c_str());
+		return hr;
+	}
+
+	// Instancias de los lotes de la cola (se reutiliza de atrs hacia adelante)
+	hr = m_instanceBuffer.init(m_device, 256);
 	if (FAILED(hr)) {
 		ERROR("Main", "InitDevice",
-			("Failed to initialize ChangesEveryFrame Buffer. HRESULT: " + std::to_string(hr)).c_str());
+			("Failed to initialize InstanceBuffer. HRESULT: " + std::to_string(hr)).c_str());
 		return hr;
 	}
 
-	hr = m_textureCube.init(m_device, "seafloor", ExtensionType::DDS);
+	hr = m_resources.create(m_textureCube, m_device, "seafloor", ExtensionType::DDS);
 	// Load the Texture
 	if (FAILED(hr)) {
 		ERROR("Main", "InitDevice",
@@ -246,13 +345,28 @@ BaseApp::init() {
 	}
 
 	// Create the sample state
-	hr = m_samplerState.init(m_device);
+	hr = m_resources.create(m_samplerState, m_device);
 	if (FAILED(hr)) {
 		ERROR("Main", "InitDevice",
 			("Failed to initialize SamplerState. HRESULT: " + std::to_string(hr)).c_str());
 		return hr;
 	}
 
+	hr = m_jobSystem.init();
+	if (FAILED(hr)) {
+		ERROR("Main", "InitDevice",
+			("Failed to initialize JobSystem. HRESULT: " + std::to_string(hr)).c_str());
+		return hr;
+	}
+
+	// Buffer de oclusin a un cuarto de la resolucin de la ventana
+	hr = m_occlusionCuller.init((std::max)(1u, m_window.m_width / 4), (std::max)(1u, m_window.m_height / 4));
+	if (FAILED(hr)) {
+		ERROR("Main", "InitDevice",
+			("Failed to initialize OcclusionCuller. HRESULT: " + std::to_string(hr)).c_str());
+		return hr;
+	}
+
 	// Initialize the world matrices
 	m_World = XMMatrixIdentity();
 
@@ -263,14 +377,39 @@ BaseApp::init() {
 	m_View = XMMatrixLookAtLH(Eye, At, Up);
 
 
-	// Initialize the projection matrix
+	CBNeverChanges cbNeverChanges;
 	cbNeverChanges.mView = XMMatrixTranspose(m_View);
-	m_Projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, m_window.m_width / (FLOAT)m_window.m_height, 0.01f, 100.0f);
-	cbChangesOnResize.mProjection = XMMatrixTranspose(m_Projection);
+	m_cbNeverChanges.set(cbNeverChanges);
+
+	// Initialize the projection matrix
+	m_projectionWidth = m_projectionHeight = 0;
+	updateProjection();
+
+	// La cola cuantiza la profundidad en el mismo rango que la proyeccin
+	m_renderQueue.setDepthRange(0.01f, 100.0f);
+
+	// Desde aqu, con latencia > 0, renderFrame() corre en el hilo del pipeline
+	hr = m_framePipeline.init(m_frameLatency, &BaseApp::renderStage, this);
+	if (FAILED(hr)) {
+		ERROR("Main", "InitDevice",
+			("Failed to initialize FramePipeline. HRESULT: " + std::to_string(hr)).c_str());
+		return hr;
+	}
 
 	return S_OK;
 }
 
+void
+BaseApp::updateProjection() {
+	if (m_window.m_width == m_projectionWidth && m_window.m_height == m_projectionHeight) {
+		return;
+	}
+	m_projectionWidth = m_window.m_width;
+	m_projectionHeight = m_window.m_height;
+	m_Projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, m_window.m_width / (FLOAT)m_window.m_height, 0.01f, 100.0f);
+	// m_cbChangeOnResize se actualiza en renderFrame() con la proyeccin del paquete
+}
+
 void BaseApp::update(float deltaTime)
 {
 	// Update our time
@@ -279,6 +418,10 @@ void BaseApp::update(float deltaTime)
 	{
 		t += (float)XM_PI * 0.0125f;
 	}
+	else if (m_deviceContext.m_nullBackend)
+	{
+		t += deltaTime;
+	}
 	else
 	{
 		static DWORD dwTimeStart = 0;
@@ -287,12 +430,9 @@ void BaseApp::update(float deltaTime)
 			dwTimeStart = dwTimeCur;
 		t = (dwTimeCur - dwTimeStart) / 1000.0f;
 	}
-	// Actualizar la matriz de proyeccin y vista
-	cbNeverChanges.mView = XMMatrixTranspose(m_View);
-	m_cbNeverChanges.update(m_deviceContext, nullptr, 0, nullptr, &cbNeverChanges, 0, 0);
-	m_Projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, m_window.m_width / (FLOAT)m_window.m_height, 0.01f, 100.0f);
-	cbChangesOnResize.mProjection = XMMatrixTranspose(m_Projection);
-	m_cbChangeOnResize.update(m_deviceContext, nullptr, 0, nullptr, &cbChangesOnResize, 0, 0);
+	// La vista es fija; la proyeccin solo cambia con el tamao de la ventana.
+	// Los constant buffers se suben en renderFrame() si quedaron sucios.
+	updateProjection();
 
 	// Modify the color
 	m_vMeshColor.x = (sinf(t * 1.0f) + 1.0f) * 0.5f;
@@ -303,11 +443,143 @@ void BaseApp::update(float deltaTime)
 	m_World = XMMatrixRotationY(t);
 	cb.mWorld = XMMatrixTranspose(m_World);
 	cb.vMeshColor = m_vMeshColor;
-	m_cbChangesEveryFrame.update(m_deviceContext, nullptr, 0, nullptr, &cb, 0, 0);
+	// m_renderQueue copia cb a m_constantRing justo antes del draw
+
+	// Satlites: cubos chicos que giran sobre s mismos y orbitan al principal
+	for (unsigned int i = 0; i < kSatelliteCount; ++i) {
+		const float angle = t * 0.5f + i * (XM_2PI / kSatelliteCount);
+		const XMMATRIX world = XMMatrixScaling(0.3f, 0.3f, 0.3f) * XMMatrixRotationY(t * 2.0f) *
+			XMMatrixTranslation(3.0f * cosf(angle), -0.5f, 3.0f * sinf(angle));
+		m_satellites[i].mWorld = XMMatrixTranspose(world);
+		m_satellites[i].vMeshColor = XMFLOAT4((i & 1) ? 1.0f : 0.4f, (i & 2) ? 1.0f : 0.4f, (i & 4) ? 1.0f : 0.4f, 1.0f);
+	}
 }
 
 void
 BaseApp::render() {
+	// Paquete abierto en run()/runHeadless() antes de update()
+	FramePipeline::FramePacket& frame = m_framePipeline.beginFrame();
+	// Lo que se libere desde aqu vive hasta que el render termine este cuadro
+	m_resources.beginFrame(frame.frame);
+	frame.width = m_projectionWidth;
+	frame.height = m_projectionHeight;
+	frame.view.mView = XMMatrixTranspose(m_View);
+	frame.projection.mProjection = XMMatrixTranspose(m_Projection);
+
+	// Render the cube (los punteros del registro no cambian mientras el handle sea vlido)
+	RenderQueue::DrawPacket packet;
+	packet.vertexBuffer = m_resources.get(m_vertexBuffer);
+	packet.indexBuffer = m_resources.get(m_indexBuffer);
+	packet.shader = m_resources.get(m_shaderProgram);
+	packet.instancedShader = m_resources.get(m_instancedShader);
+	packet.texture = m_resources.get(m_textureCube);
+	packet.sampler = m_resources.get(m_samplerState);
+	packet.indexCount = m_mesh.m_numIndex;
+	packet.constants = cb;
+
+	// Elegir LOD segn el tamao en pantalla (sin LODs se dibuja la malla completa)
+	XMFLOAT3 viewCenter;
+	XMStoreFloat3(&viewCenter, XMVector3TransformCoord(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), m_World * m_View));
+	if (!m_mesh.m_lods.empty()) {
+		const MeshLod& lod = m_mesh.m_lods[MeshSimplifier::selectLod(m_mesh, viewCenter.z, m_Projection, (float)m_window.m_height)];
+		packet.startIndex = lod.indexOffset;
+		packet.indexCount = lod.indexCount;
+	}
+
+	// Descartar lo que queda fuera del frustum de la cmara
+	XMFLOAT3 boundsCenter, boundsExtents;
+	float boundsRadius;
+	FrustumCuller::transformBounds(m_mesh, m_World, boundsCenter, boundsExtents, boundsRadius);
+	m_sceneBvh.moveProxy(m_cubeProxy, boundsCenter, boundsExtents);
+	XMFLOAT3 satelliteCenters[kSatelliteCount], satelliteExtents[kSatelliteCount];
+	for (unsigned int i = 0; i < kSatelliteCount; ++i) {
+		float satelliteRadius;
+		FrustumCuller::transformBounds(m_mesh, XMMatrixTranspose(m_satellites[i].mWorld), satelliteCenters[i],
+			satelliteExtents[i], satelliteRadius);
+		m_sceneBvh.moveProxy(m_satelliteProxies[i], satelliteCenters[i], satelliteExtents[i]);
+	}
+	// userData de los proxies visibles: vive en la arena del cuadro (se libera en FrameArena::endFrame())
+	FrameVector<unsigned int> visible;
+	m_sceneBvh.queryFrustum(FrustumCuller::extractFrustum(m_View * m_Projection), visible);
+
+	// Descartar lo que tapan los oclusores: el cubo grande tapa a los satlites que
+	// pasan detrs de l (no se tapa a s mismo: su caja siempre est ms cerca que
+	// sus caras). Solo se rasteriza si hay otro objeto visible que probar; con el
+	// cubo solo sera costo sin ningn descarte posible.
+	bool testOcclusion = false;
+	for (unsigned int index : visible) {
+		testOcclusion = testOcclusion || index != kCubeObject;
+	}
+	if (testOcclusion) {
+		m_occlusionCuller.beginFrame(m_View * m_Projection);
+		m_occlusionCuller.addOccluder(m_mesh, m_World);
+		m_occlusionCuller.rasterize(OcclusionCuller::PATH_SSE, &m_jobSystem);
+	}
+
+	// Con el nivel 0 solo se dibujan los meshlets que no quedan de espaldas a la
+	// cmara (posicin de la cmara en espacio objeto); los LODs van completos
+	m_meshletRanges.clear();
+	if (!m_mesh.m_meshlets.empty() && packet.startIndex == 0) {
+		XMFLOAT3 cameraPosition;
+		XMStoreFloat3(&cameraPosition, XMVector3TransformCoord(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f),
+			XMMatrixInverse(nullptr, m_World * m_View)));
+		MeshletBuilder::cullMeshlets(m_mesh, cameraPosition, m_meshletRanges);
+	}
+	else {
+		m_meshletRanges.push_back({ packet.startIndex, packet.indexCount });
+	}
+
+	for (unsigned int index : visible) {
+		if (index == kCubeObject &&
+				(!testOcclusion || m_occlusionCuller.isVisible(boundsCenter, boundsExtents))) {
+			for (const MeshletBuilder::IndexRange& range : m_meshletRanges) {
+				FramePipeline::Draw draw;
+				draw.packet = packet;
+				draw.packet.startIndex = range.start;
+				draw.packet.indexCount = range.count;
+				draw.viewDepth = viewCenter.z;
+				frame.draws.push_back(draw);
+			}
+		}
+		else if (index >= kFirstSatellite && index < kFirstSatellite + kSatelliteCount &&
+				(!testOcclusion || m_occlusionCuller.isVisible(satelliteCenters[index - kFirstSatellite],
+					satelliteExtents[index - kFirstSatellite]))) {
+			// Malla completa en todos: los vecinos en la cola se agrupan en un lote
+			const CBChangesEveryFrame& satellite = m_satellites[index - kFirstSatellite];
+			XMFLOAT3 satelliteView;
+			XMStoreFloat3(&satelliteView, XMVector3TransformCoord(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f),
+				XMMatrixTranspose(satellite.mWorld) * m_View));
+			FramePipeline::Draw draw;
+			draw.packet = packet;
+			draw.packet.startIndex = 0;
+			draw.packet.indexCount = m_mesh.m_numIndex;
+			draw.packet.constants = satellite;
+			draw.viewDepth = satelliteView.z;
+			frame.draws.push_back(draw);
+		}
+	}
+
+	// Desde aqu el paquete es de solo lectura: update() ya puede seguir con el prximo cuadro
+	m_framePipeline.submit();
+
+	// Destruir lo liberado en cuadros que el render ya termin
+	m_resources.collect(m_framePipeline.renderedFrames());
+}
+
+void
+BaseApp::renderStage(void* app, const FramePipeline::FramePacket& frame) {
+	static_cast<BaseApp*>(app)->renderFrame(frame);
+}
+
+void
+BaseApp::renderFrame(const FramePipeline::FramePacket& frame) {
+	// Sin GPU, el cuadro del backend mide solo el envo de comandos
+	if (m_deviceContext.m_nullBackend) {
+		m_nullBackend.beginFrame();
+	}
+	m_deviceContext.beginFrame();
+	m_constantRing.beginFrame(m_deviceContext);
+
 	// Set Render Target View
 	float ClearColor[4] = { 0.1f, 0.1f, 0.1f, 1.0f };
 	m_renderTargetView.render(m_deviceContext, m_depthStencilView, 1, ClearColor);
@@ -318,49 +590,54 @@ BaseApp::render() {
 	// Set depth stencil view
 	m_depthStencilView.render(m_deviceContext);
 
-	// Set shader program
-	m_shaderProgram.render(m_deviceContext);
-
-	// Render the cube
-	 // Asignar buffers Vertex e Index
-	m_vertexBuffer.render(m_deviceContext, 0, 1);
-	m_indexBuffer.render(m_deviceContext, 0, 1, false, DXGI_FORMAT_R32_UINT);
-
-	// Asignar buffers constantes
-	m_cbNeverChanges.render(m_deviceContext, 0, 1);
-	m_cbChangeOnResize.render(m_deviceContext, 1, 1);
-	m_cbChangesEveryFrame.render(m_deviceContext, 2, 1);
-	m_cbChangesEveryFrame.render(m_deviceContext, 2, 1, true);
-
-	// Asignar textura y sampler
-	m_textureCube.render(m_deviceContext, 0, 1);
-	m_samplerState.render(m_deviceContext, 0, 1);
-	m_deviceContext.DrawIndexed(m_mesh.m_numIndex, 0, 0);
+	// Asignar buffers constantes del cuadro (b2 lo enlaza la cola); set() solo
+	// marca sucio si la cmara o la proyeccin cambiaron
+	m_cbNeverChanges.set(frame.view);
+	m_cbChangeOnResize.set(frame.projection);
+	m_cbNeverChanges.flush(m_deviceContext);
+	m_cbChangeOnResize.flush(m_deviceContext);
+	m_cbNeverChanges.render(m_deviceContext, 0);
+	m_cbChangeOnResize.render(m_deviceContext, 1);
+
+	m_renderQueue.begin();
+	for (const FramePipeline::Draw& draw : frame.draws) {
+		m_renderQueue.submit(draw.packet, draw.viewDepth, draw.pass);
+	}
+	m_renderQueue.sort();
+	m_renderQueue.execute(m_deviceContext, m_constantRing, m_instanceBuffer);
+	m_constantRing.endFrame(m_deviceContext);
 
 	// Present our back buffer to our front buffer
 	m_swapChain.present();
+	m_deviceContext.endFrame();
+
+	if (m_deviceContext.m_nullBackend) {
+		m_nullBackend.endFrame();
+	}
 }
 
 void
 BaseApp::destroy() {
-	if (m_deviceContext.m_deviceContext) m_deviceContext.m_deviceContext->ClearState();
-
-	m_samplerState.destroy();
-	m_textureCube.destroy();
+	// Termina los paquetes en vuelo antes de liberar lo que referencian
+	m_framePipeline.destroy();
+	m_deviceContext.ClearState();
+	m_renderQueue.clear();
 
 	m_cbNeverChanges.destroy();
 	m_cbChangeOnResize.destroy();
-	m_cbChangesEveryFrame.destroy();
-	m_vertexBuffer.destroy();
-	m_indexBuffer.destroy();
-	m_shaderProgram.destroy();
-	m_depthStencil.destroy();
+	m_constantRing.destroy();
+	m_instanceBuffer.destroy();
 	m_depthStencilView.destroy();
 	m_renderTargetView.destroy();
 	m_swapChain.destroy();
-	m_backBuffer.destroy();
+	m_resources.destroy();
 	m_deviceContext.destroy();
 	m_device.destroy();
+
+	m_occlusionCuller.destroy();
+	m_jobSystem.destroy();
+	m_nullBackend.m_rasterizer = nullptr;
+	m_rasterizer.destroy();
 }
 
 LRESULT
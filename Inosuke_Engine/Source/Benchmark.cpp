@@ -0,0 +1,105 @@
+#include "Benchmark.h"
+#include "FrameArena.h"
+#include "FramePipeline.h"
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+#include "ModelLoader.h"
+#include "OcclusionCuller.h"
+#include "RenderQueue.h"
+#include "ResourceRegistry.h"
+#include "SceneBvh.h"
+#include "VertexQuantizer.h"
+
+namespace {
+  /// Benchmark registrado: nombre para -bench y funcin con sus parmetros por omisin.
+  struct Entry {
+    const char* name;
+    bool needsFile;
+    bool (*run)(const std::string& file);
+  };
+
+  const Entry kEntries[] = {
+    { "renderqueue",  false, [](const std::string&) { return RenderQueue::benchmark(); } },
+    { "instancing",   false, [](const std::string&) { return RenderQueue::benchmarkInstancing(); } },
+    { "deferred",     false, [](const std::string&) { return RenderQueue::benchmarkDeferred(); } },
+    { "frustum",      false, [](const std::string&) { return FrustumCuller::benchmark(); } },
+    { "bvh",          false, [](const std::string&) { return SceneBvh::benchmark(); } },
+    { "occlusion",    false, [](const std::string&) { return OcclusionCuller::benchmark(); } },
+    { "jobs",         false, [](const std::string&) { return JobSystem::benchmark(); } },
+    { "pipeline",     false, [](const std::string&) { return FramePipeline::benchmark(); } },
+    { "arena",        false, [](const std::string&) { return FrameArena::benchmark(); } },
+    { "registry",     false, [](const std::string&) { return ResourceRegistry::benchmark(); } },
+    { "model",        true,  [](const std::string& file) { return ModelLoader::benchmark(file); } },
+    { "modelscaling", true,  [](const std::string& file) { return ModelLoader::benchmarkScaling(file); } },
+    { "modelcache",   true,  [](const std::string& file) { return ModelLoader::benchmarkCache(file); } },
+    { "meshlets",     true,  [](const std::string& file) { return MeshletBuilder::benchmark(file); } },
+    { "simplify",     true,  [](const std::string& file) { return MeshSimplifier::benchmark(file); } },
+    { "quantize",     true,  [](const std::string& file) { return VertexQuantizer::benchmark(file); } },
+  };
+
+  /// Una lnea en la consola (en wide, como MESSAGE/ERROR, para no mezclar orientaciones).
+  void
+  printLine(FILE* stream, const std::wostringstream& line) {
+    fputws(line.str().c_str(), stream);
+    fputwc(L'\n', stream);
+    fflush(stream);
+  }
+
+  bool
+  runEntry(const Entry& entry, const std::string& file) {
+    std::wostringstream begin;
+    begin << L"== " << entry.name;
+    printLine(stdout, begin);
+    const bool passed = entry.run(file);
+    std::wostringstream end;
+    end << L"== " << entry.name << (passed ? L": passed" : L": FAILED");
+    printLine(stdout, end);
+    return passed;
+  }
+}
+
+int
+Benchmark::run(const std::string& name, const std::string& file) {
+  logToConsole() = true;
+
+  if (name == "all") {
+    bool passed = true;
+    for (const Entry& entry : kEntries) {
+      if (!entry.needsFile || !file.empty()) {
+        passed = runEntry(entry, file) && passed;
+      }
+    }
+    return passed ? 0 : 1;
+  }
+
+  for (const Entry& entry : kEntries) {
+    if (name != entry.name) {
+      continue;
+    }
+    if (entry.needsFile && file.empty()) {
+      std::wostringstream error;
+      error << L"Benchmark " << entry.name << L" needs a model file: -bench " << entry.name << L" <file.obj>";
+      printLine(stderr, error);
+      return 2;
+    }
+    return runEntry(entry, file) ? 0 : 1;
+  }
+
+  std::wostringstream error;
+  error << L"Unknown benchmark " << name.c_str();
+  printLine(stderr, error);
+  list();
+  return 2;
+}
+
+void
+Benchmark::list() {
+  std::wostringstream names;
+  names << L"Benchmarks (-bench <name> [file.obj]):\n  all";
+  for (const Entry& entry : kEntries) {
+    names << L"\n  " << entry.name << (entry.needsFile ? L" <file.obj>" : L"");
+  }
+  printLine(stdout, names);
+}
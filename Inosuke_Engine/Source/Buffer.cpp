@@ -4,7 +4,7 @@
 
 HRESULT
 Buffer::init(Device& device, const MeshComponent& mesh, unsigned int bindFlag) {
-	if (!device.m_device) {
+	if (!device.isValid()) {
 		ERROR("ShaderProgram", "init", "Device is null.");
 		return E_POINTER;
 	}
@@ -19,6 +19,7 @@ Buffer::init(Device& device, const MeshComponent& mesh, unsigned int bindFlag) {
 	
 	D3D11_BUFFER_DESC desc = {};
 	D3D11_SUBRESOURCE_DATA data = {};
+	std::vector<unsigned short> index16;
 
 	desc.Usage = D3D11_USAGE_DEFAULT;
 	desc.CPUAccessFlags = 0;
@@ -31,18 +32,56 @@ Buffer::init(Device& device, const MeshComponent& mesh, unsigned int bindFlag) {
 		data.pSysMem = mesh.m_vertex.data();
 	}
 	else if (bindFlag & D3D11_BIND_INDEX_BUFFER) {
-		m_stride = sizeof(unsigned int);
+		// Con R16 (ver MeshComponent::selectIndexFormat) los ndices se reducen aqu; la
+		// copia solo vive hasta que CreateBuffer los copia. Si m_index cambi despus
+		// de elegir el formato y ya no cabe, se sube en 32 bits.
+		bool use16 = mesh.m_indexFormat == DXGI_FORMAT_R16_UINT;
+		if (use16) {
+			index16.resize(mesh.m_index.size());
+			for (size_t i = 0; i < mesh.m_index.size() && use16; ++i) {
+				use16 = mesh.m_index[i] <= 0xFFFFu;
+				index16[i] = static_cast<unsigned short>(mesh.m_index[i]);
+			}
+		}
+		m_indexFormat = use16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+		m_stride = use16 ? sizeof(unsigned short) : sizeof(unsigned int);
 		desc.ByteWidth = m_stride * static_cast<unsigned int>(mesh.m_index.size());
 		desc.BindFlags = (D3D11_BIND_FLAG)bindFlag;
-		data.pSysMem = mesh.m_index.data();
+		data.pSysMem = use16 ? static_cast<const void*>(index16.data())
+			: static_cast<const void*>(mesh.m_index.data());
 	}
 
 	return createBuffer(device, desc, &data);
 }
 
+HRESULT
+Buffer::init(Device& device, const VertexQuantizer::QuantizedMesh& vertices) {
+	if (!device.isValid()) {
+		ERROR("Buffer", "init", "Device is null.");
+		return E_POINTER;
+	}
+	if (vertices.data.empty() || vertices.stride == 0) {
+		ERROR("Buffer", "init", "Quantized vertex data is empty");
+		return E_INVALIDARG;
+	}
+
+	D3D11_BUFFER_DESC desc = {};
+	D3D11_SUBRESOURCE_DATA data = {};
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.ByteWidth = static_cast<unsigned int>(vertices.data.size());
+	desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	desc.CPUAccessFlags = 0;
+	data.pSysMem = vertices.data.data();
+
+	m_bindFlag = D3D11_BIND_VERTEX_BUFFER;
+	m_stride = vertices.stride;
+
+	return createBuffer(device, desc, &data);
+}
+
 HRESULT
 Buffer::init(Device& device, unsigned int ByteWidth) {
-	if (!device.m_device) {
+	if (!device.isValid()) {
 		ERROR("ShaderProgram", "init", "Device is null.");
 		return E_POINTER;
 	}
@@ -77,14 +116,15 @@ Buffer::update(DeviceContext& deviceContext,
 		ERROR("ShaderProgram", "update", "pSrcData is null.");
 		return;
 	}
-	deviceContext.m_deviceContext->UpdateSubresource(m_buffer,
+	deviceContext.UpdateSubresource(m_buffer,
 		DstSubresource,
 		pDstBox,
 		pSrcData,
 		SrcRowPitch,
 		SrcDepthPitch);
-
-
+	if (m_bindFlag == D3D11_BIND_CONSTANT_BUFFER) {
+		deviceContext.countUpload(pDstBox ? pDstBox->right - pDstBox->left : m_stride);
+	}
 }
 
 void
@@ -93,7 +133,7 @@ Buffer::render(DeviceContext& deviceContext,
 	unsigned int NumBuffers,
 	bool setPixelShader,
 	DXGI_FORMAT format) {
-	if (!deviceContext.m_deviceContext) {
+	if (!deviceContext.isValid()) {
 		ERROR("RenderTargetView", "render", "DeviceContext is nullptr.");
 		return;
 	}
@@ -104,16 +144,18 @@ Buffer::render(DeviceContext& deviceContext,
 
 	switch (m_bindFlag) {
 	case D3D11_BIND_VERTEX_BUFFER:
-		deviceContext.m_deviceContext->IASetVertexBuffers(StartSlot, NumBuffers, &m_buffer, &m_stride, &m_offset);
+		deviceContext.IASetVertexBuffers(StartSlot, NumBuffers, &m_buffer, &m_stride, &m_offset);
 		break;
 	case D3D11_BIND_CONSTANT_BUFFER:
-		deviceContext.m_deviceContext->VSSetConstantBuffers(StartSlot, NumBuffers, &m_buffer);
+		deviceContext.VSSetConstantBuffers(StartSlot, NumBuffers, &m_buffer);
 		if (setPixelShader) {
-			deviceContext.m_deviceContext->PSSetConstantBuffers(StartSlot, NumBuffers, &m_buffer);
+			deviceContext.PSSetConstantBuffers(StartSlot, NumBuffers, &m_buffer);
 		}
 		break;
 	case D3D11_BIND_INDEX_BUFFER:
-		deviceContext.m_deviceContext->IASetIndexBuffer(m_buffer, format, m_offset);
+		deviceContext.IASetIndexBuffer(m_buffer,
+			format == DXGI_FORMAT_UNKNOWN ? m_indexFormat : format,
+			m_offset);
 		break;
 	default:
 		ERROR("Buffer", "render", "Unsupported BindFlag");
@@ -124,13 +166,24 @@ Buffer::render(DeviceContext& deviceContext,
 void
 Buffer::destroy() {
 	SAFE_RELEASE(m_buffer);
+	m_indexFormat = DXGI_FORMAT_UNKNOWN;
+}
+
+unsigned int
+Buffer::getByteWidth() const {
+	if (!m_buffer) {
+		return 0;
+	}
+	D3D11_BUFFER_DESC desc;
+	m_buffer->GetDesc(&desc);
+	return desc.ByteWidth;
 }
 
 HRESULT
 Buffer::createBuffer(Device& device,
 	D3D11_BUFFER_DESC& desc,
 	D3D11_SUBRESOURCE_DATA* initData) {
-	if (!device.m_device) {
+	if (!device.isValid()) {
 		ERROR("Buffer", "createBuffer", "Device is nullptr");
 		return E_POINTER;
 	}
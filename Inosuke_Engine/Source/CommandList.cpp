@@ -0,0 +1,390 @@
+#include "CommandList.h"
+#include "DeviceContext.h"
+
+namespace {
+  /// Los arreglos de un comando se guardan seguidos, cada uno alineado a 8 bytes.
+  inline unsigned int alignData(size_t bytes) {
+    return (unsigned int)((bytes + 7) & ~(size_t)7);
+  }
+
+  /// Cabecera de UpdateSubresource en m_data; los datos van detrs.
+  struct UpdateHeader {
+    D3D11_BOX box;
+    unsigned int hasBox;
+    unsigned int depthPitch;
+  };
+
+  /// Bytes de pSrcData que lee UpdateSubresource; 0 si el recurso no se puede grabar.
+  unsigned int
+  updateBytes(ID3D11Resource* resource,
+              unsigned int subresource,
+              const D3D11_BOX* box,
+              unsigned int rowPitch) {
+    D3D11_RESOURCE_DIMENSION dimension = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+    resource->GetType(&dimension);
+    if (dimension == D3D11_RESOURCE_DIMENSION_BUFFER) {
+      if (box) {
+        return box->right > box->left ? box->right - box->left : 0;
+      }
+      D3D11_BUFFER_DESC desc;
+      static_cast<ID3D11Buffer*>(resource)->GetDesc(&desc);
+      return desc.ByteWidth;
+    }
+    if (dimension == D3D11_RESOURCE_DIMENSION_TEXTURE2D) {
+      // Formatos sin compresin: una fila de datos por fila de pixeles
+      unsigned int rows = 0;
+      if (box) {
+        rows = box->bottom > box->top ? box->bottom - box->top : 0;
+      }
+      else {
+        D3D11_TEXTURE2D_DESC desc;
+        static_cast<ID3D11Texture2D*>(resource)->GetDesc(&desc);
+        const unsigned int mip = desc.MipLevels > 0 ? subresource % desc.MipLevels : 0;
+        rows = (std::max)(1u, desc.Height >> mip);
+      }
+      return rowPitch * rows;
+    }
+    return 0;
+  }
+}
+
+void
+CommandList::reset() {
+  m_commands.clear();
+  m_data.clear();
+  m_draws = 0;
+  SAFE_RELEASE(m_native);
+}
+
+void
+CommandList::destroy() {
+  reset();
+  std::vector<Command>().swap(m_commands);
+  std::vector<unsigned char>().swap(m_data);
+}
+
+CommandList::Command&
+CommandList::push(CommandType type, const void* object) {
+  Command command = { type, 0, 0, 0, kNoData, object };
+  m_commands.push_back(command);
+  return m_commands.back();
+}
+
+unsigned int
+CommandList::store(const void* source, size_t bytes) {
+  const unsigned int offset = alignData(m_data.size());
+  m_data.resize(offset);
+  const unsigned char* bytesSource = static_cast<const unsigned char*>(source);
+  m_data.insert(m_data.end(), bytesSource, bytesSource + bytes);
+  return offset;
+}
+
+void
+CommandList::ClearState() {
+  push(CMD_CLEAR_STATE);
+}
+
+void
+CommandList::UpdateSubresource(ID3D11Resource* pDstResource,
+  unsigned int DstSubresource,
+  const D3D11_BOX* pDstBox,
+  const void* pSrcData,
+  unsigned int SrcRowPitch,
+  unsigned int SrcDepthPitch) {
+  const unsigned int bytes = updateBytes(pDstResource, DstSubresource, pDstBox, SrcRowPitch);
+  if (bytes == 0) {
+    ERROR("CommandList", "UpdateSubresource", "Only buffers and uncompressed 2D textures can be recorded");
+    return;
+  }
+  UpdateHeader header = {};
+  if (pDstBox) {
+    header.box = *pDstBox;
+    header.hasBox = 1;
+  }
+  header.depthPitch = SrcDepthPitch;
+
+  Command& command = push(CMD_UPDATE_SUBRESOURCE, pDstResource);
+  command.start = DstSubresource;
+  command.count = bytes;
+  command.value = (int)SrcRowPitch;
+  command.data = store(&header, sizeof(header));
+  store(pSrcData, bytes);
+}
+
+void
+CommandList::RSSetViewports(unsigned int NumViewports, const D3D11_VIEWPORT* pViewports) {
+  Command& command = push(CMD_RS_SET_VIEWPORTS);
+  command.count = NumViewports;
+  command.data = store(pViewports, sizeof(D3D11_VIEWPORT) * NumViewports);
+}
+
+void
+CommandList::RSSetState(ID3D11RasterizerState* pRasterizerState) {
+  push(CMD_RS_SET_STATE, pRasterizerState);
+}
+
+void
+CommandList::IASetInputLayout(ID3D11InputLayout* pInputLayout) {
+  push(CMD_IA_SET_INPUT_LAYOUT, pInputLayout);
+}
+
+void
+CommandList::IASetVertexBuffers(unsigned int StartSlot,
+  unsigned int NumBuffers,
+  ID3D11Buffer* const* ppVertexBuffers,
+  const unsigned int* pStrides,
+  const unsigned int* pOffsets) {
+  Command& command = push(CMD_IA_SET_VERTEX_BUFFERS);
+  command.start = StartSlot;
+  command.count = NumBuffers;
+  command.data = store(ppVertexBuffers, sizeof(ID3D11Buffer*) * NumBuffers);
+  store(pStrides, sizeof(unsigned int) * NumBuffers);
+  store(pOffsets, sizeof(unsigned int) * NumBuffers);
+}
+
+void
+CommandList::IASetIndexBuffer(ID3D11Buffer* pIndexBuffer, DXGI_FORMAT Format, unsigned int Offset) {
+  Command& command = push(CMD_IA_SET_INDEX_BUFFER, pIndexBuffer);
+  command.start = (unsigned int)Format;
+  command.value = (int)Offset;
+}
+
+void
+CommandList::IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY Topology) {
+  push(CMD_IA_SET_PRIMITIVE_TOPOLOGY).start = (unsigned int)Topology;
+}
+
+void
+CommandList::VSSetShader(ID3D11VertexShader* pVertexShader) {
+  push(CMD_VS_SET_SHADER, pVertexShader);
+}
+
+void
+CommandList::PSSetShader(ID3D11PixelShader* pPixelShader) {
+  push(CMD_PS_SET_SHADER, pPixelShader);
+}
+
+void
+CommandList::SetConstantBuffers(bool pixelShader,
+  unsigned int StartSlot,
+  unsigned int NumBuffers,
+  ID3D11Buffer* const* ppConstantBuffers,
+  const unsigned int* pFirstConstant,
+  const unsigned int* pNumConstants) {
+  Command& command = push(pixelShader ? CMD_PS_SET_CONSTANT_BUFFERS : CMD_VS_SET_CONSTANT_BUFFERS);
+  command.start = StartSlot;
+  command.count = NumBuffers;
+  command.value = pFirstConstant ? 1 : 0;
+  command.data = store(ppConstantBuffers, sizeof(ID3D11Buffer*) * NumBuffers);
+  if (pFirstConstant) {
+    store(pFirstConstant, sizeof(unsigned int) * NumBuffers);
+    store(pNumConstants, sizeof(unsigned int) * NumBuffers);
+  }
+}
+
+void
+CommandList::PSSetShaderResources(unsigned int StartSlot,
+  unsigned int NumViews,
+  ID3D11ShaderResourceView* const* ppShaderResourceViews) {
+  Command& command = push(CMD_PS_SET_SHADER_RESOURCES);
+  command.start = StartSlot;
+  command.count = NumViews;
+  command.data = store(ppShaderResourceViews, sizeof(ID3D11ShaderResourceView*) * NumViews);
+}
+
+void
+CommandList::PSSetSamplers(unsigned int StartSlot, unsigned int NumSamplers, ID3D11SamplerState* const* ppSamplers) {
+  Command& command = push(CMD_PS_SET_SAMPLERS);
+  command.start = StartSlot;
+  command.count = NumSamplers;
+  command.data = store(ppSamplers, sizeof(ID3D11SamplerState*) * NumSamplers);
+}
+
+void
+CommandList::OMSetRenderTargets(unsigned int NumViews,
+  ID3D11RenderTargetView* const* ppRenderTargetViews,
+  ID3D11DepthStencilView* pDepthStencilView) {
+  Command& command = push(CMD_OM_SET_RENDER_TARGETS, pDepthStencilView);
+  command.count = NumViews;
+  if (NumViews > 0) {
+    command.data = store(ppRenderTargetViews, sizeof(ID3D11RenderTargetView*) * NumViews);
+  }
+}
+
+void
+CommandList::OMSetBlendState(ID3D11BlendState* pBlendState, const float BlendFactor[4], unsigned int SampleMask) {
+  Command& command = push(CMD_OM_SET_BLEND_STATE, pBlendState);
+  command.value = (int)SampleMask;
+  if (BlendFactor) {
+    command.data = store(BlendFactor, sizeof(float) * 4);
+  }
+}
+
+void
+CommandList::ClearRenderTargetView(ID3D11RenderTargetView* pRenderTargetView, const float ColorRGBA[4]) {
+  push(CMD_CLEAR_RENDER_TARGET_VIEW, pRenderTargetView).data = store(ColorRGBA, sizeof(float) * 4);
+}
+
+void
+CommandList::ClearDepthStencilView(ID3D11DepthStencilView* pDepthStencilView,
+  unsigned int ClearFlags,
+  float Depth,
+  UINT8 Stencil) {
+  Command& command = push(CMD_CLEAR_DEPTH_STENCIL_VIEW, pDepthStencilView);
+  command.start = ClearFlags;
+  command.value = Stencil;
+  command.data = store(&Depth, sizeof(float));
+}
+
+void
+CommandList::DrawIndexed(unsigned int IndexCount, unsigned int StartIndexLocation, int BaseVertexLocation) {
+  Command& command = push(CMD_DRAW_INDEXED);
+  command.count = IndexCount;
+  command.start = StartIndexLocation;
+  command.value = BaseVertexLocation;
+  ++m_draws;
+}
+
+void
+CommandList::DrawIndexedInstanced(unsigned int IndexCountPerInstance,
+  unsigned int InstanceCount,
+  unsigned int StartIndexLocation,
+  int BaseVertexLocation,
+  unsigned int StartInstanceLocation) {
+  const unsigned int instances[2] = { InstanceCount, StartInstanceLocation };
+  Command& command = push(CMD_DRAW_INDEXED_INSTANCED);
+  command.count = IndexCountPerInstance;
+  command.start = StartIndexLocation;
+  command.value = BaseVertexLocation;
+  command.data = store(instances, sizeof(instances));
+  ++m_draws;
+}
+
+void
+CommandList::execute(DeviceContext& deviceContext) const {
+  for (const Command& command : m_commands) {
+    void* object = const_cast<void*>(command.object);
+    switch (command.type) {
+    case CMD_CLEAR_STATE:
+      deviceContext.ClearState();
+      break;
+    case CMD_UPDATE_SUBRESOURCE: {
+      const UpdateHeader* header = load<UpdateHeader>(command.data);
+      deviceContext.UpdateSubresource(static_cast<ID3D11Resource*>(object), command.start,
+        header->hasBox ? &header->box : nullptr, load<unsigned char>(command.data + alignData(sizeof(UpdateHeader))),
+        (unsigned int)command.value, header->depthPitch);
+      break;
+    }
+    case CMD_RS_SET_VIEWPORTS:
+      deviceContext.RSSetViewports(command.count, load<D3D11_VIEWPORT>(command.data));
+      break;
+    case CMD_RS_SET_STATE:
+      deviceContext.RSSetState(static_cast<ID3D11RasterizerState*>(object));
+      break;
+    case CMD_IA_SET_INPUT_LAYOUT:
+      deviceContext.IASetInputLayout(static_cast<ID3D11InputLayout*>(object));
+      break;
+    case CMD_IA_SET_VERTEX_BUFFERS: {
+      const unsigned int strides = command.data + alignData(sizeof(ID3D11Buffer*) * command.count);
+      const unsigned int offsets = strides + alignData(sizeof(unsigned int) * command.count);
+      deviceContext.IASetVertexBuffers(command.start, command.count, load<ID3D11Buffer*>(command.data),
+        load<unsigned int>(strides), load<unsigned int>(offsets));
+      break;
+    }
+    case CMD_IA_SET_INDEX_BUFFER:
+      deviceContext.IASetIndexBuffer(static_cast<ID3D11Buffer*>(object), (DXGI_FORMAT)command.start,
+        (unsigned int)command.value);
+      break;
+    case CMD_IA_SET_PRIMITIVE_TOPOLOGY:
+      deviceContext.IASetPrimitiveTopology((D3D11_PRIMITIVE_TOPOLOGY)command.start);
+      break;
+    case CMD_VS_SET_SHADER:
+      deviceContext.VSSetShader(static_cast<ID3D11VertexShader*>(object), nullptr, 0);
+      break;
+    case CMD_PS_SET_SHADER:
+      deviceContext.PSSetShader(static_cast<ID3D11PixelShader*>(object), nullptr, 0);
+      break;
+    case CMD_VS_SET_CONSTANT_BUFFERS:
+    case CMD_PS_SET_CONSTANT_BUFFERS: {
+      const bool pixelShader = command.type == CMD_PS_SET_CONSTANT_BUFFERS;
+      ID3D11Buffer* const* buffers = load<ID3D11Buffer*>(command.data);
+      if (command.value) {
+        const unsigned int first = command.data + alignData(sizeof(ID3D11Buffer*) * command.count);
+        const unsigned int counts = first + alignData(sizeof(unsigned int) * command.count);
+        if (pixelShader)
+          deviceContext.PSSetConstantBuffers1(command.start, command.count, buffers,
+            load<unsigned int>(first), load<unsigned int>(counts));
+        else
+          deviceContext.VSSetConstantBuffers1(command.start, command.count, buffers,
+            load<unsigned int>(first), load<unsigned int>(counts));
+      }
+      else if (pixelShader) {
+        deviceContext.PSSetConstantBuffers(command.start, command.count, buffers);
+      }
+      else {
+        deviceContext.VSSetConstantBuffers(command.start, command.count, buffers);
+      }
+      break;
+    }
+    case CMD_PS_SET_SHADER_RESOURCES:
+      deviceContext.PSSetShaderResources(command.start, command.count, load<ID3D11ShaderResourceView*>(command.data));
+      break;
+    case CMD_PS_SET_SAMPLERS:
+      deviceContext.PSSetSamplers(command.start, command.count, load<ID3D11SamplerState*>(command.data));
+      break;
+    case CMD_OM_SET_RENDER_TARGETS:
+      deviceContext.OMSetRenderTargets(command.count,
+        command.data != kNoData ? load<ID3D11RenderTargetView*>(command.data) : nullptr,
+        static_cast<ID3D11DepthStencilView*>(object));
+      break;
+    case CMD_OM_SET_BLEND_STATE:
+      deviceContext.OMSetBlendState(static_cast<ID3D11BlendState*>(object),
+        command.data != kNoData ? load<float>(command.data) : nullptr, (unsigned int)command.value);
+      break;
+    case CMD_CLEAR_RENDER_TARGET_VIEW:
+      deviceContext.ClearRenderTargetView(static_cast<ID3D11RenderTargetView*>(object), load<float>(command.data));
+      break;
+    case CMD_CLEAR_DEPTH_STENCIL_VIEW:
+      deviceContext.ClearDepthStencilView(static_cast<ID3D11DepthStencilView*>(object), command.start,
+        *load<float>(command.data), (UINT8)command.value);
+      break;
+    case CMD_DRAW_INDEXED:
+      deviceContext.DrawIndexed(command.count, command.start, command.value);
+      break;
+    case CMD_DRAW_INDEXED_INSTANCED: {
+      const unsigned int* instances = load<unsigned int>(command.data);
+      deviceContext.DrawIndexedInstanced(command.count, instances[0], command.start, command.value, instances[1]);
+      break;
+    }
+    default:
+      break;
+    }
+  }
+}
+
+const char*
+CommandList::commandName(CommandType type) {
+  static const char* const kNames[CMD_COUNT] = {
+    "ClearState",
+    "UpdateSubresource",
+    "RSSetViewports",
+    "RSSetState",
+    "IASetInputLayout",
+    "IASetVertexBuffers",
+    "IASetIndexBuffer",
+    "IASetPrimitiveTopology",
+    "VSSetShader",
+    "VSSetConstantBuffers",
+    "PSSetShader",
+    "PSSetConstantBuffers",
+    "PSSetShaderResources",
+    "PSSetSamplers",
+    "OMSetRenderTargets",
+    "OMSetBlendState",
+    "ClearRenderTargetView",
+    "ClearDepthStencilView",
+    "DrawIndexed",
+    "DrawIndexedInstanced"
+  };
+  return type < CMD_COUNT ? kNames[type] : "Unknown";
+}
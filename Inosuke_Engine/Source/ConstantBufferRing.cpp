@@ -0,0 +1,274 @@
+#include "ConstantBufferRing.h"
+#include "Device.h"
+#include "DeviceContext.h"
+
+HRESULT
+ConstantBufferRing::init(Device& device, unsigned int byteWidth) {
+  if (!device.isValid()) {
+    ERROR("ConstantBufferRing", "init", "Device is nullptr");
+    return E_POINTER;
+  }
+  if (byteWidth == 0) {
+    ERROR("ConstantBufferRing", "init", "byteWidth is zero");
+    return E_INVALIDARG;
+  }
+  destroy();
+
+  m_size = (byteWidth + kAlignment - 1) / kAlignment * kAlignment;
+
+  D3D11_BUFFER_DESC desc;
+  memset(&desc, 0, sizeof(desc));
+  desc.Usage = D3D11_USAGE_DYNAMIC;
+  desc.ByteWidth = m_size;
+  desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+  desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+  HRESULT hr = device.CreateBuffer(&desc, nullptr, &m_buffer);
+  if (FAILED(hr)) {
+    ERROR("ConstantBufferRing", "init",
+      ("Failed to create ring buffer. HRESULT: " + std::to_string(hr)).c_str());
+    return hr;
+  }
+
+  desc.ByteWidth = kAlignment;
+  hr = device.CreateBuffer(&desc, nullptr, &m_drawBuffer);
+  if (FAILED(hr)) {
+    ERROR("ConstantBufferRing", "init",
+      ("Failed to create per-draw buffer. HRESULT: " + std::to_string(hr)).c_str());
+    destroy();
+    return hr;
+  }
+
+  D3D11_QUERY_DESC queryDesc;
+  queryDesc.Query = D3D11_QUERY_EVENT;
+  queryDesc.MiscFlags = 0;
+  for (FrameFence& fence : m_fences) {
+    hr = device.CreateQuery(&queryDesc, &fence.query);
+    if (FAILED(hr)) {
+      ERROR("ConstantBufferRing", "init",
+        ("Failed to create fence query. HRESULT: " + std::to_string(hr)).c_str());
+      destroy();
+      return hr;
+    }
+  }
+  return S_OK;
+}
+
+void
+ConstantBufferRing::destroy() {
+  SAFE_RELEASE(m_buffer);
+  SAFE_RELEASE(m_drawBuffer);
+  for (FrameFence& fence : m_fences) {
+    SAFE_RELEASE(fence.query);
+    fence = FrameFence();
+  }
+  m_size = 0;
+  m_head = 0;
+  m_inFlight = 0;
+  m_frameBytes = 0;
+  m_needsDiscard = true;
+  m_nextFence = 0;
+  m_fencesInFlight = 0;
+  m_stats = Stats();
+}
+
+void
+ConstantBufferRing::retireFrames(DeviceContext& deviceContext) {
+  while (m_fencesInFlight > 0) {
+    FrameFence& oldest = m_fences[(m_nextFence + kMaxFramesInFlight - m_fencesInFlight) % kMaxFramesInFlight];
+    BOOL done = FALSE;
+    if (deviceContext.GetData(oldest.query, &done, sizeof(done), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK || !done) {
+      break;
+    }
+    m_inFlight -= oldest.bytes;
+    oldest.bytes = 0;
+    oldest.inFlight = false;
+    --m_fencesInFlight;
+    ++m_stats.framesRetired;
+  }
+}
+
+void
+ConstantBufferRing::forgetInFlight() {
+  for (FrameFence& fence : m_fences) {
+    fence.bytes = 0;
+  }
+  m_inFlight = 0;
+  m_frameBytes = 0;
+  m_head = 0;
+}
+
+bool
+ConstantBufferRing::usesRing(const DeviceContext& deviceContext) {
+  return deviceContext.supportsConstantBufferOffsets() && deviceContext.supportsConstantBufferNoOverwrite();
+}
+
+void
+ConstantBufferRing::beginFrame(DeviceContext& deviceContext) {
+  if (!m_buffer) {
+    return;
+  }
+  retireFrames(deviceContext);
+  m_frameBytes = 0;
+}
+
+void
+ConstantBufferRing::endFrame(DeviceContext& deviceContext) {
+  if (!m_buffer) {
+    return;
+  }
+  ++m_stats.frames;
+
+  FrameFence& fence = m_fences[m_nextFence];
+  if (fence.inFlight) {
+    retireFrames(deviceContext);
+  }
+  if (fence.inFlight) {
+    // La GPU va ms atrasada que kMaxFramesInFlight: en vez de esperarla, el
+    // prximo push() hace DISCARD y el fence se reutiliza para este cuadro
+    ++m_stats.fenceOverflows;
+    forgetInFlight();
+    m_needsDiscard = true;
+    --m_fencesInFlight;
+  }
+
+  deviceContext.End(fence.query);
+  fence.bytes = m_frameBytes;
+  fence.inFlight = true;
+  ++m_fencesInFlight;
+  m_nextFence = (m_nextFence + 1) % kMaxFramesInFlight;
+  m_frameBytes = 0;
+}
+
+bool
+ConstantBufferRing::push(DeviceContext& deviceContext, const void* data, unsigned int bytes, Allocation& out) {
+  if (!m_buffer) {
+    ERROR("ConstantBufferRing", "push", "Ring buffer is not initialized");
+    return false;
+  }
+  if (!data || bytes == 0) {
+    ERROR("ConstantBufferRing", "push", "Invalid arguments: data is nullptr or bytes is zero");
+    return false;
+  }
+  const unsigned int aligned = (bytes + kAlignment - 1) / kAlignment * kAlignment;
+  if (aligned > m_size || aligned > D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT * 16) {
+    ERROR("ConstantBufferRing", "push",
+      ("Allocation of " + std::to_string(bytes) + " bytes does not fit in the ring").c_str());
+    return false;
+  }
+
+  if (!usesRing(deviceContext)) {
+    // Sin offsets todos los objetos leen desde la constante 0, y sin NO_OVERWRITE
+    // cada Map del anillo sera un DISCARD: se renombra el buffer chico de cada
+    // draw, no el anillo
+    if (aligned > kAlignment) {
+      ERROR("ConstantBufferRing", "push",
+        ("Allocation of " + std::to_string(bytes) + " bytes needs the ring (offsets and NO_OVERWRITE)").c_str());
+      return false;
+    }
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (FAILED(deviceContext.Map(m_drawBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+      return false;
+    }
+    memcpy(mapped.pData, data, bytes);
+    deviceContext.Unmap(m_drawBuffer, 0);
+    deviceContext.countUpload(bytes);
+    out.firstConstant = 0;
+    out.numConstants = aligned / 16;
+    ++m_stats.fallbackUploads;
+    ++m_stats.allocations;
+    m_stats.bytesRequested += bytes;
+    m_stats.bytesAllocated += aligned;
+    return true;
+  }
+
+  D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+  if (m_needsDiscard) {
+    mapType = D3D11_MAP_WRITE_DISCARD;
+    forgetInFlight();
+  }
+  else {
+    const bool wrap = m_head + aligned > m_size;
+    const unsigned int skipped = wrap ? m_size - m_head : 0;
+    if (m_inFlight + skipped + aligned > m_size) {
+      retireFrames(deviceContext);
+    }
+    if (m_inFlight + skipped + aligned > m_size) {
+      // La memoria de cuadros en vuelo ocupa el lugar: el driver renombra el buffer
+      ++m_stats.ringFull;
+      mapType = D3D11_MAP_WRITE_DISCARD;
+      forgetInFlight();
+    }
+    else if (wrap) {
+      ++m_stats.wraps;
+      m_stats.bytesWrapped += skipped;
+      m_inFlight += skipped;
+      m_frameBytes += skipped;
+      m_head = 0;
+    }
+  }
+
+  D3D11_MAPPED_SUBRESOURCE mapped;
+  if (FAILED(deviceContext.Map(m_buffer, 0, mapType, 0, &mapped))) {
+    return false;
+  }
+  memcpy(static_cast<unsigned char*>(mapped.pData) + m_head, data, bytes);
+  deviceContext.Unmap(m_buffer, 0);
+  deviceContext.countUpload(bytes);
+
+  if (mapType == D3D11_MAP_WRITE_DISCARD) {
+    ++m_stats.discards;
+    m_needsDiscard = false;
+  }
+  out.firstConstant = m_head / 16;
+  out.numConstants = aligned / 16;
+  m_head += aligned;
+  m_inFlight += aligned;
+  m_frameBytes += aligned;
+
+  ++m_stats.allocations;
+  m_stats.bytesRequested += bytes;
+  m_stats.bytesAllocated += aligned;
+  m_stats.peakBytesInFlight = (std::max)(m_stats.peakBytesInFlight, m_inFlight);
+  return true;
+}
+
+void
+ConstantBufferRing::bind(DeviceContext& deviceContext,
+  unsigned int slot,
+  const Allocation& allocation,
+  bool setPixelShader) {
+  if (!m_buffer) {
+    ERROR("ConstantBufferRing", "bind", "Ring buffer is not initialized");
+    return;
+  }
+  if (!usesRing(deviceContext)) {
+    // push() escribi en m_drawBuffer; la cach de estado filtra el rebind
+    deviceContext.VSSetConstantBuffers(slot, 1, &m_drawBuffer);
+    if (setPixelShader) {
+      deviceContext.PSSetConstantBuffers(slot, 1, &m_drawBuffer);
+    }
+    return;
+  }
+  deviceContext.VSSetConstantBuffers1(slot, 1, &m_buffer, &allocation.firstConstant, &allocation.numConstants);
+  if (setPixelShader) {
+    deviceContext.PSSetConstantBuffers1(slot, 1, &m_buffer, &allocation.firstConstant, &allocation.numConstants);
+  }
+}
+
+void
+ConstantBufferRing::report(const std::string& label) const {
+  std::wostringstream wss;
+  wss << label.c_str() << L": " << m_size << L" byte ring, " << m_stats.allocations << L" allocations over "
+      << m_stats.frames << L" frames ("
+      << (m_stats.frames ? (double)m_stats.allocations / m_stats.frames : 0.0) << L" per frame), "
+      << m_stats.bytesRequested << L" bytes requested, " << m_stats.bytesAllocated << L" allocated, "
+      << m_stats.bytesWrapped << L" skipped at " << m_stats.wraps << L" wraps";
+  MESSAGE(L"ConstantBufferRing", L"report", wss.str());
+
+  wss.str(L"");
+  wss << L"  " << m_stats.discards << L" discards (" << m_stats.ringFull << L" ring full), "
+      << m_stats.fallbackUploads << L" per-draw uploads without the ring, "
+      << m_stats.framesRetired << L" frames retired, " << m_stats.fenceOverflows << L" fence overflows, peak in flight "
+      << m_stats.peakBytesInFlight << L" bytes";
+  MESSAGE(L"ConstantBufferRing", L"report", wss.str());
+}
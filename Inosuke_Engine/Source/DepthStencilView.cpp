@@ -5,7 +5,7 @@
 
 HRESULT
 DepthStencilView::init(Device& device, Texture& depthStencil, DXGI_FORMAT format) {
-	if (!device.m_device) {
+	if (!device.isValid()) {
 		ERROR("DepthStencilView", "init", "Device is null.");
 	}
 	if (!depthStencil.m_texture) {
@@ -21,7 +21,7 @@ DepthStencilView::init(Device& device, Texture& depthStencil, DXGI_FORMAT format
 	descDSV.Texture2D.MipSlice = 0;
 
 	// Create depth stencil view
-	HRESULT hr = device.m_device->CreateDepthStencilView(depthStencil.m_texture,
+	HRESULT hr = device.CreateDepthStencilView(depthStencil.m_texture,
 		&descDSV,
 		&m_depthStencilView);
 
@@ -37,13 +37,13 @@ DepthStencilView::init(Device& device, Texture& depthStencil, DXGI_FORMAT format
 
 void
 DepthStencilView::render(DeviceContext& deviceContext) {
-	if (!deviceContext.m_deviceContext) {
+	if (!deviceContext.isValid()) {
 		ERROR("DepthStencilView", "render", "Device context is null.");
 		return;
 	}
 
 	// Clear depth stencil view
-	deviceContext.m_deviceContext->ClearDepthStencilView(m_depthStencilView,
+	deviceContext.ClearDepthStencilView(m_depthStencilView,
 																												D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL,
 																												1.0f,
 																												0);
@@ -1,7 +1,10 @@
 #include "Device.h"
+#include "NullBackend.h"
+
 void
 Device::destroy() {
 	SAFE_RELEASE(m_device);
+	m_nullBackend = nullptr;
 }
 
 HRESULT
@@ -19,7 +22,9 @@ Device::CreateRenderTargetView(ID3D11Resource* pResource,
 	}
 
 	// Crear el Render Target View
-	HRESULT hr = m_device->CreateRenderTargetView(pResource, pDesc, ppRTView);
+	HRESULT hr = m_nullBackend
+		? m_nullBackend->CreateRenderTargetView(pResource, pDesc, ppRTView)
+		: m_device->CreateRenderTargetView(pResource, pDesc, ppRTView);
 
 	if (SUCCEEDED(hr)) {
 		MESSAGE("Device", "CreateRenderTargetView",
@@ -48,7 +53,9 @@ Device::CreateTexture2D(const D3D11_TEXTURE2D_DESC* pDesc,
 	}
 
 	// Crear la textura 2D
-	HRESULT hr = m_device->CreateTexture2D(pDesc, pInitialData, ppTexture2D);
+	HRESULT hr = m_nullBackend
+		? m_nullBackend->CreateTexture2D(pDesc, pInitialData, ppTexture2D)
+		: m_device->CreateTexture2D(pDesc, pInitialData, ppTexture2D);
 
 	if (SUCCEEDED(hr)) {
 		MESSAGE("Device", "CreateTexture2D",
@@ -77,7 +84,9 @@ Device::CreateDepthStencilView(ID3D11Resource* pResource,
 	}
 
 	// Crear el Depth Stencil View
-	HRESULT hr = m_device->CreateDepthStencilView(pResource, pDesc, ppDepthStencilView);
+	HRESULT hr = m_nullBackend
+		? m_nullBackend->CreateDepthStencilView(pResource, pDesc, ppDepthStencilView)
+		: m_device->CreateDepthStencilView(pResource, pDesc, ppDepthStencilView);
 
 	if (SUCCEEDED(hr)) {
 		MESSAGE("Device", "CreateDepthStencilView",
@@ -107,10 +116,9 @@ Device::CreateVertexShader(const void* pShaderBytecode,
 	}
 
 	// Crear el Vertex Shader
-	HRESULT hr = m_device->CreateVertexShader(pShaderBytecode,
-		BytecodeLength,
-		pClassLinkage,
-		ppVertexShader);
+	HRESULT hr = m_nullBackend
+		? m_nullBackend->CreateVertexShader(pShaderBytecode, BytecodeLength, pClassLinkage, ppVertexShader)
+		: m_device->CreateVertexShader(pShaderBytecode, BytecodeLength, pClassLinkage, ppVertexShader);
 
 	if (SUCCEEDED(hr)) {
 		MESSAGE("Device", "CreateVertexShader",
@@ -141,11 +149,9 @@ Device::CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC* pInputElementDescs,
 	}
 
 	// Crear el Input Layout
-	HRESULT hr = m_device->CreateInputLayout(pInputElementDescs,
-		NumElements,
-		pShaderBytecodeWithInputSignature,
-		BytecodeLength,
-		ppInputLayout);
+	HRESULT hr = m_nullBackend
+		? m_nullBackend->CreateInputLayout(pInputElementDescs, NumElements, pShaderBytecodeWithInputSignature, BytecodeLength, ppInputLayout)
+		: m_device->CreateInputLayout(pInputElementDescs, NumElements, pShaderBytecodeWithInputSignature, BytecodeLength, ppInputLayout);
 
 	if (SUCCEEDED(hr)) {
 		MESSAGE("Device", "CreateInputLayout",
@@ -175,10 +181,9 @@ Device::CreatePixelShader(const void* pShaderBytecode,
 	}
 
 	// Crear el Pixel Shader
-	HRESULT hr = m_device->CreatePixelShader(pShaderBytecode,
-		BytecodeLength,
-		pClassLinkage,
-		ppPixelShader);
+	HRESULT hr = m_nullBackend
+		? m_nullBackend->CreatePixelShader(pShaderBytecode, BytecodeLength, pClassLinkage, ppPixelShader)
+		: m_device->CreatePixelShader(pShaderBytecode, BytecodeLength, pClassLinkage, ppPixelShader);
 
 	if (SUCCEEDED(hr)) {
 		MESSAGE("Device", "CreatePixelShader",
@@ -206,7 +211,9 @@ Device::CreateSamplerState(const D3D11_SAMPLER_DESC* pSamplerDesc,
 	}
 
 	// Crear el Sampler State
-	HRESULT hr = m_device->CreateSamplerState(pSamplerDesc, ppSamplerState);
+	HRESULT hr = m_nullBackend
+		? m_nullBackend->CreateSamplerState(pSamplerDesc, ppSamplerState)
+		: m_device->CreateSamplerState(pSamplerDesc, ppSamplerState);
 
 	if (SUCCEEDED(hr)) {
 		MESSAGE("Device", "CreateSamplerState",
@@ -220,6 +227,36 @@ Device::CreateSamplerState(const D3D11_SAMPLER_DESC* pSamplerDesc,
 	return hr;
 }
 
+HRESULT
+Device::CreateQuery(const D3D11_QUERY_DESC* pQueryDesc,
+	ID3D11Query** ppQuery) {
+	// Validar parametros de entrada
+	if (!pQueryDesc) {
+		ERROR("Device", "CreateQuery", "pQueryDesc is nullptr");
+		return E_INVALIDARG;
+	}
+	if (!ppQuery) {
+		ERROR("Device", "CreateQuery", "ppQuery is nullptr");
+		return E_POINTER;
+	}
+
+	// Crear el Query
+	HRESULT hr = m_nullBackend
+		? m_nullBackend->CreateQuery(pQueryDesc, ppQuery)
+		: m_device->CreateQuery(pQueryDesc, ppQuery);
+
+	if (SUCCEEDED(hr)) {
+		MESSAGE("Device", "CreateQuery",
+			"Query created successfully!");
+	}
+	else {
+		ERROR("Device", "CreateQuery",
+			("Failed to create Query. HRESULT: " + std::to_string(hr)).c_str());
+	}
+
+	return hr;
+}
+
 HRESULT
 Device::CreateBuffer(const D3D11_BUFFER_DESC* pDesc,
 	const D3D11_SUBRESOURCE_DATA* pInitialData,
@@ -235,7 +272,9 @@ Device::CreateBuffer(const D3D11_BUFFER_DESC* pDesc,
 	}
 
 	// Crear el Buffer
-	HRESULT hr = m_device->CreateBuffer(pDesc, pInitialData, ppBuffer);
+	HRESULT hr = m_nullBackend
+		? m_nullBackend->CreateBuffer(pDesc, pInitialData, ppBuffer)
+		: m_device->CreateBuffer(pDesc, pInitialData, ppBuffer);
 
 	if (SUCCEEDED(hr)) {
 		MESSAGE("Device", "CreateBuffer",
@@ -247,4 +286,65 @@ Device::CreateBuffer(const D3D11_BUFFER_DESC* pDesc,
 
 	}
 	return hr;
-}
\ No newline at end of file
+}
+
+HRESULT
+Device::CreateShaderResourceView(ID3D11Resource* pResource,
+	const D3D11_SHADER_RESOURCE_VIEW_DESC* pDesc,
+	ID3D11ShaderResourceView** ppSRView) {
+	// Validar parametros de entrada
+	if (!pResource) {
+		ERROR("Device", "CreateShaderResourceView", "pResource is nullptr");
+		return E_INVALIDARG;
+	}
+	if (!ppSRView) {
+		ERROR("Device", "CreateShaderResourceView", "ppSRView is nullptr");
+		return E_POINTER;
+	}
+
+	// Crear el Shader Resource View
+	HRESULT hr = m_nullBackend
+		? m_nullBackend->CreateShaderResourceView(pResource, pDesc, ppSRView)
+		: m_device->CreateShaderResourceView(pResource, pDesc, ppSRView);
+
+	if (SUCCEEDED(hr)) {
+		MESSAGE("Device", "CreateShaderResourceView",
+			"Shader Resource View created successfully!");
+	}
+	else {
+		ERROR("Device", "CreateShaderResourceView",
+			("Failed to create Shader Resource View. HRESULT: " + std::to_string(hr)).c_str());
+	}
+
+	return hr;
+}
+
+HRESULT
+Device::CreateShaderResourceViewFromFile(const std::string& fileName,
+	ID3D11ShaderResourceView** ppSRView) {
+	// Validar parametros de entrada
+	if (fileName.empty()) {
+		ERROR("Device", "CreateShaderResourceViewFromFile", "fileName is empty");
+		return E_INVALIDARG;
+	}
+	if (!ppSRView) {
+		ERROR("Device", "CreateShaderResourceViewFromFile", "ppSRView is nullptr");
+		return E_POINTER;
+	}
+
+	// Cargar la imagen y crear su Shader Resource View
+	HRESULT hr = m_nullBackend
+		? m_nullBackend->CreateShaderResourceViewFromFile(fileName, ppSRView)
+		: D3DX11CreateShaderResourceViewFromFile(m_device, fileName.c_str(), nullptr, nullptr, ppSRView, nullptr);
+
+	if (SUCCEEDED(hr)) {
+		MESSAGE("Device", "CreateShaderResourceViewFromFile",
+			"Shader Resource View created successfully!");
+	}
+	else {
+		ERROR("Device", "CreateShaderResourceViewFromFile",
+			("Failed to load " + fileName + ". HRESULT: " + std::to_string(hr)).c_str());
+	}
+
+	return hr;
+}
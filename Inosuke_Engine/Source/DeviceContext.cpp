@@ -1,17 +1,345 @@
 #include "DeviceContext.h"
+#include "NullBackend.h"
+#include "CommandList.h"
+#include "Device.h"
+
+namespace {
+	/**
+	 * Busca el sub-rango [first, last] (relativo a StartSlot) de slots que cambian al
+	 * enlazar @p values. Los slots fuera de la cach cuentan como cambiados.
+	 * Devuelve false si todos coinciden con la copia.
+	 */
+	template<typename T>
+	bool
+	changedRange(T* const* bound,
+							 unsigned int boundCount,
+							 unsigned int startSlot,
+							 unsigned int count,
+							 T* const* values,
+							 unsigned int& first,
+							 unsigned int& last) {
+		bool changed = false;
+		for (unsigned int i = 0; i < count; ++i) {
+			const unsigned int slot = startSlot + i;
+			if (slot >= boundCount || bound[slot] != values[i]) {
+				if (!changed) {
+					first = i;
+				}
+				last = i;
+				changed = true;
+			}
+		}
+		return changed;
+	}
+
+	template<typename T>
+	void
+	storeRange(T** bound,
+						 unsigned int boundCount,
+						 unsigned int startSlot,
+						 unsigned int count,
+						 T* const* values) {
+		for (unsigned int i = 0; i < count && startSlot + i < boundCount; ++i) {
+			bound[startSlot + i] = values[i];
+		}
+	}
+}
 
 void
 DeviceContext::destroy() {
+#if INOSUKE_D3D11_1
+	SAFE_RELEASE(m_deviceContext1);
+#endif
 	SAFE_RELEASE(m_deviceContext);
+	m_nullBackend = nullptr;
+	m_commandList = nullptr;
+	m_nativeList = nullptr;
+	m_deferred = false;
+	m_bound = BoundState();
+}
+
+HRESULT
+DeviceContext::initDeferred(Device& device, bool native) {
+	destroy();
+	m_deferred = true;
+	if (native && device.m_device) {
+		HRESULT hr = device.m_device->CreateDeferredContext(0, &m_deviceContext);
+		if (FAILED(hr)) {
+			ERROR("DeviceContext", "initDeferred",
+				("Failed to create deferred context. HRESULT: " + std::to_string(hr)).c_str());
+			m_deferred = false;
+			return hr;
+		}
+		queryFeatures(device);
+	}
+	return S_OK;
+}
+
+bool
+DeviceContext::rejectIdleDeferred(const char* method) const {
+	// Sin lista abierta un contexto diferido no tiene a dnde mandar la llamada
+	// (el de formato del motor ni siquiera tiene ID3D11DeviceContext)
+	if (m_deferred && !isRecording()) {
+		ERROR("DeviceContext", method, "Deferred context used outside beginRecording()/finishRecording()");
+		return true;
+	}
+	return false;
+}
+
+bool
+DeviceContext::supportsConstantBufferOffsets() const {
+	if (m_nullBackend) {
+		return m_nullBackend->m_constantBufferOffsets;
+	}
+#if INOSUKE_D3D11_1
+	return m_deviceContext1 != nullptr;
+#else
+	return false;
+#endif
+}
+
+bool
+DeviceContext::supportsConstantBufferNoOverwrite() const {
+	if (m_nullBackend) {
+		return m_nullBackend->m_constantBufferNoOverwrite;
+	}
+#if INOSUKE_D3D11_1
+	return m_constantBufferNoOverwrite;
+#else
+	return false;
+#endif
+}
+
+void
+DeviceContext::queryFeatures(Device& device) {
+#if INOSUKE_D3D11_1
+	SAFE_RELEASE(m_deviceContext1);
+	m_constantBufferNoOverwrite = false;
+	if (!m_deviceContext || !device.m_device) {
+		return;
+	}
+	// Windows 7 con Platform Update da ID3D11DeviceContext1 pero sin offsets
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	if (FAILED(device.m_device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options)))) {
+		return;
+	}
+	m_constantBufferNoOverwrite = options.MapNoOverwriteOnDynamicConstantBuffer != FALSE;
+	if (options.ConstantBufferOffsetting) {
+		m_deviceContext->QueryInterface(__uuidof(ID3D11DeviceContext1), reinterpret_cast<void**>(&m_deviceContext1));
+	}
+#else
+	(void)device;
+#endif
+	if (supportsConstantBufferOffsets()) {
+		MESSAGE("DeviceContext", "queryFeatures", "Constant buffer offsets supported (D3D 11.1)");
+	}
+	if (supportsConstantBufferNoOverwrite()) {
+		MESSAGE("DeviceContext", "queryFeatures", "NO_OVERWRITE on dynamic constant buffers supported");
+	}
+}
+
+void
+DeviceContext::beginRecording(CommandList& commandList) {
+	if (!m_deferred) {
+		ERROR("DeviceContext", "beginRecording", "Only deferred contexts record command lists");
+		return;
+	}
+	if (isRecording()) {
+		ERROR("DeviceContext", "beginRecording", "A command list is already being recorded");
+		return;
+	}
+	commandList.reset();
+	// Como un contexto diferido de D3D11, cada lista empieza con el estado de ClearState()
+	m_bound = BoundState();
+	if (m_deviceContext) {
+		m_nativeList = &commandList;
+	}
+	else {
+		m_commandList = &commandList;
+	}
+}
+
+HRESULT
+DeviceContext::finishRecording() {
+	HRESULT hr = S_OK;
+	if (m_nativeList) {
+		hr = m_deviceContext->FinishCommandList(FALSE, &m_nativeList->m_native);
+		if (FAILED(hr)) {
+			ERROR("DeviceContext", "finishRecording",
+				("Failed to finish command list. HRESULT: " + std::to_string(hr)).c_str());
+		}
+	}
+	m_commandList = nullptr;
+	m_nativeList = nullptr;
+	return hr;
+}
+
+void
+DeviceContext::ExecuteCommandList(const CommandList& commandList) {
+	if (m_deferred) {
+		ERROR("DeviceContext", "ExecuteCommandList", "Command lists run on the immediate context");
+		return;
+	}
+	if (commandList.m_native) {
+		if (!m_deviceContext) {
+			ERROR("DeviceContext", "ExecuteCommandList", "Native command list without a D3D11 context");
+			return;
+		}
+		// RestoreContextState = FALSE: D3D11 deja el contexto como tras ClearState()
+		m_deviceContext->ExecuteCommandList(commandList.m_native, FALSE);
+		m_bound = BoundState();
+		return;
+	}
+	commandList.execute(*this);
+	ClearState();
+}
+
+unsigned int
+DeviceContext::StateStats::totalIssued() const {
+	unsigned int total = 0;
+	for (int i = 0; i < STATE_COUNT; ++i) {
+		total += issued[i];
+	}
+	return total;
+}
+
+unsigned int
+DeviceContext::StateStats::totalFiltered() const {
+	unsigned int total = 0;
+	for (int i = 0; i < STATE_COUNT; ++i) {
+		total += filtered[i];
+	}
+	return total;
+}
+
+bool
+DeviceContext::filterCall(StateCall call, bool redundant) {
+	if (redundant && m_filterRedundantState) {
+		++m_frameStats.filtered[call];
+		return true;
+	}
+	++m_frameStats.issued[call];
+	return false;
+}
+
+void
+DeviceContext::beginFrame() {
+	endFrame();
+	m_frameStats = StateStats();
+	m_frameOpen = true;
+}
+
+void
+DeviceContext::endFrame() {
+	if (!m_frameOpen)
+		return;
+	m_lastFrameStats = m_frameStats;
+	for (int i = 0; i < STATE_COUNT; ++i) {
+		m_totalStats.issued[i] += m_frameStats.issued[i];
+		m_totalStats.filtered[i] += m_frameStats.filtered[i];
+	}
+	m_totalStats.uploads += m_frameStats.uploads;
+	m_totalStats.uploadBytes += m_frameStats.uploadBytes;
+	++m_frameCount;
+	m_frameOpen = false;
+}
+
+const char*
+DeviceContext::stateCallName(StateCall call) {
+	static const char* names[STATE_COUNT] = {
+		"RSSetViewports",
+		"RSSetState",
+		"IASetInputLayout",
+		"IASetVertexBuffers",
+		"IASetIndexBuffer",
+		"IASetPrimitiveTopology",
+		"VSSetShader",
+		"VSSetConstantBuffers",
+		"PSSetShader",
+		"PSSetConstantBuffers",
+		"PSSetShaderResources",
+		"PSSetSamplers",
+		"OMSetRenderTargets",
+		"OMSetBlendState"
+	};
+	return (call >= 0 && call < STATE_COUNT) ? names[call] : "Unknown";
+}
+
+void
+DeviceContext::reportStateStats(const std::string& label) const {
+	std::wostringstream wss;
+	wss << label.c_str() << L": last frame " << m_lastFrameStats.totalIssued() << L" state calls issued, "
+		<< m_lastFrameStats.totalFiltered() << L" filtered";
+	if (m_frameCount > 0) {
+		wss << L"; average over " << m_frameCount << L" frames "
+			<< (double)m_totalStats.totalIssued() / m_frameCount << L" issued, "
+			<< (double)m_totalStats.totalFiltered() / m_frameCount << L" filtered";
+	}
+	MESSAGE(L"DeviceContext", L"reportStateStats", wss.str());
+
+	wss.str(L"");
+	wss << L"  constant uploads: last frame " << m_lastFrameStats.uploads << L" (" << m_lastFrameStats.uploadBytes
+		<< L" bytes)";
+	if (m_frameCount > 0) {
+		wss << L"; average " << (double)m_totalStats.uploads / m_frameCount << L" ("
+			<< (double)m_totalStats.uploadBytes / m_frameCount << L" bytes)";
+	}
+	MESSAGE(L"DeviceContext", L"reportStateStats", wss.str());
+
+	for (int i = 0; i < STATE_COUNT; ++i) {
+		if (m_lastFrameStats.issued[i] == 0 && m_lastFrameStats.filtered[i] == 0) {
+			continue;
+		}
+		wss.str(L"");
+		wss << L"  " << stateCallName((StateCall)i) << L": " << m_lastFrameStats.issued[i]
+			<< L" issued, " << m_lastFrameStats.filtered[i] << L" filtered";
+		MESSAGE(L"DeviceContext", L"reportStateStats", wss.str());
+	}
+}
+
+void
+DeviceContext::ClearState() {
+	m_bound = BoundState();
+	if (m_commandList) {
+		m_commandList->ClearState();
+		return;
+	}
+	if (m_nullBackend) {
+		m_nullBackend->ClearState();
+		return;
+	}
+	if (m_deviceContext) {
+		m_deviceContext->ClearState();
+	}
 }
 
 void
 DeviceContext::RSSetViewports(unsigned int NumViewports,
 															const D3D11_VIEWPORT* pViewports) {
+	if (rejectIdleDeferred("RSSetViewports"))
+		return;
 	if (!pViewports) {
 		ERROR("DeviceContext", "RSSetViewports", "pViewports is nullptr");
 		return;
 	}
+	// Solo se compara el caso comn de un viewport
+	const bool redundant = NumViewports == 1 && m_bound.numViewports == 1 &&
+		memcmp(&m_bound.viewport, pViewports, sizeof(D3D11_VIEWPORT)) == 0;
+	if (filterCall(STATE_RS_SET_VIEWPORTS, redundant)) {
+		return;
+	}
+	m_bound.numViewports = NumViewports;
+	if (NumViewports > 0) {
+		m_bound.viewport = pViewports[0];
+	}
+	if (m_commandList) {
+		m_commandList->RSSetViewports(NumViewports, pViewports);
+		return;
+	}
+	if (m_nullBackend) {
+		m_nullBackend->RSSetViewports(NumViewports, pViewports);
+		return;
+	}
 	m_deviceContext->RSSetViewports(NumViewports, pViewports);
 }
 
@@ -19,19 +347,61 @@ void
 DeviceContext::PSSetShaderResources(unsigned int StartSlot,
 																		unsigned int NumViews,
 																		ID3D11ShaderResourceView* const* ppShaderResourceViews) {
+	if (rejectIdleDeferred("PSSetShaderResources"))
+		return;
 	if (!ppShaderResourceViews) {
 		ERROR("DeviceContext", "PSSetShaderResources", "ppShaderResourceViews is nullptr");
 		return;
 	}
+	unsigned int first = 0, last = 0;
+	bool changed = changedRange(m_bound.psShaderResources, kMaxShaderResources,
+		StartSlot, NumViews, ppShaderResourceViews, first, last);
+	if (!m_bound.shaderResourcesKnown || !m_filterRedundantState) {
+		changed = NumViews > 0;
+		first = 0;
+		last = NumViews - 1;
+	}
+	if (filterCall(STATE_PS_SET_SHADER_RESOURCES, !changed)) {
+		return;
+	}
+	storeRange(m_bound.psShaderResources, kMaxShaderResources, StartSlot, NumViews, ppShaderResourceViews);
+	m_bound.shaderResourcesKnown = true;
+
+	// Solo el sub-rango que cambi
+	StartSlot += first;
+	NumViews = last - first + 1;
+	ppShaderResourceViews += first;
+	if (m_commandList) {
+		m_commandList->PSSetShaderResources(StartSlot, NumViews, ppShaderResourceViews);
+		return;
+	}
+	if (m_nullBackend) {
+		m_nullBackend->PSSetShaderResources(StartSlot, NumViews, ppShaderResourceViews);
+		return;
+	}
 	m_deviceContext->PSSetShaderResources(StartSlot, NumViews, ppShaderResourceViews);
 }
 
 void
 DeviceContext::IASetInputLayout(ID3D11InputLayout* pInputLayout) {
+	if (rejectIdleDeferred("IASetInputLayout"))
+		return;
 	if (!pInputLayout) {
 		ERROR("DeviceContext", "IASetInputLayout", "pInputLayout is nullptr");
 		return;
 	}
+	if (filterCall(STATE_IA_SET_INPUT_LAYOUT, m_bound.inputLayout == pInputLayout)) {
+		return;
+	}
+	m_bound.inputLayout = pInputLayout;
+	if (m_commandList) {
+		m_commandList->IASetInputLayout(pInputLayout);
+		return;
+	}
+	if (m_nullBackend) {
+		m_nullBackend->IASetInputLayout(pInputLayout);
+		return;
+	}
 	m_deviceContext->IASetInputLayout(pInputLayout);
 }
 
@@ -39,10 +409,25 @@ void
 DeviceContext::VSSetShader(ID3D11VertexShader* pVertexShader,
 														ID3D11ClassInstance* const* ppClassInstances,
 														unsigned int NumClassInstances) {
+	if (rejectIdleDeferred("VSSetShader"))
+		return;
 	if (!pVertexShader) {
 		ERROR("DeviceContext", "VSSetShader", "pVertexShader is nullptr");
 		return;
 	}
+	// Con class instances no se filtra (la cach no las guarda)
+	if (filterCall(STATE_VS_SET_SHADER, m_bound.vertexShader == pVertexShader && NumClassInstances == 0)) {
+		return;
+	}
+	m_bound.vertexShader = pVertexShader;
+	if (m_commandList) {
+		m_commandList->VSSetShader(pVertexShader);
+		return;
+	}
+	if (m_nullBackend) {
+		m_nullBackend->VSSetShader(pVertexShader);
+		return;
+	}
 	m_deviceContext->VSSetShader(pVertexShader, ppClassInstances, NumClassInstances);
 }
 
@@ -50,10 +435,24 @@ void
 DeviceContext::PSSetShader(ID3D11PixelShader* pPixelShader,
 														ID3D11ClassInstance* const* ppClassInstances,
 														unsigned int NumClassInstances) {
+	if (rejectIdleDeferred("PSSetShader"))
+		return;
 	if (!pPixelShader) {
 		ERROR("DeviceContext", "PSSetShader", "pPixelShader is nullptr");
 		return;
 	}
+	if (filterCall(STATE_PS_SET_SHADER, m_bound.pixelShader == pPixelShader && NumClassInstances == 0)) {
+		return;
+	}
+	m_bound.pixelShader = pPixelShader;
+	if (m_commandList) {
+		m_commandList->PSSetShader(pPixelShader);
+		return;
+	}
+	if (m_nullBackend) {
+		m_nullBackend->PSSetShader(pPixelShader);
+		return;
+	}
 	m_deviceContext->PSSetShader(pPixelShader, ppClassInstances, NumClassInstances);
 }
 
@@ -64,11 +463,21 @@ DeviceContext::UpdateSubresource(ID3D11Resource* pDstResource,
 																	const void* pSrcData,
 																	unsigned int SrcRowPitch,
 																	unsigned int SrcDepthPitch) {
+	if (rejectIdleDeferred("UpdateSubresource"))
+		return;
 	if (!pDstResource || !pSrcData) {
 		ERROR("DeviceContext", "UpdateSubresource",
 			"Invalid arguments: pDstResource or pSrcData is nullptr");
 		return;
 	}
+	if (m_commandList) {
+		m_commandList->UpdateSubresource(pDstResource, DstSubresource, pDstBox, pSrcData, SrcRowPitch, SrcDepthPitch);
+		return;
+	}
+	if (m_nullBackend) {
+		m_nullBackend->UpdateSubresource(pDstResource, DstSubresource, pDstBox, pSrcData, SrcRowPitch, SrcDepthPitch);
+		return;
+	}
 	m_deviceContext->UpdateSubresource(pDstResource,
 																		DstSubresource,
 																		pDstBox,
@@ -83,11 +492,55 @@ DeviceContext::IASetVertexBuffers(unsigned int StartSlot,
 																	ID3D11Buffer* const* ppVertexBuffers,
 																	const unsigned int* pStrides,
 																	const unsigned int* pOffsets) {
+	if (rejectIdleDeferred("IASetVertexBuffers"))
+		return;
 	if (!ppVertexBuffers || !pStrides || !pOffsets) {
 		ERROR("DeviceContext", "IASetVertexBuffers",
 			"Invalid arguments: ppVertexBuffers, pStrides, or pOffsets is nullptr");
 		return;
 	}
+	unsigned int first = 0, last = 0;
+	bool changed = false;
+	for (unsigned int i = 0; i < NumBuffers; ++i) {
+		const unsigned int slot = StartSlot + i;
+		if (slot >= kMaxVertexBuffers ||
+			m_bound.vertexBuffers[slot] != ppVertexBuffers[i] ||
+			m_bound.vertexStrides[slot] != pStrides[i] ||
+			m_bound.vertexOffsets[slot] != pOffsets[i]) {
+			if (!changed) {
+				first = i;
+			}
+			last = i;
+			changed = true;
+		}
+	}
+	if (filterCall(STATE_IA_SET_VERTEX_BUFFERS, !changed)) {
+		return;
+	}
+	if (!m_filterRedundantState) {
+		first = 0;
+		last = NumBuffers - 1;
+	}
+	for (unsigned int i = 0; i < NumBuffers && StartSlot + i < kMaxVertexBuffers; ++i) {
+		m_bound.vertexBuffers[StartSlot + i] = ppVertexBuffers[i];
+		m_bound.vertexStrides[StartSlot + i] = pStrides[i];
+		m_bound.vertexOffsets[StartSlot + i] = pOffsets[i];
+	}
+
+	// Solo el sub-rango que cambi
+	StartSlot += first;
+	NumBuffers = last - first + 1;
+	ppVertexBuffers += first;
+	pStrides += first;
+	pOffsets += first;
+	if (m_commandList) {
+		m_commandList->IASetVertexBuffers(StartSlot, NumBuffers, ppVertexBuffers, pStrides, pOffsets);
+		return;
+	}
+	if (m_nullBackend) {
+		m_nullBackend->IASetVertexBuffers(StartSlot, NumBuffers, ppVertexBuffers, pStrides, pOffsets);
+		return;
+	}
 	m_deviceContext->IASetVertexBuffers(StartSlot,
 																			NumBuffers,
 																			ppVertexBuffers,
@@ -99,10 +552,27 @@ void
 DeviceContext::IASetIndexBuffer(ID3D11Buffer* pIndexBuffer,
 																DXGI_FORMAT Format,
 																unsigned int Offset) {
+	if (rejectIdleDeferred("IASetIndexBuffer"))
+		return;
 	if (!pIndexBuffer) {
 		ERROR("DeviceContext", "IASetIndexBuffer", "pIndexBuffer is nullptr");
 		return;
 	}
+	if (filterCall(STATE_IA_SET_INDEX_BUFFER, m_bound.indexBuffer == pIndexBuffer &&
+		m_bound.indexFormat == Format && m_bound.indexOffset == Offset)) {
+		return;
+	}
+	m_bound.indexBuffer = pIndexBuffer;
+	m_bound.indexFormat = Format;
+	m_bound.indexOffset = Offset;
+	if (m_commandList) {
+		m_commandList->IASetIndexBuffer(pIndexBuffer, Format, Offset);
+		return;
+	}
+	if (m_nullBackend) {
+		m_nullBackend->IASetIndexBuffer(pIndexBuffer, Format, Offset);
+		return;
+	}
 	m_deviceContext->IASetIndexBuffer(pIndexBuffer, Format, Offset);
 }
 
@@ -110,19 +580,59 @@ void
 DeviceContext::PSSetSamplers(unsigned int StartSlot,
 															unsigned int NumSamplers,
 															ID3D11SamplerState* const* ppSamplers) {
+	if (rejectIdleDeferred("PSSetSamplers"))
+		return;
 	if (!ppSamplers) {
 		ERROR("DeviceContext", "PSSetSamplers", "ppSamplers is nullptr");
 		return;
 	}
+	unsigned int first = 0, last = 0;
+	const bool changed = changedRange(m_bound.psSamplers, kMaxSamplers,
+		StartSlot, NumSamplers, ppSamplers, first, last);
+	if (filterCall(STATE_PS_SET_SAMPLERS, !changed)) {
+		return;
+	}
+	if (!m_filterRedundantState) {
+		first = 0;
+		last = NumSamplers - 1;
+	}
+	storeRange(m_bound.psSamplers, kMaxSamplers, StartSlot, NumSamplers, ppSamplers);
+
+	// Solo el sub-rango que cambi
+	StartSlot += first;
+	NumSamplers = last - first + 1;
+	ppSamplers += first;
+	if (m_commandList) {
+		m_commandList->PSSetSamplers(StartSlot, NumSamplers, ppSamplers);
+		return;
+	}
+	if (m_nullBackend) {
+		m_nullBackend->PSSetSamplers(StartSlot, NumSamplers, ppSamplers);
+		return;
+	}
 	m_deviceContext->PSSetSamplers(StartSlot, NumSamplers, ppSamplers);
 }
 
 void
 DeviceContext::RSSetState(ID3D11RasterizerState* pRasterizerState) {
+	if (rejectIdleDeferred("RSSetState"))
+		return;
 	if (!pRasterizerState) {
 		ERROR("DeviceContext", "RSSetState", "pRasterizerState is nullptr");
 		return;
 	}
+	if (filterCall(STATE_RS_SET_STATE, m_bound.rasterizerState == pRasterizerState)) {
+		return;
+	}
+	m_bound.rasterizerState = pRasterizerState;
+	if (m_commandList) {
+		m_commandList->RSSetState(pRasterizerState);
+		return;
+	}
+	if (m_nullBackend) {
+		m_nullBackend->RSSetState(pRasterizerState);
+		return;
+	}
 	m_deviceContext->RSSetState(pRasterizerState);
 }
 
@@ -130,10 +640,31 @@ void
 DeviceContext::OMSetBlendState(ID3D11BlendState* pBlendState,
 															const float BlendFactor[4],
 															unsigned int SampleMask) {
+	if (rejectIdleDeferred("OMSetBlendState"))
+		return;
 	if (!pBlendState) {
 		ERROR("DeviceContext", "OMSetBlendState", "pBlendState is nullptr");
 		return;
 	}
+	// BlendFactor nulo equivale a { 1, 1, 1, 1 }
+	const float defaultFactor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	const float* factor = BlendFactor ? BlendFactor : defaultFactor;
+	if (filterCall(STATE_OM_SET_BLEND_STATE, m_bound.blendState == pBlendState &&
+		m_bound.sampleMask == SampleMask &&
+		memcmp(m_bound.blendFactor, factor, sizeof(m_bound.blendFactor)) == 0)) {
+		return;
+	}
+	m_bound.blendState = pBlendState;
+	m_bound.sampleMask = SampleMask;
+	memcpy(m_bound.blendFactor, factor, sizeof(m_bound.blendFactor));
+	if (m_commandList) {
+		m_commandList->OMSetBlendState(pBlendState, BlendFactor, SampleMask);
+		return;
+	}
+	if (m_nullBackend) {
+		m_nullBackend->OMSetBlendState(pBlendState, SampleMask);
+		return;
+	}
 	m_deviceContext->OMSetBlendState(pBlendState, BlendFactor, SampleMask);
 }
 
@@ -141,6 +672,8 @@ void
 DeviceContext::OMSetRenderTargets(unsigned int NumViews,
 																	ID3D11RenderTargetView* const* ppRenderTargetViews,
 																	ID3D11DepthStencilView* pDepthStencilView) {
+	if (rejectIdleDeferred("OMSetRenderTargets"))
+		return;
 	// Validar los parmetros
 	if (!ppRenderTargetViews && !pDepthStencilView) {
 		ERROR("DeviceContext", "OMSetRenderTargets",
@@ -154,12 +687,39 @@ DeviceContext::OMSetRenderTargets(unsigned int NumViews,
 		return;
 	}
 
+	bool redundant = NumViews <= kMaxRenderTargets &&
+		NumViews == m_bound.numRenderTargets &&
+		pDepthStencilView == m_bound.depthStencilView;
+	for (unsigned int i = 0; redundant && i < NumViews; ++i) {
+		redundant = m_bound.renderTargets[i] == ppRenderTargetViews[i];
+	}
+	if (filterCall(STATE_OM_SET_RENDER_TARGETS, redundant)) {
+		return;
+	}
+	memset(m_bound.renderTargets, 0, sizeof(m_bound.renderTargets));
+	for (unsigned int i = 0; i < NumViews && i < kMaxRenderTargets; ++i) {
+		m_bound.renderTargets[i] = ppRenderTargetViews[i];
+	}
+	m_bound.numRenderTargets = NumViews;
+	m_bound.depthStencilView = pDepthStencilView;
+	m_bound.shaderResourcesKnown = false;
+
 	// Asignar los render targets y el depth stencil
+	if (m_commandList) {
+		m_commandList->OMSetRenderTargets(NumViews, ppRenderTargetViews, pDepthStencilView);
+		return;
+	}
+	if (m_nullBackend) {
+		m_nullBackend->OMSetRenderTargets(NumViews, ppRenderTargetViews, pDepthStencilView);
+		return;
+	}
 	m_deviceContext->OMSetRenderTargets(NumViews, ppRenderTargetViews, pDepthStencilView);
 }
 
 void
 DeviceContext::IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY Topology) {
+	if (rejectIdleDeferred("IASetPrimitiveTopology"))
+		return;
 	// Validar el parmetro Topology
 	if (Topology == D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED) {
 		ERROR("DeviceContext", "IASetPrimitiveTopology",
@@ -167,13 +727,28 @@ DeviceContext::IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY Topology) {
 		return;
 	}
 
+	if (filterCall(STATE_IA_SET_PRIMITIVE_TOPOLOGY, m_bound.topology == Topology)) {
+		return;
+	}
+	m_bound.topology = Topology;
+
 	// Asignar la topologa al Input Assembler
+	if (m_commandList) {
+		m_commandList->IASetPrimitiveTopology(Topology);
+		return;
+	}
+	if (m_nullBackend) {
+		m_nullBackend->IASetPrimitiveTopology(Topology);
+		return;
+	}
 	m_deviceContext->IASetPrimitiveTopology(Topology);
 }
 
 void
 DeviceContext::ClearRenderTargetView(ID3D11RenderTargetView* pRenderTargetView,
 	const float ColorRGBA[4]) {
+	if (rejectIdleDeferred("ClearRenderTargetView"))
+		return;
 	// Validar parmetros
 	if (!pRenderTargetView) {
 		ERROR("DeviceContext", "ClearRenderTargetView", "pRenderTargetView is nullptr");
@@ -185,6 +760,14 @@ DeviceContext::ClearRenderTargetView(ID3D11RenderTargetView* pRenderTargetView,
 	}
 
 	// Limpiar el render target
+	if (m_commandList) {
+		m_commandList->ClearRenderTargetView(pRenderTargetView, ColorRGBA);
+		return;
+	}
+	if (m_nullBackend) {
+		m_nullBackend->ClearRenderTargetView(pRenderTargetView, ColorRGBA);
+		return;
+	}
 	m_deviceContext->ClearRenderTargetView(pRenderTargetView, ColorRGBA);
 }
 
@@ -193,6 +776,8 @@ DeviceContext::ClearDepthStencilView(ID3D11DepthStencilView* pDepthStencilView,
 																			unsigned int ClearFlags,
 																			float Depth,
 																			UINT8 Stencil) {
+	if (rejectIdleDeferred("ClearDepthStencilView"))
+		return;
 	// Validar parmetros
 	if (!pDepthStencilView) {
 		ERROR("DeviceContext", "ClearDepthStencilView",
@@ -208,6 +793,14 @@ DeviceContext::ClearDepthStencilView(ID3D11DepthStencilView* pDepthStencilView,
 	}
 
 	// Limpiar el depth stencil
+	if (m_commandList) {
+		m_commandList->ClearDepthStencilView(pDepthStencilView, ClearFlags, Depth, Stencil);
+		return;
+	}
+	if (m_nullBackend) {
+		m_nullBackend->ClearDepthStencilView(pDepthStencilView, ClearFlags, Depth, Stencil);
+		return;
+	}
 	m_deviceContext->ClearDepthStencilView(pDepthStencilView, ClearFlags, Depth, Stencil);
 }
 
@@ -220,9 +813,7 @@ DeviceContext::VSSetConstantBuffers(unsigned int StartSlot,
 		ERROR("DeviceContext", "VSSetConstantBuffers", "ppConstantBuffers is nullptr");
 		return;
 	}
-
-	// Asignar los constant buffers al vertex shader
-	m_deviceContext->VSSetConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers);
+	setConstantBuffers(false, StartSlot, NumBuffers, ppConstantBuffers, nullptr, nullptr);
 }
 
 void
@@ -234,15 +825,225 @@ DeviceContext::PSSetConstantBuffers(unsigned int StartSlot,
 		ERROR("DeviceContext", "PSSetConstantBuffers", "ppConstantBuffers is nullptr");
 		return;
 	}
+	setConstantBuffers(true, StartSlot, NumBuffers, ppConstantBuffers, nullptr, nullptr);
+}
+
+void
+DeviceContext::VSSetConstantBuffers1(unsigned int StartSlot,
+																		 unsigned int NumBuffers,
+																		 ID3D11Buffer* const* ppConstantBuffers,
+																		 const unsigned int* pFirstConstant,
+																		 const unsigned int* pNumConstants) {
+	// Validar parmetros
+	if (!ppConstantBuffers || !pFirstConstant || !pNumConstants) {
+		ERROR("DeviceContext", "VSSetConstantBuffers1",
+			"Invalid arguments: ppConstantBuffers, pFirstConstant, or pNumConstants is nullptr");
+		return;
+	}
+	setConstantBuffers(false, StartSlot, NumBuffers, ppConstantBuffers, pFirstConstant, pNumConstants);
+}
+
+void
+DeviceContext::PSSetConstantBuffers1(unsigned int StartSlot,
+																		 unsigned int NumBuffers,
+																		 ID3D11Buffer* const* ppConstantBuffers,
+																		 const unsigned int* pFirstConstant,
+																		 const unsigned int* pNumConstants) {
+	// Validar parmetros
+	if (!ppConstantBuffers || !pFirstConstant || !pNumConstants) {
+		ERROR("DeviceContext", "PSSetConstantBuffers1",
+			"Invalid arguments: ppConstantBuffers, pFirstConstant, or pNumConstants is nullptr");
+		return;
+	}
+	setConstantBuffers(true, StartSlot, NumBuffers, ppConstantBuffers, pFirstConstant, pNumConstants);
+}
+
+void
+DeviceContext::setConstantBuffers(bool pixelShader,
+																	unsigned int StartSlot,
+																	unsigned int NumBuffers,
+																	ID3D11Buffer* const* ppConstantBuffers,
+																	const unsigned int* pFirstConstant,
+																	const unsigned int* pNumConstants) {
+	if (rejectIdleDeferred("VS/PSSetConstantBuffers"))
+		return;
+	ID3D11Buffer** bound = pixelShader ? m_bound.psConstantBuffers : m_bound.vsConstantBuffers;
+	unsigned int* boundFirst = pixelShader ? m_bound.psFirstConstants : m_bound.vsFirstConstants;
+	unsigned int* boundCount = pixelShader ? m_bound.psNumConstants : m_bound.vsNumConstants;
+
+	// Un slot cambia si cambia el buffer o su ventana de constantes
+	unsigned int first = 0, last = 0;
+	bool changed = false;
+	for (unsigned int i = 0; i < NumBuffers; ++i) {
+		const unsigned int slot = StartSlot + i;
+		const unsigned int firstConstant = pFirstConstant ? pFirstConstant[i] : 0;
+		const unsigned int numConstants = pNumConstants ? pNumConstants[i] : D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT;
+		if (slot >= kMaxConstantBuffers ||
+			bound[slot] != ppConstantBuffers[i] ||
+			boundFirst[slot] != firstConstant ||
+			boundCount[slot] != numConstants) {
+			if (!changed) {
+				first = i;
+			}
+			last = i;
+			changed = true;
+		}
+	}
+	if (filterCall(pixelShader ? STATE_PS_SET_CONSTANT_BUFFERS : STATE_VS_SET_CONSTANT_BUFFERS, !changed)) {
+		return;
+	}
+	if (!m_filterRedundantState) {
+		first = 0;
+		last = NumBuffers - 1;
+	}
+	for (unsigned int i = 0; i < NumBuffers && StartSlot + i < kMaxConstantBuffers; ++i) {
+		bound[StartSlot + i] = ppConstantBuffers[i];
+		boundFirst[StartSlot + i] = pFirstConstant ? pFirstConstant[i] : 0;
+		boundCount[StartSlot + i] = pNumConstants ? pNumConstants[i] : D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT;
+	}
+
+	// Asignar los constant buffers al shader (solo el sub-rango que cambi)
+	StartSlot += first;
+	NumBuffers = last - first + 1;
+	ppConstantBuffers += first;
+	if (pFirstConstant) {
+		pFirstConstant += first;
+		pNumConstants += first;
+	}
+	if (m_commandList) {
+		m_commandList->SetConstantBuffers(pixelShader, StartSlot, NumBuffers, ppConstantBuffers, pFirstConstant, pNumConstants);
+		return;
+	}
+	if (pFirstConstant) {
+		if (m_nullBackend && m_nullBackend->m_constantBufferOffsets) {
+			if (pixelShader)
+				m_nullBackend->PSSetConstantBuffers1(StartSlot, NumBuffers, ppConstantBuffers, pFirstConstant, pNumConstants);
+			else
+				m_nullBackend->VSSetConstantBuffers1(StartSlot, NumBuffers, ppConstantBuffers, pFirstConstant, pNumConstants);
+			return;
+		}
+#if INOSUKE_D3D11_1
+		if (!m_nullBackend && m_deviceContext1) {
+			if (pixelShader)
+				m_deviceContext1->PSSetConstantBuffers1(StartSlot, NumBuffers, ppConstantBuffers, pFirstConstant, pNumConstants);
+			else
+				m_deviceContext1->VSSetConstantBuffers1(StartSlot, NumBuffers, ppConstantBuffers, pFirstConstant, pNumConstants);
+			return;
+		}
+#endif
+		// Sin ID3D11DeviceContext1 solo se puede enlazar el buffer desde el inicio
+		for (unsigned int i = 0; i < NumBuffers; ++i) {
+			if (pFirstConstant[i] != 0) {
+				ERROR("DeviceContext", "setConstantBuffers",
+					"Constant buffer offsets need ID3D11DeviceContext1 (D3D 11.1)");
+				return;
+			}
+		}
+	}
+	if (m_nullBackend) {
+		if (pixelShader)
+			m_nullBackend->PSSetConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers);
+		else
+			m_nullBackend->VSSetConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers);
+		return;
+	}
+	if (pixelShader)
+		m_deviceContext->PSSetConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers);
+	else
+		m_deviceContext->VSSetConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers);
+}
 
-	// Asignar los constant buffers al pixel shader
-	m_deviceContext->PSSetConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers);
+HRESULT
+DeviceContext::Map(ID3D11Resource* pResource,
+									 unsigned int Subresource,
+									 D3D11_MAP MapType,
+									 unsigned int MapFlags,
+									 D3D11_MAPPED_SUBRESOURCE* pMappedResource) {
+	if (rejectIdleDeferred("Map"))
+		return E_FAIL;
+	if (!pResource || !pMappedResource) {
+		ERROR("DeviceContext", "Map",
+			"Invalid arguments: pResource or pMappedResource is nullptr");
+		return E_INVALIDARG;
+	}
+	if (m_commandList) {
+		ERROR("DeviceContext", "Map", "Not supported while recording a command list; use UpdateSubresource");
+		return E_FAIL;
+	}
+	HRESULT hr = m_nullBackend
+		? m_nullBackend->Map(pResource, Subresource, MapType, MapFlags, pMappedResource)
+		: m_deviceContext->Map(pResource, Subresource, MapType, MapFlags, pMappedResource);
+	if (FAILED(hr)) {
+		ERROR("DeviceContext", "Map",
+			("Failed to map resource. HRESULT: " + std::to_string(hr)).c_str());
+	}
+	return hr;
+}
+
+void
+DeviceContext::Unmap(ID3D11Resource* pResource, unsigned int Subresource) {
+	if (rejectIdleDeferred("Unmap"))
+		return;
+	if (!pResource) {
+		ERROR("DeviceContext", "Unmap", "pResource is nullptr");
+		return;
+	}
+	if (m_commandList) {
+		ERROR("DeviceContext", "Unmap", "Not supported while recording a command list");
+		return;
+	}
+	if (m_nullBackend) {
+		m_nullBackend->Unmap(pResource, Subresource);
+		return;
+	}
+	m_deviceContext->Unmap(pResource, Subresource);
+}
+
+void
+DeviceContext::End(ID3D11Asynchronous* pAsync) {
+	if (rejectIdleDeferred("End"))
+		return;
+	if (!pAsync) {
+		ERROR("DeviceContext", "End", "pAsync is nullptr");
+		return;
+	}
+	if (m_commandList) {
+		ERROR("DeviceContext", "End", "Not supported while recording a command list");
+		return;
+	}
+	if (m_nullBackend) {
+		m_nullBackend->End(pAsync);
+		return;
+	}
+	m_deviceContext->End(pAsync);
+}
+
+HRESULT
+DeviceContext::GetData(ID3D11Asynchronous* pAsync,
+											 void* pData,
+											 unsigned int DataSize,
+											 unsigned int GetDataFlags) {
+	if (rejectIdleDeferred("GetData"))
+		return E_FAIL;
+	if (!pAsync) {
+		ERROR("DeviceContext", "GetData", "pAsync is nullptr");
+		return E_INVALIDARG;
+	}
+	if (m_commandList) {
+		ERROR("DeviceContext", "GetData", "Not supported while recording a command list");
+		return E_FAIL;
+	}
+	return m_nullBackend
+		? m_nullBackend->GetData(pAsync, pData, DataSize, GetDataFlags)
+		: m_deviceContext->GetData(pAsync, pData, DataSize, GetDataFlags);
 }
 
 void
 DeviceContext::DrawIndexed(unsigned int IndexCount,
 													unsigned int StartIndexLocation,
 													int BaseVertexLocation) {
+	if (rejectIdleDeferred("DrawIndexed"))
+		return;
 	// Validar parmetros
 	if (IndexCount == 0) {
 		ERROR("DeviceContext", "DrawIndexed", "IndexCount is zero");
@@ -250,5 +1051,49 @@ DeviceContext::DrawIndexed(unsigned int IndexCount,
 	}
 
 	// Ejecutar el dibujo
+	if (m_commandList) {
+		m_commandList->DrawIndexed(IndexCount, StartIndexLocation, BaseVertexLocation);
+		return;
+	}
+	if (m_nullBackend) {
+		m_nullBackend->DrawIndexed(IndexCount, StartIndexLocation, BaseVertexLocation);
+		return;
+	}
 	m_deviceContext->DrawIndexed(IndexCount, StartIndexLocation, BaseVertexLocation);
+}
+
+void
+DeviceContext::DrawIndexedInstanced(unsigned int IndexCountPerInstance,
+																		unsigned int InstanceCount,
+																		unsigned int StartIndexLocation,
+																		int BaseVertexLocation,
+																		unsigned int StartInstanceLocation) {
+	if (rejectIdleDeferred("DrawIndexedInstanced"))
+		return;
+	if (IndexCountPerInstance == 0 || InstanceCount == 0) {
+		ERROR("DeviceContext", "DrawIndexedInstanced", "IndexCountPerInstance or InstanceCount is zero");
+		return;
+	}
+
+	if (m_commandList) {
+		m_commandList->DrawIndexedInstanced(IndexCountPerInstance,
+																				InstanceCount,
+																				StartIndexLocation,
+																				BaseVertexLocation,
+																				StartInstanceLocation);
+		return;
+	}
+	if (m_nullBackend) {
+		m_nullBackend->DrawIndexedInstanced(IndexCountPerInstance,
+																				InstanceCount,
+																				StartIndexLocation,
+																				BaseVertexLocation,
+																				StartInstanceLocation);
+		return;
+	}
+	m_deviceContext->DrawIndexedInstanced(IndexCountPerInstance,
+																				InstanceCount,
+																				StartIndexLocation,
+																				BaseVertexLocation,
+																				StartInstanceLocation);
 }
\ No newline at end of file
@@ -0,0 +1,341 @@
+#include "FrameArena.h"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+
+namespace {
+  /// Arenas de los hilos vivos (para endFrame() y report()).
+  std::mutex g_registryMutex;
+  std::vector<FrameArena*> g_arenas;
+  FrameArena::Stats g_retired;              ///< Suma de las arenas de hilos que ya terminaron
+  unsigned int g_retiredArenas = 0;
+  size_t g_framePeak = 0;                   ///< Mximo de bytes de todos los hilos en un cuadro
+
+  std::atomic<unsigned long long> g_frame{ 0 };
+  std::atomic<bool> g_tracking{ false };
+
+  /// Arena del hilo, registrada mientras el hilo vive.
+  struct LocalArena {
+    FrameArena arena;
+
+    LocalArena() {
+      std::lock_guard<std::mutex> lock(g_registryMutex);
+      g_arenas.push_back(&arena);
+    }
+
+    ~LocalArena() {
+      arena.reset();
+      std::lock_guard<std::mutex> lock(g_registryMutex);
+      const FrameArena::Stats& stats = arena.stats();
+      g_retired.frames += stats.frames;
+      g_retired.allocations += stats.allocations;
+      g_retired.blockAllocations += stats.blockAllocations;
+      g_retired.peakBytes = (std::max)(g_retired.peakBytes, stats.peakBytes);
+      ++g_retiredArenas;
+      g_arenas.erase(std::remove(g_arenas.begin(), g_arenas.end(), &arena), g_arenas.end());
+    }
+  };
+
+  thread_local LocalArena t_local;
+
+  inline double elapsedMs(const std::chrono::high_resolution_clock::time_point& start) {
+    return std::chrono::duration<double, std::milli>(
+      std::chrono::high_resolution_clock::now() - start).count();
+  }
+
+  /// Offset dentro de @p data del primer byte alineado a @p alignment desde @p offset.
+  inline size_t alignOffset(const unsigned char* data, size_t offset, size_t alignment) {
+    const uintptr_t address = (uintptr_t)(data + offset);
+    return offset + (((address + alignment - 1) & ~(uintptr_t)(alignment - 1)) - address);
+  }
+}
+
+FrameArena::Scope::Scope(FrameArena& arena)
+  : m_arena(arena),
+    m_block(arena.m_block),
+    m_offset(arena.m_offset),
+    m_used(arena.bytesUsed()) {
+  ++m_arena.m_scopes;
+}
+
+FrameArena::Scope::~Scope() {
+  m_arena.m_block = m_block;
+  m_arena.m_offset = m_offset;
+  m_arena.m_used.store(m_used, std::memory_order_relaxed);
+  --m_arena.m_scopes;
+}
+
+void*
+FrameArena::allocate(size_t bytes, size_t alignment) {
+  ++m_stats.allocations;
+  if (m_block < m_blocks.size()) {
+    const Block& block = m_blocks[m_block];
+    const size_t offset = alignOffset(block.data, m_offset, alignment);
+    if (offset + bytes <= block.size) {
+      addUsed(offset + bytes - m_offset);
+      m_offset = offset + bytes;
+      return block.data + offset;
+    }
+  }
+  return allocateSlow(bytes, alignment);
+}
+
+void*
+FrameArena::allocateSlow(size_t bytes, size_t alignment) {
+  // Bloques que quedaron libres al cerrar un Scope
+  while (!m_blocks.empty() && m_block + 1 < m_blocks.size()) {
+    ++m_block;
+    const Block& block = m_blocks[m_block];
+    const size_t offset = alignOffset(block.data, 0, alignment);
+    if (offset + bytes <= block.size) {
+      addUsed(offset + bytes);
+      m_offset = offset + bytes;
+      return block.data + offset;
+    }
+  }
+
+  const size_t lastSize = m_blocks.empty() ? 0 : m_blocks.back().size;
+  Block block;
+  block.size = (std::max)((std::max)(kBlockSize, lastSize * 2), bytes + alignment);
+  block.data = new unsigned char[block.size];
+  m_blocks.push_back(block);
+  m_block = m_blocks.size() - 1;
+  ++m_stats.blockAllocations;
+  m_stats.capacity += block.size;
+
+  const size_t offset = alignOffset(block.data, 0, alignment);
+  addUsed(offset + bytes);
+  m_offset = offset + bytes;
+  return block.data + offset;
+}
+
+void
+FrameArena::addUsed(size_t bytes) {
+  const size_t used = bytesUsed() + bytes;
+  m_used.store(used, std::memory_order_relaxed);
+  if (used > highWater()) {
+    m_high.store(used, std::memory_order_relaxed);
+  }
+}
+
+void
+FrameArena::deallocate(void* pointer, size_t bytes) {
+  if (!pointer || m_block >= m_blocks.size()) {
+    return;
+  }
+  unsigned char* top = m_blocks[m_block].data + m_offset;
+  if (static_cast<unsigned char*>(pointer) + bytes == top) {
+    m_offset -= bytes;
+    m_used.store(bytesUsed() - bytes, std::memory_order_relaxed);
+  }
+}
+
+void
+FrameArena::reset() {
+  if (m_scopes > 0) {
+    ERROR("FrameArena", "reset", "Reset with an open Scope");
+    return;
+  }
+  const size_t used = highWater();
+  ++m_stats.frames;
+  m_stats.lastFrameBytes = used;
+  m_stats.peakBytes = (std::max)(m_stats.peakBytes, used);
+
+  // Un solo bloque con lo que us este cuadro: el prximo no va al heap
+  if (m_blocks.size() > 1) {
+    const size_t capacity = m_stats.capacity;
+    destroy();
+    Block block;
+    block.size = capacity;
+    block.data = new unsigned char[block.size];
+    m_blocks.push_back(block);
+    ++m_stats.blockAllocations;
+    m_stats.capacity = capacity;
+  }
+  m_block = 0;
+  m_offset = 0;
+  m_used.store(0, std::memory_order_relaxed);
+  m_high.store(0, std::memory_order_relaxed);
+}
+
+void
+FrameArena::destroy() {
+  for (Block& block : m_blocks) {
+    delete[] block.data;
+  }
+  m_blocks.clear();
+  m_block = 0;
+  m_offset = 0;
+  m_used.store(0, std::memory_order_relaxed);
+  m_high.store(0, std::memory_order_relaxed);
+  m_stats.capacity = 0;
+}
+
+FrameArena&
+FrameArena::local() {
+  FrameArena& arena = t_local.arena;
+  const unsigned long long frame = g_frame.load(std::memory_order_acquire);
+  if (arena.m_frame.load(std::memory_order_relaxed) != frame && arena.m_scopes == 0) {
+    arena.reset();
+    arena.m_frame.store(frame, std::memory_order_relaxed);
+  }
+  return arena;
+}
+
+void
+FrameArena::endFrame() {
+  FrameArena& arena = local();
+  const unsigned long long frame = g_frame.load(std::memory_order_relaxed);
+  if (g_tracking.load(std::memory_order_relaxed)) {
+    size_t frameBytes = 0;
+    size_t largest = 0;
+    unsigned int arenas = 0;
+    size_t peak;
+    {
+      std::lock_guard<std::mutex> lock(g_registryMutex);
+      for (const FrameArena* other : g_arenas) {
+        // Las que no se usaron en este cuadro todava tienen lo del anterior
+        if (other->m_frame.load(std::memory_order_relaxed) != frame) {
+          continue;
+        }
+        const size_t used = other->highWater();
+        frameBytes += used;
+        largest = (std::max)(largest, used);
+        arenas += used > 0 ? 1 : 0;
+      }
+      g_framePeak = (std::max)(g_framePeak, frameBytes);
+      peak = g_framePeak;
+    }
+    std::wostringstream wss;
+    wss << L"frame " << frame << L": " << frameBytes << L" bytes in " << arenas
+        << L" threads (largest " << largest << L"), high-water " << peak << L" bytes";
+    MESSAGE(L"FrameArena", L"endFrame", wss.str());
+  }
+  g_frame.store(frame + 1, std::memory_order_release);
+  if (arena.m_scopes == 0) {
+    arena.reset();
+    arena.m_frame.store(frame + 1, std::memory_order_relaxed);
+  }
+}
+
+unsigned long long
+FrameArena::frameNumber() {
+  return g_frame.load(std::memory_order_acquire);
+}
+
+void
+FrameArena::setTracking(bool tracking) {
+  g_tracking.store(tracking, std::memory_order_relaxed);
+}
+
+bool
+FrameArena::isTracking() {
+  return g_tracking.load(std::memory_order_relaxed);
+}
+
+void
+FrameArena::report(const std::string& label) {
+  std::lock_guard<std::mutex> lock(g_registryMutex);
+  unsigned int index = 0;
+  for (const FrameArena* arena : g_arenas) {
+    const Stats& stats = arena->stats();
+    if (stats.allocations == 0) {
+      continue;
+    }
+    std::wostringstream wss;
+    wss << label.c_str() << L": thread arena " << index++ << L": peak " << stats.peakBytes
+        << L" bytes/frame, last " << stats.lastFrameBytes << L" bytes, " << stats.capacity / 1024.0
+        << L" KB reserved, " << stats.allocations / (double)(std::max)(stats.frames, 1ull)
+        << L" allocations/frame, " << stats.blockAllocations << L" heap blocks in " << stats.frames << L" frames";
+    MESSAGE(L"FrameArena", L"report", wss.str());
+  }
+
+  std::wostringstream wss;
+  wss << label.c_str() << L": " << g_frame.load(std::memory_order_relaxed) << L" frames, " << g_arenas.size()
+      << L" live arenas, " << g_retiredArenas << L" retired (peak " << g_retired.peakBytes << L" bytes, "
+      << g_retired.blockAllocations << L" heap blocks)";
+  if (g_tracking.load(std::memory_order_relaxed)) {
+    wss << L", high-water " << g_framePeak << L" bytes/frame";
+  }
+  MESSAGE(L"FrameArena", L"report", wss.str());
+}
+
+bool
+FrameArena::benchmark(unsigned int frames, unsigned int lists) {
+  // Tamaos de las listas (iguales para las tres versiones)
+  std::vector<unsigned int> sizes(lists);
+  unsigned int random = 0x9e3779b9u;
+  for (unsigned int& size : sizes) {
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    size = 8 + random % 248;
+  }
+
+  auto fill = [](auto& list, unsigned int size, unsigned int seed) {
+    for (unsigned int i = 0; i < size; ++i) {
+      list.push_back(seed * 31u + i);
+    }
+    unsigned long long sum = 0;
+    for (unsigned int value : list) {
+      sum += value;
+    }
+    return sum;
+  };
+
+  // Lista nueva en el heap por cada una (lo que haca el cdigo sin arena)
+  unsigned long long heapSum = 0;
+  auto start = std::chrono::high_resolution_clock::now();
+  for (unsigned int frame = 0; frame < frames; ++frame) {
+    for (unsigned int i = 0; i < lists; ++i) {
+      std::vector<unsigned int> list;
+      heapSum += fill(list, sizes[i], frame + i);
+    }
+  }
+  const double heapMs = elapsedMs(start) / frames;
+
+  // Un vector miembro reutilizado (lo que hacen RenderQueue o SceneBvh)
+  unsigned long long reusedSum = 0;
+  std::vector<unsigned int> reused;
+  start = std::chrono::high_resolution_clock::now();
+  for (unsigned int frame = 0; frame < frames; ++frame) {
+    for (unsigned int i = 0; i < lists; ++i) {
+      reused.clear();
+      reusedSum += fill(reused, sizes[i], frame + i);
+    }
+  }
+  const double reusedMs = elapsedMs(start) / frames;
+
+  // Lista nueva en la arena; se libera toda junta al final del cuadro
+  unsigned long long arenaSum = 0;
+  FrameArena arena;
+  unsigned long long warmBlocks = 0;
+  start = std::chrono::high_resolution_clock::now();
+  for (unsigned int frame = 0; frame < frames; ++frame) {
+    for (unsigned int i = 0; i < lists; ++i) {
+      FrameAllocator<unsigned int> allocator(arena);
+      FrameVector<unsigned int> list(allocator);
+      arenaSum += fill(list, sizes[i], frame + i);
+    }
+    arena.reset();
+    if (frame == 0) {
+      warmBlocks = arena.stats().blockAllocations;
+    }
+  }
+  const double arenaMs = elapsedMs(start) / frames;
+  const Stats& stats = arena.stats();
+
+  const bool ok = heapSum == arenaSum && reusedSum == arenaSum;
+  const double nsPerList = 1.0e6 / (std::max)(lists, 1u);
+  std::wostringstream wss;
+  wss << lists << L" lists/frame: heap " << heapMs * nsPerList << L" ns/list, reused vector "
+      << reusedMs * nsPerList << L" ns/list, arena " << arenaMs * nsPerList << L" ns/list ("
+      << heapMs / (std::max)(arenaMs, 1.0e-9) << L"x heap); arena peak " << stats.peakBytes / 1024.0
+      << L" KB/frame, " << stats.blockAllocations - warmBlocks << L" heap blocks after the first frame"
+      << (ok ? L"" : L" (results differ)");
+  MESSAGE(L"FrameArena", L"benchmark", wss.str());
+  if (!ok) {
+    ERROR("FrameArena", "benchmark", "Arena lists differ from std::vector lists");
+  }
+  return ok;
+}
@@ -0,0 +1,233 @@
+#include "FramePipeline.h"
+#include <algorithm>
+
+namespace {
+  inline double elapsedMs(const std::chrono::high_resolution_clock::time_point& start) {
+    return std::chrono::duration<double, std::milli>(
+      std::chrono::high_resolution_clock::now() - start).count();
+  }
+
+  /// Trabajo de CPU de @p us microsegundos (sin dormir, para que ocupe el ncleo).
+  void spin(unsigned int us) {
+    const auto start = std::chrono::high_resolution_clock::now();
+    while (elapsedMs(start) * 1000.0 < us) {
+    }
+  }
+}
+
+HRESULT
+FramePipeline::init(unsigned int latency, RenderFunction render, void* data) {
+  if (!render) {
+    ERROR("FramePipeline", "init", "Render function is null");
+    return E_INVALIDARG;
+  }
+  destroy();
+
+  m_latency = (std::min)(latency, kMaxLatency);
+  m_render = render;
+  m_data = data;
+  m_packets.assign(m_latency + 1, FramePacket());
+  m_begun = m_submitted = m_rendered = 0;
+  m_open = false;
+  m_quit = false;
+  resetStats();
+
+  if (m_latency > 0) {
+    m_thread = std::thread(&FramePipeline::renderLoop, this);
+  }
+
+  std::wostringstream wss;
+  wss << L"latency " << m_latency << L" (" << m_packets.size() << L" packets"
+      << (m_latency > 0 ? L", render thread)" : L", serial)");
+  MESSAGE(L"FramePipeline", L"init", wss.str());
+  return S_OK;
+}
+
+void
+FramePipeline::destroy() {
+  if (m_thread.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_quit = true;
+    }
+    m_packetReady.notify_one();
+    m_thread.join();
+  }
+  m_packets.clear();
+  m_render = nullptr;
+  m_data = nullptr;
+  m_latency = 0;
+  m_begun = m_submitted = m_rendered = 0;
+  m_open = false;
+}
+
+FramePipeline::FramePacket&
+FramePipeline::beginFrame() {
+  const auto start = std::chrono::high_resolution_clock::now();
+  std::unique_lock<std::mutex> lock(m_mutex);
+  if (m_open) {
+    return m_packets[(m_begun - 1) % m_packets.size()];
+  }
+  // El paquete m_begun % (L + 1) est libre cuando a lo sumo L siguen en el render
+  m_packetFree.wait(lock, [this]() { return m_begun - m_rendered <= m_latency; });
+  m_stats.updateWaitMs += elapsedMs(start);
+
+  FramePacket& packet = m_packets[m_begun % m_packets.size()];
+  packet.frame = m_begun++;
+  packet.draws.clear();
+  m_open = true;
+  m_updateStart = std::chrono::high_resolution_clock::now();
+  return packet;
+}
+
+void
+FramePipeline::submit() {
+  if (!m_open) {
+    ERROR("FramePipeline", "submit", "submit() without beginFrame()");
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.updateMs += elapsedMs(m_updateStart);
+    m_open = false;
+    ++m_submitted;
+    m_stats.maxInFlight = (std::max)(m_stats.maxInFlight, (unsigned int)(m_submitted - m_rendered));
+  }
+  if (m_latency == 0) {
+    renderPacket(m_packets[0]);
+  }
+  else {
+    m_packetReady.notify_one();
+  }
+}
+
+void
+FramePipeline::flush() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_packetFree.wait(lock, [this]() { return m_rendered == m_submitted; });
+}
+
+FramePipeline::Stats
+FramePipeline::stats() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stats;
+}
+
+unsigned long long
+FramePipeline::renderedFrames() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_rendered;
+}
+
+void
+FramePipeline::resetStats() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_stats = Stats();
+  m_firstFrame = std::chrono::high_resolution_clock::now();
+}
+
+void
+FramePipeline::report(const std::string& label) const {
+  const Stats total = stats();
+  const double frames = (double)(std::max)(total.frames, 1ull);
+  std::wostringstream wss;
+  wss << label.c_str() << L": latency " << m_latency << L", " << total.frames << L" frames, "
+      << total.wallMs / frames << L" ms/frame (update " << total.updateMs / frames << L" ms + wait "
+      << total.updateWaitMs / frames << L" ms, render " << total.renderMs / frames << L" ms + idle "
+      << total.renderWaitMs / frames << L" ms), " << total.draws / frames << L" draws/frame, max "
+      << total.maxInFlight << L" in flight";
+  MESSAGE(L"FramePipeline", L"report", wss.str());
+}
+
+void
+FramePipeline::renderLoop() {
+  for (;;) {
+    FramePacket* packet;
+    {
+      const auto start = std::chrono::high_resolution_clock::now();
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_packetReady.wait(lock, [this]() { return m_quit || m_rendered < m_submitted; });
+      // Con m_quit se terminan primero los paquetes ya enviados
+      if (m_rendered == m_submitted) {
+        return;
+      }
+      m_stats.renderWaitMs += elapsedMs(start);
+      packet = &m_packets[m_rendered % m_packets.size()];
+    }
+    renderPacket(*packet);
+  }
+}
+
+void
+FramePipeline::renderPacket(FramePacket& packet) {
+  const auto start = std::chrono::high_resolution_clock::now();
+  m_render(m_data, packet);
+  const double renderMs = elapsedMs(start);
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.renderMs += renderMs;
+    m_stats.draws += packet.draws.size();
+    ++m_stats.frames;
+    ++m_rendered;
+    m_stats.wallMs = elapsedMs(m_firstFrame);
+  }
+  m_packetFree.notify_all();
+}
+
+bool
+FramePipeline::benchmark(unsigned int frames, unsigned int updateUs, unsigned int renderUs) {
+  struct Consumer {
+    unsigned int renderUs;
+    unsigned long long expected;
+    bool ok;
+  };
+  // El render verifica que recibe los cuadros en orden y con los draws que arm su update
+  auto render = [](void* data, const FramePacket& packet) {
+    Consumer& consumer = *static_cast<Consumer*>(data);
+    bool ok = packet.frame == consumer.expected && packet.draws.size() == packet.frame % 7 + 1;
+    for (size_t i = 0; ok && i < packet.draws.size(); ++i) {
+      ok = packet.draws[i].viewDepth == (float)(packet.frame + i);
+    }
+    consumer.ok = consumer.ok && ok;
+    ++consumer.expected;
+    spin(consumer.renderUs);
+  };
+
+  bool ok = true;
+  double serialMs = 0.0;
+  for (unsigned int latency = 0; latency <= kMaxLatency; ++latency) {
+    Consumer consumer = { renderUs, 0, true };
+    FramePipeline pipeline;
+    if (FAILED(pipeline.init(latency, render, &consumer))) {
+      return false;
+    }
+    for (unsigned int frame = 0; frame < frames; ++frame) {
+      FramePacket& packet = pipeline.beginFrame();
+      spin(updateUs);
+      packet.draws.resize(packet.frame % 7 + 1);
+      for (size_t i = 0; i < packet.draws.size(); ++i) {
+        packet.draws[i].viewDepth = (float)(packet.frame + i);
+      }
+      pipeline.submit();
+    }
+    pipeline.flush();
+    ok = ok && consumer.ok && consumer.expected == frames;
+
+    const Stats total = pipeline.stats();
+    const double frameMs = total.wallMs / (std::max)(frames, 1u);
+    if (latency == 0) {
+      serialMs = frameMs;
+    }
+    pipeline.report("FramePipeline::benchmark latency " + std::to_string(latency));
+
+    std::wostringstream wss;
+    wss << L"latency " << latency << L": " << frameMs << L" ms/frame, " << serialMs / (std::max)(frameMs, 1.0e-6)
+        << L"x serial" << (consumer.ok ? L"" : L" (packets out of order)");
+    MESSAGE(L"FramePipeline", L"benchmark", wss.str());
+  }
+
+  if (!ok) {
+    ERROR("FramePipeline", "benchmark", "Render stage received a wrong packet");
+  }
+  return ok;
+}
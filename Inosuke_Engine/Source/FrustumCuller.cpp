@@ -0,0 +1,480 @@
+#include "FrustumCuller.h"
+#include "MeshComponent.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// MSVC acepta intrnsecos AVX en cualquier funcin; GCC/Clang los piden por funcin
+#if defined(_MSC_VER)
+#define FRUSTUM_AVX_FUNCTION
+#else
+#define FRUSTUM_AVX_FUNCTION __attribute__((target("avx")))
+#endif
+
+namespace {
+  /// Objetos por bloque en cullParallel (mltiplo de 8 para que AVX no toque la cola).
+  const unsigned int kParallelBlock = 16 * 1024;
+
+  /// Plano con sus valores absolutos (los usa la prueba de caja).
+  struct PlaneData {
+    float a, b, c, d;
+    float absA, absB, absC;
+  };
+
+  void
+  loadPlanes(const FrustumCuller::Frustum& frustum, PlaneData planes[6]) {
+    for (int i = 0; i < 6; ++i) {
+      const XMFLOAT4& p = frustum.planes[i];
+      planes[i] = { p.x, p.y, p.z, p.w, fabsf(p.x), fabsf(p.y), fabsf(p.z) };
+    }
+  }
+
+  /// Junta en orden los tramos de visible que escribi cada bloque de cullParallel.
+  unsigned int
+  compactBlocks(std::vector<unsigned int>& visible, const std::vector<unsigned int>& counts) {
+    unsigned int count = 0;
+    for (size_t block = 0; block < counts.size(); ++block) {
+      const unsigned int* source = visible.data() + block * kParallelBlock;
+      std::copy(source, source + counts[block], visible.data() + count);
+      count += counts[block];
+    }
+    visible.resize(count);
+    return count;
+  }
+
+  /// xorshift32: el benchmark usa la misma escena en cada corrida.
+  inline unsigned int nextRandom(unsigned int& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+  inline float randomRange(unsigned int& state, float minimum, float maximum) {
+    return minimum + (maximum - minimum) * ((nextRandom(state) & 0xffffff) / 16777215.0f);
+  }
+
+  // Las tres implementaciones evalan las mismas operaciones en el mismo orden
+  // (sin FMA), as que coinciden bit a bit:
+  //   esfera: visible si  (a*cx + b*cy + c*cz + d) >= -r          en los 6 planos
+  //   caja:   visible si  (a*cx + b*cy + c*cz + d) + (|a|*ex + |b|*ey + |c|*ez) >= 0
+
+  unsigned int
+  cullScalar(const PlaneData planes[6],
+    const float* cx, const float* cy, const float* cz,
+    const float* ex, const float* ey, const float* ez, const float* radius,
+    bool aabb, unsigned int begin, unsigned int end, unsigned int* out) {
+    unsigned int count = 0;
+    for (unsigned int i = begin; i < end; ++i) {
+      bool inside = true;
+      for (int p = 0; p < 6; ++p) {
+        const PlaneData& plane = planes[p];
+        const float dist = plane.a * cx[i] + plane.b * cy[i] + plane.c * cz[i] + plane.d;
+        if (aabb) {
+          const float reach = plane.absA * ex[i] + plane.absB * ey[i] + plane.absC * ez[i];
+          inside = inside && (dist + reach >= 0.0f);
+        }
+        else {
+          inside = inside && (dist >= -radius[i]);
+        }
+      }
+      out[count] = i;
+      count += inside ? 1 : 0;
+    }
+    return count;
+  }
+
+  unsigned int
+  cullSSE(const PlaneData planes[6],
+    const float* cx, const float* cy, const float* cz,
+    const float* ex, const float* ey, const float* ez, const float* radius,
+    bool aabb, unsigned int begin, unsigned int end, unsigned int* out) {
+    unsigned int count = 0;
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    unsigned int i = begin;
+    for (; i + 4 <= end; i += 4) {
+      const __m128 x = _mm_loadu_ps(cx + i);
+      const __m128 y = _mm_loadu_ps(cy + i);
+      const __m128 z = _mm_loadu_ps(cz + i);
+      __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+      if (aabb) {
+        const __m128 hx = _mm_loadu_ps(ex + i);
+        const __m128 hy = _mm_loadu_ps(ey + i);
+        const __m128 hz = _mm_loadu_ps(ez + i);
+        for (int p = 0; p < 6; ++p) {
+          const PlaneData& plane = planes[p];
+          __m128 dist = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.a), x), _mm_mul_ps(_mm_set1_ps(plane.b), y));
+          dist = _mm_add_ps(_mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(plane.c), z)), _mm_set1_ps(plane.d));
+          __m128 reach = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.absA), hx), _mm_mul_ps(_mm_set1_ps(plane.absB), hy));
+          reach = _mm_add_ps(reach, _mm_mul_ps(_mm_set1_ps(plane.absC), hz));
+          inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(dist, reach), zero));
+        }
+      }
+      else {
+        const __m128 negRadius = _mm_xor_ps(_mm_loadu_ps(radius + i), signMask);
+        for (int p = 0; p < 6; ++p) {
+          const PlaneData& plane = planes[p];
+          __m128 dist = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.a), x), _mm_mul_ps(_mm_set1_ps(plane.b), y));
+          dist = _mm_add_ps(_mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(plane.c), z)), _mm_set1_ps(plane.d));
+          inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, negRadius));
+        }
+      }
+      // Compactacin sin saltos: se escribe siempre y solo avanza si es visible
+      const int mask = _mm_movemask_ps(inside);
+      for (unsigned int lane = 0; lane < 4; ++lane) {
+        out[count] = i + lane;
+        count += (mask >> lane) & 1;
+      }
+    }
+    return count + cullScalar(planes, cx, cy, cz, ex, ey, ez, radius, aabb, i, end, out + count);
+  }
+
+  FRUSTUM_AVX_FUNCTION unsigned int
+  cullAVX(const PlaneData planes[6],
+    const float* cx, const float* cy, const float* cz,
+    const float* ex, const float* ey, const float* ez, const float* radius,
+    bool aabb, unsigned int begin, unsigned int end, unsigned int* out) {
+    unsigned int count = 0;
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    unsigned int i = begin;
+    for (; i + 8 <= end; i += 8) {
+      const __m256 x = _mm256_loadu_ps(cx + i);
+      const __m256 y = _mm256_loadu_ps(cy + i);
+      const __m256 z = _mm256_loadu_ps(cz + i);
+      __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+      if (aabb) {
+        const __m256 hx = _mm256_loadu_ps(ex + i);
+        const __m256 hy = _mm256_loadu_ps(ey + i);
+        const __m256 hz = _mm256_loadu_ps(ez + i);
+        for (int p = 0; p < 6; ++p) {
+          const PlaneData& plane = planes[p];
+          __m256 dist = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.a), x), _mm256_mul_ps(_mm256_set1_ps(plane.b), y));
+          dist = _mm256_add_ps(_mm256_add_ps(dist, _mm256_mul_ps(_mm256_set1_ps(plane.c), z)), _mm256_set1_ps(plane.d));
+          __m256 reach = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.absA), hx),
+                                       _mm256_mul_ps(_mm256_set1_ps(plane.absB), hy));
+          reach = _mm256_add_ps(reach, _mm256_mul_ps(_mm256_set1_ps(plane.absC), hz));
+          inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(dist, reach), zero, _CMP_GE_OQ));
+        }
+      }
+      else {
+        const __m256 negRadius = _mm256_xor_ps(_mm256_loadu_ps(radius + i), signMask);
+        for (int p = 0; p < 6; ++p) {
+          const PlaneData& plane = planes[p];
+          __m256 dist = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.a), x), _mm256_mul_ps(_mm256_set1_ps(plane.b), y));
+          dist = _mm256_add_ps(_mm256_add_ps(dist, _mm256_mul_ps(_mm256_set1_ps(plane.c), z)), _mm256_set1_ps(plane.d));
+          inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, negRadius, _CMP_GE_OQ));
+        }
+      }
+      const int mask = _mm256_movemask_ps(inside);
+      for (unsigned int lane = 0; lane < 8; ++lane) {
+        out[count] = i + lane;
+        count += (mask >> lane) & 1;
+      }
+    }
+    // Evita la penalizacin de mezclar AVX con el cdigo SSE que sigue
+    _mm256_zeroupper();
+    return count + cullScalar(planes, cx, cy, cz, ex, ey, ez, radius, aabb, i, end, out + count);
+  }
+
+  inline double elapsedMs(const std::chrono::high_resolution_clock::time_point& start) {
+    return std::chrono::duration<double, std::milli>(
+      std::chrono::high_resolution_clock::now() - start).count();
+  }
+}
+
+FrustumCuller::Frustum
+FrustumCuller::extractFrustum(const XMMATRIX& viewProjection) {
+  // Con vector fila, clip = p * M: cada coordenada de clip es una columna de M
+  XMFLOAT4X4 m;
+  XMStoreFloat4x4(&m, viewProjection);
+  const float col[4][4] = {
+    { m._11, m._21, m._31, m._41 },
+    { m._12, m._22, m._32, m._42 },
+    { m._13, m._23, m._33, m._43 },
+    { m._14, m._24, m._34, m._44 }
+  };
+
+  Frustum frustum;
+  for (int i = 0; i < 6; ++i) {
+    float plane[4];
+    for (int k = 0; k < 4; ++k) {
+      switch (i) {
+      case 0: plane[k] = col[3][k] + col[0][k]; break;   // -w <= x
+      case 1: plane[k] = col[3][k] - col[0][k]; break;   //  x <= w
+      case 2: plane[k] = col[3][k] + col[1][k]; break;   // -w <= y
+      case 3: plane[k] = col[3][k] - col[1][k]; break;   //  y <= w
+      case 4: plane[k] = col[2][k]; break;               //  0 <= z
+      default: plane[k] = col[3][k] - col[2][k]; break;  //  z <= w
+      }
+    }
+    const float length = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+    const float scale = length > 0.0f ? 1.0f / length : 0.0f;
+    frustum.planes[i] = XMFLOAT4(plane[0] * scale, plane[1] * scale, plane[2] * scale, plane[3] * scale);
+  }
+  return frustum;
+}
+
+void
+FrustumCuller::transformBounds(const MeshComponent& mesh,
+  const XMMATRIX& world,
+  XMFLOAT3& center,
+  XMFLOAT3& extents,
+  float& radius) {
+  XMStoreFloat3(&center, XMVector3TransformCoord(XMLoadFloat3(&mesh.m_boundsCenter), world));
+
+  // Semiejes de la caja rotada: |M| aplicada a los semiejes (Arvo)
+  XMFLOAT4X4 m;
+  XMStoreFloat4x4(&m, world);
+  const XMFLOAT3& e = mesh.m_boundsExtents;
+  extents.x = fabsf(m._11) * e.x + fabsf(m._21) * e.y + fabsf(m._31) * e.z;
+  extents.y = fabsf(m._12) * e.x + fabsf(m._22) * e.y + fabsf(m._32) * e.z;
+  extents.z = fabsf(m._13) * e.x + fabsf(m._23) * e.y + fabsf(m._33) * e.z;
+
+  const float scaleX = m._11 * m._11 + m._12 * m._12 + m._13 * m._13;
+  const float scaleY = m._21 * m._21 + m._22 * m._22 + m._23 * m._23;
+  const float scaleZ = m._31 * m._31 + m._32 * m._32 + m._33 * m._33;
+  radius = mesh.m_boundsRadius * sqrtf((std::max)(scaleX, (std::max)(scaleY, scaleZ)));
+}
+
+unsigned int
+FrustumCuller::add(const XMFLOAT3& center, const XMFLOAT3& extents, float radius) {
+  m_centerX.push_back(center.x);
+  m_centerY.push_back(center.y);
+  m_centerZ.push_back(center.z);
+  m_extentX.push_back(extents.x);
+  m_extentY.push_back(extents.y);
+  m_extentZ.push_back(extents.z);
+  m_radius.push_back(radius);
+  return size() - 1;
+}
+
+void
+FrustumCuller::set(unsigned int index, const XMFLOAT3& center, const XMFLOAT3& extents, float radius) {
+  if (index >= size()) {
+    ERROR("FrustumCuller", "set", ("Index out of range: " + std::to_string(index)).c_str());
+    return;
+  }
+  m_centerX[index] = center.x;
+  m_centerY[index] = center.y;
+  m_centerZ[index] = center.z;
+  m_extentX[index] = extents.x;
+  m_extentY[index] = extents.y;
+  m_extentZ[index] = extents.z;
+  m_radius[index] = radius;
+}
+
+void
+FrustumCuller::clear() {
+  m_centerX.clear();
+  m_centerY.clear();
+  m_centerZ.clear();
+  m_extentX.clear();
+  m_extentY.clear();
+  m_extentZ.clear();
+  m_radius.clear();
+}
+
+bool
+FrustumCuller::avxSupported() {
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+  const bool osxsave = (info[2] & (1 << 27)) != 0;
+  const bool avx = (info[2] & (1 << 28)) != 0;
+  // El sistema debe guardar los registros YMM en los cambios de contexto
+  return osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+#else
+  return __builtin_cpu_supports("avx");
+#endif
+}
+
+FrustumCuller::Path
+FrustumCuller::resolvePath(Path path) {
+  static const bool avx = avxSupported();
+  if (path == PATH_AUTO) {
+    return avx ? PATH_AVX : PATH_SSE;
+  }
+  if (path == PATH_AVX && !avx) {
+    return PATH_SSE;
+  }
+  return path;
+}
+
+unsigned int
+FrustumCuller::cullRange(const Frustum& frustum,
+  unsigned int begin,
+  unsigned int end,
+  unsigned int* out,
+  Test test,
+  Path path) const {
+  PlaneData planes[6];
+  loadPlanes(frustum, planes);
+  const bool aabb = test == TEST_AABB;
+  switch (path) {
+  case PATH_AVX:
+    return cullAVX(planes, m_centerX.data(), m_centerY.data(), m_centerZ.data(),
+      m_extentX.data(), m_extentY.data(), m_extentZ.data(), m_radius.data(), aabb, begin, end, out);
+  case PATH_SSE:
+    return cullSSE(planes, m_centerX.data(), m_centerY.data(), m_centerZ.data(),
+      m_extentX.data(), m_extentY.data(), m_extentZ.data(), m_radius.data(), aabb, begin, end, out);
+  default:
+    return cullScalar(planes, m_centerX.data(), m_centerY.data(), m_centerZ.data(),
+      m_extentX.data(), m_extentY.data(), m_extentZ.data(), m_radius.data(), aabb, begin, end, out);
+  }
+}
+
+unsigned int
+FrustumCuller::cull(const Frustum& frustum,
+  std::vector<unsigned int>& visible,
+  Test test,
+  Path path) const {
+  // La compactacin escribe un ndice por objeto probado: se reserva el peor caso
+  visible.resize(size());
+  const unsigned int count = size() ? cullRange(frustum, 0, size(), visible.data(), test, resolvePath(path)) : 0;
+  visible.resize(count);
+  return count;
+}
+
+unsigned int
+FrustumCuller::cullParallel(const Frustum& frustum,
+  std::vector<unsigned int>& visible,
+  unsigned int threads,
+  Test test,
+  Path path) const {
+  const unsigned int objectCount = size();
+  const unsigned int blockCount = (objectCount + kParallelBlock - 1) / kParallelBlock;
+  if (threads == 0) threads = std::thread::hardware_concurrency();
+  threads = (std::min)((std::max)(threads, 1u), (std::max)(blockCount, 1u));
+  if (threads <= 1) {
+    return cull(frustum, visible, test, path);
+  }
+  path = resolvePath(path);
+
+  // Cada bloque escribe en su propio tramo de visible; luego se juntan en orden
+  visible.resize(objectCount);
+  std::vector<unsigned int> counts(blockCount);
+  std::atomic<unsigned int> nextBlock(0);
+  auto worker = [&]() {
+    for (unsigned int block = nextBlock++; block < blockCount; block = nextBlock++) {
+      const unsigned int begin = block * kParallelBlock;
+      const unsigned int end = (std::min)(begin + kParallelBlock, objectCount);
+      counts[block] = cullRange(frustum, begin, end, visible.data() + begin, test, path);
+    }
+  };
+  std::vector<std::thread> pool;
+  for (unsigned int t = 1; t < threads; ++t) pool.emplace_back(worker);
+  worker();
+  for (std::thread& t : pool) t.join();
+
+  return compactBlocks(visible, counts);
+}
+
+unsigned int
+FrustumCuller::cullParallel(const Frustum& frustum,
+  std::vector<unsigned int>& visible,
+  JobSystem& jobs,
+  Test test,
+  Path path) const {
+  const unsigned int objectCount = size();
+  const unsigned int blockCount = (objectCount + kParallelBlock - 1) / kParallelBlock;
+  if (jobs.getThreadCount() <= 1 || blockCount <= 1) {
+    return cull(frustum, visible, test, path);
+  }
+  path = resolvePath(path);
+
+  visible.resize(objectCount);
+  std::vector<unsigned int> counts(blockCount);
+  jobs.parallelFor(blockCount, 1, [&](unsigned int firstBlock, unsigned int lastBlock) {
+    for (unsigned int block = firstBlock; block < lastBlock; ++block) {
+      const unsigned int begin = block * kParallelBlock;
+      const unsigned int end = (std::min)(begin + kParallelBlock, objectCount);
+      counts[block] = cullRange(frustum, begin, end, visible.data() + begin, test, path);
+    }
+  });
+
+  return compactBlocks(visible, counts);
+}
+
+bool
+FrustumCuller::benchmark(unsigned int objectCount, int iterations) {
+  if (iterations < 1) iterations = 1;
+
+  // Objetos repartidos en un cubo de 2 km alrededor de la cmara
+  FrustumCuller culler;
+  unsigned int seed = 0x2468aceu;
+  for (unsigned int i = 0; i < objectCount; ++i) {
+    const XMFLOAT3 center(randomRange(seed, -1000.0f, 1000.0f), randomRange(seed, -1000.0f, 1000.0f),
+      randomRange(seed, -1000.0f, 1000.0f));
+    const XMFLOAT3 extents(randomRange(seed, 0.5f, 5.0f), randomRange(seed, 0.5f, 5.0f), randomRange(seed, 0.5f, 5.0f));
+    culler.add(center, extents, sqrtf(extents.x * extents.x + extents.y * extents.y + extents.z * extents.z));
+  }
+
+  const XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f),
+    XMVectorSet(0.3f, 0.1f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+  const XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000.0f);
+  const Frustum frustum = extractFrustum(view * projection);
+
+  const bool avx = avxSupported();
+  const unsigned int hardwareThreads = (std::max)(1u, std::thread::hardware_concurrency());
+  bool ok = true;
+  std::wostringstream wss;
+  wss << objectCount << L" objects x " << iterations << L" iterations, " << hardwareThreads << L" threads, AVX "
+      << (avx ? L"yes" : L"no");
+  MESSAGE(L"FrustumCuller", L"benchmark", wss.str().c_str());
+
+  JobSystem jobs;
+  jobs.init(hardwareThreads);
+
+  const wchar_t* testNames[2] = { L"sphere", L"aabb" };
+  for (int test = TEST_SPHERE; test <= TEST_AABB; ++test) {
+    std::vector<unsigned int> reference, visible;
+    culler.cull(frustum, reference, (Test)test, PATH_SCALAR);
+
+    struct Run {
+      const wchar_t* name;
+      Path path;
+      unsigned int threads;    ///< 0 = repartido con JobSystem
+    };
+    const Run runs[] = {
+      { L"scalar", PATH_SCALAR, 1 },
+      { L"sse", PATH_SSE, 1 },
+      { L"avx", PATH_AVX, 1 },
+      { L"auto mt", PATH_AUTO, hardwareThreads },
+      { L"auto jobs", PATH_AUTO, 0 }
+    };
+    wss.str(L"");
+    wss << L"  " << testNames[test] << L": " << reference.size() << L" visible;";
+    for (const Run& run : runs) {
+      if (run.path == PATH_AVX && !avx) {
+        continue;
+      }
+      const auto start = std::chrono::high_resolution_clock::now();
+      for (int i = 0; i < iterations; ++i) {
+        if (run.threads == 0) {
+          culler.cullParallel(frustum, visible, jobs, (Test)test, run.path);
+        }
+        else {
+          culler.cullParallel(frustum, visible, run.threads, (Test)test, run.path);
+        }
+      }
+      const double ms = elapsedMs(start);
+      ok = ok && visible == reference;
+      wss << L" " << run.name << L" " << ms * 1.0e6 / ((double)iterations * (objectCount ? objectCount : 1))
+          << L" ns/object";
+    }
+    MESSAGE(L"FrustumCuller", L"benchmark", wss.str().c_str());
+  }
+
+  if (!ok) {
+    ERROR(L"FrustumCuller", L"benchmark", L"SIMD or multithreaded culling differs from the scalar result");
+  }
+  return ok;
+}
@@ -0,0 +1,7 @@
+#include "HeadlessDevice.h"
+
+HeadlessDevice::HeadlessDevice(bool recordCommands) {
+  m_backend.m_recordCommands = recordCommands;
+  m_device.m_nullBackend = &m_backend;
+  m_deviceContext.m_nullBackend = &m_backend;
+}
@@ -0,0 +1,104 @@
+#include "InstanceBuffer.h"
+#include "Device.h"
+#include "DeviceContext.h"
+
+HRESULT
+InstanceBuffer::init(Device& device, unsigned int maxInstances) {
+  if (!device.isValid()) {
+    ERROR("InstanceBuffer", "init", "Device is nullptr");
+    return E_POINTER;
+  }
+  if (maxInstances == 0) {
+    ERROR("InstanceBuffer", "init", "maxInstances is zero");
+    return E_INVALIDARG;
+  }
+  destroy();
+
+  D3D11_BUFFER_DESC desc;
+  memset(&desc, 0, sizeof(desc));
+  desc.Usage = D3D11_USAGE_DYNAMIC;
+  desc.ByteWidth = maxInstances * sizeof(CBChangesEveryFrame);
+  desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+  desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+  HRESULT hr = device.CreateBuffer(&desc, nullptr, &m_buffer);
+  if (FAILED(hr)) {
+    ERROR("InstanceBuffer", "init",
+      ("Failed to create instance buffer. HRESULT: " + std::to_string(hr)).c_str());
+    return hr;
+  }
+  m_capacity = maxInstances;
+  return S_OK;
+}
+
+void
+InstanceBuffer::destroy() {
+  SAFE_RELEASE(m_buffer);
+  m_capacity = 0;
+  m_head = 0;
+  m_needsDiscard = true;
+  m_stats = Stats();
+}
+
+void
+InstanceBuffer::appendLayout(std::vector<D3D11_INPUT_ELEMENT_DESC>& layout) {
+  // Filas de mWorld (ya transpuesta, como en b2) y luego vMeshColor
+  for (unsigned int row = 0; row < 4; ++row) {
+    layout.push_back({ "INSTANCE_WORLD", row, DXGI_FORMAT_R32G32B32A32_FLOAT, kSlot,
+                       row * 16, D3D11_INPUT_PER_INSTANCE_DATA, 1 });
+  }
+  layout.push_back({ "INSTANCE_COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, kSlot,
+                     offsetof(CBChangesEveryFrame, vMeshColor), D3D11_INPUT_PER_INSTANCE_DATA, 1 });
+}
+
+bool
+InstanceBuffer::push(DeviceContext& deviceContext,
+  const CBChangesEveryFrame* instances,
+  unsigned int count,
+  unsigned int& firstInstance) {
+  if (!m_buffer) {
+    ERROR("InstanceBuffer", "push", "Instance buffer is not initialized");
+    return false;
+  }
+  if (!instances || count == 0 || count > m_capacity) {
+    ERROR("InstanceBuffer", "push", "Invalid arguments: instances is nullptr or count is out of range");
+    return false;
+  }
+
+  D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+  if (m_needsDiscard || m_head + count > m_capacity) {
+    mapType = D3D11_MAP_WRITE_DISCARD;
+    m_head = 0;
+  }
+
+  D3D11_MAPPED_SUBRESOURCE mapped;
+  if (FAILED(deviceContext.Map(m_buffer, 0, mapType, 0, &mapped))) {
+    return false;
+  }
+  const unsigned int bytes = count * sizeof(CBChangesEveryFrame);
+  memcpy(static_cast<unsigned char*>(mapped.pData) + m_head * sizeof(CBChangesEveryFrame), instances, bytes);
+  deviceContext.Unmap(m_buffer, 0);
+  deviceContext.countUpload(bytes);
+
+  if (mapType == D3D11_MAP_WRITE_DISCARD) {
+    ++m_stats.discards;
+    m_needsDiscard = false;
+  }
+  firstInstance = m_head;
+  m_head += count;
+
+  ++m_stats.batches;
+  m_stats.instances += count;
+  m_stats.bytes += bytes;
+  return true;
+}
+
+void
+InstanceBuffer::render(DeviceContext& deviceContext) {
+  if (!m_buffer) {
+    ERROR("InstanceBuffer", "render", "Instance buffer is not initialized");
+    return;
+  }
+  const unsigned int stride = sizeof(CBChangesEveryFrame);
+  const unsigned int offset = 0;
+  deviceContext.IASetVertexBuffers(kSlot, 1, &m_buffer, &stride, &offset);
+}
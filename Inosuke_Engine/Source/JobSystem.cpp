@@ -0,0 +1,603 @@
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+  /// Hilo del sistema al que pertenece el hilo actual (los hilos de trabajo).
+  thread_local const JobSystem* t_system = nullptr;
+  thread_local int t_worker = -1;
+
+  /// Intentos de robo fallidos antes de dormir.
+  const int kSpinsBeforeSleep = 64;
+
+  inline unsigned int nextRandom(unsigned int& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+  inline double elapsedMs(const std::chrono::high_resolution_clock::time_point& start) {
+    return std::chrono::duration<double, std::milli>(
+      std::chrono::high_resolution_clock::now() - start).count();
+  }
+}
+
+// Cola de Chase-Lev con los rdenes de memoria de L, Pop, Cohen y Zappa Nardelli
+// ("Correct and Efficient Work-Stealing for Weak Memory Models", 2013).
+
+bool
+JobSystem::WorkQueue::push(Job* job) {
+  const long long bottom = m_bottom.load(std::memory_order_relaxed);
+  const long long top = m_top.load(std::memory_order_acquire);
+  if (bottom - top >= (long long)kMaxJobsPerThread) {
+    return false;
+  }
+  m_jobs[bottom & (kMaxJobsPerThread - 1)].store(job, std::memory_order_relaxed);
+  // Store con release en lugar de fence + relaxed: mismo orden, y ThreadSanitizer lo entiende
+  m_bottom.store(bottom + 1, std::memory_order_release);
+  return true;
+}
+
+JobSystem::Job*
+JobSystem::WorkQueue::pop() {
+  const long long bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+  m_bottom.store(bottom, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  long long top = m_top.load(std::memory_order_relaxed);
+  if (top > bottom) {
+    m_bottom.store(bottom + 1, std::memory_order_relaxed);   // Vaca
+    return nullptr;
+  }
+  Job* job = m_jobs[bottom & (kMaxJobsPerThread - 1)].load(std::memory_order_relaxed);
+  if (top == bottom) {
+    // ltimo elemento: compite con los ladrones
+    if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      job = nullptr;
+    }
+    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+  }
+  return job;
+}
+
+JobSystem::Job*
+JobSystem::WorkQueue::steal() {
+  long long top = m_top.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  const long long bottom = m_bottom.load(std::memory_order_acquire);
+  if (top >= bottom) {
+    return nullptr;
+  }
+  Job* job = m_jobs[top & (kMaxJobsPerThread - 1)].load(std::memory_order_relaxed);
+  if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+    return nullptr;   // Otro hilo lo tom primero
+  }
+  return job;
+}
+
+bool
+JobSystem::WorkQueue::empty() const {
+  return m_top.load(std::memory_order_acquire) >= m_bottom.load(std::memory_order_acquire);
+}
+
+HRESULT
+JobSystem::init(unsigned int threads) {
+  destroy();
+  if (threads == 0) {
+    threads = (std::max)(1u, std::thread::hardware_concurrency());
+  }
+  m_quit = false;
+  m_queued = 0;
+  m_sleeping = 0;
+  m_mainThread = std::this_thread::get_id();
+  for (unsigned int i = 0; i < threads; ++i) {
+    m_workers.emplace_back(new Worker());
+    m_workers.back()->random = 0x9e3779b9u * (i + 1);
+  }
+  for (unsigned int i = 1; i < threads; ++i) {
+    m_workers[i]->thread = std::thread(&JobSystem::workerLoop, this, i);
+  }
+
+  std::wostringstream wss;
+  wss << threads << L" threads, " << kMaxJobsPerThread << L" jobs per thread";
+  MESSAGE(L"JobSystem", L"init", wss.str());
+  return S_OK;
+}
+
+void
+JobSystem::destroy() {
+  if (m_workers.empty()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_quit = true;
+  }
+  m_wake.notify_all();
+  for (std::unique_ptr<Worker>& worker : m_workers) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+  m_workers.clear();
+}
+
+int
+JobSystem::currentWorker() const {
+  if (t_system == this) {
+    return t_worker;
+  }
+  return std::this_thread::get_id() == m_mainThread && !m_workers.empty() ? 0 : -1;
+}
+
+void
+JobSystem::spawn(Counter& counter, JobFunction function, void* data, unsigned int begin, unsigned int end) {
+  counter.m_value.fetch_add(1, std::memory_order_relaxed);
+  const int worker = currentWorker();
+  if (worker < 0) {
+    Job job;
+    job.function = function;
+    job.data = data;
+    job.begin = begin;
+    job.end = end;
+    job.counter = &counter;
+    execute(job);
+    return;
+  }
+  Worker& owner = *m_workers[worker];
+  ++owner.stats.spawned;
+  Job* job = acquireJob(owner);
+  if (!job) {
+    // Anillo lleno de trabajos sin ejecutar: no pisar ninguno
+    ++owner.stats.inlined;
+    Job local;
+    local.function = function;
+    local.data = data;
+    local.begin = begin;
+    local.end = end;
+    local.counter = &counter;
+    execute(local);
+    return;
+  }
+  job->function = function;
+  job->data = data;
+  job->begin = begin;
+  job->end = end;
+  job->counter = &counter;
+  submit(job, worker);
+}
+
+void
+JobSystem::spawnAfter(Counter& dependency,
+  Counter& counter,
+  JobFunction function,
+  void* data,
+  unsigned int begin,
+  unsigned int end) {
+  const int worker = currentWorker();
+  if (worker < 0) {
+    ERROR("JobSystem", "spawnAfter", "Called from a thread outside the job system");
+    return;
+  }
+  counter.m_value.fetch_add(1, std::memory_order_relaxed);
+  Worker& owner = *m_workers[worker];
+  ++owner.stats.spawned;
+  Job* job = acquireJob(owner);
+  if (!job) {
+    // No se puede ejecutar ahora: espera a la dependencia fuera del anillo
+    job = new Job();
+    job->heap = true;
+  }
+  job->function = function;
+  job->data = data;
+  job->begin = begin;
+  job->end = end;
+  job->counter = &counter;
+
+  {
+    // finish() deja el contador en 0 con el mutex tomado: si aqu an no es 0,
+    // el que lo deje en 0 ver este trabajo en la lista
+    std::lock_guard<std::mutex> lock(dependency.m_mutex);
+    if (dependency.m_value.load(std::memory_order_acquire) != 0) {
+      dependency.m_continuations.push_back(job);
+      return;
+    }
+  }
+  submit(job, worker);
+}
+
+JobSystem::Job*
+JobSystem::acquireJob(Worker& owner) {
+  // Solo el dueo toma ranuras; cualquier hilo las libera en execute()
+  for (unsigned int i = 0; i < kMaxJobsPerThread; ++i) {
+    Job& job = owner.ring[owner.nextJob++ & (kMaxJobsPerThread - 1)];
+    if (!job.busy.load(std::memory_order_acquire)) {
+      job.busy.store(true, std::memory_order_relaxed);
+      return &job;
+    }
+  }
+  return nullptr;
+}
+
+void
+JobSystem::submit(Job* job, unsigned int worker) {
+  Worker& owner = *m_workers[worker];
+  if (!owner.queue.push(job)) {
+    ++owner.stats.inlined;
+    execute(*job);
+    return;
+  }
+  m_queued.fetch_add(1, std::memory_order_seq_cst);
+  if (m_sleeping.load(std::memory_order_seq_cst) > 0) {
+    // Tomar el mutex asegura que el hilo que iba a dormir ya est esperando
+    { std::lock_guard<std::mutex> lock(m_mutex); }
+    m_wake.notify_one();
+  }
+}
+
+JobSystem::Job*
+JobSystem::findJob(unsigned int worker) {
+  Worker& self = *m_workers[worker];
+  Job* job = self.queue.pop();
+  if (!job) {
+    const unsigned int count = (unsigned int)m_workers.size();
+    if (count > 1) {
+      // Empezar en una vctima al azar para no pelear todos por la misma
+      const unsigned int first = nextRandom(self.random) % count;
+      for (unsigned int i = 0; i < count && !job; ++i) {
+        const unsigned int victim = (first + i) % count;
+        if (victim == worker) {
+          continue;
+        }
+        ++self.stats.stealAttempts;
+        job = m_workers[victim]->queue.steal();
+      }
+      if (job) {
+        ++self.stats.stolen;
+      }
+    }
+  }
+  if (job) {
+    m_queued.fetch_sub(1, std::memory_order_relaxed);
+  }
+  return job;
+}
+
+void
+JobSystem::execute(Job& job) {
+  // Copia local: desde aqu el dueo puede reutilizar la ranura
+  const JobFunction function = job.function;
+  void* data = job.data;
+  const unsigned int begin = job.begin;
+  const unsigned int end = job.end;
+  Counter* counter = job.counter;
+  if (job.heap) {
+    delete &job;
+  }
+  else {
+    job.busy.store(false, std::memory_order_release);
+  }
+
+  function(data, begin, end);
+  const int worker = currentWorker();
+  if (worker >= 0) {
+    ++m_workers[worker]->stats.executed;
+  }
+  finish(*counter);
+}
+
+void
+JobSystem::finish(Counter& counter) {
+  int value = counter.m_value.load(std::memory_order_relaxed);
+  while (value > 1) {
+    if (counter.m_value.compare_exchange_weak(value, value - 1, std::memory_order_acq_rel,
+                                              std::memory_order_relaxed)) {
+      return;
+    }
+  }
+
+  // Puede llegar a 0: en cuanto llega, wait() vuelve y el Counter (en la pila de
+  // quien espera) puede destruirse. Bajar y vaciar la lista con el mutex tomado;
+  // wait() toma el mismo mutex antes de volver, as que espera a que se suelte.
+  std::vector<Job*> continuations;
+  {
+    std::lock_guard<std::mutex> lock(counter.m_mutex);
+    if (counter.m_value.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+      return;
+    }
+    continuations.swap(counter.m_continuations);
+  }
+  if (continuations.empty()) {
+    return;
+  }
+  const int worker = currentWorker();
+  for (Job* job : continuations) {
+    if (worker >= 0) {
+      submit(job, worker);
+    }
+    else {
+      execute(*job);
+    }
+  }
+}
+
+void
+JobSystem::wait(Counter& counter) {
+  const int worker = currentWorker();
+  while (!counter.isDone()) {
+    Job* job = worker >= 0 ? findJob(worker) : nullptr;
+    if (job) {
+      execute(*job);
+    }
+    else {
+      std::this_thread::yield();
+    }
+  }
+  // El hilo que lo dej en 0 puede seguir dentro de finish()
+  std::lock_guard<std::mutex> lock(counter.m_mutex);
+}
+
+void
+JobSystem::workerLoop(unsigned int worker) {
+  t_system = this;
+  t_worker = (int)worker;
+  int spins = 0;
+  while (!m_quit.load(std::memory_order_acquire)) {
+    Job* job = findJob(worker);
+    if (job) {
+      execute(*job);
+      spins = 0;
+      continue;
+    }
+    if (++spins < kSpinsBeforeSleep) {
+      std::this_thread::yield();
+      continue;
+    }
+    spins = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_sleeping.fetch_add(1, std::memory_order_seq_cst);
+    ++m_workers[worker]->stats.sleeps;
+    m_wake.wait(lock, [this]() { return m_quit.load() || m_queued.load(std::memory_order_seq_cst) > 0; });
+    m_sleeping.fetch_sub(1, std::memory_order_seq_cst);
+  }
+  t_system = nullptr;
+  t_worker = -1;
+}
+
+void
+JobSystem::splitRange(void* data, unsigned int begin, unsigned int end) {
+  const ParallelFor& range = *static_cast<const ParallelFor*>(data);
+  while (end - begin > range.grain) {
+    const unsigned int middle = begin + (end - begin) / 2;
+    range.system->spawn(*range.counter, &JobSystem::splitRange, data, middle, end);
+    end = middle;
+  }
+  range.invoke(range.body, begin, end);
+}
+
+JobSystem::Stats
+JobSystem::stats() const {
+  Stats total;
+  for (const std::unique_ptr<Worker>& worker : m_workers) {
+    total.spawned += worker->stats.spawned;
+    total.executed += worker->stats.executed;
+    total.stolen += worker->stats.stolen;
+    total.stealAttempts += worker->stats.stealAttempts;
+    total.inlined += worker->stats.inlined;
+    total.sleeps += worker->stats.sleeps;
+  }
+  return total;
+}
+
+void
+JobSystem::resetStats() {
+  for (std::unique_ptr<Worker>& worker : m_workers) {
+    worker->stats = Stats();
+  }
+}
+
+void
+JobSystem::report(const std::string& label) const {
+  const Stats total = stats();
+  std::wostringstream wss;
+  wss << label.c_str() << L": " << getThreadCount() << L" threads, " << total.spawned << L" spawned, "
+    << total.executed << L" executed (" << total.stolen << L" stolen in " << total.stealAttempts
+    << L" attempts), " << total.inlined << L" inlined, " << total.sleeps << L" sleeps";
+  MESSAGE(L"JobSystem", L"report", wss.str());
+}
+
+bool
+JobSystem::benchmark(unsigned int maxThreads) {
+  const unsigned int hardwareThreads = (std::max)(1u, std::thread::hardware_concurrency());
+  if (maxThreads == 0) maxThreads = hardwareThreads;
+  bool ok = true;
+
+  std::wostringstream wss;
+  wss << hardwareThreads << L" hardware threads, testing up to " << maxThreads;
+  MESSAGE(L"JobSystem", L"benchmark", wss.str());
+
+  // 1) Costo de spawn + ejecucin de un trabajo vaco, contra crear y unir un std::thread
+  {
+    const int kThreadCreates = 200;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < kThreadCreates; ++i) {
+      std::thread([]() {}).join();
+    }
+    const double threadNs = elapsedMs(start) * 1.0e6 / kThreadCreates;
+
+    const unsigned int kJobs = 1u << 20;
+    const unsigned int kBatch = 1024;
+    auto empty = [](void*, unsigned int, unsigned int) {};
+    for (unsigned int threads : { 1u, maxThreads }) {
+      JobSystem jobs;
+      jobs.init(threads);
+      Counter counter;
+      start = std::chrono::high_resolution_clock::now();
+      for (unsigned int i = 0; i < kJobs; i += kBatch) {
+        for (unsigned int j = 0; j < kBatch; ++j) {
+          jobs.spawn(counter, empty, nullptr);
+        }
+        jobs.wait(counter);
+      }
+      const double jobNs = elapsedMs(start) * 1.0e6 / kJobs;
+      const Stats stats = jobs.stats();
+      ok = ok && stats.executed == kJobs;
+
+      wss.str(L"");
+      wss << L"  spawn+run empty job, " << threads << L" threads: " << jobNs << L" ns/job ("
+          << stats.stolen << L" stolen) vs std::thread create+join " << threadNs << L" ns";
+      MESSAGE(L"JobSystem", L"benchmark", wss.str());
+      if (threads == maxThreads) break;
+    }
+  }
+
+  // 2) Latencia de robo: el hilo 0 encola un trabajo y espera sin ejecutarlo
+  if (maxThreads > 1) {
+    JobSystem jobs;
+    jobs.init(2);
+    const int kSamples = 2000;
+    std::vector<double> latencies;
+    latencies.reserve(kSamples);
+    struct Probe {
+      std::chrono::high_resolution_clock::time_point started;
+    } probe;
+    auto record = [](void* data, unsigned int, unsigned int) {
+      static_cast<Probe*>(data)->started = std::chrono::high_resolution_clock::now();
+    };
+    for (int i = 0; i < kSamples; ++i) {
+      Counter counter;
+      const auto spawned = std::chrono::high_resolution_clock::now();
+      jobs.spawn(counter, record, &probe);
+      while (!counter.isDone()) {
+        std::this_thread::yield();
+      }
+      { std::lock_guard<std::mutex> lock(counter.m_mutex); }
+      latencies.push_back(std::chrono::duration<double, std::micro>(probe.started - spawned).count());
+    }
+    std::sort(latencies.begin(), latencies.end());
+    wss.str(L"");
+    wss << L"  steal latency (spawn on thread 0 to start on thread 1): median " << latencies[kSamples / 2]
+        << L" us, p90 " << latencies[kSamples * 9 / 10] << L" us, " << jobs.stats().sleeps << L" wake-ups from sleep";
+    if (hardwareThreads < 2) wss << L" (1 core: includes the OS switching threads)";
+    MESSAGE(L"JobSystem", L"benchmark", wss.str());
+  }
+
+  // 3) Escala de parallelFor: sumas parciales por bloque fijo, as el total no
+  // depende del reparto
+  {
+    const unsigned int kElements = 1u << 22;
+    const unsigned int kBlock = 4096;
+    const unsigned int blockCount = kElements / kBlock;
+    auto work = [&](std::vector<double>& partial, unsigned int begin, unsigned int end) {
+      for (unsigned int block = begin; block < end; ++block) {
+        double sum = 0.0;
+        for (unsigned int i = block * kBlock; i < (block + 1) * kBlock; ++i) {
+          sum += sqrt((double)i) * sin((double)i * 0.001);
+        }
+        partial[block] = sum;
+      }
+    };
+    std::vector<double> reference(blockCount);
+    auto start = std::chrono::high_resolution_clock::now();
+    work(reference, 0, blockCount);
+    const double serialMs = elapsedMs(start);
+
+    for (unsigned int threads = 1; ; threads = (std::min)(threads * 2, maxThreads)) {
+      JobSystem jobs;
+      jobs.init(threads);
+      std::vector<double> partial(blockCount, 0.0);
+      start = std::chrono::high_resolution_clock::now();
+      jobs.parallelFor(blockCount, 4, [&](unsigned int begin, unsigned int end) { work(partial, begin, end); });
+      const double parallelMs = elapsedMs(start);
+      ok = ok && partial == reference;
+
+      wss.str(L"");
+      wss << L"  parallelFor " << threads << L" threads: " << parallelMs << L" ms, speedup "
+          << serialMs / parallelMs << L"x over serial " << serialMs << L" ms (" << jobs.stats().stolen
+          << L" stolen)";
+      MESSAGE(L"JobSystem", L"benchmark", wss.str());
+      if (threads == maxThreads) break;
+    }
+  }
+
+  // 4) Dependencias: la segunda etapa lee lo que escribi la primera
+  {
+    JobSystem jobs;
+    jobs.init(maxThreads);
+    const unsigned int kItems = 1024;
+    std::vector<unsigned int> stage1(kItems, 0), stage2(kItems, 0);
+    struct Stages {
+      std::vector<unsigned int>* first;
+      std::vector<unsigned int>* second;
+    } stages = { &stage1, &stage2 };
+    auto produce = [](void* data, unsigned int begin, unsigned int) {
+      (*static_cast<Stages*>(data)->first)[begin] = begin * 3 + 1;
+    };
+    auto consume = [](void* data, unsigned int begin, unsigned int) {
+      Stages& s = *static_cast<Stages*>(data);
+      (*s.second)[begin] = (*s.first)[begin] * 2;
+    };
+    for (int round = 0; round < 20 && ok; ++round) {
+      Counter first, second;
+      std::fill(stage1.begin(), stage1.end(), 0u);
+      // Encolar los consumidores primero: solo pueden correr cuando 'first' llegue a 0
+      first.m_value.fetch_add(1);   // Retener la etapa hasta encolar todo
+      for (unsigned int i = 0; i < kItems; ++i) jobs.spawnAfter(first, second, consume, &stages, i, i + 1);
+      for (unsigned int i = 0; i < kItems; ++i) jobs.spawn(first, produce, &stages, i, i + 1);
+      jobs.finish(first);
+      jobs.wait(second);
+      for (unsigned int i = 0; i < kItems; ++i) ok = ok && stage2[i] == (i * 3 + 1) * 2;
+    }
+    wss.str(L"");
+    wss << L"  dependencies: " << kItems << L" consumers after " << kItems << L" producers x 20 rounds "
+        << (ok ? L"ok" : L"FAILED");
+    MESSAGE(L"JobSystem", L"benchmark", wss.str());
+  }
+
+  // 5) Estrs: parallelFor cortos seguidos (el Counter vive en la pila de cada
+  // llamada) y ms trabajos que ranuras en el anillo, con y sin dependencia
+  {
+    JobSystem jobs;
+    jobs.init(maxThreads);
+    const unsigned int kCalls = 20000;
+    std::atomic<unsigned int> touched{ 0 };
+    unsigned long long expected = 0;
+    for (unsigned int call = 0; call < kCalls; ++call) {
+      const unsigned int count = 1 + call % 16;
+      jobs.parallelFor(count, 1, [&](unsigned int begin, unsigned int end) {
+        touched.fetch_add(end - begin, std::memory_order_relaxed);
+      });
+      expected += count;
+    }
+    const bool shortCalls = touched.load() == expected;
+
+    const unsigned int kOverflow = kMaxJobsPerThread * 2 + 17;
+    std::atomic<unsigned int> ran{ 0 };
+    auto increment = [](void* data, unsigned int, unsigned int) {
+      static_cast<std::atomic<unsigned int>*>(data)->fetch_add(1, std::memory_order_relaxed);
+    };
+    Counter gate, parked, flat;
+    gate.m_value.fetch_add(1);
+    for (unsigned int i = 0; i < kOverflow; ++i) jobs.spawnAfter(gate, parked, increment, &ran);
+    const bool heldBack = ran.load() == 0;
+    for (unsigned int i = 0; i < kOverflow; ++i) jobs.spawn(flat, increment, &ran);
+    jobs.wait(flat);
+    const bool flatRan = ran.load() == kOverflow;
+    jobs.finish(gate);
+    jobs.wait(parked);
+    const bool overflow = heldBack && flatRan && ran.load() == kOverflow * 2;
+    ok = ok && shortCalls && overflow;
+
+    wss.str(L"");
+    wss << L"  stress: " << kCalls << L" short parallelFor " << (shortCalls ? L"ok" : L"FAILED") << L", "
+        << kOverflow << L" jobs and " << kOverflow << L" continuations over a " << kMaxJobsPerThread
+        << L"-slot ring " << (overflow ? L"ok" : L"FAILED") << L" (" << jobs.stats().inlined << L" inlined)";
+    MESSAGE(L"JobSystem", L"benchmark", wss.str());
+  }
+
+  if (!ok) {
+    ERROR(L"JobSystem", L"benchmark", L"A parallel result differs from the serial one");
+  }
+  return ok;
+}
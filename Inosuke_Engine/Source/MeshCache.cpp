@@ -0,0 +1,395 @@
+#include "MeshCache.h"
+#include "MeshComponent.h"
+#include "MappedFile.h"
+#include <fstream>
+#include <cstring>
+#include <cmath>
+
+namespace {
+  struct MeshCacheHeader {
+    unsigned int magic;
+    unsigned int version;
+    unsigned long long sourceSize;
+    unsigned long long sourceWriteTime;
+    unsigned long long sourceHash;
+    unsigned int numElements;     // Elementos del layout de vrtice
+    unsigned int vertexStride;    // sizeof(SimpleVertex) al generar la cach
+    unsigned int vertexCount;
+    unsigned int indexCount;
+    unsigned int indexStride;     // Bytes por ndice
+    unsigned int flags;           // MeshCache::kFlag*
+    unsigned int lodCount;        // Niveles de detalle (0 = solo la malla completa)
+    unsigned int meshletCount;    // Clusters del nivel 0 (0 = no se construyeron)
+    float boundsMin[3];
+    float boundsMax[3];
+    float boundsRadius;           // Esfera centrada en la caja (MeshComponent::computeBounds)
+    unsigned int reserved;
+    unsigned long long elementsOffset;
+    unsigned long long lodOffset;
+    unsigned long long meshletOffset;
+    unsigned long long vertexOffset;
+    unsigned long long indexOffset;
+    unsigned long long fileSize;
+    unsigned long long checksum;  // contentChecksum(): header y todo lo que le sigue
+  };
+
+  struct MeshCacheLod {
+    unsigned int indexOffset;
+    unsigned int indexCount;
+    float error;
+    unsigned int reserved;
+  };
+
+  struct MeshCacheMeshlet {
+    unsigned int indexOffset;
+    unsigned int triangleCount;
+    unsigned int vertexCount;
+    float center[3];
+    float radius;
+    float coneAxis[3];
+    float coneCutoff;
+    unsigned int reserved[3];
+  };
+
+  struct MeshCacheElement {
+    char semantic[16];
+    unsigned int semanticIndex;
+    unsigned int format;          // DXGI_FORMAT
+    unsigned int offset;          // Offset dentro de SimpleVertex
+    unsigned int reserved;
+  };
+
+  // Layout actual de SimpleVertex; una cach con otro layout se descarta.
+  const MeshCacheElement kSimpleVertexLayout[] = {
+    { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, offsetof(SimpleVertex, Pos), 0 },
+    { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,    offsetof(SimpleVertex, Tex), 0 },
+  };
+  const unsigned int kNumLayoutElements =
+    sizeof(kSimpleVertexLayout) / sizeof(kSimpleVertexLayout[0]);
+
+  // Bytes muestreados al inicio y al final del archivo fuente para el sello.
+  const size_t kStampSampleBytes = 64 * 1024;
+
+  inline unsigned long long align16(unsigned long long value) {
+    return (value + 15) & ~15ull;
+  }
+
+  /**
+   * @brief @p count elementos de @p stride bytes desde @p offset caben en
+   * [@p begin, @p end). Sin sumas que puedan desbordar con valores corruptos.
+   */
+  inline bool sectionFits(unsigned long long offset,
+    unsigned long long count,
+    unsigned long long stride,
+    unsigned long long begin,
+    unsigned long long end) {
+    return offset >= begin && offset <= end && count <= (end - offset) / stride;
+  }
+
+  /// Checksum de la cach: header (con checksum = 0) y contenido, as un conteo corrupto no pasa.
+  unsigned long long contentChecksum(const MeshCacheHeader& header, const char* payload, size_t size) {
+    MeshCacheHeader unchecked = header;
+    unchecked.checksum = 0;
+    return MeshCache::hashBytes(payload, size, MeshCache::hashBytes(&unchecked, sizeof(unchecked)));
+  }
+
+  inline unsigned long long rotl64(unsigned long long x, int r) {
+    return (x << r) | (x >> (64 - r));
+  }
+
+  inline unsigned long long mixLane(unsigned long long acc, unsigned long long word) {
+    acc += word * 0xC2B2AE3D27D4EB4Full;
+    acc = rotl64(acc, 31);
+    return acc * 0x9E3779B97F4A7C15ull;
+  }
+}
+
+unsigned long long
+MeshCache::hashBytes(const void* data, size_t size, unsigned long long seed) {
+  const unsigned char* p = static_cast<const unsigned char*>(data);
+  const unsigned char* const end = p + size;
+
+  // Cuatro carriles independientes para no encadenar una multiplicacin por palabra.
+  unsigned long long lanes[4] = {
+    seed + 0x9E3779B97F4A7C15ull + 0xC2B2AE3D27D4EB4Full,
+    seed + 0xC2B2AE3D27D4EB4Full,
+    seed,
+    seed - 0x9E3779B97F4A7C15ull
+  };
+  for (; end - p >= 32; p += 32) {
+    unsigned long long words[4];
+    memcpy(words, p, 32);
+    for (int i = 0; i < 4; ++i) lanes[i] = mixLane(lanes[i], words[i]);
+  }
+
+  unsigned long long h = rotl64(lanes[0], 1) + rotl64(lanes[1], 7) +
+                         rotl64(lanes[2], 12) + rotl64(lanes[3], 18);
+  h += (unsigned long long)size;
+  for (; end - p >= 8; p += 8) {
+    unsigned long long word;
+    memcpy(&word, p, 8);
+    h = mixLane(h, word);
+  }
+  for (; p < end; ++p) {
+    h = (h ^ *p) * 0x100000001B3ull;
+  }
+
+  h ^= h >> 33;
+  h *= 0xFF51AFD7ED558CCDull;
+  h ^= h >> 33;
+  h *= 0xC4CEB9FE1A85EC53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+std::string
+MeshCache::cachePathFor(const std::string& sourceFile) {
+  return sourceFile + ".imesh";
+}
+
+bool
+MeshCache::stampSource(const std::string& sourceFile, SourceStamp& outStamp) {
+  WIN32_FILE_ATTRIBUTE_DATA attributes = {};
+  if (!GetFileAttributesExA(sourceFile.c_str(), GetFileExInfoStandard, &attributes)) {
+    return false;
+  }
+
+  outStamp.size = ((unsigned long long)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+  outStamp.writeTime = ((unsigned long long)attributes.ftLastWriteTime.dwHighDateTime << 32) |
+                       attributes.ftLastWriteTime.dwLowDateTime;
+  outStamp.hash = 0;
+
+  // Hashear el archivo completo anulara la ganancia de la cach en archivos de
+  // cientos de MB; se muestrean el inicio y el final adems de tamao y fecha.
+  MappedFile file;
+  if (SUCCEEDED(file.init(sourceFile))) {
+    const size_t head = (std::min)(file.size(), kStampSampleBytes);
+    outStamp.hash = hashBytes(file.data(), head, outStamp.size);
+    if (file.size() > head) {
+      const size_t tail = (std::min)(file.size() - head, kStampSampleBytes);
+      outStamp.hash = hashBytes(file.data() + file.size() - tail, tail, outStamp.hash);
+    }
+  }
+  return true;
+}
+
+bool
+MeshCache::save(const std::string& cacheFile,
+  const MeshComponent& mesh,
+  const SourceStamp& stamp,
+  unsigned int flags) {
+  if (mesh.m_vertex.empty() || mesh.m_index.empty()) {
+    ERROR("MeshCache", "save", "Mesh is empty");
+    return false;
+  }
+
+  MeshCacheHeader header = {};
+  header.magic = kMagic;
+  header.version = kVersion;
+  header.sourceSize = stamp.size;
+  header.sourceWriteTime = stamp.writeTime;
+  header.sourceHash = stamp.hash;
+  header.numElements = kNumLayoutElements;
+  header.vertexStride = sizeof(SimpleVertex);
+  header.vertexCount = (unsigned int)mesh.m_vertex.size();
+  header.indexCount = (unsigned int)mesh.m_index.size();
+  header.indexStride = sizeof(unsigned int);
+  header.flags = flags;
+  header.lodCount = (unsigned int)mesh.m_lods.size();
+  header.meshletCount = (unsigned int)mesh.m_meshlets.size();
+
+  header.boundsMin[0] = header.boundsMax[0] = mesh.m_vertex[0].Pos.x;
+  header.boundsMin[1] = header.boundsMax[1] = mesh.m_vertex[0].Pos.y;
+  header.boundsMin[2] = header.boundsMax[2] = mesh.m_vertex[0].Pos.z;
+  for (const SimpleVertex& v : mesh.m_vertex) {
+    header.boundsMin[0] = (std::min)(header.boundsMin[0], v.Pos.x);
+    header.boundsMin[1] = (std::min)(header.boundsMin[1], v.Pos.y);
+    header.boundsMin[2] = (std::min)(header.boundsMin[2], v.Pos.z);
+    header.boundsMax[0] = (std::max)(header.boundsMax[0], v.Pos.x);
+    header.boundsMax[1] = (std::max)(header.boundsMax[1], v.Pos.y);
+    header.boundsMax[2] = (std::max)(header.boundsMax[2], v.Pos.z);
+  }
+  // Mismo radio que computeBounds(): vrtice ms lejano al centro de la caja
+  const float center[3] = { (header.boundsMin[0] + header.boundsMax[0]) * 0.5f,
+    (header.boundsMin[1] + header.boundsMax[1]) * 0.5f, (header.boundsMin[2] + header.boundsMax[2]) * 0.5f };
+  float radiusSq = 0.0f;
+  for (const SimpleVertex& v : mesh.m_vertex) {
+    const float dx = v.Pos.x - center[0];
+    const float dy = v.Pos.y - center[1];
+    const float dz = v.Pos.z - center[2];
+    radiusSq = (std::max)(radiusSq, dx * dx + dy * dy + dz * dz);
+  }
+  header.boundsRadius = sqrtf(radiusSq);
+
+  const unsigned long long vertexBytes = (unsigned long long)header.vertexCount * header.vertexStride;
+  const unsigned long long indexBytes = (unsigned long long)header.indexCount * header.indexStride;
+  const unsigned long long lodBytes = (unsigned long long)header.lodCount * sizeof(MeshCacheLod);
+  const unsigned long long meshletBytes = (unsigned long long)header.meshletCount * sizeof(MeshCacheMeshlet);
+  header.elementsOffset = align16(sizeof(MeshCacheHeader));
+  header.lodOffset = align16(header.elementsOffset + sizeof(kSimpleVertexLayout));
+  header.meshletOffset = align16(header.lodOffset + lodBytes);
+  header.vertexOffset = align16(header.meshletOffset + meshletBytes);
+  header.indexOffset = align16(header.vertexOffset + vertexBytes);
+  header.fileSize = header.indexOffset + indexBytes;
+
+  // Armar el contenido completo en memoria para calcular el checksum de una pasada.
+  // Los offsets del header son del archivo; en payload se restan los bytes del header.
+  std::vector<char> payload((size_t)(header.fileSize - sizeof(MeshCacheHeader)), 0);
+  auto section = [&payload](unsigned long long fileOffset) {
+    return payload.data() + (size_t)(fileOffset - sizeof(MeshCacheHeader));
+  };
+  memcpy(section(header.elementsOffset), kSimpleVertexLayout, sizeof(kSimpleVertexLayout));
+  for (unsigned int i = 0; i < header.lodCount; ++i) {
+    const MeshCacheLod lod = { mesh.m_lods[i].indexOffset, mesh.m_lods[i].indexCount, mesh.m_lods[i].error, 0 };
+    memcpy(section(header.lodOffset) + i * sizeof(MeshCacheLod), &lod, sizeof(lod));
+  }
+  for (unsigned int i = 0; i < header.meshletCount; ++i) {
+    const Meshlet& source = mesh.m_meshlets[i];
+    const MeshCacheMeshlet meshlet = {
+      source.indexOffset, source.triangleCount, source.vertexCount,
+      { source.center.x, source.center.y, source.center.z }, source.radius,
+      { source.coneAxis.x, source.coneAxis.y, source.coneAxis.z }, source.coneCutoff, { 0, 0, 0 }
+    };
+    memcpy(section(header.meshletOffset) + i * sizeof(MeshCacheMeshlet), &meshlet, sizeof(meshlet));
+  }
+  memcpy(section(header.vertexOffset), mesh.m_vertex.data(), (size_t)vertexBytes);
+  memcpy(section(header.indexOffset), mesh.m_index.data(), (size_t)indexBytes);
+  header.checksum = contentChecksum(header, payload.data(), payload.size());
+
+  const std::string tempFile = cacheFile + ".tmp";
+  bool written = false;
+  {
+    std::ofstream out(tempFile, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+      ERROR("MeshCache", "save", ("Failed to open: " + tempFile).c_str());
+      return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(payload.data(), (std::streamsize)payload.size());
+    out.close();
+    written = !out.fail();
+  }
+  // Un temporal a medias no se renombra ni se deja junto a la cach
+  if (!written) {
+    ERROR("MeshCache", "save", ("Failed to write: " + tempFile).c_str());
+    DeleteFileA(tempFile.c_str());
+    return false;
+  }
+
+  if (!MoveFileExA(tempFile.c_str(), cacheFile.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+    ERROR("MeshCache", "save", ("Failed to replace: " + cacheFile).c_str());
+    DeleteFileA(tempFile.c_str());
+    return false;
+  }
+
+  MESSAGE("MeshCache", "save", ("OK " + cacheFile).c_str());
+  return true;
+}
+
+bool
+MeshCache::load(const std::string& cacheFile,
+  const SourceStamp& stamp,
+  MeshComponent& outMesh,
+  unsigned int* outFlags) {
+  // Que la cach no exista es lo normal en la primera carga: no se reporta como error.
+  WIN32_FILE_ATTRIBUTE_DATA attributes = {};
+  if (!GetFileAttributesExA(cacheFile.c_str(), GetFileExInfoStandard, &attributes)) {
+    return false;
+  }
+
+  MappedFile file;
+  if (FAILED(file.init(cacheFile))) {
+    return false;
+  }
+  if (file.size() < sizeof(MeshCacheHeader)) {
+    ERROR("MeshCache", "load", ("Truncated cache: " + cacheFile).c_str());
+    return false;
+  }
+
+  MeshCacheHeader header;
+  memcpy(&header, file.data(), sizeof(header));
+
+  if (header.magic != kMagic || header.version != kVersion) {
+    MESSAGE("MeshCache", "load", ("Stale cache version: " + cacheFile).c_str());
+    return false;
+  }
+  if (header.sourceSize != stamp.size ||
+      header.sourceWriteTime != stamp.writeTime ||
+      header.sourceHash != stamp.hash) {
+    MESSAGE("MeshCache", "load", ("Source changed, cache invalidated: " + cacheFile).c_str());
+    return false;
+  }
+  // Secciones en orden y dentro del archivo, validadas antes de leer cualquiera:
+  // header | layout | LODs | meshlets | vrtices | ndices
+  const unsigned long long fileSize = file.size();
+  if (header.fileSize != fileSize ||
+      header.vertexStride != sizeof(SimpleVertex) ||
+      header.indexStride != sizeof(unsigned int) ||
+      header.numElements != kNumLayoutElements ||
+      ((header.elementsOffset | header.lodOffset | header.meshletOffset | header.vertexOffset |
+        header.indexOffset) & 15) != 0 ||
+      !sectionFits(header.elementsOffset, 1, sizeof(kSimpleVertexLayout), sizeof(MeshCacheHeader), fileSize) ||
+      !sectionFits(header.lodOffset, header.lodCount, sizeof(MeshCacheLod),
+        header.elementsOffset + sizeof(kSimpleVertexLayout), fileSize) ||
+      !sectionFits(header.meshletOffset, header.meshletCount, sizeof(MeshCacheMeshlet), header.lodOffset, fileSize) ||
+      header.meshletOffset - header.lodOffset < (unsigned long long)header.lodCount * sizeof(MeshCacheLod) ||
+      !sectionFits(header.vertexOffset, header.vertexCount, header.vertexStride, header.meshletOffset, fileSize) ||
+      header.vertexOffset - header.meshletOffset < (unsigned long long)header.meshletCount * sizeof(MeshCacheMeshlet) ||
+      !sectionFits(header.indexOffset, header.indexCount, header.indexStride, header.vertexOffset, fileSize) ||
+      header.indexOffset - header.vertexOffset < (unsigned long long)header.vertexCount * header.vertexStride) {
+    ERROR("MeshCache", "load", ("Malformed cache: " + cacheFile).c_str());
+    return false;
+  }
+  if (contentChecksum(header, file.data() + sizeof(MeshCacheHeader), file.size() - sizeof(MeshCacheHeader)) !=
+      header.checksum) {
+    ERROR("MeshCache", "load", ("Checksum mismatch: " + cacheFile).c_str());
+    return false;
+  }
+  if (memcmp(file.data() + header.elementsOffset, kSimpleVertexLayout, sizeof(kSimpleVertexLayout)) != 0) {
+    MESSAGE("MeshCache", "load", ("Vertex layout changed, cache invalidated: " + cacheFile).c_str());
+    return false;
+  }
+
+  const SimpleVertex* vertices = reinterpret_cast<const SimpleVertex*>(file.data() + header.vertexOffset);
+  const unsigned int* indices = reinterpret_cast<const unsigned int*>(file.data() + header.indexOffset);
+  std::vector<MeshLod> lods(header.lodCount);
+  for (unsigned int i = 0; i < header.lodCount; ++i) {
+    MeshCacheLod lod;
+    memcpy(&lod, file.data() + header.lodOffset + i * sizeof(MeshCacheLod), sizeof(lod));
+    if ((unsigned long long)lod.indexOffset + lod.indexCount > header.indexCount || lod.indexCount % 3 != 0) {
+      ERROR("MeshCache", "load", ("Malformed LOD table: " + cacheFile).c_str());
+      return false;
+    }
+    lods[i] = { lod.indexOffset, lod.indexCount, lod.error };
+  }
+  // Los meshlets parten el nivel 0: cada uno debe caer dentro de sus ndices
+  const unsigned long long level0Count = lods.empty() ? header.indexCount : lods[0].indexCount;
+  std::vector<Meshlet> meshlets(header.meshletCount);
+  for (unsigned int i = 0; i < header.meshletCount; ++i) {
+    MeshCacheMeshlet meshlet;
+    memcpy(&meshlet, file.data() + header.meshletOffset + i * sizeof(MeshCacheMeshlet), sizeof(meshlet));
+    if (meshlet.triangleCount == 0 ||
+        (unsigned long long)meshlet.indexOffset + meshlet.triangleCount * 3ull > level0Count) {
+      ERROR("MeshCache", "load", ("Malformed meshlet table: " + cacheFile).c_str());
+      return false;
+    }
+    meshlets[i] = { meshlet.indexOffset, meshlet.triangleCount, meshlet.vertexCount,
+      XMFLOAT3(meshlet.center[0], meshlet.center[1], meshlet.center[2]), meshlet.radius,
+      XMFLOAT3(meshlet.coneAxis[0], meshlet.coneAxis[1], meshlet.coneAxis[2]), meshlet.coneCutoff };
+  }
+
+  outMesh.m_vertex.assign(vertices, vertices + header.vertexCount);
+  outMesh.m_index.assign(indices, indices + header.indexCount);
+  outMesh.m_lods.swap(lods);
+  outMesh.m_meshlets.swap(meshlets);
+  outMesh.m_numVertex = (int)header.vertexCount;
+  outMesh.m_numIndex = (int)(outMesh.m_lods.empty() ? header.indexCount : outMesh.m_lods[0].indexCount);
+  // Los bounds vienen del header (cubierto por el checksum): no se recorren los vrtices
+  outMesh.m_boundsCenter = XMFLOAT3((header.boundsMin[0] + header.boundsMax[0]) * 0.5f,
+    (header.boundsMin[1] + header.boundsMax[1]) * 0.5f, (header.boundsMin[2] + header.boundsMax[2]) * 0.5f);
+  outMesh.m_boundsExtents = XMFLOAT3((header.boundsMax[0] - header.boundsMin[0]) * 0.5f,
+    (header.boundsMax[1] - header.boundsMin[1]) * 0.5f, (header.boundsMax[2] - header.boundsMin[2]) * 0.5f);
+  outMesh.m_boundsRadius = header.boundsRadius;
+  if (outFlags) *outFlags = header.flags;
+  return true;
+}
@@ -0,0 +1,54 @@
+#include "MeshComponent.h"
+#include <algorithm>
+#include <cmath>
+
+void
+MeshComponent::selectIndexFormat() {
+  // 0xFFFF solo es especial (corte de strip) en topologas de tira; con listas
+  // de tringulos los 65536 valores son ndices vlidos.
+  const size_t kMaxVertices16 = 65536;
+
+  m_indexFormat = !m_vertex.empty() && m_vertex.size() <= kMaxVertices16
+    ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+}
+
+void
+MeshComponent::computeBounds() {
+  if (m_vertex.empty()) {
+    m_boundsCenter = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    m_boundsExtents = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    m_boundsRadius = 0.0f;
+    return;
+  }
+  XMFLOAT3 minimum = m_vertex[0].Pos;
+  XMFLOAT3 maximum = m_vertex[0].Pos;
+  for (const SimpleVertex& vertex : m_vertex) {
+    minimum.x = (std::min)(minimum.x, vertex.Pos.x);
+    minimum.y = (std::min)(minimum.y, vertex.Pos.y);
+    minimum.z = (std::min)(minimum.z, vertex.Pos.z);
+    maximum.x = (std::max)(maximum.x, vertex.Pos.x);
+    maximum.y = (std::max)(maximum.y, vertex.Pos.y);
+    maximum.z = (std::max)(maximum.z, vertex.Pos.z);
+  }
+  m_boundsCenter = XMFLOAT3((minimum.x + maximum.x) * 0.5f, (minimum.y + maximum.y) * 0.5f, (minimum.z + maximum.z) * 0.5f);
+  m_boundsExtents = XMFLOAT3((maximum.x - minimum.x) * 0.5f, (maximum.y - minimum.y) * 0.5f, (maximum.z - minimum.z) * 0.5f);
+
+  // Esfera centrada en la caja: el vrtice ms lejano define el radio
+  float radiusSq = 0.0f;
+  for (const SimpleVertex& vertex : m_vertex) {
+    const float dx = vertex.Pos.x - m_boundsCenter.x;
+    const float dy = vertex.Pos.y - m_boundsCenter.y;
+    const float dz = vertex.Pos.z - m_boundsCenter.z;
+    radiusSq = (std::max)(radiusSq, dx * dx + dy * dy + dz * dz);
+  }
+  m_boundsRadius = sqrtf(radiusSq);
+}
+
+void
+MeshComponent::clearLods() {
+  if (m_lods.empty()) return;
+  m_index.resize(m_lods[0].indexCount);
+  m_numIndex = (int)m_index.size();
+  m_lods.clear();
+  selectIndexFormat();
+}
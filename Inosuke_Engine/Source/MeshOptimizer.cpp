@@ -0,0 +1,504 @@
+#include "MeshOptimizer.h"
+#include "MeshComponent.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace {
+  // Parmetros del artculo de Forsyth ("Linear-Speed Vertex Cache Optimisation").
+  const unsigned int kScoreCacheSize = 32;   // Cach LRU simulado para el puntaje
+  const float kCacheDecayPower = 1.5f;
+  const float kLastTriangleScore = 0.75f;
+  const float kValenceBoostScale = 2.0f;
+  const float kValenceBoostPower = 0.5f;
+  const unsigned int kMaxValence = 32;       // Valencias mayores usan el ltimo valor de la tabla
+
+  struct ScoreTables {
+    float cache[kScoreCacheSize];
+    float valence[kMaxValence + 1];
+
+    ScoreTables() {
+      for (unsigned int i = 0; i < kScoreCacheSize; ++i) {
+        // Los 3 vrtices del ltimo tringulo reciben un puntaje fijo: reutilizarlos de
+        // inmediato casi nunca genera buenas tiras.
+        cache[i] = i < 3 ? kLastTriangleScore
+          : powf(1.0f - float(i - 3) / float(kScoreCacheSize - 3), kCacheDecayPower);
+      }
+      valence[0] = 0.0f;
+      for (unsigned int i = 1; i <= kMaxValence; ++i) {
+        valence[i] = kValenceBoostScale * powf(float(i), -kValenceBoostPower);
+      }
+    }
+  };
+
+  /**
+   * Vista ortogrfica para analyzeOverdraw(): eje y sentido de cada coordenada de
+   * pantalla (x, y hacia arriba, profundidad). Son las bases de XMMatrixLookAtLH
+   * mirando a lo largo de +Z, -Z, +X, -X, +Y y -Y.
+   */
+  struct OverdrawView {
+    int axis[3];
+    bool flip[3];
+  };
+
+  const OverdrawView kOverdrawViews[] = {
+    { { 0, 1, 2 }, { false, false, false } },
+    { { 0, 1, 2 }, { true,  false, true  } },
+    { { 2, 1, 0 }, { true,  false, false } },
+    { { 2, 1, 0 }, { false, false, true  } },
+    { { 0, 2, 1 }, { true,  false, false } },
+    { { 0, 2, 1 }, { false, false, true  } },
+  };
+
+  inline float axisValue(const XMFLOAT3& p, int axis) {
+    return axis == 0 ? p.x : (axis == 1 ? p.y : p.z);
+  }
+
+  void rasterizeTriangle(const float x[3], const float y[3], const float z[3],
+    unsigned int resolution,
+    std::vector<float>& depth,
+    unsigned long long& shaded) {
+    // En D3D11 la cara frontal es horaria en pantalla; con y hacia arriba eso es
+    // rea con signo negativa. Se invierte el orden para trabajar con rea positiva.
+    const float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+    if (area >= 0.0f) return;
+    const float ax = x[0], ay = y[0], az = z[0];
+    const float bx = x[2], by = y[2], bz = z[2];
+    const float cx = x[1], cy = y[1], cz = z[1];
+    const float invArea = -1.0f / area;
+
+    const int minX = (std::max)(0, (int)floorf((std::min)({ ax, bx, cx })));
+    const int minY = (std::max)(0, (int)floorf((std::min)({ ay, by, cy })));
+    const int maxX = (std::min)((int)resolution - 1, (int)ceilf((std::max)({ ax, bx, cx })));
+    const int maxY = (std::min)((int)resolution - 1, (int)ceilf((std::max)({ ay, by, cy })));
+
+    for (int py = minY; py <= maxY; ++py) {
+      const float sy = py + 0.5f;
+      for (int px = minX; px <= maxX; ++px) {
+        const float sx = px + 0.5f;
+        // Funciones de arista respecto al centro del pxel.
+        const float w0 = (cx - bx) * (sy - by) - (cy - by) * (sx - bx);
+        const float w1 = (ax - cx) * (sy - cy) - (ay - cy) * (sx - cx);
+        const float w2 = (bx - ax) * (sy - ay) - (by - ay) * (sx - ax);
+        if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+
+        const float d = (w0 * az + w1 * bz + w2 * cz) * invArea;
+        float& stored = depth[(size_t)py * resolution + px];
+        if (d < stored) {
+          stored = d;
+          ++shaded;
+        }
+      }
+    }
+  }
+
+  inline float vertexScore(const ScoreTables& tables, int cachePosition, unsigned int liveTriangles) {
+    // Un vrtice sin tringulos pendientes ya no aporta a ningn puntaje.
+    if (liveTriangles == 0) return -1.0f;
+    const float cacheScore = cachePosition >= 0 ? tables.cache[cachePosition] : 0.0f;
+    return cacheScore + tables.valence[(std::min)(liveTriangles, kMaxValence)];
+  }
+}
+
+bool
+MeshOptimizer::optimize(MeshComponent& mesh, float overdrawThreshold) {
+  if (mesh.m_vertex.empty() || mesh.m_index.empty() || mesh.m_index.size() % 3 != 0) {
+    ERROR("MeshOptimizer", "optimize", "Mesh is empty or not a triangle list");
+    return false;
+  }
+  for (unsigned int index : mesh.m_index) {
+    if (index >= mesh.m_vertex.size()) {
+      ERROR("MeshOptimizer", "optimize", "Index out of range");
+      return false;
+    }
+  }
+
+  // Los LODs son listas aparte sobre los mismos vrtices; reordenarlos junto al nivel 0
+  // los mezclara, as que se descartan y deben regenerarse despus. Los meshlets
+  // apuntan a rangos de m_index que dejan de existir.
+  mesh.clearLods();
+  mesh.m_meshlets.clear();
+
+  const auto start = std::chrono::high_resolution_clock::now();
+  const CacheStats before = analyzeVertexCache(mesh.m_index, mesh.m_vertex.size());
+  const bool reorderOverdraw = overdrawThreshold > 0.0f;
+  OverdrawStats overdrawBefore;
+  if (reorderOverdraw) overdrawBefore = analyzeOverdraw(mesh.m_index, mesh.m_vertex);
+
+  optimizeVertexCache(mesh.m_index, mesh.m_vertex.size());
+  if (reorderOverdraw) optimizeOverdraw(mesh.m_index, mesh.m_vertex, overdrawThreshold);
+  optimizeVertexFetch(mesh.m_vertex, mesh.m_index);
+  mesh.m_numVertex = (int)mesh.m_vertex.size();
+  mesh.m_numIndex = (int)mesh.m_index.size();
+  mesh.selectIndexFormat();
+
+  const double seconds = std::chrono::duration<double>(
+    std::chrono::high_resolution_clock::now() - start).count();
+  const CacheStats after = analyzeVertexCache(mesh.m_index, mesh.m_vertex.size());
+
+  std::wostringstream wss;
+  std::wstring wname(mesh.m_name.begin(), mesh.m_name.end());
+  wss << wname << L" [V:" << mesh.m_numVertex << L" T:" << mesh.m_numIndex / 3 << L"]"
+      << L" ACMR " << before.acmr << L" -> " << after.acmr
+      << L", ATVR " << before.atvr << L" -> " << after.atvr
+      << L" (FIFO " << kReportCacheSize << L")";
+  if (reorderOverdraw) {
+    const OverdrawStats overdrawAfter = analyzeOverdraw(mesh.m_index, mesh.m_vertex);
+    wss << L", overdraw " << overdrawBefore.overdraw << L" -> " << overdrawAfter.overdraw;
+  }
+  wss << L" " << (seconds * 1000.0) << L" ms";
+  MESSAGE(L"MeshOptimizer", L"optimize", wss.str().c_str());
+  return true;
+}
+
+void
+MeshOptimizer::optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount) {
+  const size_t triangleCount = indices.size() / 3;
+  if (triangleCount == 0) return;
+
+  static const ScoreTables tables;
+
+  // Adyacencia vrtice -> tringulos en un solo arreglo (CSR). Los tringulos ya
+  // emitidos se sacan de la lista de cada vrtice, as que solo se recorren los vivos.
+  std::vector<unsigned int> liveTriangles(vertexCount, 0);
+  for (unsigned int index : indices) ++liveTriangles[index];
+
+  std::vector<unsigned int> adjacencyOffset(vertexCount + 1, 0);
+  for (size_t v = 0; v < vertexCount; ++v) {
+    adjacencyOffset[v + 1] = adjacencyOffset[v] + liveTriangles[v];
+  }
+  std::vector<unsigned int> adjacency(indices.size());
+  {
+    std::vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+    for (size_t t = 0; t < triangleCount; ++t) {
+      for (int k = 0; k < 3; ++k) adjacency[fill[indices[t * 3 + k]]++] = (unsigned int)t;
+    }
+  }
+
+  std::vector<float> vertexScores(vertexCount);
+  for (size_t v = 0; v < vertexCount; ++v) {
+    vertexScores[v] = vertexScore(tables, -1, liveTriangles[v]);
+  }
+
+  std::vector<float> triangleScores(triangleCount);
+  unsigned int current = 0;
+  for (size_t t = 0; t < triangleCount; ++t) {
+    triangleScores[t] = vertexScores[indices[t * 3 + 0]] +
+                        vertexScores[indices[t * 3 + 1]] +
+                        vertexScores[indices[t * 3 + 2]];
+    if (triangleScores[t] > triangleScores[current]) current = (unsigned int)t;
+  }
+
+  std::vector<char> emitted(triangleCount, 0);
+  std::vector<unsigned int> result;
+  result.reserve(indices.size());
+
+  unsigned int cache[kScoreCacheSize + 3];
+  unsigned int cacheCount = 0;
+  size_t cursor = 0;  // Siguiente tringulo no emitido en orden original (respaldo)
+
+  for (;;) {
+    emitted[current] = 1;
+    const unsigned int a = indices[current * 3 + 0];
+    const unsigned int b = indices[current * 3 + 1];
+    const unsigned int c = indices[current * 3 + 2];
+    result.push_back(a);
+    result.push_back(b);
+    result.push_back(c);
+    if (result.size() == indices.size()) break;
+
+    // LRU: el tringulo emitido pasa al frente y el resto se corre.
+    unsigned int newCache[kScoreCacheSize + 3];
+    unsigned int newCount = 0;
+    newCache[newCount++] = a;
+    newCache[newCount++] = b;
+    newCache[newCount++] = c;
+    for (unsigned int i = 0; i < cacheCount; ++i) {
+      const unsigned int v = cache[i];
+      if (v != a && v != b && v != c) newCache[newCount++] = v;
+    }
+
+    for (unsigned int v : { a, b, c }) {
+      unsigned int* list = adjacency.data() + adjacencyOffset[v];
+      const unsigned int count = liveTriangles[v];
+      for (unsigned int i = 0; i < count; ++i) {
+        if (list[i] == current) {
+          list[i] = list[count - 1];
+          --liveTriangles[v];
+          break;
+        }
+      }
+    }
+
+    // Recalcula puntajes de los vrtices que entraron, se movieron o salieron del cach
+    // y propaga la diferencia a sus tringulos vivos.
+    for (unsigned int i = 0; i < newCount; ++i) {
+      const unsigned int v = newCache[i];
+      const float score = vertexScore(tables, i < kScoreCacheSize ? (int)i : -1, liveTriangles[v]);
+      const float delta = score - vertexScores[v];
+      vertexScores[v] = score;
+
+      const unsigned int* list = adjacency.data() + adjacencyOffset[v];
+      for (unsigned int j = 0; j < liveTriangles[v]; ++j) triangleScores[list[j]] += delta;
+    }
+
+    // El siguiente tringulo es el de mayor puntaje entre los que tocan el cach.
+    cacheCount = (std::min)(newCount, kScoreCacheSize);
+    float bestScore = -1.0f;
+    unsigned int best = ~0u;
+    for (unsigned int i = 0; i < cacheCount; ++i) {
+      const unsigned int v = newCache[i];
+      cache[i] = v;
+
+      const unsigned int* list = adjacency.data() + adjacencyOffset[v];
+      for (unsigned int j = 0; j < liveTriangles[v]; ++j) {
+        if (triangleScores[list[j]] > bestScore) {
+          bestScore = triangleScores[list[j]];
+          best = list[j];
+        }
+      }
+    }
+
+    if (best == ~0u) {
+      // Ningn tringulo comparte vrtices con el cach: se salta al siguiente pendiente.
+      while (emitted[cursor]) ++cursor;
+      best = (unsigned int)cursor;
+    }
+    current = best;
+  }
+
+  indices.swap(result);
+}
+
+void
+MeshOptimizer::optimizeOverdraw(std::vector<unsigned int>& indices,
+  const std::vector<SimpleVertex>& vertices,
+  float threshold) {
+  const size_t triangleCount = indices.size() / 3;
+  if (triangleCount == 0) return;
+
+  // Misma simulacin FIFO que analyzeVertexCache(); sumar cacheSize + 1 al reloj
+  // vaca el cach sin recorrerlo.
+  const unsigned int cacheSize = kReportCacheSize;
+  std::vector<unsigned int> timestamps(vertices.size(), 0);
+  unsigned int timestamp = cacheSize + 1;
+  auto triangleMisses = [&](size_t t) {
+    unsigned int misses = 0;
+    for (int k = 0; k < 3; ++k) {
+      const unsigned int index = indices[t * 3 + k];
+      if (timestamp - timestamps[index] > cacheSize) {
+        timestamps[index] = timestamp++;
+        ++misses;
+      }
+    }
+    return misses;
+  };
+
+  // Cortes duros: tringulos con 3 fallos, donde el orden del cach ya "reinicia"
+  // y partir ah no cuesta nada.
+  std::vector<size_t> hardBounds(1, 0);
+  triangleMisses(0);
+  for (size_t t = 1; t < triangleCount; ++t) {
+    if (triangleMisses(t) == 3) hardBounds.push_back(t);
+  }
+  hardBounds.push_back(triangleCount);
+
+  // Cortes suaves: dentro de cada tramo se cierra el cluster en cuanto su ACMR
+  // acumulado baja a threshold veces el ACMR del tramo completo.
+  std::vector<size_t> clusters;
+  for (size_t h = 0; h + 1 < hardBounds.size(); ++h) {
+    const size_t start = hardBounds[h];
+    const size_t end = hardBounds[h + 1];
+
+    timestamp += cacheSize + 1;
+    unsigned int spanMisses = 0;
+    for (size_t t = start; t < end; ++t) spanMisses += triangleMisses(t);
+    const float spanThreshold = threshold * float(spanMisses) / float(end - start);
+
+    clusters.push_back(start);
+    timestamp += cacheSize + 1;
+    unsigned int runningMisses = 0;
+    unsigned int runningTriangles = 0;
+    for (size_t t = start; t < end; ++t) {
+      runningMisses += triangleMisses(t);
+      ++runningTriangles;
+      if (t + 1 < end && float(runningMisses) <= spanThreshold * float(runningTriangles)) {
+        clusters.push_back(t + 1);
+        timestamp += cacheSize + 1;
+        runningMisses = 0;
+        runningTriangles = 0;
+      }
+    }
+  }
+  clusters.push_back(triangleCount);
+  const size_t clusterCount = clusters.size() - 1;
+
+  // Heurstica independiente de la vista: los clusters lejos del centro y que miran
+  // hacia afuera suelen tapar a los dems, as que se dibujan primero.
+  XMFLOAT3 meshCenter(0.0f, 0.0f, 0.0f);
+  for (unsigned int index : indices) {
+    meshCenter.x += vertices[index].Pos.x;
+    meshCenter.y += vertices[index].Pos.y;
+    meshCenter.z += vertices[index].Pos.z;
+  }
+  const float invCount = 1.0f / float(indices.size());
+  meshCenter.x *= invCount;
+  meshCenter.y *= invCount;
+  meshCenter.z *= invCount;
+
+  std::vector<float> sortKeys(clusterCount);
+  for (size_t c = 0; c < clusterCount; ++c) {
+    float center[3] = { 0.0f, 0.0f, 0.0f };
+    float normal[3] = { 0.0f, 0.0f, 0.0f };
+    float areaSum = 0.0f;
+    for (size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+      const XMFLOAT3& a = vertices[indices[t * 3 + 0]].Pos;
+      const XMFLOAT3& b = vertices[indices[t * 3 + 1]].Pos;
+      const XMFLOAT3& d = vertices[indices[t * 3 + 2]].Pos;
+      const float e1[3] = { b.x - a.x, b.y - a.y, b.z - a.z };
+      const float e2[3] = { d.x - a.x, d.y - a.y, d.z - a.z };
+      // Con el winding del motor (horario visto de frente) e1 x e2 apunta hacia afuera.
+      const float n[3] = { e1[1] * e2[2] - e1[2] * e2[1],
+                           e1[2] * e2[0] - e1[0] * e2[2],
+                           e1[0] * e2[1] - e1[1] * e2[0] };
+      const float area = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+      center[0] += (a.x + b.x + d.x) * area;
+      center[1] += (a.y + b.y + d.y) * area;
+      center[2] += (a.z + b.z + d.z) * area;
+      normal[0] += n[0];
+      normal[1] += n[1];
+      normal[2] += n[2];
+      areaSum += area;
+    }
+
+    const float normalLength = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+    if (areaSum <= 0.0f || normalLength <= 0.0f) {
+      sortKeys[c] = 0.0f;
+      continue;
+    }
+    const float invArea = 1.0f / (3.0f * areaSum);
+    sortKeys[c] = ((center[0] * invArea - meshCenter.x) * normal[0] +
+                   (center[1] * invArea - meshCenter.y) * normal[1] +
+                   (center[2] * invArea - meshCenter.z) * normal[2]) / normalLength;
+  }
+
+  std::vector<unsigned int> order(clusterCount);
+  for (size_t c = 0; c < clusterCount; ++c) order[c] = (unsigned int)c;
+  std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) {
+    return sortKeys[a] > sortKeys[b];
+  });
+
+  std::vector<unsigned int> result;
+  result.reserve(indices.size());
+  for (unsigned int c : order) {
+    result.insert(result.end(),
+      indices.begin() + clusters[c] * 3,
+      indices.begin() + clusters[c + 1] * 3);
+  }
+  indices.swap(result);
+}
+
+size_t
+MeshOptimizer::optimizeVertexFetch(std::vector<SimpleVertex>& vertices,
+  std::vector<unsigned int>& indices) {
+  const unsigned int kUnused = ~0u;
+  std::vector<unsigned int> remap(vertices.size(), kUnused);
+  std::vector<SimpleVertex> reordered;
+  reordered.reserve(vertices.size());
+
+  for (unsigned int& index : indices) {
+    if (remap[index] == kUnused) {
+      remap[index] = (unsigned int)reordered.size();
+      reordered.push_back(vertices[index]);
+    }
+    index = remap[index];
+  }
+
+  vertices.swap(reordered);
+  return vertices.size();
+}
+
+MeshOptimizer::CacheStats
+MeshOptimizer::analyzeVertexCache(const std::vector<unsigned int>& indices,
+  size_t vertexCount,
+  unsigned int cacheSize) {
+  CacheStats stats;
+  if (indices.size() < 3 || cacheSize == 0) return stats;
+
+  // FIFO con marcas de tiempo: un vrtice est en cach si entr hace menos de
+  // cacheSize inserciones. Evita mantener la cola explcita.
+  std::vector<unsigned int> timestamps(vertexCount, 0);
+  std::vector<char> referenced(vertexCount, 0);
+  unsigned int timestamp = cacheSize + 1;
+  unsigned int unique = 0;
+
+  for (unsigned int index : indices) {
+    if (index >= vertexCount) continue;
+    if (timestamp - timestamps[index] > cacheSize) {
+      timestamps[index] = timestamp++;
+      ++stats.transformed;
+    }
+    if (!referenced[index]) {
+      referenced[index] = 1;
+      ++unique;
+    }
+  }
+
+  stats.acmr = float(stats.transformed) / float(indices.size() / 3);
+  stats.atvr = unique ? float(stats.transformed) / float(unique) : 0.0f;
+  return stats;
+}
+
+MeshOptimizer::OverdrawStats
+MeshOptimizer::analyzeOverdraw(const std::vector<unsigned int>& indices,
+  const std::vector<SimpleVertex>& vertices) {
+  OverdrawStats stats;
+  if (indices.size() < 3 || vertices.empty()) return stats;
+
+  // Normaliza la malla al cubo [0, 1] conservando proporciones.
+  XMFLOAT3 minBound = vertices[0].Pos;
+  XMFLOAT3 maxBound = vertices[0].Pos;
+  for (const SimpleVertex& v : vertices) {
+    minBound.x = (std::min)(minBound.x, v.Pos.x);
+    minBound.y = (std::min)(minBound.y, v.Pos.y);
+    minBound.z = (std::min)(minBound.z, v.Pos.z);
+    maxBound.x = (std::max)(maxBound.x, v.Pos.x);
+    maxBound.y = (std::max)(maxBound.y, v.Pos.y);
+    maxBound.z = (std::max)(maxBound.z, v.Pos.z);
+  }
+  const float extent = (std::max)({ maxBound.x - minBound.x,
+                                    maxBound.y - minBound.y,
+                                    maxBound.z - minBound.z });
+  const float scale = extent > 0.0f ? 1.0f / extent : 0.0f;
+
+  const unsigned int resolution = kOverdrawResolution;
+  std::vector<float> depth((size_t)resolution * resolution);
+
+  for (const OverdrawView& view : kOverdrawViews) {
+    std::fill(depth.begin(), depth.end(), (std::numeric_limits<float>::max)());
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+      float screen[3][3];
+      for (int k = 0; k < 3; ++k) {
+        const XMFLOAT3& p = vertices[indices[i + k]].Pos;
+        const XMFLOAT3 n((p.x - minBound.x) * scale, (p.y - minBound.y) * scale, (p.z - minBound.z) * scale);
+        for (int c = 0; c < 3; ++c) {
+          const float value = axisValue(n, view.axis[c]);
+          screen[c][k] = view.flip[c] ? 1.0f - value : value;
+        }
+        screen[0][k] *= resolution;
+        screen[1][k] *= resolution;
+      }
+      rasterizeTriangle(screen[0], screen[1], screen[2], resolution, depth, stats.shaded);
+    }
+
+    for (float d : depth) {
+      if (d != (std::numeric_limits<float>::max)()) ++stats.covered;
+    }
+  }
+
+  stats.overdraw = stats.covered ? float(stats.shaded) / float(stats.covered) : 0.0f;
+  return stats;
+}
@@ -0,0 +1,482 @@
+#include "MeshSimplifier.h"
+#include "MeshComponent.h"
+#include "MeshOptimizer.h"
+#include "ModelLoader.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+  /// Cudrica simtrica 4x4 (10 trminos) ms el rea acumulada que la pondera.
+  struct Quadric {
+    double a2, ab, ac, ad;
+    double b2, bc, bd;
+    double c2, cd;
+    double d2;
+    double weight;
+  };
+
+  void addPlane(Quadric& q, double a, double b, double c, double d, double w) {
+    q.a2 += w * a * a; q.ab += w * a * b; q.ac += w * a * c; q.ad += w * a * d;
+    q.b2 += w * b * b; q.bc += w * b * c; q.bd += w * b * d;
+    q.c2 += w * c * c; q.cd += w * c * d;
+    q.d2 += w * d * d;
+    q.weight += w;
+  }
+
+  void addQuadric(Quadric& q, const Quadric& other) {
+    q.a2 += other.a2; q.ab += other.ab; q.ac += other.ac; q.ad += other.ad;
+    q.b2 += other.b2; q.bc += other.bc; q.bd += other.bd;
+    q.c2 += other.c2; q.cd += other.cd;
+    q.d2 += other.d2;
+    q.weight += other.weight;
+  }
+
+  /// Distancia cuadrtica media de @p p a los planos acumulados en @p q.
+  double evaluate(const Quadric& q, const XMFLOAT3& p) {
+    const double x = p.x, y = p.y, z = p.z;
+    const double r = q.a2 * x * x + q.b2 * y * y + q.c2 * z * z +
+                     2.0 * (q.ab * x * y + q.ac * x * z + q.bc * y * z) +
+                     2.0 * (q.ad * x + q.bd * y + q.cd * z) + q.d2;
+    return q.weight > 0.0 ? fabs(r) / q.weight : 0.0;
+  }
+
+  struct Collapse {
+    unsigned int from;
+    unsigned int to;
+    double cost;
+  };
+
+  inline XMFLOAT3 sub(const XMFLOAT3& a, const XMFLOAT3& b) {
+    return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z);
+  }
+
+  inline XMFLOAT3 cross(const XMFLOAT3& a, const XMFLOAT3& b) {
+    return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+  }
+
+  inline float dot(const XMFLOAT3& a, const XMFLOAT3& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+  }
+
+  inline XMFLOAT3 triangleNormal(const XMFLOAT3& a, const XMFLOAT3& b, const XMFLOAT3& c) {
+    return cross(sub(b, a), sub(c, a));
+  }
+
+  /// Extensin (lado mayor del AABB) y esquina mnima de la malla.
+  float meshExtent(const std::vector<SimpleVertex>& vertices, XMFLOAT3& outMin) {
+    outMin = vertices[0].Pos;
+    XMFLOAT3 maxBound = vertices[0].Pos;
+    for (const SimpleVertex& v : vertices) {
+      outMin.x = (std::min)(outMin.x, v.Pos.x);
+      outMin.y = (std::min)(outMin.y, v.Pos.y);
+      outMin.z = (std::min)(outMin.z, v.Pos.z);
+      maxBound.x = (std::max)(maxBound.x, v.Pos.x);
+      maxBound.y = (std::max)(maxBound.y, v.Pos.y);
+      maxBound.z = (std::max)(maxBound.z, v.Pos.z);
+    }
+    return (std::max)({ maxBound.x - outMin.x, maxBound.y - outMin.y, maxBound.z - outMin.z });
+  }
+
+  /// Distancia de @p p al tringulo (a, b, c) (punto ms cercano de Ericson).
+  float pointTriangleDistance(const XMFLOAT3& p, const XMFLOAT3& a, const XMFLOAT3& b, const XMFLOAT3& c) {
+    const XMFLOAT3 ab = sub(b, a), ac = sub(c, a), ap = sub(p, a);
+    const float d1 = dot(ab, ap), d2 = dot(ac, ap);
+    XMFLOAT3 closest;
+    if (d1 <= 0.0f && d2 <= 0.0f) {
+      closest = a;
+    }
+    else {
+      const XMFLOAT3 bp = sub(p, b);
+      const float d3 = dot(ab, bp), d4 = dot(ac, bp);
+      const XMFLOAT3 cp = sub(p, c);
+      const float d5 = dot(ab, cp), d6 = dot(ac, cp);
+      const float vc = d1 * d4 - d3 * d2;
+      const float vb = d5 * d2 - d1 * d6;
+      const float va = d3 * d6 - d5 * d4;
+      if (d3 >= 0.0f && d4 <= d3) {
+        closest = b;
+      }
+      else if (d6 >= 0.0f && d5 <= d6) {
+        closest = c;
+      }
+      else if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+        const float v = d1 / (d1 - d3);
+        closest = XMFLOAT3(a.x + ab.x * v, a.y + ab.y * v, a.z + ab.z * v);
+      }
+      else if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+        const float w = d2 / (d2 - d6);
+        closest = XMFLOAT3(a.x + ac.x * w, a.y + ac.y * w, a.z + ac.z * w);
+      }
+      else if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+        const float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        closest = XMFLOAT3(b.x + (c.x - b.x) * w, b.y + (c.y - b.y) * w, b.z + (c.z - b.z) * w);
+      }
+      else {
+        const float denom = 1.0f / (va + vb + vc);
+        const float v = vb * denom, w = vc * denom;
+        closest = XMFLOAT3(a.x + ab.x * v + ac.x * w, a.y + ab.y * v + ac.y * w, a.z + ab.z * v + ac.z * w);
+      }
+    }
+    const XMFLOAT3 d = sub(p, closest);
+    return sqrtf(dot(d, d));
+  }
+}
+
+bool
+MeshSimplifier::simplify(const std::vector<SimpleVertex>& vertices,
+  const std::vector<unsigned int>& indices,
+  size_t targetIndexCount,
+  float targetError,
+  std::vector<unsigned int>& outIndices,
+  float* outError) {
+  if (vertices.empty() || indices.size() % 3 != 0) {
+    ERROR("MeshSimplifier", "simplify", "Mesh is empty or not a triangle list");
+    return false;
+  }
+  const size_t vertexCount = vertices.size();
+  for (unsigned int index : indices) {
+    if (index >= vertexCount) {
+      ERROR("MeshSimplifier", "simplify", "Index out of range");
+      return false;
+    }
+  }
+
+  // Posiciones normalizadas a la extensin de la malla: el error queda relativo a su tamao.
+  XMFLOAT3 minBound;
+  const float extent = meshExtent(vertices, minBound);
+  const float invExtent = extent > 0.0f ? 1.0f / extent : 0.0f;
+  std::vector<XMFLOAT3> positions(vertexCount);
+  for (size_t v = 0; v < vertexCount; ++v) {
+    positions[v] = XMFLOAT3((vertices[v].Pos.x - minBound.x) * invExtent,
+                            (vertices[v].Pos.y - minBound.y) * invExtent,
+                            (vertices[v].Pos.z - minBound.z) * invExtent);
+  }
+
+  std::vector<unsigned int> current;
+  current.reserve(indices.size());
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    const unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+    if (a == b || b == c || a == c) continue;
+    current.push_back(a);
+    current.push_back(b);
+    current.push_back(c);
+  }
+
+  // Identificador por posicin exacta: las esquinas de una costura de UV lo comparten.
+  std::vector<unsigned int> order(vertexCount);
+  for (size_t v = 0; v < vertexCount; ++v) order[v] = (unsigned int)v;
+  std::sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) {
+    const XMFLOAT3& pa = vertices[a].Pos;
+    const XMFLOAT3& pb = vertices[b].Pos;
+    if (pa.x != pb.x) return pa.x < pb.x;
+    if (pa.y != pb.y) return pa.y < pb.y;
+    if (pa.z != pb.z) return pa.z < pb.z;
+    return a < b;
+  });
+  std::vector<unsigned int> positionId(vertexCount);
+  unsigned int positionCount = 0;
+  for (size_t i = 0; i < vertexCount; ++i) {
+    if (i > 0) {
+      const XMFLOAT3& pa = vertices[order[i - 1]].Pos;
+      const XMFLOAT3& pb = vertices[order[i]].Pos;
+      if (pa.x != pb.x || pa.y != pb.y || pa.z != pb.z) ++positionCount;
+    }
+    positionId[order[i]] = positionCount;
+  }
+  ++positionCount;
+
+  // Vrtices bloqueados: costuras (varias esquinas referenciadas en la misma posicin),
+  // bordes abiertos y aristas no manifold.
+  std::vector<char> locked(vertexCount, 0);
+  {
+    std::vector<char> referenced(vertexCount, 0);
+    for (unsigned int index : current) referenced[index] = 1;
+    std::vector<unsigned int> wedges(positionCount, 0);
+    for (size_t v = 0; v < vertexCount; ++v) {
+      if (referenced[v]) ++wedges[positionId[v]];
+    }
+    for (size_t v = 0; v < vertexCount; ++v) {
+      if (wedges[positionId[v]] > 1) locked[v] = 1;
+    }
+
+    std::vector<unsigned long long> edges;
+    edges.reserve(current.size());
+    for (size_t i = 0; i < current.size(); i += 3) {
+      for (int k = 0; k < 3; ++k) {
+        const unsigned long long a = positionId[current[i + k]];
+        const unsigned long long b = positionId[current[i + (k + 1) % 3]];
+        edges.push_back((a << 32) | b);
+      }
+    }
+    std::sort(edges.begin(), edges.end());
+    for (size_t i = 0; i < current.size(); i += 3) {
+      for (int k = 0; k < 3; ++k) {
+        const unsigned int va = current[i + k];
+        const unsigned int vb = current[i + (k + 1) % 3];
+        const unsigned long long a = positionId[va];
+        const unsigned long long b = positionId[vb];
+        const auto same = std::equal_range(edges.begin(), edges.end(), (a << 32) | b);
+        const bool border = !std::binary_search(edges.begin(), edges.end(), (b << 32) | a);
+        if (border || same.second - same.first > 1) {
+          locked[va] = 1;
+          locked[vb] = 1;
+        }
+      }
+    }
+  }
+
+  std::vector<Quadric> quadrics(vertexCount, Quadric());
+  for (size_t i = 0; i < current.size(); i += 3) {
+    const XMFLOAT3& p0 = positions[current[i]];
+    const XMFLOAT3 n = triangleNormal(p0, positions[current[i + 1]], positions[current[i + 2]]);
+    const double length = sqrt(double(n.x) * n.x + double(n.y) * n.y + double(n.z) * n.z);
+    if (length <= 0.0) continue;
+    const double a = n.x / length, b = n.y / length, c = n.z / length;
+    const double d = -(a * p0.x + b * p0.y + c * p0.z);
+    for (int k = 0; k < 3; ++k) addPlane(quadrics[current[i + k]], a, b, c, d, length * 0.5);
+  }
+
+  const size_t targetTriangles = targetIndexCount / 3;
+  const double errorLimit = double(targetError) * double(targetError);
+  double maxCost = 0.0;
+
+  std::vector<unsigned int> remap(vertexCount);
+  std::vector<char> touched(vertexCount);
+  std::vector<unsigned int> adjacencyOffset(vertexCount + 1);
+  std::vector<unsigned int> adjacency;
+  std::vector<Collapse> collapses;
+
+  // Cada pasada aplica los colapsos ms baratos que no se pisen entre s (el 1-anillo
+  // del vrtice que se mueve queda fijo hasta la siguiente pasada).
+  while (current.size() / 3 > targetTriangles) {
+    const size_t triangleCount = current.size() / 3;
+
+    std::fill(adjacencyOffset.begin(), adjacencyOffset.end(), 0);
+    for (unsigned int index : current) ++adjacencyOffset[index + 1];
+    for (size_t v = 0; v < vertexCount; ++v) adjacencyOffset[v + 1] += adjacencyOffset[v];
+    adjacency.resize(current.size());
+    {
+      std::vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+      for (size_t t = 0; t < triangleCount; ++t) {
+        for (int k = 0; k < 3; ++k) adjacency[fill[current[t * 3 + k]]++] = (unsigned int)t;
+      }
+    }
+
+    collapses.clear();
+    for (size_t i = 0; i < current.size(); i += 3) {
+      for (int k = 0; k < 3; ++k) {
+        const unsigned int a = current[i + k];
+        const unsigned int b = current[i + (k + 1) % 3];
+        if (!locked[a]) collapses.push_back({ a, b, evaluate(quadrics[a], positions[b]) });
+        if (!locked[b]) collapses.push_back({ b, a, evaluate(quadrics[b], positions[a]) });
+      }
+    }
+    if (collapses.empty()) break;
+    std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) {
+      if (x.cost != y.cost) return x.cost < y.cost;
+      if (x.from != y.from) return x.from < y.from;
+      return x.to < y.to;
+    });
+
+    for (size_t v = 0; v < vertexCount; ++v) remap[v] = (unsigned int)v;
+    std::fill(touched.begin(), touched.end(), 0);
+    size_t removed = 0;
+    size_t applied = 0;
+
+    for (const Collapse& collapse : collapses) {
+      if (collapse.cost > errorLimit) break;
+      if (touched[collapse.from] || remap[collapse.to] != collapse.to) continue;
+
+      // Rechaza colapsos que volteen o degeneren algn tringulo que sobrevive.
+      bool valid = true;
+      unsigned int shared = 0;
+      const unsigned int* list = adjacency.data() + adjacencyOffset[collapse.from];
+      const unsigned int count = adjacencyOffset[collapse.from + 1] - adjacencyOffset[collapse.from];
+      for (unsigned int j = 0; j < count && valid; ++j) {
+        const unsigned int* tri = current.data() + list[j] * 3;
+        if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to) {
+          ++shared;
+          continue;
+        }
+        XMFLOAT3 p[3] = { positions[tri[0]], positions[tri[1]], positions[tri[2]] };
+        const XMFLOAT3 before = triangleNormal(p[0], p[1], p[2]);
+        for (int k = 0; k < 3; ++k) {
+          if (tri[k] == collapse.from) p[k] = positions[collapse.to];
+        }
+        const XMFLOAT3 after = triangleNormal(p[0], p[1], p[2]);
+        const float lengths = sqrtf(dot(before, before) * dot(after, after));
+        valid = lengths > 0.0f && dot(before, after) > 1e-2f * lengths;
+      }
+      if (!valid) continue;
+
+      remap[collapse.from] = collapse.to;
+      addQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+      maxCost = (std::max)(maxCost, collapse.cost);
+      for (unsigned int j = 0; j < count; ++j) {
+        const unsigned int* tri = current.data() + list[j] * 3;
+        touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = 1;
+      }
+      removed += shared;
+      ++applied;
+      if (triangleCount - removed <= targetTriangles) break;
+    }
+    if (applied == 0) break;
+
+    size_t write = 0;
+    for (size_t i = 0; i < current.size(); i += 3) {
+      const unsigned int a = remap[current[i]];
+      const unsigned int b = remap[current[i + 1]];
+      const unsigned int c = remap[current[i + 2]];
+      if (a == b || b == c || a == c) continue;
+      current[write++] = a;
+      current[write++] = b;
+      current[write++] = c;
+    }
+    current.resize(write);
+  }
+
+  outIndices.swap(current);
+  if (outError) *outError = (float)sqrt(maxCost);
+  return true;
+}
+
+bool
+MeshSimplifier::buildLods(MeshComponent& mesh, unsigned int levels, float ratio, float maxError) {
+  if (mesh.m_vertex.empty() || mesh.m_index.empty()) {
+    ERROR("MeshSimplifier", "buildLods", "Mesh is empty");
+    return false;
+  }
+  if (levels < 1 || ratio <= 0.0f || ratio >= 1.0f) {
+    ERROR("MeshSimplifier", "buildLods", "levels must be >= 1 and ratio in (0, 1)");
+    return false;
+  }
+
+  mesh.clearLods();
+  XMFLOAT3 minBound;
+  const float extent = meshExtent(mesh.m_vertex, minBound);
+
+  MeshLod base = { 0, (unsigned int)mesh.m_index.size(), 0.0f };
+  mesh.m_lods.push_back(base);
+
+  std::vector<unsigned int> previous(mesh.m_index);
+  float accumulatedError = 0.0f;
+  for (unsigned int level = 1; level < levels; ++level) {
+    const size_t target = (size_t)(previous.size() / 3 * ratio) * 3;
+    std::vector<unsigned int> simplified;
+    float error = 0.0f;
+    if (!simplify(mesh.m_vertex, previous, target, maxError, simplified, &error)) return false;
+    if (simplified.empty() || simplified.size() >= previous.size()) break;
+
+    MeshOptimizer::optimizeVertexCache(simplified, mesh.m_vertex.size());
+
+    // Cada nivel se simplifica desde el anterior: el error respecto al nivel 0 se acumula.
+    accumulatedError += error;
+    MeshLod lod = { (unsigned int)mesh.m_index.size(), (unsigned int)simplified.size(), accumulatedError * extent };
+    mesh.m_lods.push_back(lod);
+    mesh.m_index.insert(mesh.m_index.end(), simplified.begin(), simplified.end());
+    previous.swap(simplified);
+  }
+
+  mesh.selectIndexFormat();
+
+  std::wostringstream wss;
+  std::wstring wname(mesh.m_name.begin(), mesh.m_name.end());
+  wss << wname << L" " << mesh.m_lods.size() << L" LODs:";
+  for (const MeshLod& lod : mesh.m_lods) {
+    wss << L" [T:" << lod.indexCount / 3 << L" err " << lod.error << L"]";
+  }
+  MESSAGE(L"MeshSimplifier", L"buildLods", wss.str().c_str());
+  return true;
+}
+
+unsigned int
+MeshSimplifier::selectLod(const MeshComponent& mesh,
+  float viewDepth,
+  const XMMATRIX& projection,
+  float viewportHeight,
+  float maxPixelError) {
+  if (mesh.m_lods.size() < 2 || viewDepth <= 0.0f) return 0;
+
+  // Con proyeccin en perspectiva un error e a profundidad z ocupa e * _22 / z en NDC,
+  // y la mitad del alto del viewport corresponde a 1 en NDC.
+  XMFLOAT4X4 matrix;
+  XMStoreFloat4x4(&matrix, projection);
+  const float pixelsPerUnit = matrix._22 * 0.5f * viewportHeight / viewDepth;
+
+  unsigned int selected = 0;
+  for (unsigned int i = 1; i < mesh.m_lods.size(); ++i) {
+    if (mesh.m_lods[i].error * pixelsPerUnit > maxPixelError) break;
+    selected = i;
+  }
+  return selected;
+}
+
+bool
+MeshSimplifier::benchmark(const std::string& filename, unsigned int levels, float ratio) {
+  MeshComponent source;
+  ModelLoader::Options opts;
+  if (!ModelLoader::loadFromFile(filename, source, opts)) return false;
+
+  MeshComponent first = source;
+  const auto start = std::chrono::high_resolution_clock::now();
+  if (!buildLods(first, levels, ratio)) return false;
+  const double seconds = std::chrono::duration<double>(
+    std::chrono::high_resolution_clock::now() - start).count();
+
+  MeshComponent second = source;
+  if (!buildLods(second, levels, ratio)) return false;
+  bool deterministic = first.m_index == second.m_index && first.m_lods.size() == second.m_lods.size();
+  for (size_t i = 0; deterministic && i < first.m_lods.size(); ++i) {
+    deterministic = first.m_lods[i].indexOffset == second.m_lods[i].indexOffset &&
+                    first.m_lods[i].indexCount == second.m_lods[i].indexCount &&
+                    first.m_lods[i].error == second.m_lods[i].error;
+  }
+
+  XMFLOAT3 minBound;
+  const float extent = (std::max)(meshExtent(source.m_vertex, minBound), 1e-6f);
+
+  // Error medido: distancia de vrtices originales (muestreados) a la superficie del LOD.
+  const size_t kMaxSamples = 256;
+  std::vector<unsigned int> samples;
+  const size_t stride = (std::max)((size_t)1, source.m_index.size() / kMaxSamples);
+  for (size_t i = 0; i < source.m_index.size(); i += stride) samples.push_back(source.m_index[i]);
+
+  std::wstring wfn(filename.begin(), filename.end());
+  {
+    std::wostringstream wss;
+    wss << wfn << L" " << first.m_lods.size() << L" LODs in " << (seconds * 1000.0) << L" ms";
+    MESSAGE(L"MeshSimplifier", L"benchmark", wss.str().c_str());
+  }
+  for (size_t l = 0; l < first.m_lods.size(); ++l) {
+    const MeshLod& lod = first.m_lods[l];
+    float maxDistance = 0.0f;
+    double sumDistance = 0.0;
+    for (unsigned int s : samples) {
+      const XMFLOAT3& p = first.m_vertex[s].Pos;
+      float best = 3.4e38f;
+      for (unsigned int i = lod.indexOffset; i < lod.indexOffset + lod.indexCount; i += 3) {
+        best = (std::min)(best, pointTriangleDistance(p,
+          first.m_vertex[first.m_index[i]].Pos,
+          first.m_vertex[first.m_index[i + 1]].Pos,
+          first.m_vertex[first.m_index[i + 2]].Pos));
+      }
+      maxDistance = (std::max)(maxDistance, best);
+      sumDistance += best;
+    }
+
+    std::wostringstream wss;
+    wss << L"  LOD " << l << L": T " << lod.indexCount / 3
+        << L" (" << (100.0 * lod.indexCount / first.m_lods[0].indexCount) << L"%)"
+        << L", estimated " << lod.error << L" (" << (100.0f * lod.error / extent) << L"%)"
+        << L", measured max " << maxDistance << L" (" << (100.0f * maxDistance / extent) << L"%)"
+        << L" avg " << (samples.empty() ? 0.0 : sumDistance / samples.size());
+    MESSAGE(L"MeshSimplifier", L"benchmark", wss.str().c_str());
+  }
+
+  if (!deterministic) {
+    ERROR(L"MeshSimplifier", L"benchmark", (L"Dos corridas generaron LODs distintos: " + wfn).c_str());
+    return false;
+  }
+  return true;
+}
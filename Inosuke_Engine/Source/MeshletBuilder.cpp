@@ -0,0 +1,395 @@
+#include "MeshletBuilder.h"
+#include "MeshComponent.h"
+#include "MeshOptimizer.h"
+#include "ModelLoader.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+
+namespace {
+  // Por debajo de este coseno mnimo el cono es tan ancho que casi nunca descarta nada.
+  const float kMinConeDot = 0.1f;
+
+  inline float distanceSq(const XMFLOAT3& a, const XMFLOAT3& b) {
+    const float dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+    return dx * dx + dy * dy + dz * dz;
+  }
+}
+
+bool
+MeshletBuilder::build(MeshComponent& mesh, unsigned int maxVertices, unsigned int maxTriangles) {
+  if (mesh.m_vertex.empty() || mesh.m_index.empty() || mesh.m_index.size() % 3 != 0) {
+    ERROR("MeshletBuilder", "build", "Mesh is empty or not a triangle list");
+    return false;
+  }
+  if (maxVertices < 3 || maxTriangles < 1) {
+    ERROR("MeshletBuilder", "build", "maxVertices must be >= 3 and maxTriangles >= 1");
+    return false;
+  }
+  const size_t vertexCount = mesh.m_vertex.size();
+  for (unsigned int index : mesh.m_index) {
+    if (index >= vertexCount) {
+      ERROR("MeshletBuilder", "build", "Index out of range");
+      return false;
+    }
+  }
+
+  // Con LODs solo se parte el nivel 0; los dems niveles quedan detrs, intactos.
+  const size_t lodIndexCount = mesh.m_lods.empty() ? mesh.m_index.size() : mesh.m_lods[0].indexCount;
+  const std::vector<unsigned int> indices(mesh.m_index.begin(), mesh.m_index.begin() + lodIndexCount);
+  const size_t triangleCount = indices.size() / 3;
+
+  // Adyacencia vrtice -> tringulos vivos (CSR), igual que en MeshOptimizer.
+  std::vector<unsigned int> liveTriangles(vertexCount, 0);
+  for (unsigned int index : indices) ++liveTriangles[index];
+  std::vector<unsigned int> adjacencyOffset(vertexCount + 1, 0);
+  for (size_t v = 0; v < vertexCount; ++v) {
+    adjacencyOffset[v + 1] = adjacencyOffset[v] + liveTriangles[v];
+  }
+  std::vector<unsigned int> adjacency(indices.size());
+  {
+    std::vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+    for (size_t t = 0; t < triangleCount; ++t) {
+      for (int k = 0; k < 3; ++k) adjacency[fill[indices[t * 3 + k]]++] = (unsigned int)t;
+    }
+  }
+
+  std::vector<XMFLOAT3> centroids(triangleCount);
+  for (size_t t = 0; t < triangleCount; ++t) {
+    const XMFLOAT3& a = mesh.m_vertex[indices[t * 3 + 0]].Pos;
+    const XMFLOAT3& b = mesh.m_vertex[indices[t * 3 + 1]].Pos;
+    const XMFLOAT3& c = mesh.m_vertex[indices[t * 3 + 2]].Pos;
+    centroids[t] = XMFLOAT3((a.x + b.x + c.x) / 3.0f, (a.y + b.y + c.y) / 3.0f, (a.z + b.z + c.z) / 3.0f);
+  }
+
+  std::vector<char> emitted(triangleCount, 0);
+  // Id del ltimo meshlet que incluy cada vrtice; evita limpiar marcas entre clusters.
+  std::vector<unsigned int> vertexOwner(vertexCount, ~0u);
+  // ndice del vrtice dentro de meshletVertices (vlido si vertexOwner es el meshlet actual).
+  std::vector<unsigned int> vertexLocal(vertexCount, 0);
+  std::vector<unsigned int> localIndices;
+  std::vector<unsigned int> result;
+  result.reserve(indices.size());
+  std::vector<Meshlet> meshlets;
+  std::vector<unsigned int> meshletVertices;
+  meshletVertices.reserve(maxVertices);
+
+  unsigned int meshletId = 0;
+  Meshlet current = {};
+  XMFLOAT3 centroidSum(0.0f, 0.0f, 0.0f);
+  size_t cursor = 0;
+  unsigned int next = 0;
+
+  auto newVertexCount = [&](unsigned int t) {
+    const unsigned int a = indices[t * 3 + 0];
+    const unsigned int b = indices[t * 3 + 1];
+    const unsigned int c = indices[t * 3 + 2];
+    return (unsigned int)(vertexOwner[a] != meshletId) +
+           (unsigned int)(vertexOwner[b] != meshletId && b != a) +
+           (unsigned int)(vertexOwner[c] != meshletId && c != a && c != b);
+  };
+
+  auto closeMeshlet = [&]() {
+    // El crecimiento ordena los tringulos por cercana, no por reuso: se vuelven a
+    // ordenar para el cach post-transform dentro del cluster, con ndices locales
+    // para que el costo sea del tamao del cluster y no de la malla.
+    const size_t clusterIndexCount = (size_t)current.triangleCount * 3;
+    unsigned int* cluster = result.data() + current.indexOffset;
+    localIndices.resize(clusterIndexCount);
+    for (size_t i = 0; i < clusterIndexCount; ++i) localIndices[i] = vertexLocal[cluster[i]];
+    MeshOptimizer::optimizeVertexCache(localIndices, meshletVertices.size());
+    for (size_t i = 0; i < clusterIndexCount; ++i) cluster[i] = meshletVertices[localIndices[i]];
+
+    current.vertexCount = (unsigned int)meshletVertices.size();
+    computeBounds(mesh.m_vertex, result.data() + current.indexOffset, meshletVertices, current);
+    meshlets.push_back(current);
+  };
+
+  for (;;) {
+    // Agrega el tringulo elegido al meshlet actual.
+    for (int k = 0; k < 3; ++k) {
+      const unsigned int v = indices[next * 3 + k];
+      if (vertexOwner[v] != meshletId) {
+        vertexOwner[v] = meshletId;
+        vertexLocal[v] = (unsigned int)meshletVertices.size();
+        meshletVertices.push_back(v);
+      }
+      result.push_back(v);
+
+      unsigned int* list = adjacency.data() + adjacencyOffset[v];
+      const unsigned int count = liveTriangles[v];
+      for (unsigned int i = 0; i < count; ++i) {
+        if (list[i] == next) {
+          list[i] = list[count - 1];
+          --liveTriangles[v];
+          break;
+        }
+      }
+    }
+    emitted[next] = 1;
+    ++current.triangleCount;
+    centroidSum.x += centroids[next].x;
+    centroidSum.y += centroids[next].y;
+    centroidSum.z += centroids[next].z;
+    if (result.size() == indices.size()) break;
+
+    // Candidato: vecino que agregue menos vrtices nuevos y, a igualdad, el ms cercano.
+    unsigned int best = ~0u;
+    unsigned int bestExtra = 4;
+    float bestDistance = 0.0f;
+    if (current.triangleCount < maxTriangles) {
+      const float inv = 1.0f / float(current.triangleCount);
+      const XMFLOAT3 center(centroidSum.x * inv, centroidSum.y * inv, centroidSum.z * inv);
+      for (unsigned int v : meshletVertices) {
+        const unsigned int* list = adjacency.data() + adjacencyOffset[v];
+        for (unsigned int i = 0; i < liveTriangles[v]; ++i) {
+          const unsigned int t = list[i];
+          const unsigned int extra = newVertexCount(t);
+          if (meshletVertices.size() + extra > maxVertices || extra > bestExtra) continue;
+          const float distance = distanceSq(centroids[t], center);
+          if (extra < bestExtra || distance < bestDistance) {
+            best = t;
+            bestExtra = extra;
+            bestDistance = distance;
+          }
+        }
+      }
+    }
+
+    if (best == ~0u) {
+      // El meshlet est lleno o aislado: se cierra y el siguiente arranca junto a l
+      // (si quedan vecinos) para que los clusters consecutivos sigan siendo cercanos.
+      for (unsigned int v : meshletVertices) {
+        if (liveTriangles[v] > 0) {
+          best = adjacency[adjacencyOffset[v]];
+          break;
+        }
+      }
+      if (best == ~0u) {
+        while (emitted[cursor]) ++cursor;
+        best = (unsigned int)cursor;
+      }
+
+      closeMeshlet();
+      ++meshletId;
+      current = Meshlet();
+      current.indexOffset = (unsigned int)result.size();
+      centroidSum = XMFLOAT3(0.0f, 0.0f, 0.0f);
+      meshletVertices.clear();
+    }
+    next = best;
+  }
+  closeMeshlet();
+
+  result.insert(result.end(), mesh.m_index.begin() + lodIndexCount, mesh.m_index.end());
+  mesh.m_index.swap(result);
+  mesh.m_meshlets.swap(meshlets);
+  mesh.selectIndexFormat();
+  return true;
+}
+
+void
+MeshletBuilder::computeBounds(const std::vector<SimpleVertex>& vertices,
+  const unsigned int* triangles,
+  const std::vector<unsigned int>& meshletVertices,
+  Meshlet& meshlet) {
+  XMFLOAT3 minBound = vertices[meshletVertices[0]].Pos;
+  XMFLOAT3 maxBound = minBound;
+  for (unsigned int v : meshletVertices) {
+    const XMFLOAT3& p = vertices[v].Pos;
+    minBound.x = (std::min)(minBound.x, p.x);
+    minBound.y = (std::min)(minBound.y, p.y);
+    minBound.z = (std::min)(minBound.z, p.z);
+    maxBound.x = (std::max)(maxBound.x, p.x);
+    maxBound.y = (std::max)(maxBound.y, p.y);
+    maxBound.z = (std::max)(maxBound.z, p.z);
+  }
+  meshlet.center = XMFLOAT3((minBound.x + maxBound.x) * 0.5f,
+                            (minBound.y + maxBound.y) * 0.5f,
+                            (minBound.z + maxBound.z) * 0.5f);
+  float radiusSq = 0.0f;
+  for (unsigned int v : meshletVertices) {
+    radiusSq = (std::max)(radiusSq, distanceSq(vertices[v].Pos, meshlet.center));
+  }
+  meshlet.radius = sqrtf(radiusSq);
+
+  // Cono de normales: eje = promedio de normales unitarias, apertura = la normal ms alejada.
+  std::vector<XMFLOAT3> normals;
+  normals.reserve(meshlet.triangleCount);
+  XMFLOAT3 axis(0.0f, 0.0f, 0.0f);
+  for (unsigned int t = 0; t < meshlet.triangleCount; ++t) {
+    const XMFLOAT3& a = vertices[triangles[t * 3 + 0]].Pos;
+    const XMFLOAT3& b = vertices[triangles[t * 3 + 1]].Pos;
+    const XMFLOAT3& c = vertices[triangles[t * 3 + 2]].Pos;
+    const float e1[3] = { b.x - a.x, b.y - a.y, b.z - a.z };
+    const float e2[3] = { c.x - a.x, c.y - a.y, c.z - a.z };
+    XMFLOAT3 n(e1[1] * e2[2] - e1[2] * e2[1],
+               e1[2] * e2[0] - e1[0] * e2[2],
+               e1[0] * e2[1] - e1[1] * e2[0]);
+    const float length = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+    if (length <= 0.0f) continue;
+    n.x /= length;
+    n.y /= length;
+    n.z /= length;
+    normals.push_back(n);
+    axis.x += n.x;
+    axis.y += n.y;
+    axis.z += n.z;
+  }
+
+  meshlet.coneAxis = XMFLOAT3(0.0f, 0.0f, 0.0f);
+  meshlet.coneCutoff = 1.0f;
+  const float axisLength = sqrtf(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
+  if (normals.empty() || axisLength <= 0.0f) return;
+
+  axis.x /= axisLength;
+  axis.y /= axisLength;
+  axis.z /= axisLength;
+  float minDot = 1.0f;
+  for (const XMFLOAT3& n : normals) {
+    minDot = (std::min)(minDot, n.x * axis.x + n.y * axis.y + n.z * axis.z);
+  }
+  meshlet.coneAxis = axis;
+  meshlet.coneCutoff = minDot <= kMinConeDot ? 1.0f : sqrtf(1.0f - minDot * minDot);
+}
+
+bool
+MeshletBuilder::isBackfacing(const Meshlet& meshlet, const XMFLOAT3& cameraPosition) {
+  // Prueba conservadora con la esfera: todo el cluster mira en la misma direccin
+  // que el rayo de la cmara, con margen para cualquier punto dentro de la esfera.
+  const float dx = meshlet.center.x - cameraPosition.x;
+  const float dy = meshlet.center.y - cameraPosition.y;
+  const float dz = meshlet.center.z - cameraPosition.z;
+  const float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+  const float alignment = dx * meshlet.coneAxis.x + dy * meshlet.coneAxis.y + dz * meshlet.coneAxis.z;
+  return alignment >= meshlet.coneCutoff * distance + meshlet.radius;
+}
+
+size_t
+MeshletBuilder::cullMeshlets(const MeshComponent& mesh,
+  const XMFLOAT3& cameraPosition,
+  std::vector<IndexRange>& outRanges) {
+  outRanges.clear();
+  size_t visible = 0;
+  for (const Meshlet& meshlet : mesh.m_meshlets) {
+    if (isBackfacing(meshlet, cameraPosition)) continue;
+    ++visible;
+
+    const unsigned int count = meshlet.triangleCount * 3;
+    if (!outRanges.empty() && outRanges.back().start + outRanges.back().count == meshlet.indexOffset) {
+      outRanges.back().count += count;
+    }
+    else {
+      outRanges.push_back({ meshlet.indexOffset, count });
+    }
+  }
+  return visible;
+}
+
+bool
+MeshletBuilder::benchmark(const std::string& filename,
+  int iterations,
+  unsigned int maxVertices,
+  unsigned int maxTriangles) {
+  if (iterations < 1) iterations = 1;
+
+  // Como ModelLoader con optimize + buildMeshlets: se parte la malla ya optimizada
+  MeshComponent source;
+  ModelLoader::Options opts;
+  opts.optimize = true;
+  if (!ModelLoader::loadFromFile(filename, source, opts)) return false;
+
+  MeshComponent built;
+  double bestSeconds = 0.0;
+  for (int i = 0; i < iterations; ++i) {
+    built = source;
+    const auto start = std::chrono::high_resolution_clock::now();
+    if (!build(built, maxVertices, maxTriangles)) return false;
+    const double seconds = std::chrono::duration<double>(
+      std::chrono::high_resolution_clock::now() - start).count();
+    if (i == 0 || seconds < bestSeconds) bestSeconds = seconds;
+  }
+
+  // Identidad: los meshlets cubren m_index sin huecos y son los mismos tringulos.
+  bool identical = built.m_index.size() == source.m_index.size();
+  unsigned int expectedOffset = 0;
+  for (const Meshlet& meshlet : built.m_meshlets) {
+    identical = identical && meshlet.indexOffset == expectedOffset &&
+                meshlet.vertexCount <= maxVertices && meshlet.triangleCount <= maxTriangles;
+    expectedOffset += meshlet.triangleCount * 3;
+  }
+  identical = identical && expectedOffset == built.m_index.size();
+  if (identical) {
+    typedef std::array<unsigned int, 3> Triangle;
+    std::vector<Triangle> before(source.m_index.size() / 3), after(built.m_index.size() / 3);
+    for (size_t t = 0; t < before.size(); ++t) {
+      before[t] = { source.m_index[t * 3], source.m_index[t * 3 + 1], source.m_index[t * 3 + 2] };
+      after[t] = { built.m_index[t * 3], built.m_index[t * 3 + 1], built.m_index[t * 3 + 2] };
+    }
+    std::sort(before.begin(), before.end());
+    std::sort(after.begin(), after.end());
+    identical = before == after;
+  }
+
+  // Calidad: ocupacin de los lmites, radio relativo al de la malla, conos tiles y
+  // descarte por cono desde 6 cmaras sobre los ejes a 3 radios del centro.
+  const size_t meshletCount = built.m_meshlets.size();
+  double vertexFill = 0.0, triangleFill = 0.0, radiusSum = 0.0;
+  size_t usefulCones = 0;
+  XMFLOAT3 minBound = built.m_vertex[0].Pos, maxBound = minBound;
+  for (const SimpleVertex& v : built.m_vertex) {
+    minBound.x = (std::min)(minBound.x, v.Pos.x);
+    minBound.y = (std::min)(minBound.y, v.Pos.y);
+    minBound.z = (std::min)(minBound.z, v.Pos.z);
+    maxBound.x = (std::max)(maxBound.x, v.Pos.x);
+    maxBound.y = (std::max)(maxBound.y, v.Pos.y);
+    maxBound.z = (std::max)(maxBound.z, v.Pos.z);
+  }
+  const XMFLOAT3 meshCenter((minBound.x + maxBound.x) * 0.5f,
+                            (minBound.y + maxBound.y) * 0.5f,
+                            (minBound.z + maxBound.z) * 0.5f);
+  const float meshRadius = (std::max)(sqrtf(distanceSq(minBound, maxBound)) * 0.5f, 1e-6f);
+
+  for (const Meshlet& meshlet : built.m_meshlets) {
+    vertexFill += double(meshlet.vertexCount) / maxVertices;
+    triangleFill += double(meshlet.triangleCount) / maxTriangles;
+    radiusSum += meshlet.radius / meshRadius;
+    if (meshlet.coneCutoff < 1.0f) ++usefulCones;
+  }
+
+  size_t culled = 0;
+  std::vector<IndexRange> ranges;
+  const float d = meshRadius * 3.0f;
+  const XMFLOAT3 cameras[6] = {
+    XMFLOAT3(meshCenter.x + d, meshCenter.y, meshCenter.z), XMFLOAT3(meshCenter.x - d, meshCenter.y, meshCenter.z),
+    XMFLOAT3(meshCenter.x, meshCenter.y + d, meshCenter.z), XMFLOAT3(meshCenter.x, meshCenter.y - d, meshCenter.z),
+    XMFLOAT3(meshCenter.x, meshCenter.y, meshCenter.z + d), XMFLOAT3(meshCenter.x, meshCenter.y, meshCenter.z - d)
+  };
+  for (const XMFLOAT3& camera : cameras) {
+    culled += meshletCount - cullMeshlets(built, camera, ranges);
+  }
+
+  std::wostringstream wss;
+  std::wstring wfn(filename.begin(), filename.end());
+  wss << wfn << L" [T:" << built.m_index.size() / 3 << L"] limits " << maxVertices << L"v/" << maxTriangles
+      << L"t: " << meshletCount << L" meshlets in " << (bestSeconds * 1000.0) << L" ms"
+      << L", fill v " << (meshletCount ? 100.0 * vertexFill / meshletCount : 0.0) << L"%"
+      << L" t " << (meshletCount ? 100.0 * triangleFill / meshletCount : 0.0) << L"%"
+      << L", radius " << (meshletCount ? radiusSum / meshletCount : 0.0) << L"x mesh"
+      << L", cones " << (meshletCount ? 100.0 * usefulCones / meshletCount : 0.0) << L"%"
+      << L", cone-culled " << (meshletCount ? 100.0 * culled / (6.0 * meshletCount) : 0.0) << L"%";
+  // Lo que el orden por clusters le cuesta al cach post-transform
+  const MeshOptimizer::CacheStats optimizedCache =
+    MeshOptimizer::analyzeVertexCache(source.m_index, source.m_vertex.size());
+  const MeshOptimizer::CacheStats meshletCache =
+    MeshOptimizer::analyzeVertexCache(built.m_index, built.m_vertex.size());
+  wss << L", ACMR optimized " << optimizedCache.acmr << L" -> meshlets " << meshletCache.acmr;
+  MESSAGE(L"MeshletBuilder", L"benchmark", wss.str().c_str());
+
+  if (!identical) {
+    ERROR(L"MeshletBuilder", L"benchmark", (L"Los meshlets no reproducen la malla: " + wfn).c_str());
+    return false;
+  }
+  return true;
+}
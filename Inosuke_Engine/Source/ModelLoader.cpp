@@ -1,14 +1,19 @@
 #include "ModelLoader.h"
 #include "MeshComponent.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "MeshletBuilder.h"
+#include "MeshSimplifier.h"
+#include "VertexDedupTable.h"
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstring>
 
 
-void ModelLoader::split(const std::string& s, char d, std::vector<std::string>& out) {
-  out.clear();
-  std::string tok;
-  std::istringstream ss(s);
-  while (std::getline(ss, tok, d)) out.push_back(tok);
-}
-
 std::string ModelLoader::trim(const std::string& s) {
   const char* ws = " \t\r\n";
   size_t b = s.find_first_not_of(ws);
@@ -24,70 +29,276 @@ int ModelLoader::resolveIndex(int idx, int count, bool allowNegative) {
   return idx - 1;                                     
 }
 
-void ModelLoader::processFace(
-  const std::vector<std::string>& face,
-  std::unordered_map<std::string, unsigned>& uniqueMap,
+bool ModelLoader::parseStream(const std::string& filename,
   std::vector<SimpleVertex>& outVertices,
   std::vector<unsigned>& outIndices,
-  const std::vector<XMFLOAT3>& pos,
-  const std::vector<XMFLOAT2>& uvs,
-  const std::vector<XMFLOAT3>& norms,
+  size_t& outBytes,
   const Options& opts)
 {
-  
-  std::vector<unsigned> vidx; vidx.reserve(face.size());
+  std::ifstream f(filename);
+  if (!f.is_open()) {
+    std::wstring wfn(filename.begin(), filename.end());
+    ERROR(L"ModelLoader", L"loadFromFile", (L"No se pudo abrir: " + wfn).c_str());
+    return false;
+  }
 
-  for (const std::string& vtokenRaw : face) {
-    std::string vtoken = trim(vtokenRaw);
-    if (vtoken.empty()) continue;
+  std::vector<XMFLOAT3> positions;
+  std::vector<XMFLOAT2> texcoords;
+  std::vector<XMFLOAT3> normals;
+  VertexDedupTable unique;
+  std::vector<std::string_view> views;
+  std::vector<unsigned> scratch;
 
-    auto it = uniqueMap.find(vtoken);
-    if (it != uniqueMap.end()) {
-      vidx.push_back(it->second);
-      continue;
+  outBytes = 0;
+  std::string line;
+  while (std::getline(f, line)) {
+    outBytes += line.size() + 1;
+    line = trim(line);
+    if (line.empty() || line[0] == '#') continue;
+
+    std::istringstream ss(line);
+    std::string tag;
+    ss >> tag;
+
+    if (tag == "v") {
+      XMFLOAT3 p{};
+      if (ss >> p.x >> p.y >> p.z) positions.push_back(p);
+    }
+    else if (tag == "vt") {
+      XMFLOAT2 t{};
+      if (ss >> t.x >> t.y) texcoords.push_back(t); 
     }
+    else if (tag == "vn") {
+      XMFLOAT3 n{};
+      if (ss >> n.x >> n.y >> n.z) normals.push_back(n);
+    }
+    else if (tag == "f") {
+      // Las esquinas apuntan dentro de la lnea: sin un std::string por token
+      views.clear();
+      const char* p = line.data() + tag.size();
+      const char* end = line.data() + line.size();
+      while (p < end) {
+        while (p < end && isspace((unsigned char)*p)) ++p;
+        const char* token = p;
+        while (p < end && !isspace((unsigned char)*p)) ++p;
+        if (p > token) views.emplace_back(token, p - token);
+      }
+      if (views.size() >= 3) {
+        processFace(views, unique, scratch, outVertices, outIndices,
+          positions, texcoords, normals, opts);
+      }
+    }
+    
+  }
+  f.close();
+  return true;
+}
 
-    // Parse "v[/vt][/vn]"
-    std::vector<std::string> parts;
-    split(vtoken, '/', parts);
-    int v = 0, vt = 0, vn = 0;
+//--------------------------------------------------------------------------------------
+// Ruta en memoria proyectada: recorre el archivo con punteros, sin copiar lneas.
+//--------------------------------------------------------------------------------------
+
+namespace {
+  // Mismo conjunto que isspace() en locale "C", excepto '\n' que delimita la lnea.
+  inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+  }
 
-    try {
-      if (parts.size() >= 1 && !parts[0].empty()) v = std::stoi(parts[0]);
-      if (parts.size() >= 2 && !parts[1].empty()) vt = std::stoi(parts[1]);
-      if (parts.size() >= 3 && !parts[2].empty()) vn = std::stoi(parts[2]);
+  inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+  }
+
+  inline const char* skipBlanks(const char* p, const char* end) {
+    while (p < end && isBlank(*p)) ++p;
+    return p;
+  }
+
+  inline const char* skipToken(const char* p, const char* end) {
+    while (p < end && !isBlank(*p)) ++p;
+    return p;
+  }
+
+  // Potencias de 10 representables exactamente en float (5^10 < 2^24).
+  const float kPow10[] = {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+  };
+}
+
+bool ModelLoader::parseFloat(const char*& p, const char* end, float& out) {
+  const char* s = skipBlanks(p, end);
+  const char* c = s;
+  bool negative = false;
+  if (c < end && (*c == '+' || *c == '-')) {
+    negative = (*c == '-');
+    ++c;
+  }
+  const char* numberBegin = c;
+
+  // Mantisa decimal. Mientras quepa en 24 bits y el exponente sea chico,
+  // una sola multiplicacin/divisin en float da el resultado correctamente
+  // redondeado (camino rpido de Clinger); si no, se delega en from_chars.
+  unsigned long long mantissa = 0;
+  int exponent = 0;
+  int digits = 0;
+  bool exact = true;
+  for (; c < end && isDigit(*c); ++c, ++digits) {
+    if (mantissa < (1ull << 24)) mantissa = mantissa * 10 + (*c - '0');
+    else { exact = false; ++exponent; }
+  }
+  if (c < end && *c == '.') {
+    for (++c; c < end && isDigit(*c); ++c, ++digits) {
+      if (mantissa < (1ull << 24)) { mantissa = mantissa * 10 + (*c - '0'); --exponent; }
+      else exact = false;
+    }
+  }
+  if (digits == 0) return false;
+
+  if (c < end && (*c == 'e' || *c == 'E')) {
+    const char* e = c + 1;
+    bool expNegative = false;
+    if (e < end && (*e == '+' || *e == '-')) {
+      expNegative = (*e == '-');
+      ++e;
+    }
+    if (e < end && isDigit(*e)) {
+      int expValue = 0;
+      for (; e < end && isDigit(*e); ++e) {
+        if (expValue < 10000) expValue = expValue * 10 + (*e - '0');
+      }
+      exponent += expNegative ? -expValue : expValue;
+      c = e;
     }
-    catch (...) {
-      
-      continue;
+  }
+
+  float value;
+  if (exact && mantissa <= (1ull << 24) && exponent >= -10 && exponent <= 10) {
+    value = static_cast<float>(mantissa);
+    value = exponent < 0 ? value / kPow10[-exponent] : value * kPow10[exponent];
+  }
+  else {
+    auto res = std::from_chars(numberBegin, c, value);
+    if (res.ec != std::errc()) return false;
+  }
+
+  out = negative ? -value : value;
+  p = c;
+  return true;
+}
+
+bool ModelLoader::parseInt(const char*& p, const char* end, int& out) {
+  // Igual que std::stoi: signo opcional, al menos un dgito, se detiene en el primer no-dgito.
+  const char* c = p;
+  bool negative = false;
+  if (c < end && (*c == '+' || *c == '-')) {
+    negative = (*c == '-');
+    ++c;
+  }
+  if (c >= end || !isDigit(*c)) return false;
+
+  long long value = 0;
+  for (; c < end && isDigit(*c); ++c) {
+    value = value * 10 + (*c - '0');
+    if (value > 2147483648ll) return false;
+  }
+  if (negative) value = -value;
+  if (value > 2147483647ll) return false;
+
+  out = static_cast<int>(value);
+  p = c;
+  return true;
+}
+
+bool ModelLoader::parseCorner(std::string_view token, int values[3]) {
+  // Parse "v[/vt][/vn]" sin separar en strings
+  values[0] = values[1] = values[2] = 0;
+  const char* c = token.data();
+  const char* end = c + token.size();
+  for (int part = 0; part < 3 && c < end; ++part) {
+    const char* slash = static_cast<const char*>(memchr(c, '/', end - c));
+    const char* partEnd = slash ? slash : end;
+    if (partEnd != c) {
+      const char* q = c;
+      if (!parseInt(q, partEnd, values[part])) return false;
     }
+    c = slash ? slash + 1 : end;
+  }
+  return true;
+}
 
-    int pv = resolveIndex(v, (int)pos.size(), opts.allowNegative);
-    int pt = resolveIndex(vt, (int)uvs.size(), opts.allowNegative);
-    
+bool ModelLoader::resolveCorner(const int values[3],
+  int posCount,
+  int uvCount,
+  int normalCount,
+  bool allowNegative,
+  VertexKey& key)
+{
+  key.pos = resolveIndex(values[0], posCount, allowNegative);
+  if (key.pos < 0 || key.pos >= posCount) return false;
 
-    if (pv < 0 || pv >= (int)pos.size()) continue;
+  // Atributos opcionales fuera de rango se normalizan a -1 para que la clave
+  // solo distinga lo que realmente cambia el vrtice.
+  int pt = resolveIndex(values[1], uvCount, allowNegative);
+  int pn = resolveIndex(values[2], normalCount, allowNegative);
+  key.uv = (pt >= 0 && pt < uvCount) ? pt : -1;
+  key.normal = (pn >= 0 && pn < normalCount) ? pn : -1;
+  return true;
+}
 
+void ModelLoader::addCorner(const VertexKey& key,
+  VertexDedupTable& uniqueMap,
+  std::vector<unsigned>& vidx,
+  std::vector<SimpleVertex>& outVertices,
+  const std::vector<XMFLOAT3>& pos,
+  const std::vector<XMFLOAT2>& uvs,
+  const Options& opts)
+{
+  bool inserted = false;
+  unsigned index = uniqueMap.findOrInsert(key, (unsigned)outVertices.size(), inserted);
+  if (inserted) {
     SimpleVertex sv{};
-    sv.Pos = pos[pv];
-
-    if (pt >= 0 && pt < (int)uvs.size()) {
-      sv.Tex = uvs[pt];
+    sv.Pos = pos[key.pos];
+    if (key.uv >= 0) {
+      sv.Tex = uvs[key.uv];
       if (opts.flipV) sv.Tex.y = 1.0f - sv.Tex.y;
     }
     else {
       sv.Tex = XMFLOAT2(0.0f, 0.0f);
     }
-
-    unsigned newIndex = (unsigned)outVertices.size();
     outVertices.push_back(sv);
-    uniqueMap[vtoken] = newIndex;
-    vidx.push_back(newIndex);
   }
+  vidx.push_back(index);
+}
+
+void ModelLoader::processFace(
+  const std::vector<std::string_view>& face,
+  VertexDedupTable& uniqueMap,
+  std::vector<unsigned>& vidx,
+  std::vector<SimpleVertex>& outVertices,
+  std::vector<unsigned>& outIndices,
+  const std::vector<XMFLOAT3>& pos,
+  const std::vector<XMFLOAT2>& uvs,
+  const std::vector<XMFLOAT3>& norms,
+  const Options& opts)
+{
+  vidx.clear();
+
+  for (const std::string_view& vtoken : face) {
+    int values[3];
+    if (!parseCorner(vtoken, values)) continue;
+
+    VertexKey key;
+    if (!resolveCorner(values, (int)pos.size(), (int)uvs.size(), (int)norms.size(),
+                       opts.allowNegative, key)) continue;
+
+    addCorner(key, uniqueMap, vidx, outVertices, pos, uvs, opts);
+  }
+
+  emitFan(vidx, outIndices);
+}
 
+void ModelLoader::emitFan(const std::vector<unsigned>& vidx, std::vector<unsigned>& outIndices) {
   if (vidx.size() < 3) return;
 
-  
   const unsigned i0 = vidx[0];
   for (size_t i = 1; i + 1 < vidx.size(); ++i) {
     outIndices.push_back(i0);
@@ -96,64 +307,339 @@ void ModelLoader::processFace(
   }
 }
 
-bool ModelLoader::loadFromFile(const std::string& filename,
-  MeshComponent& outMesh,
+//--------------------------------------------------------------------------------------
+// Ruta paralela: bloques alineados a '\n' parseados en hilos y fusionados en orden.
+//--------------------------------------------------------------------------------------
+
+namespace {
+  // Por debajo de este tamao el costo de lanzar hilos supera al parseo.
+  const size_t kMinParallelBytes = 1u << 20;
+
+  // Estimacin conservadora para reservar la tabla de deduplicacin de la ruta serial.
+  const size_t kBytesPerUniqueVertex = 96;
+
+  // Bloques por hilo, para repartir mejor archivos con secciones v/f desbalanceadas.
+  const unsigned int kChunksPerThread = 4;
+
+  struct ObjCorner {
+    int values[3];  // v, vt, vn tal como aparecen en el archivo
+    bool valid;     // false si el token no se pudo parsear
+  };
+
+  struct ObjFace {
+    unsigned int firstCorner;  // Primer ObjCorner del bloque
+    unsigned int numCorners;
+    int numPositions;          // "v" vistos en el bloque antes de esta cara
+    int numTexcoords;          // "vt" vistos en el bloque antes de esta cara
+    int numNormals;            // "vn" vistos en el bloque antes de esta cara
+  };
+
+  struct ObjChunk {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    std::vector<XMFLOAT3> positions;
+    std::vector<XMFLOAT2> texcoords;
+    std::vector<XMFLOAT3> normals;
+    std::vector<ObjCorner> corners;
+    std::vector<ObjFace> faces;
+  };
+}
+
+void ModelLoader::parseChunks(const char* data,
+  size_t size,
+  unsigned int threads,
+  std::vector<SimpleVertex>& outVertices,
+  std::vector<unsigned>& outIndices,
   const Options& opts)
 {
-  std::ifstream f(filename);
-  if (!f.is_open()) {
+  // 1) Partir el archivo en bloques que empiezan justo despus de un '\n'.
+  const size_t numChunks = (std::max)(size_t(1),
+    (std::min)(size_t(threads) * kChunksPerThread, size / (kMinParallelBytes / 16)));
+  std::vector<ObjChunk> chunks(numChunks);
+  const char* const fileEnd = data + size;
+  const char* cursor = data;
+  for (size_t i = 0; i < numChunks; ++i) {
+    const char* split = (i + 1 == numChunks) ? fileEnd : data + (size / numChunks) * (i + 1);
+    if (split < cursor) split = cursor;
+    if (split < fileEnd) {
+      const char* nl = static_cast<const char*>(memchr(split, '\n', fileEnd - split));
+      split = nl ? nl + 1 : fileEnd;
+    }
+    chunks[i].begin = cursor;
+    chunks[i].end = split;
+    cursor = split;
+  }
+
+  // 2) Parsear cada bloque de forma independiente. Los ndices de las caras se
+  //    guardan sin resolver junto con los contadores locales del bloque, porque
+  //    los ndices relativos (negativos) dependen de cuntos "v"/"vt" hay antes.
+  auto parseChunk = [&opts](ObjChunk& chunk) {
+    const char* p = chunk.begin;
+    while (p < chunk.end) {
+      const char* nl = static_cast<const char*>(memchr(p, '\n', chunk.end - p));
+      const char* lineEnd = nl ? nl : chunk.end;
+      const char* c = p;
+      p = nl ? nl + 1 : chunk.end;
+
+      while (c < lineEnd && (*c == ' ' || *c == '\t' || *c == '\r')) ++c;
+      while (lineEnd > c && (lineEnd[-1] == ' ' || lineEnd[-1] == '\t' || lineEnd[-1] == '\r')) --lineEnd;
+      if (c == lineEnd || *c == '#') continue;
+
+      const char* tagEnd = skipToken(c, lineEnd);
+      const size_t tagLen = tagEnd - c;
+      c = tagEnd;
+
+      if (tagLen == 1 && c[-1] == 'v') {
+        XMFLOAT3 v{};
+        if (parseFloat(c, lineEnd, v.x) && parseFloat(c, lineEnd, v.y) && parseFloat(c, lineEnd, v.z))
+          chunk.positions.push_back(v);
+      }
+      else if (tagLen == 2 && c[-2] == 'v' && c[-1] == 't') {
+        XMFLOAT2 t{};
+        if (parseFloat(c, lineEnd, t.x) && parseFloat(c, lineEnd, t.y))
+          chunk.texcoords.push_back(t);
+      }
+      else if (tagLen == 2 && c[-2] == 'v' && c[-1] == 'n') {
+        XMFLOAT3 n{};
+        if (parseFloat(c, lineEnd, n.x) && parseFloat(c, lineEnd, n.y) && parseFloat(c, lineEnd, n.z))
+          chunk.normals.push_back(n);
+      }
+      else if (tagLen == 1 && c[-1] == 'f') {
+        ObjFace face;
+        face.firstCorner = (unsigned int)chunk.corners.size();
+        face.numPositions = (int)chunk.positions.size();
+        face.numTexcoords = (int)chunk.texcoords.size();
+        face.numNormals = (int)chunk.normals.size();
+        for (c = skipBlanks(c, lineEnd); c < lineEnd; c = skipBlanks(c, lineEnd)) {
+          const char* tokEnd = skipToken(c, lineEnd);
+          ObjCorner corner;
+          corner.valid = parseCorner(std::string_view(c, tokEnd - c), corner.values);
+          chunk.corners.push_back(corner);
+          c = tokEnd;
+        }
+        face.numCorners = (unsigned int)chunk.corners.size() - face.firstCorner;
+        if (face.numCorners >= 3) chunk.faces.push_back(face);
+        else chunk.corners.resize(face.firstCorner);
+      }
+    }
+  };
+
+  if (opts.jobs) {
+    opts.jobs->parallelFor((unsigned int)numChunks, 1, [&](unsigned int begin, unsigned int end) {
+      for (unsigned int i = begin; i < end; ++i) parseChunk(chunks[i]);
+    });
+  }
+  else {
+    std::atomic<size_t> nextChunk(0);
+    auto worker = [&]() {
+      for (size_t i = nextChunk++; i < numChunks; i = nextChunk++) parseChunk(chunks[i]);
+    };
+    std::vector<std::thread> pool;
+    const unsigned int numWorkers = (unsigned int)(std::min)(size_t(threads), numChunks);
+    for (unsigned int t = 1; t < numWorkers; ++t) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+  }
+
+  // 3) Concatenar atributos en orden de archivo, guardando la base de cada bloque.
+  std::vector<int> posBase(numChunks), uvBase(numChunks), normalBase(numChunks);
+  size_t totalPos = 0, totalUv = 0, totalNormals = 0;
+  for (size_t i = 0; i < numChunks; ++i) {
+    posBase[i] = (int)totalPos;
+    uvBase[i] = (int)totalUv;
+    normalBase[i] = (int)totalNormals;
+    totalPos += chunks[i].positions.size();
+    totalUv += chunks[i].texcoords.size();
+    totalNormals += chunks[i].normals.size();
+  }
+  std::vector<XMFLOAT3> positions;
+  std::vector<XMFLOAT2> texcoords;
+  positions.reserve(totalPos);
+  texcoords.reserve(totalUv);
+  for (ObjChunk& chunk : chunks) {
+    positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+    texcoords.insert(texcoords.end(), chunk.texcoords.begin(), chunk.texcoords.end());
+    std::vector<XMFLOAT3>().swap(chunk.positions);
+    std::vector<XMFLOAT2>().swap(chunk.texcoords);
+    std::vector<XMFLOAT3>().swap(chunk.normals);
+  }
+
+  // 4) Fusin serial en orden de archivo: misma deduplicacin y numeracin que
+  //    el loader serial, as la salida es idntica sin importar los hilos.
+  VertexDedupTable uniqueMap;
+  uniqueMap.reserve(totalPos + totalPos / 4);
+  outVertices.reserve(totalPos + totalPos / 4);
+  std::vector<unsigned> vidx;
+  for (size_t i = 0; i < numChunks; ++i) {
+    const ObjChunk& chunk = chunks[i];
+    for (const ObjFace& face : chunk.faces) {
+      const int posCount = posBase[i] + face.numPositions;
+      const int uvCount = uvBase[i] + face.numTexcoords;
+      const int normalCount = normalBase[i] + face.numNormals;
+      vidx.clear();
+      for (unsigned int k = 0; k < face.numCorners; ++k) {
+        const ObjCorner& corner = chunk.corners[face.firstCorner + k];
+        if (!corner.valid) continue;
+
+        VertexKey key;
+        if (!resolveCorner(corner.values, posCount, uvCount, normalCount,
+                           opts.allowNegative, key)) continue;
+
+        addCorner(key, uniqueMap, vidx, outVertices, positions, texcoords, opts);
+      }
+      emitFan(vidx, outIndices);
+    }
+  }
+}
+
+bool ModelLoader::parseMapped(const std::string& filename,
+  std::vector<SimpleVertex>& outVertices,
+  std::vector<unsigned>& outIndices,
+  size_t& outBytes,
+  const Options& opts)
+{
+  MappedFile file;
+  if (FAILED(file.init(filename))) {
     std::wstring wfn(filename.begin(), filename.end());
     ERROR(L"ModelLoader", L"loadFromFile", (L"No se pudo abrir: " + wfn).c_str());
     return false;
   }
+  outBytes = file.size();
+
+  unsigned int threads = opts.jobs ? opts.jobs->getThreadCount()
+    : (opts.threads ? opts.threads : std::thread::hardware_concurrency());
+  if (threads > 1 && file.size() >= kMinParallelBytes) {
+    parseChunks(file.data(), file.size(), threads, outVertices, outIndices, opts);
+    return true;
+  }
+
+  const char* p = file.data();
+  const char* const fileEnd = p + file.size();
 
   std::vector<XMFLOAT3> positions;
   std::vector<XMFLOAT2> texcoords;
   std::vector<XMFLOAT3> normals;
+  VertexDedupTable unique;
+  unique.reserve(file.size() / kBytesPerUniqueVertex);
+  std::vector<std::string_view> tokens;
+  std::vector<unsigned> scratch;
 
-  std::vector<SimpleVertex> outVertices;
-  std::vector<unsigned> outIndices;
-  std::unordered_map<std::string, unsigned> unique;
+  while (p < fileEnd) {
+    const char* nl = static_cast<const char*>(memchr(p, '\n', fileEnd - p));
+    const char* lineEnd = nl ? nl : fileEnd;
+    const char* c = p;
+    p = nl ? nl + 1 : fileEnd;
 
-  std::string line;
-  while (std::getline(f, line)) {
-    line = trim(line);
-    if (line.empty() || line[0] == '#') continue;
+    // Mismo recorte que trim(): solo ' ', '\t' y '\r'
+    while (c < lineEnd && (*c == ' ' || *c == '\t' || *c == '\r')) ++c;
+    while (lineEnd > c && (lineEnd[-1] == ' ' || lineEnd[-1] == '\t' || lineEnd[-1] == '\r')) --lineEnd;
+    if (c == lineEnd || *c == '#') continue;
 
-    std::istringstream ss(line);
-    std::string tag;
-    ss >> tag;
+    const char* tagEnd = skipToken(c, lineEnd);
+    const size_t tagLen = tagEnd - c;
+    c = tagEnd;
 
-    if (tag == "v") {
-      XMFLOAT3 p{};
-      if (ss >> p.x >> p.y >> p.z) positions.push_back(p);
+    if (tagLen == 1 && c[-1] == 'v') {
+      XMFLOAT3 v{};
+      if (parseFloat(c, lineEnd, v.x) && parseFloat(c, lineEnd, v.y) && parseFloat(c, lineEnd, v.z))
+        positions.push_back(v);
     }
-    else if (tag == "vt") {
+    else if (tagLen == 2 && c[-2] == 'v' && c[-1] == 't') {
       XMFLOAT2 t{};
-      if (ss >> t.x >> t.y) texcoords.push_back(t); 
+      if (parseFloat(c, lineEnd, t.x) && parseFloat(c, lineEnd, t.y))
+        texcoords.push_back(t);
     }
-    else if (tag == "vn") {
+    else if (tagLen == 2 && c[-2] == 'v' && c[-1] == 'n') {
       XMFLOAT3 n{};
-      if (ss >> n.x >> n.y >> n.z) normals.push_back(n);
+      if (parseFloat(c, lineEnd, n.x) && parseFloat(c, lineEnd, n.y) && parseFloat(c, lineEnd, n.z))
+        normals.push_back(n);
     }
-    else if (tag == "f") {
-      std::vector<std::string> tokens;
-      std::string vtok;
-      while (ss >> vtok) tokens.push_back(vtok);
+    else if (tagLen == 1 && c[-1] == 'f') {
+      tokens.clear();
+      for (c = skipBlanks(c, lineEnd); c < lineEnd; c = skipBlanks(c, lineEnd)) {
+        const char* tokEnd = skipToken(c, lineEnd);
+        tokens.emplace_back(c, tokEnd - c);
+        c = tokEnd;
+      }
       if (tokens.size() >= 3) {
-        processFace(tokens, unique, outVertices, outIndices,
+        processFace(tokens, unique, scratch, outVertices, outIndices,
           positions, texcoords, normals, opts);
       }
     }
-    
   }
-  f.close();
+
+  return true;
+}
+
+bool ModelLoader::loadFromFile(const std::string& filename,
+  MeshComponent& outMesh,
+  const Options& opts)
+{
+  const auto start = std::chrono::high_resolution_clock::now();
+
+  // Cach binaria: si el sello del OBJ coincide, se evita el parseo por completo.
+  MeshCache::SourceStamp stamp;
+  const bool stamped = opts.useCache && MeshCache::stampSource(filename, stamp);
+  const std::string cacheFile = MeshCache::cachePathFor(filename);
+  unsigned int optimizeFlags = 0;
+  if (opts.optimize) {
+    optimizeFlags = MeshCache::kFlagOptimized;
+    if (opts.overdrawThreshold > 0.0f) optimizeFlags |= MeshCache::kFlagOverdrawOptimized;
+  }
+
+  unsigned int cacheFlags = 0;
+  if (stamped && MeshCache::load(cacheFile, stamp, outMesh, &cacheFlags)) {
+    outMesh.m_name = filename;
+    // Cach horneada sin las etapas pedidas: se completan una sola vez y se reescribe.
+    // Como en la carga desde el OBJ, la marca solo se guarda si optimize() tuvo xito.
+    bool rebake = false;
+    bool optimized = false;
+    if ((cacheFlags & optimizeFlags) != optimizeFlags) {
+      optimized = MeshOptimizer::optimize(outMesh, opts.overdrawThreshold);
+      if (optimized) {
+        cacheFlags |= optimizeFlags;
+        rebake = true;
+      }
+    }
+    if (!optimized) outMesh.selectIndexFormat();
+    if (opts.lodLevels > 1 && outMesh.m_lods.size() < 2) {
+      MeshSimplifier::buildLods(outMesh, opts.lodLevels);
+      rebake = true;
+    }
+    if (opts.buildMeshlets && outMesh.m_meshlets.empty() && MeshletBuilder::build(outMesh)) {
+      rebake = true;
+    }
+    if (rebake) {
+      MeshCache::save(cacheFile, outMesh, stamp, cacheFlags);
+    }
+    const double seconds = std::chrono::duration<double>(
+      std::chrono::high_resolution_clock::now() - start).count();
+
+    std::wostringstream wss;
+    std::wstring wfn(cacheFile.begin(), cacheFile.end());
+    wss << L"OK (cache) " << wfn << L" [V:" << outMesh.m_numVertex << L" I:" << outMesh.m_numIndex << L"]"
+        << L" " << (seconds * 1000.0) << L" ms";
+    MESSAGE(L"ModelLoader", L"loadFromFile", wss.str().c_str());
+    return true;
+  }
+
+  std::vector<SimpleVertex> outVertices;
+  std::vector<unsigned> outIndices;
+  size_t bytes = 0;
+
+  const bool parsed = opts.memoryMapped
+    ? parseMapped(filename, outVertices, outIndices, bytes, opts)
+    : parseStream(filename, outVertices, outIndices, bytes, opts);
+  if (!parsed) return false;
 
   outMesh.m_name = filename;
   outMesh.m_vertex = std::move(outVertices);
   outMesh.m_index = std::move(outIndices);
   outMesh.m_numVertex = (int)outMesh.m_vertex.size();
   outMesh.m_numIndex = (int)outMesh.m_index.size();
+  outMesh.m_meshlets.clear();
+  outMesh.m_lods.clear();
+  outMesh.computeBounds();
 
   if (outMesh.m_numVertex == 0 || outMesh.m_numIndex == 0) {
     std::wstring wfn(filename.begin(), filename.end());
@@ -161,9 +647,178 @@ bool ModelLoader::loadFromFile(const std::string& filename,
     return false;
   }
 
+  const double seconds = std::chrono::duration<double>(
+    std::chrono::high_resolution_clock::now() - start).count();
+
   std::wostringstream wss;
   std::wstring wfn(filename.begin(), filename.end());
-  wss << L"OK " << wfn << L" [V:" << outMesh.m_numVertex << L" I:" << outMesh.m_numIndex << L"]";
+  wss << L"OK " << wfn << L" [V:" << outMesh.m_numVertex << L" I:" << outMesh.m_numIndex << L"]"
+      << L" " << (seconds * 1000.0) << L" ms"
+      << L" (" << (bytes / (1024.0 * 1024.0)) / (seconds > 0.0 ? seconds : 1e-9) << L" MB/s)";
   MESSAGE(L"ModelLoader", L"loadFromFile", wss.str().c_str());
+
+  // m_index se conserva en 32 bits (cach y herramientas); Buffer::init sube 16 bits si alcanza.
+  const bool optimized = opts.optimize && MeshOptimizer::optimize(outMesh, opts.overdrawThreshold);
+  if (!optimized) outMesh.selectIndexFormat();
+  if (opts.lodLevels > 1) MeshSimplifier::buildLods(outMesh, opts.lodLevels);
+  if (opts.buildMeshlets) MeshletBuilder::build(outMesh);
+  if (stamped) MeshCache::save(cacheFile, outMesh, stamp, optimized ? optimizeFlags : 0);
+  return true;
+}
+
+bool ModelLoader::benchmark(const std::string& filename, int iterations)
+{
+  if (iterations < 1) iterations = 1;
+
+  const bool modes[2] = { false, true };
+  const wchar_t* names[2] = { L"stream", L"mapped" };
+  double best[2] = { 0.0, 0.0 };
+  size_t bytes = 0;
+  std::vector<SimpleVertex> vertices[2];
+  std::vector<unsigned> indices[2];
+
+  for (int m = 0; m < 2; ++m) {
+    Options opts;
+    opts.memoryMapped = modes[m];
+    for (int i = 0; i < iterations; ++i) {
+      vertices[m].clear();
+      indices[m].clear();
+      const auto start = std::chrono::high_resolution_clock::now();
+      const bool ok = opts.memoryMapped
+        ? parseMapped(filename, vertices[m], indices[m], bytes, opts)
+        : parseStream(filename, vertices[m], indices[m], bytes, opts);
+      const double seconds = std::chrono::duration<double>(
+        std::chrono::high_resolution_clock::now() - start).count();
+      if (!ok) return false;
+      if (i == 0 || seconds < best[m]) best[m] = seconds;
+    }
+  }
+
+  const bool identical =
+    vertices[0].size() == vertices[1].size() &&
+    indices[0] == indices[1] &&
+    (vertices[0].empty() ||
+     memcmp(vertices[0].data(), vertices[1].data(), vertices[0].size() * sizeof(SimpleVertex)) == 0);
+
+  std::wstring wfn(filename.begin(), filename.end());
+  const double megabytes = bytes / (1024.0 * 1024.0);
+  for (int m = 0; m < 2; ++m) {
+    std::wostringstream wss;
+    wss << wfn << L" " << names[m] << L": " << (best[m] * 1000.0) << L" ms, "
+        << megabytes / (best[m] > 0.0 ? best[m] : 1e-9) << L" MB/s";
+    MESSAGE(L"ModelLoader", L"benchmark", wss.str().c_str());
+  }
+
+  if (!identical) {
+    ERROR(L"ModelLoader", L"benchmark", (L"Las rutas stream y mapped difieren: " + wfn).c_str());
+    return false;
+  }
+  return true;
+}
+
+bool ModelLoader::benchmarkScaling(const std::string& filename, unsigned int maxThreads)
+{
+  if (maxThreads < 1) maxThreads = 1;
+
+  std::vector<SimpleVertex> refVertices;
+  std::vector<unsigned> refIndices;
+  std::wstring wfn(filename.begin(), filename.end());
+  double serialSeconds = 0.0;
+  bool identical = true;
+
+  for (unsigned int threads = 1; threads <= maxThreads; threads *= 2) {
+    Options opts;
+    opts.threads = threads;
+
+    std::vector<SimpleVertex> vertices;
+    std::vector<unsigned> indices;
+    size_t bytes = 0;
+    const auto start = std::chrono::high_resolution_clock::now();
+    if (!parseMapped(filename, vertices, indices, bytes, opts)) return false;
+    const double seconds = std::chrono::duration<double>(
+      std::chrono::high_resolution_clock::now() - start).count();
+
+    if (threads == 1) {
+      serialSeconds = seconds;
+      refVertices.swap(vertices);
+      refIndices.swap(indices);
+    }
+    else if (vertices.size() != refVertices.size() || indices != refIndices ||
+             (!vertices.empty() &&
+              memcmp(vertices.data(), refVertices.data(), vertices.size() * sizeof(SimpleVertex)) != 0)) {
+      identical = false;
+    }
+
+    std::wostringstream wss;
+    wss << wfn << L" threads " << threads << L": " << (seconds * 1000.0) << L" ms, "
+        << (bytes / (1024.0 * 1024.0)) / (seconds > 0.0 ? seconds : 1e-9) << L" MB/s, x"
+        << serialSeconds / (seconds > 0.0 ? seconds : 1e-9);
+    MESSAGE(L"ModelLoader", L"benchmarkScaling", wss.str().c_str());
+  }
+
+  if (!identical) {
+    ERROR(L"ModelLoader", L"benchmarkScaling", (L"La salida paralela difiere de la serial: " + wfn).c_str());
+    return false;
+  }
+  return true;
+}
+
+bool ModelLoader::benchmarkCache(const std::string& filename, int iterations)
+{
+  if (iterations < 1) iterations = 1;
+
+  MeshCache::SourceStamp stamp;
+  if (!MeshCache::stampSource(filename, stamp)) return false;
+  const std::string cacheFile = MeshCache::cachePathFor(filename);
+
+  // Fro: parseo completo del OBJ y escritura de la cach.
+  Options opts;
+  MeshComponent parsed;
+  double coldSeconds = 0.0;
+  for (int i = 0; i < iterations; ++i) {
+    std::vector<SimpleVertex> vertices;
+    std::vector<unsigned> indices;
+    size_t bytes = 0;
+    const auto start = std::chrono::high_resolution_clock::now();
+    if (!parseMapped(filename, vertices, indices, bytes, opts)) return false;
+    const double seconds = std::chrono::duration<double>(
+      std::chrono::high_resolution_clock::now() - start).count();
+    if (i == 0 || seconds < coldSeconds) coldSeconds = seconds;
+    parsed.m_vertex.swap(vertices);
+    parsed.m_index.swap(indices);
+  }
+  parsed.m_numVertex = (int)parsed.m_vertex.size();
+  parsed.m_numIndex = (int)parsed.m_index.size();
+  if (!MeshCache::save(cacheFile, parsed, stamp)) return false;
+
+  // Caliente: sello + validacin + copia desde la cach proyectada.
+  MeshComponent cached;
+  double warmSeconds = 0.0;
+  for (int i = 0; i < iterations; ++i) {
+    const auto start = std::chrono::high_resolution_clock::now();
+    MeshCache::SourceStamp warmStamp;
+    if (!MeshCache::stampSource(filename, warmStamp) ||
+        !MeshCache::load(cacheFile, warmStamp, cached)) return false;
+    const double seconds = std::chrono::duration<double>(
+      std::chrono::high_resolution_clock::now() - start).count();
+    if (i == 0 || seconds < warmSeconds) warmSeconds = seconds;
+  }
+
+  const bool identical =
+    cached.m_index == parsed.m_index &&
+    cached.m_vertex.size() == parsed.m_vertex.size() &&
+    memcmp(cached.m_vertex.data(), parsed.m_vertex.data(),
+           parsed.m_vertex.size() * sizeof(SimpleVertex)) == 0;
+
+  std::wostringstream wss;
+  std::wstring wfn(filename.begin(), filename.end());
+  wss << wfn << L" cold parse: " << (coldSeconds * 1000.0) << L" ms, warm cache: "
+      << (warmSeconds * 1000.0) << L" ms, x" << coldSeconds / (warmSeconds > 0.0 ? warmSeconds : 1e-9);
+  MESSAGE(L"ModelLoader", L"benchmarkCache", wss.str().c_str());
+
+  if (!identical) {
+    ERROR(L"ModelLoader", L"benchmarkCache", (L"La cach no reproduce la malla parseada: " + wfn).c_str());
+    return false;
+  }
   return true;
 }
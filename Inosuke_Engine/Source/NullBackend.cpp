@@ -0,0 +1,1236 @@
+#include "NullBackend.h"
+#include "SoftwareRasterizer.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+
+namespace {
+  /**
+   * Base de los objetos nulos: IUnknown con conteo de referencias e
+   * ID3D11DeviceChild sin datos privados. Se destruye al llegar a 0 referencias.
+   */
+  template<typename Interface>
+  class NullObject : public Interface {
+  public:
+    explicit NullObject(NullBackend& backend) : m_backend(backend) {
+      ++m_backend.m_liveObjects;
+    }
+    virtual ~NullObject() {
+      --m_backend.m_liveObjects;
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override {
+      if (!ppvObject) {
+        return E_POINTER;
+      }
+      if (riid == __uuidof(Interface) || riid == __uuidof(IUnknown)) {
+        *ppvObject = static_cast<Interface*>(this);
+        AddRef();
+        return S_OK;
+      }
+      *ppvObject = nullptr;
+      return E_NOINTERFACE;
+    }
+    ULONG STDMETHODCALLTYPE AddRef() override {
+      return ++m_refCount;
+    }
+    ULONG STDMETHODCALLTYPE Release() override {
+      ULONG count = --m_refCount;
+      if (count == 0) {
+        delete this;
+      }
+      return count;
+    }
+    void STDMETHODCALLTYPE GetDevice(ID3D11Device** ppDevice) override {
+      if (ppDevice) *ppDevice = nullptr;
+    }
+    HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID, UINT* pDataSize, void*) override {
+      if (pDataSize) *pDataSize = 0;
+      return DXGI_ERROR_NOT_FOUND;
+    }
+    HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID, UINT, const void*) override {
+      return S_OK;
+    }
+    HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID, const IUnknown*) override {
+      return S_OK;
+    }
+
+  private:
+    NullBackend& m_backend;
+    ULONG m_refCount = 1;
+  };
+
+  /**
+   * Buffer o textura: guarda su desc para que GetDesc/GetType respondan como en
+   * D3D11, y su contenido (buffers y texturas RGBA8) para el rasterizador.
+   */
+  template<typename Interface, typename Desc, D3D11_RESOURCE_DIMENSION Dimension>
+  class NullResource : public NullObject<Interface> {
+  public:
+    NullResource(NullBackend& backend, const Desc& desc)
+      : NullObject<Interface>(backend), m_desc(desc) {}
+
+    void STDMETHODCALLTYPE GetType(D3D11_RESOURCE_DIMENSION* pResourceDimension) override {
+      if (pResourceDimension) *pResourceDimension = Dimension;
+    }
+    void STDMETHODCALLTYPE SetEvictionPriority(UINT EvictionPriority) override {
+      m_evictionPriority = EvictionPriority;
+    }
+    UINT STDMETHODCALLTYPE GetEvictionPriority() override {
+      return m_evictionPriority;
+    }
+    void STDMETHODCALLTYPE GetDesc(Desc* pDesc) override {
+      if (pDesc) *pDesc = m_desc;
+    }
+
+    const Desc& desc() const { return m_desc; }
+
+  public:
+    std::vector<unsigned char> m_data;
+
+  private:
+    Desc m_desc;
+    UINT m_evictionPriority = 0;
+  };
+
+  /// Vista: mantiene una referencia al recurso, igual que una vista real.
+  template<typename Interface, typename Desc>
+  class NullView : public NullObject<Interface> {
+  public:
+    NullView(NullBackend& backend, ID3D11Resource* resource, const Desc* desc)
+      : NullObject<Interface>(backend), m_resource(resource) {
+      memset(&m_desc, 0, sizeof(m_desc));
+      if (desc) m_desc = *desc;
+      if (m_resource) m_resource->AddRef();
+    }
+    ~NullView() {
+      SAFE_RELEASE(m_resource);
+    }
+
+    void STDMETHODCALLTYPE GetResource(ID3D11Resource** ppResource) override {
+      if (!ppResource) return;
+      *ppResource = m_resource;
+      if (m_resource) m_resource->AddRef();
+    }
+    void STDMETHODCALLTYPE GetDesc(Desc* pDesc) override {
+      if (pDesc) *pDesc = m_desc;
+    }
+
+    /// Recurso sin AddRef (a diferencia de GetResource).
+    ID3D11Resource* resource() const { return m_resource; }
+
+  private:
+    ID3D11Resource* m_resource;
+    Desc m_desc;
+  };
+
+  class NullSamplerState : public NullObject<ID3D11SamplerState> {
+  public:
+    NullSamplerState(NullBackend& backend, const D3D11_SAMPLER_DESC& desc)
+      : NullObject<ID3D11SamplerState>(backend), m_desc(desc) {}
+
+    void STDMETHODCALLTYPE GetDesc(D3D11_SAMPLER_DESC* pDesc) override {
+      if (pDesc) *pDesc = m_desc;
+    }
+
+  private:
+    D3D11_SAMPLER_DESC m_desc;
+  };
+
+  /// Query de evento: se completa cuando el backend llega a m_signalPresent.
+  class NullQuery : public NullObject<ID3D11Query> {
+  public:
+    NullQuery(NullBackend& backend, const D3D11_QUERY_DESC& desc)
+      : NullObject<ID3D11Query>(backend), m_desc(desc) {}
+
+    UINT STDMETHODCALLTYPE GetDataSize() override {
+      return sizeof(BOOL);
+    }
+    void STDMETHODCALLTYPE GetDesc(D3D11_QUERY_DESC* pDesc) override {
+      if (pDesc) *pDesc = m_desc;
+    }
+
+  public:
+    bool m_ended = false;
+    unsigned long long m_signalPresent = 0;
+
+  private:
+    D3D11_QUERY_DESC m_desc;
+  };
+
+  /// Blob de "bytecode": en headless contiene el texto del archivo .fx.
+  class NullBlob : public ID3DBlob {
+  public:
+    explicit NullBlob(std::vector<char>&& data) : m_data(std::move(data)) {}
+    virtual ~NullBlob() = default;
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override {
+      if (!ppvObject) {
+        return E_POINTER;
+      }
+      if (riid == __uuidof(ID3D10Blob) || riid == __uuidof(IUnknown)) {
+        *ppvObject = static_cast<ID3DBlob*>(this);
+        AddRef();
+        return S_OK;
+      }
+      *ppvObject = nullptr;
+      return E_NOINTERFACE;
+    }
+    ULONG STDMETHODCALLTYPE AddRef() override {
+      return ++m_refCount;
+    }
+    ULONG STDMETHODCALLTYPE Release() override {
+      ULONG count = --m_refCount;
+      if (count == 0) {
+        delete this;
+      }
+      return count;
+    }
+    LPVOID STDMETHODCALLTYPE GetBufferPointer() override {
+      return m_data.data();
+    }
+    SIZE_T STDMETHODCALLTYPE GetBufferSize() override {
+      return m_data.size();
+    }
+
+  private:
+    std::vector<char> m_data;
+    ULONG m_refCount = 1;
+  };
+
+  typedef NullResource<ID3D11Buffer, D3D11_BUFFER_DESC,
+    D3D11_RESOURCE_DIMENSION_BUFFER> NullBuffer;
+  typedef NullResource<ID3D11Texture2D, D3D11_TEXTURE2D_DESC,
+    D3D11_RESOURCE_DIMENSION_TEXTURE2D> NullTexture2D;
+  typedef NullView<ID3D11RenderTargetView, D3D11_RENDER_TARGET_VIEW_DESC> NullRenderTargetView;
+  typedef NullView<ID3D11DepthStencilView, D3D11_DEPTH_STENCIL_VIEW_DESC> NullDepthStencilView;
+  typedef NullView<ID3D11ShaderResourceView, D3D11_SHADER_RESOURCE_VIEW_DESC> NullShaderResourceView;
+
+  /// Bytes aproximados por texel de los formatos que usa el motor (solo para el reporte).
+  unsigned int
+  formatBytes(DXGI_FORMAT format) {
+    switch (format) {
+    case DXGI_FORMAT_R32G32B32A32_FLOAT: return 16;
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+    case DXGI_FORMAT_R16G16B16A16_FLOAT: return 8;
+    default: return 4;
+    }
+  }
+
+  bool
+  isStateCommand(NullBackend::CommandType type) {
+    return type >= NullBackend::CMD_RS_SET_VIEWPORTS && type <= NullBackend::CMD_OM_SET_BLEND_STATE;
+  }
+
+  /// Contenido de un buffer nulo (los buffers los crea siempre NullBackend).
+  std::vector<unsigned char>*
+  bufferData(ID3D11Buffer* buffer) {
+    return buffer ? &static_cast<NullBuffer*>(buffer)->m_data : nullptr;
+  }
+
+  unsigned int
+  readUInt(const unsigned char* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((unsigned int)data[3] << 24);
+  }
+
+  /// Extrae un canal de 8 bits con su mscara de bits del DDS (0 si no hay mscara: canal ausente).
+  unsigned char
+  maskChannel(unsigned int pixel, unsigned int mask, unsigned char missing) {
+    if (mask == 0) {
+      return missing;
+    }
+    unsigned int shift = 0;
+    while (((mask >> shift) & 1) == 0) {
+      ++shift;
+    }
+    const unsigned int max = mask >> shift;
+    return (unsigned char)(((pixel & mask) >> shift) * 255 / max);
+  }
+
+  /// Color RGB565 de un bloque DXT a RGBA8.
+  void
+  decode565(unsigned int color, unsigned char out[4]) {
+    out[0] = (unsigned char)(((color >> 11) & 31) * 255 / 31);
+    out[1] = (unsigned char)(((color >> 5) & 63) * 255 / 63);
+    out[2] = (unsigned char)((color & 31) * 255 / 31);
+    out[3] = 255;
+  }
+
+  /// Decodifica el color de un bloque DXT1/3/5 de 4x4 (8 bytes) a 16 texels RGBA8.
+  void
+  decodeColorBlock(const unsigned char* block, bool dxt1, unsigned char texels[16][4]) {
+    const unsigned int c0 = block[0] | (block[1] << 8);
+    const unsigned int c1 = block[2] | (block[3] << 8);
+    unsigned char palette[4][4];
+    decode565(c0, palette[0]);
+    decode565(c1, palette[1]);
+    for (int c = 0; c < 3; ++c) {
+      if (c0 > c1 || !dxt1) {
+        palette[2][c] = (unsigned char)((2 * palette[0][c] + palette[1][c]) / 3);
+        palette[3][c] = (unsigned char)((palette[0][c] + 2 * palette[1][c]) / 3);
+      }
+      else {
+        palette[2][c] = (unsigned char)((palette[0][c] + palette[1][c]) / 2);
+        palette[3][c] = 0;
+      }
+    }
+    palette[2][3] = 255;
+    palette[3][3] = (dxt1 && c0 <= c1) ? 0 : 255;
+
+    const unsigned int indices = readUInt(block + 4);
+    for (int i = 0; i < 16; ++i) {
+      memcpy(texels[i], palette[(indices >> (i * 2)) & 3], 4);
+    }
+  }
+
+  /**
+   * Decodifica el primer mip de un DDS a RGBA8. Soporta RGB/RGBA sin compresin
+   * de 24 o 32 bits (con mscaras) y DXT1/DXT3/DXT5.
+   */
+  bool
+  decodeDDS(const std::vector<unsigned char>& file,
+    std::vector<unsigned char>& rgba,
+    unsigned int& width,
+    unsigned int& height) {
+    const size_t kHeaderSize = 128;   // "DDS " + DDS_HEADER
+    if (file.size() < kHeaderSize || memcmp(file.data(), "DDS ", 4) != 0) {
+      return false;
+    }
+    const unsigned char* header = file.data() + 4;
+    height = readUInt(header + 8);
+    width = readUInt(header + 12);
+    const unsigned char* pixelFormat = header + 72;
+    const unsigned int flags = readUInt(pixelFormat + 4);
+    const unsigned int fourCC = readUInt(pixelFormat + 8);
+    const unsigned int bitCount = readUInt(pixelFormat + 12);
+    const unsigned int masks[4] = { readUInt(pixelFormat + 16), readUInt(pixelFormat + 20),
+      readUInt(pixelFormat + 24), readUInt(pixelFormat + 28) };
+    if (width == 0 || height == 0 || width > 16384 || height > 16384) {
+      return false;
+    }
+
+    const unsigned char* data = file.data() + kHeaderSize;
+    const size_t available = file.size() - kHeaderSize;
+    rgba.assign((size_t)width * height * 4, 0);
+
+    const unsigned int kFourCC = 0x4;
+    if (flags & kFourCC) {
+      const bool dxt1 = fourCC == 0x31545844;   // "DXT1"
+      const bool dxt3 = fourCC == 0x33545844;   // "DXT3"
+      const bool dxt5 = fourCC == 0x35545844;   // "DXT5"
+      if (!dxt1 && !dxt3 && !dxt5) {
+        return false;
+      }
+      const unsigned int blocksX = (width + 3) / 4;
+      const unsigned int blocksY = (height + 3) / 4;
+      const size_t blockBytes = dxt1 ? 8 : 16;
+      if (available < (size_t)blocksX * blocksY * blockBytes) {
+        return false;
+      }
+      for (unsigned int by = 0; by < blocksY; ++by) {
+        for (unsigned int bx = 0; bx < blocksX; ++bx) {
+          const unsigned char* block = data + ((size_t)by * blocksX + bx) * blockBytes;
+          unsigned char texels[16][4];
+          decodeColorBlock(dxt1 ? block : block + 8, dxt1, texels);
+          if (dxt3) {
+            for (int i = 0; i < 16; ++i) {
+              texels[i][3] = (unsigned char)(((block[i / 2] >> ((i & 1) * 4)) & 15) * 17);
+            }
+          }
+          else if (dxt5) {
+            unsigned int alpha[8] = { block[0], block[1] };
+            for (int i = 2; i < 8; ++i) {
+              alpha[i] = block[0] > block[1]
+                ? ((8 - i) * block[0] + (i - 1) * block[1]) / 7
+                : (i < 6 ? ((6 - i) * block[0] + (i - 1) * block[1]) / 5 : (i == 6 ? 0 : 255));
+            }
+            unsigned long long bits = 0;
+            for (int i = 0; i < 6; ++i) {
+              bits |= (unsigned long long)block[2 + i] << (i * 8);
+            }
+            for (int i = 0; i < 16; ++i) {
+              texels[i][3] = (unsigned char)alpha[(bits >> (i * 3)) & 7];
+            }
+          }
+          for (int i = 0; i < 16; ++i) {
+            const unsigned int x = bx * 4 + (i & 3);
+            const unsigned int y = by * 4 + (i >> 2);
+            if (x < width && y < height) {
+              memcpy(&rgba[((size_t)y * width + x) * 4], texels[i], 4);
+            }
+          }
+        }
+      }
+      return true;
+    }
+
+    if (bitCount != 24 && bitCount != 32) {
+      return false;
+    }
+    const unsigned int bytesPerPixel = bitCount / 8;
+    const size_t rowPitch = (size_t)width * bytesPerPixel;
+    if (available < rowPitch * height) {
+      return false;
+    }
+    const unsigned int kAlphaPixels = 0x1;
+    for (unsigned int y = 0; y < height; ++y) {
+      for (unsigned int x = 0; x < width; ++x) {
+        const unsigned char* source = data + y * rowPitch + x * bytesPerPixel;
+        const unsigned int pixel = source[0] | (source[1] << 8) | (source[2] << 16) |
+          (bytesPerPixel == 4 ? (unsigned int)source[3] << 24 : 0);
+        unsigned char* target = &rgba[((size_t)y * width + x) * 4];
+        target[0] = maskChannel(pixel, masks[0], 0);
+        target[1] = maskChannel(pixel, masks[1], 0);
+        target[2] = maskChannel(pixel, masks[2], 0);
+        target[3] = maskChannel(pixel, (flags & kAlphaPixels) ? masks[3] : 0, 255);
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Indica si @p source contiene una llamada/declaracin "name(" con @p name
+   * como identificador completo (no sufijo de otro nombre).
+   */
+  bool
+  declaresFunction(const char* source, const char* name) {
+    const size_t length = strlen(name);
+    for (const char* found = strstr(source, name); found; found = strstr(found + 1, name)) {
+      if (found != source && (isalnum((unsigned char)found[-1]) || found[-1] == '_')) {
+        continue;
+      }
+      const char* next = found + length;
+      while (*next == ' ' || *next == '\t') {
+        ++next;
+      }
+      if (*next == '(') {
+        return true;
+      }
+    }
+    return false;
+  }
+}
+
+HRESULT
+NullBackend::CreateBuffer(const D3D11_BUFFER_DESC* pDesc,
+  const D3D11_SUBRESOURCE_DATA* pInitialData,
+  ID3D11Buffer** ppBuffer) {
+  if (!pDesc || pDesc->ByteWidth == 0) {
+    return E_INVALIDARG;
+  }
+  if (pDesc->Usage == D3D11_USAGE_IMMUTABLE && !pInitialData) {
+    return E_INVALIDARG;
+  }
+  if (!ppBuffer) {
+    return S_FALSE;
+  }
+  NullBuffer* buffer = new NullBuffer(*this, *pDesc);
+  buffer->m_data.assign(pDesc->ByteWidth, 0);
+  if (pInitialData && pInitialData->pSysMem) {
+    memcpy(buffer->m_data.data(), pInitialData->pSysMem, pDesc->ByteWidth);
+  }
+  *ppBuffer = buffer;
+  record(CMD_CREATE_BUFFER, *ppBuffer, 0, pDesc->BindFlags, 0, pDesc->ByteWidth);
+  return S_OK;
+}
+
+HRESULT
+NullBackend::CreateTexture2D(const D3D11_TEXTURE2D_DESC* pDesc,
+  const D3D11_SUBRESOURCE_DATA* pInitialData,
+  ID3D11Texture2D** ppTexture2D) {
+  if (!pDesc || pDesc->Width == 0 || pDesc->Height == 0) {
+    return E_INVALIDARG;
+  }
+  if (!ppTexture2D) {
+    return S_FALSE;
+  }
+  NullTexture2D* texture = new NullTexture2D(*this, *pDesc);
+  // Solo se conserva el contenido RGBA8 (mip 0), que es lo que muestrea el rasterizador
+  if (pDesc->Format == DXGI_FORMAT_R8G8B8A8_UNORM && pInitialData && pInitialData->pSysMem) {
+    const size_t rowBytes = (size_t)pDesc->Width * 4;
+    const unsigned int pitch = pInitialData->SysMemPitch ? pInitialData->SysMemPitch : (unsigned int)rowBytes;
+    texture->m_data.resize(rowBytes * pDesc->Height);
+    for (unsigned int y = 0; y < pDesc->Height; ++y) {
+      memcpy(&texture->m_data[y * rowBytes],
+        static_cast<const unsigned char*>(pInitialData->pSysMem) + (size_t)y * pitch, rowBytes);
+    }
+  }
+  *ppTexture2D = texture;
+  record(CMD_CREATE_TEXTURE2D, *ppTexture2D, 0, pDesc->BindFlags, 0,
+    (unsigned long long)pDesc->Width * pDesc->Height * pDesc->ArraySize *
+    formatBytes(pDesc->Format) * (std::max)(1u, pDesc->SampleDesc.Count));
+  return S_OK;
+}
+
+HRESULT
+NullBackend::CreateRenderTargetView(ID3D11Resource* pResource,
+  const D3D11_RENDER_TARGET_VIEW_DESC* pDesc,
+  ID3D11RenderTargetView** ppRTView) {
+  if (!pResource) {
+    return E_INVALIDARG;
+  }
+  if (!ppRTView) {
+    return S_FALSE;
+  }
+  *ppRTView = new NullRenderTargetView(*this, pResource, pDesc);
+  record(CMD_CREATE_RENDER_TARGET_VIEW, *ppRTView);
+  return S_OK;
+}
+
+HRESULT
+NullBackend::CreateDepthStencilView(ID3D11Resource* pResource,
+  const D3D11_DEPTH_STENCIL_VIEW_DESC* pDesc,
+  ID3D11DepthStencilView** ppDepthStencilView) {
+  if (!pResource) {
+    return E_INVALIDARG;
+  }
+  if (!ppDepthStencilView) {
+    return S_FALSE;
+  }
+  *ppDepthStencilView = new NullDepthStencilView(*this, pResource, pDesc);
+  record(CMD_CREATE_DEPTH_STENCIL_VIEW, *ppDepthStencilView);
+  return S_OK;
+}
+
+HRESULT
+NullBackend::CreateShaderResourceView(ID3D11Resource* pResource,
+  const D3D11_SHADER_RESOURCE_VIEW_DESC* pDesc,
+  ID3D11ShaderResourceView** ppSRView) {
+  if (!pResource) {
+    return E_INVALIDARG;
+  }
+  if (!ppSRView) {
+    return S_FALSE;
+  }
+  *ppSRView = new NullShaderResourceView(*this, pResource, pDesc);
+  record(CMD_CREATE_SHADER_RESOURCE_VIEW, *ppSRView);
+  return S_OK;
+}
+
+HRESULT
+NullBackend::CreateVertexShader(const void* pShaderBytecode,
+  unsigned int BytecodeLength,
+  ID3D11ClassLinkage* pClassLinkage,
+  ID3D11VertexShader** ppVertexShader) {
+  if (!pShaderBytecode || BytecodeLength == 0) {
+    return E_INVALIDARG;
+  }
+  if (!ppVertexShader) {
+    return S_FALSE;
+  }
+  *ppVertexShader = new NullObject<ID3D11VertexShader>(*this);
+  record(CMD_CREATE_VERTEX_SHADER, *ppVertexShader, 0, 0, 0, BytecodeLength);
+  return S_OK;
+}
+
+HRESULT
+NullBackend::CreatePixelShader(const void* pShaderBytecode,
+  unsigned int BytecodeLength,
+  ID3D11ClassLinkage* pClassLinkage,
+  ID3D11PixelShader** ppPixelShader) {
+  if (!pShaderBytecode || BytecodeLength == 0) {
+    return E_INVALIDARG;
+  }
+  if (!ppPixelShader) {
+    return S_FALSE;
+  }
+  *ppPixelShader = new NullObject<ID3D11PixelShader>(*this);
+  record(CMD_CREATE_PIXEL_SHADER, *ppPixelShader, 0, 0, 0, BytecodeLength);
+  return S_OK;
+}
+
+HRESULT
+NullBackend::CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC* pInputElementDescs,
+  unsigned int NumElements,
+  const void* pShaderBytecodeWithInputSignature,
+  unsigned int BytecodeLength,
+  ID3D11InputLayout** ppInputLayout) {
+  if (!pInputElementDescs || NumElements == 0 ||
+    !pShaderBytecodeWithInputSignature || BytecodeLength == 0) {
+    return E_INVALIDARG;
+  }
+  if (!ppInputLayout) {
+    return S_FALSE;
+  }
+  *ppInputLayout = new NullObject<ID3D11InputLayout>(*this);
+  record(CMD_CREATE_INPUT_LAYOUT, *ppInputLayout, 0, NumElements);
+  return S_OK;
+}
+
+HRESULT
+NullBackend::CreateSamplerState(const D3D11_SAMPLER_DESC* pSamplerDesc,
+  ID3D11SamplerState** ppSamplerState) {
+  if (!pSamplerDesc) {
+    return E_INVALIDARG;
+  }
+  if (!ppSamplerState) {
+    return S_FALSE;
+  }
+  *ppSamplerState = new NullSamplerState(*this, *pSamplerDesc);
+  record(CMD_CREATE_SAMPLER_STATE, *ppSamplerState);
+  return S_OK;
+}
+
+HRESULT
+NullBackend::checkFile(const std::string& fileName,
+  const char* method,
+  unsigned long long* outSize) {
+  std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+  if (!file) {
+    ERROR(L"NullBackend", method, L"File not found: " << fileName.c_str());
+    return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+  }
+  *outSize = (unsigned long long)file.tellg();
+  return S_OK;
+}
+
+HRESULT
+NullBackend::CreateQuery(const D3D11_QUERY_DESC* pQueryDesc, ID3D11Query** ppQuery) {
+  if (!pQueryDesc || pQueryDesc->Query != D3D11_QUERY_EVENT) {
+    return E_INVALIDARG;
+  }
+  if (!ppQuery) {
+    return S_FALSE;
+  }
+  *ppQuery = new NullQuery(*this, *pQueryDesc);
+  record(CMD_CREATE_QUERY, *ppQuery);
+  return S_OK;
+}
+
+HRESULT
+NullBackend::CreateShaderResourceViewFromFile(const std::string& fileName,
+  ID3D11ShaderResourceView** ppSRView) {
+  if (!ppSRView) {
+    return E_POINTER;
+  }
+  unsigned long long fileSize = 0;
+  HRESULT hr = checkFile(fileName, "CreateShaderResourceViewFromFile", &fileSize);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  std::ifstream file(fileName, std::ios::binary);
+  std::vector<unsigned char> contents((size_t)fileSize);
+  file.read((char*)contents.data(), (std::streamsize)fileSize);
+
+  std::vector<unsigned char> texels;
+  unsigned int width = 0;
+  unsigned int height = 0;
+  if (!decodeDDS(contents, texels, width, height)) {
+    MESSAGE(L"NullBackend", L"CreateShaderResourceViewFromFile",
+      L"Unsupported image format, using a 1x1 white texture: " << fileName.c_str());
+    texels.assign(4, 255);
+    width = height = 1;
+  }
+
+  D3D11_TEXTURE2D_DESC desc;
+  memset(&desc, 0, sizeof(desc));
+  desc.Width = width;
+  desc.Height = height;
+  desc.MipLevels = 1;
+  desc.ArraySize = 1;
+  desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+  desc.SampleDesc.Count = 1;
+  desc.Usage = D3D11_USAGE_DEFAULT;
+  desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+  D3D11_SUBRESOURCE_DATA initData;
+  memset(&initData, 0, sizeof(initData));
+  initData.pSysMem = texels.data();
+  initData.SysMemPitch = width * 4;
+
+  ID3D11Texture2D* texture = nullptr;
+  hr = CreateTexture2D(&desc, &initData, &texture);
+  if (FAILED(hr)) {
+    return hr;
+  }
+  // El tamao del archivo es lo que D3DX habra subido a la GPU.
+  if (m_recordCommands && !m_commands.empty()) {
+    m_commands.back().bytes = fileSize;
+  }
+
+  hr = CreateShaderResourceView(texture, nullptr, ppSRView);
+  texture->Release();
+  return hr;
+}
+
+HRESULT
+NullBackend::CompileShaderFromFile(const std::string& fileName,
+  const char* szEntryPoint,
+  const char* szShaderModel,
+  ID3DBlob** ppBlobOut) {
+  if (!ppBlobOut) {
+    return E_POINTER;
+  }
+  unsigned long long fileSize = 0;
+  HRESULT hr = checkFile(fileName, "CompileShaderFromFile", &fileSize);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  std::ifstream file(fileName, std::ios::binary);
+  std::vector<char> source((size_t)fileSize + 1, '\0');
+  file.read(source.data(), (std::streamsize)fileSize);
+
+  // Sin compilador, al menos la funcin de entrada tiene que estar en el archivo
+  if (szEntryPoint && !declaresFunction(source.data(), szEntryPoint)) {
+    ERROR(L"NullBackend", L"CompileShaderFromFile",
+      L"Entry point " << szEntryPoint << L" not found in " << fileName.c_str());
+    return E_FAIL;
+  }
+
+  *ppBlobOut = new NullBlob(std::move(source));
+  record(CMD_COMPILE_SHADER, *ppBlobOut, 0, 0, 0, fileSize);
+  return S_OK;
+}
+
+void
+NullBackend::record(CommandType type,
+  const void* object,
+  unsigned int start,
+  unsigned int count,
+  int value,
+  unsigned long long bytes) {
+  ++m_callCounts[type];
+
+  if (m_frame != kNoFrame) {
+    FrameStats& stats = m_frames.back();
+    ++stats.apiCalls;
+    if (isStateCommand(type)) {
+      ++stats.stateCalls;
+    }
+    else if (type == CMD_DRAW_INDEXED || type == CMD_DRAW_INDEXED_INSTANCED) {
+      ++stats.drawCalls;
+      stats.indexCount += count;
+    }
+    else if (type == CMD_UPDATE_SUBRESOURCE) {
+      stats.bytesUploaded += bytes;
+    }
+  }
+
+  if (m_recordCommands) {
+    Command command = { type, m_frame, object, start, count, value, bytes };
+    m_commands.push_back(command);
+  }
+}
+
+void
+NullBackend::RSSetViewports(unsigned int NumViewports, const D3D11_VIEWPORT* pViewports) {
+  if (NumViewports > 0 && pViewports) {
+    m_state.viewport = pViewports[0];
+  }
+  record(CMD_RS_SET_VIEWPORTS, pViewports, 0, NumViewports);
+}
+
+void
+NullBackend::RSSetState(ID3D11RasterizerState* pRasterizerState) {
+  record(CMD_RS_SET_STATE, pRasterizerState);
+}
+
+void
+NullBackend::IASetInputLayout(ID3D11InputLayout* pInputLayout) {
+  record(CMD_IA_SET_INPUT_LAYOUT, pInputLayout);
+}
+
+void
+NullBackend::IASetVertexBuffers(unsigned int StartSlot,
+  unsigned int NumBuffers,
+  ID3D11Buffer* const* ppVertexBuffers,
+  const unsigned int* pStrides,
+  const unsigned int* pOffsets) {
+  // El rasterizador lee el slot 0 (vrtices) y el 1 (instancias)
+  for (unsigned int i = 0; i < NumBuffers; ++i) {
+    if (StartSlot + i == 0) {
+      m_state.vertexBuffer = ppVertexBuffers[i];
+      m_state.vertexStride = pStrides[i];
+      m_state.vertexOffset = pOffsets[i];
+    }
+    else if (StartSlot + i == 1) {
+      m_state.instanceBuffer = ppVertexBuffers[i];
+      m_state.instanceStride = pStrides[i];
+      m_state.instanceOffset = pOffsets[i];
+    }
+  }
+  record(CMD_IA_SET_VERTEX_BUFFERS, ppVertexBuffers[0], StartSlot, NumBuffers, (int)pStrides[0]);
+}
+
+void
+NullBackend::IASetIndexBuffer(ID3D11Buffer* pIndexBuffer, DXGI_FORMAT Format, unsigned int Offset) {
+  m_state.indexBuffer = pIndexBuffer;
+  m_state.indexFormat = Format;
+  m_state.indexOffset = Offset;
+  record(CMD_IA_SET_INDEX_BUFFER, pIndexBuffer, Offset, 1, (int)Format);
+}
+
+void
+NullBackend::IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY Topology) {
+  record(CMD_IA_SET_PRIMITIVE_TOPOLOGY, nullptr, 0, 1, (int)Topology);
+}
+
+void
+NullBackend::VSSetShader(ID3D11VertexShader* pVertexShader) {
+  record(CMD_VS_SET_SHADER, pVertexShader);
+}
+
+void
+NullBackend::VSSetConstantBuffers(unsigned int StartSlot,
+  unsigned int NumBuffers,
+  ID3D11Buffer* const* ppConstantBuffers) {
+  for (unsigned int i = 0; i < NumBuffers && StartSlot + i < kConstantBufferSlots; ++i) {
+    m_state.vsConstantBuffers[StartSlot + i] = ppConstantBuffers[i];
+    m_state.vsFirstConstants[StartSlot + i] = 0;
+  }
+  record(CMD_VS_SET_CONSTANT_BUFFERS, ppConstantBuffers[0], StartSlot, NumBuffers);
+}
+
+void
+NullBackend::VSSetConstantBuffers1(unsigned int StartSlot,
+  unsigned int NumBuffers,
+  ID3D11Buffer* const* ppConstantBuffers,
+  const unsigned int* pFirstConstant,
+  const unsigned int* pNumConstants) {
+  for (unsigned int i = 0; i < NumBuffers && StartSlot + i < kConstantBufferSlots; ++i) {
+    m_state.vsConstantBuffers[StartSlot + i] = ppConstantBuffers[i];
+    m_state.vsFirstConstants[StartSlot + i] = pFirstConstant[i];
+  }
+  record(CMD_VS_SET_CONSTANT_BUFFERS, ppConstantBuffers[0], StartSlot, NumBuffers, (int)pFirstConstant[0]);
+}
+
+void
+NullBackend::PSSetShader(ID3D11PixelShader* pPixelShader) {
+  record(CMD_PS_SET_SHADER, pPixelShader);
+}
+
+void
+NullBackend::PSSetConstantBuffers(unsigned int StartSlot,
+  unsigned int NumBuffers,
+  ID3D11Buffer* const* ppConstantBuffers) {
+  for (unsigned int i = 0; i < NumBuffers && StartSlot + i < kConstantBufferSlots; ++i) {
+    m_state.psConstantBuffers[StartSlot + i] = ppConstantBuffers[i];
+    m_state.psFirstConstants[StartSlot + i] = 0;
+  }
+  record(CMD_PS_SET_CONSTANT_BUFFERS, ppConstantBuffers[0], StartSlot, NumBuffers);
+}
+
+void
+NullBackend::PSSetConstantBuffers1(unsigned int StartSlot,
+  unsigned int NumBuffers,
+  ID3D11Buffer* const* ppConstantBuffers,
+  const unsigned int* pFirstConstant,
+  const unsigned int* pNumConstants) {
+  for (unsigned int i = 0; i < NumBuffers && StartSlot + i < kConstantBufferSlots; ++i) {
+    m_state.psConstantBuffers[StartSlot + i] = ppConstantBuffers[i];
+    m_state.psFirstConstants[StartSlot + i] = pFirstConstant[i];
+  }
+  record(CMD_PS_SET_CONSTANT_BUFFERS, ppConstantBuffers[0], StartSlot, NumBuffers, (int)pFirstConstant[0]);
+}
+
+void
+NullBackend::PSSetShaderResources(unsigned int StartSlot,
+  unsigned int NumViews,
+  ID3D11ShaderResourceView* const* ppShaderResourceViews) {
+  if (StartSlot == 0 && NumViews > 0) {
+    m_state.psResource = ppShaderResourceViews[0];
+  }
+  record(CMD_PS_SET_SHADER_RESOURCES, ppShaderResourceViews[0], StartSlot, NumViews);
+}
+
+void
+NullBackend::PSSetSamplers(unsigned int StartSlot,
+  unsigned int NumSamplers,
+  ID3D11SamplerState* const* ppSamplers) {
+  record(CMD_PS_SET_SAMPLERS, ppSamplers[0], StartSlot, NumSamplers);
+}
+
+void
+NullBackend::OMSetRenderTargets(unsigned int NumViews,
+  ID3D11RenderTargetView* const* ppRenderTargetViews,
+  ID3D11DepthStencilView* pDepthStencilView) {
+  record(CMD_OM_SET_RENDER_TARGETS,
+    NumViews > 0 ? (const void*)ppRenderTargetViews[0] : pDepthStencilView, 0, NumViews);
+}
+
+void
+NullBackend::OMSetBlendState(ID3D11BlendState* pBlendState, unsigned int SampleMask) {
+  record(CMD_OM_SET_BLEND_STATE, pBlendState, 0, 1, (int)SampleMask);
+}
+
+void
+NullBackend::UpdateSubresource(ID3D11Resource* pDstResource,
+  unsigned int DstSubresource,
+  const D3D11_BOX* pDstBox,
+  const void* pSrcData,
+  unsigned int SrcRowPitch,
+  unsigned int SrcDepthPitch) {
+  unsigned long long bytes = 0;
+  D3D11_RESOURCE_DIMENSION dimension = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+  pDstResource->GetType(&dimension);
+  if (dimension == D3D11_RESOURCE_DIMENSION_BUFFER) {
+    NullBuffer* buffer = static_cast<NullBuffer*>(static_cast<ID3D11Buffer*>(pDstResource));
+    const unsigned int left = pDstBox ? pDstBox->left : 0;
+    const unsigned int right = pDstBox ? pDstBox->right : buffer->desc().ByteWidth;
+    if (left < right && right <= buffer->m_data.size()) {
+      bytes = right - left;
+      memcpy(&buffer->m_data[left], pSrcData, (size_t)bytes);
+    }
+  }
+  else if (dimension == D3D11_RESOURCE_DIMENSION_TEXTURE2D) {
+    NullTexture2D* texture = static_cast<NullTexture2D*>(static_cast<ID3D11Texture2D*>(pDstResource));
+    const D3D11_TEXTURE2D_DESC& desc = texture->desc();
+    const unsigned int left = pDstBox ? pDstBox->left : 0;
+    const unsigned int top = pDstBox ? pDstBox->top : 0;
+    const unsigned int right = pDstBox ? pDstBox->right : desc.Width;
+    const unsigned int bottom = pDstBox ? pDstBox->bottom : desc.Height;
+    bytes = (unsigned long long)(right - left) * (bottom - top) * formatBytes(desc.Format);
+    if (DstSubresource == 0 && !texture->m_data.empty() && right <= desc.Width && bottom <= desc.Height) {
+      const size_t rowBytes = (size_t)(right - left) * 4;
+      for (unsigned int y = top; y < bottom; ++y) {
+        memcpy(&texture->m_data[((size_t)y * desc.Width + left) * 4],
+          static_cast<const unsigned char*>(pSrcData) + (size_t)(y - top) * SrcRowPitch, rowBytes);
+      }
+    }
+  }
+  record(CMD_UPDATE_SUBRESOURCE, pDstResource, 0, 1, 0, bytes);
+}
+
+HRESULT
+NullBackend::Map(ID3D11Resource* pResource,
+  unsigned int Subresource,
+  D3D11_MAP MapType,
+  unsigned int MapFlags,
+  D3D11_MAPPED_SUBRESOURCE* pMappedResource) {
+  if (!pResource || !pMappedResource || Subresource != 0) {
+    return E_INVALIDARG;
+  }
+  D3D11_RESOURCE_DIMENSION dimension = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+  pResource->GetType(&dimension);
+  if (dimension != D3D11_RESOURCE_DIMENSION_BUFFER) {
+    return E_INVALIDARG;
+  }
+  NullBuffer* buffer = static_cast<NullBuffer*>(static_cast<ID3D11Buffer*>(pResource));
+  const D3D11_BUFFER_DESC& desc = buffer->desc();
+  if (desc.Usage != D3D11_USAGE_DYNAMIC || !(desc.CPUAccessFlags & D3D11_CPU_ACCESS_WRITE) ||
+    (MapType != D3D11_MAP_WRITE_DISCARD && MapType != D3D11_MAP_WRITE_NO_OVERWRITE)) {
+    return E_INVALIDARG;
+  }
+  if (MapType == D3D11_MAP_WRITE_NO_OVERWRITE && (desc.BindFlags & D3D11_BIND_CONSTANT_BUFFER) &&
+    !m_constantBufferNoOverwrite) {
+    return E_INVALIDARG;
+  }
+  pMappedResource->pData = buffer->m_data.data();
+  pMappedResource->RowPitch = desc.ByteWidth;
+  pMappedResource->DepthPitch = desc.ByteWidth;
+  record(CMD_MAP, pResource, 0, 1, (int)MapType);
+  return S_OK;
+}
+
+void
+NullBackend::Unmap(ID3D11Resource* pResource, unsigned int Subresource) {
+  record(CMD_UNMAP, pResource);
+}
+
+void
+NullBackend::ClearRenderTargetView(ID3D11RenderTargetView* pRenderTargetView, const float ColorRGBA[4]) {
+  if (m_rasterizer) {
+    m_rasterizer->clearColor(ColorRGBA);
+  }
+  record(CMD_CLEAR_RENDER_TARGET_VIEW, pRenderTargetView);
+}
+
+void
+NullBackend::ClearDepthStencilView(ID3D11DepthStencilView* pDepthStencilView,
+  unsigned int ClearFlags,
+  float Depth,
+  UINT8 Stencil) {
+  if (m_rasterizer && (ClearFlags & D3D11_CLEAR_DEPTH)) {
+    m_rasterizer->clearDepth(Depth);
+  }
+  record(CMD_CLEAR_DEPTH_STENCIL_VIEW, pDepthStencilView, 0, 1, (int)ClearFlags);
+}
+
+void
+NullBackend::ClearState() {
+  m_state = PipelineState();
+  record(CMD_CLEAR_STATE);
+}
+
+void
+NullBackend::DrawIndexed(unsigned int IndexCount, unsigned int StartIndexLocation, int BaseVertexLocation) {
+  if (m_rasterizer) {
+    rasterize(IndexCount, StartIndexLocation, BaseVertexLocation);
+  }
+  record(CMD_DRAW_INDEXED, nullptr, StartIndexLocation, IndexCount, BaseVertexLocation);
+}
+
+void
+NullBackend::DrawIndexedInstanced(unsigned int IndexCountPerInstance,
+  unsigned int InstanceCount,
+  unsigned int StartIndexLocation,
+  int BaseVertexLocation,
+  unsigned int StartInstanceLocation) {
+  if (m_rasterizer) {
+    rasterize(IndexCountPerInstance, StartIndexLocation, BaseVertexLocation, InstanceCount, StartInstanceLocation);
+  }
+  record(CMD_DRAW_INDEXED_INSTANCED, m_state.instanceBuffer, StartInstanceLocation,
+    IndexCountPerInstance * InstanceCount, (int)InstanceCount);
+}
+
+void
+NullBackend::Present() {
+  ++m_presentCount;
+  record(CMD_PRESENT);
+}
+
+void
+NullBackend::End(ID3D11Asynchronous* pAsync) {
+  NullQuery* query = static_cast<NullQuery*>(static_cast<ID3D11Query*>(pAsync));
+  query->m_ended = true;
+  query->m_signalPresent = m_presentCount + m_gpuFrameLatency;
+  record(CMD_END_QUERY, pAsync);
+}
+
+HRESULT
+NullBackend::GetData(ID3D11Asynchronous* pAsync, void* pData, unsigned int DataSize, unsigned int GetDataFlags) {
+  NullQuery* query = static_cast<NullQuery*>(static_cast<ID3D11Query*>(pAsync));
+  record(CMD_GET_DATA, pAsync);
+  if (!query->m_ended || m_presentCount < query->m_signalPresent) {
+    return S_FALSE;
+  }
+  if (pData && DataSize >= sizeof(BOOL)) {
+    *static_cast<BOOL*>(pData) = TRUE;
+  }
+  return S_OK;
+}
+
+void
+NullBackend::rasterize(unsigned int IndexCount,
+  unsigned int StartIndexLocation,
+  int BaseVertexLocation,
+  unsigned int InstanceCount,
+  unsigned int StartInstanceLocation) {
+  const std::vector<unsigned char>* vertices = bufferData(m_state.vertexBuffer);
+  const std::vector<unsigned char>* indices = bufferData(m_state.indexBuffer);
+  if (!vertices || !indices) {
+    ERROR(L"NullBackend", L"DrawIndexed", L"Vertex or index buffer is not bound");
+    return;
+  }
+  // El rasterizador emula Inosuke_Engine.fx: solo entiende SimpleVertex
+  if (m_state.vertexStride != sizeof(SimpleVertex)) {
+    ERROR(L"NullBackend", L"DrawIndexed", L"Unsupported vertex stride " << m_state.vertexStride);
+    return;
+  }
+  if (m_state.indexFormat != DXGI_FORMAT_R16_UINT && m_state.indexFormat != DXGI_FORMAT_R32_UINT) {
+    ERROR(L"NullBackend", L"DrawIndexed", L"Unsupported index format");
+    return;
+  }
+
+  SoftwareRasterizer::DrawCall draw;
+  if (m_state.vertexOffset < vertices->size()) {
+    draw.vertices = reinterpret_cast<const SimpleVertex*>(vertices->data() + m_state.vertexOffset);
+    draw.vertexCount = (unsigned int)((vertices->size() - m_state.vertexOffset) / sizeof(SimpleVertex));
+  }
+  draw.indices16 = m_state.indexFormat == DXGI_FORMAT_R16_UINT;
+  const unsigned int indexSize = draw.indices16 ? 2 : 4;
+  if (m_state.indexOffset < indices->size()) {
+    draw.indices = indices->data() + m_state.indexOffset;
+    draw.indexCount = (unsigned int)((indices->size() - m_state.indexOffset) / indexSize);
+  }
+  draw.drawCount = IndexCount;
+  draw.startIndex = StartIndexLocation;
+  draw.baseVertex = BaseVertexLocation;
+
+  // b0 y b1 del vertex shader; b2 tiene mWorld (VS) y vMeshColor (PS)
+  const std::vector<unsigned char>* neverChanges = bufferData(m_state.vsConstantBuffers[0]);
+  const std::vector<unsigned char>* changeOnResize = bufferData(m_state.vsConstantBuffers[1]);
+  const std::vector<unsigned char>* changesEveryFrame = bufferData(m_state.vsConstantBuffers[2]);
+  // Enlazados con VSSetConstantBuffers1 se leen desde su primera constante
+  const size_t neverChangesOffset = (size_t)m_state.vsFirstConstants[0] * 16;
+  const size_t changeOnResizeOffset = (size_t)m_state.vsFirstConstants[1] * 16;
+  const size_t changesEveryFrameOffset = (size_t)m_state.vsFirstConstants[2] * 16;
+  if (neverChanges && neverChanges->size() >= neverChangesOffset + sizeof(CBNeverChanges)) {
+    draw.neverChanges = neverChanges->data() + neverChangesOffset;
+  }
+  if (changeOnResize && changeOnResize->size() >= changeOnResizeOffset + sizeof(CBChangeOnResize)) {
+    draw.changeOnResize = changeOnResize->data() + changeOnResizeOffset;
+  }
+  if (changesEveryFrame && changesEveryFrame->size() >= changesEveryFrameOffset + sizeof(CBChangesEveryFrame)) {
+    draw.changesEveryFrame = changesEveryFrame->data() + changesEveryFrameOffset;
+  }
+
+  if (m_state.psResource) {
+    ID3D11Resource* resource = static_cast<NullShaderResourceView*>(m_state.psResource)->resource();
+    D3D11_RESOURCE_DIMENSION dimension = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+    resource->GetType(&dimension);
+    if (dimension == D3D11_RESOURCE_DIMENSION_TEXTURE2D) {
+      const NullTexture2D* texture = static_cast<NullTexture2D*>(static_cast<ID3D11Texture2D*>(resource));
+      if (!texture->m_data.empty()) {
+        draw.texture.texels = texture->m_data.data();
+        draw.texture.width = texture->desc().Width;
+        draw.texture.height = texture->desc().Height;
+      }
+    }
+  }
+  draw.viewport = m_state.viewport;
+
+  if (InstanceCount == 0) {
+    m_rasterizer->drawIndexed(draw);
+    return;
+  }
+
+  // Cada instancia trae en el slot 1 lo mismo que CBChangesEveryFrame: se dibuja
+  // como un draw con ese bloque en b2
+  const std::vector<unsigned char>* instances = bufferData(m_state.instanceBuffer);
+  if (!instances || m_state.instanceStride != sizeof(CBChangesEveryFrame)) {
+    ERROR(L"NullBackend", L"DrawIndexedInstanced", L"Instance buffer is not bound or has an unsupported stride");
+    return;
+  }
+  for (unsigned int i = 0; i < InstanceCount; ++i) {
+    const size_t offset = m_state.instanceOffset + (size_t)(StartInstanceLocation + i) * m_state.instanceStride;
+    if (offset + sizeof(CBChangesEveryFrame) > instances->size()) {
+      break;
+    }
+    draw.changesEveryFrame = instances->data() + offset;
+    m_rasterizer->drawIndexed(draw);
+  }
+}
+
+void
+NullBackend::beginFrame() {
+  if (m_frame != kNoFrame) {
+    endFrame();
+  }
+  m_frame = (unsigned int)m_frames.size();
+  m_frames.push_back(FrameStats());
+  m_frameStart = std::chrono::high_resolution_clock::now();
+}
+
+void
+NullBackend::endFrame() {
+  if (m_frame == kNoFrame) {
+    return;
+  }
+  m_frames.back().cpuMs = std::chrono::duration<double, std::milli>(
+    std::chrono::high_resolution_clock::now() - m_frameStart).count();
+  m_frame = kNoFrame;
+}
+
+void
+NullBackend::reset() {
+  m_state = PipelineState();
+  m_commands.clear();
+  m_frames.clear();
+  memset(m_callCounts, 0, sizeof(m_callCounts));
+  m_frame = kNoFrame;
+}
+
+const char*
+NullBackend::commandName(CommandType type) {
+  static const char* names[CMD_COUNT] = {
+    "CreateBuffer",
+    "CreateTexture2D",
+    "CreateRenderTargetView",
+    "CreateDepthStencilView",
+    "CreateShaderResourceView",
+    "CreateVertexShader",
+    "CreatePixelShader",
+    "CreateInputLayout",
+    "CreateSamplerState",
+    "CreateQuery",
+    "CompileShader",
+    "UpdateSubresource",
+    "Map",
+    "Unmap",
+    "RSSetViewports",
+    "RSSetState",
+    "IASetInputLayout",
+    "IASetVertexBuffers",
+    "IASetIndexBuffer",
+    "IASetPrimitiveTopology",
+    "VSSetShader",
+    "VSSetConstantBuffers",
+    "PSSetShader",
+    "PSSetConstantBuffers",
+    "PSSetShaderResources",
+    "PSSetSamplers",
+    "OMSetRenderTargets",
+    "OMSetBlendState",
+    "ClearRenderTargetView",
+    "ClearDepthStencilView",
+    "ClearState",
+    "DrawIndexed",
+    "DrawIndexedInstanced",
+    "Present",
+    "End",
+    "GetData"
+  };
+  return (type >= 0 && type < CMD_COUNT) ? names[type] : "Unknown";
+}
+
+void
+NullBackend::report(const std::string& label) const {
+  std::wostringstream wss;
+  const size_t frameCount = m_frames.size();
+
+  if (frameCount > 0) {
+    std::vector<double> times;
+    times.reserve(frameCount);
+    double totalMs = 0.0;
+    unsigned long long apiCalls = 0, stateCalls = 0, drawCalls = 0, indices = 0, bytes = 0;
+    for (const FrameStats& frame : m_frames) {
+      times.push_back(frame.cpuMs);
+      totalMs += frame.cpuMs;
+      apiCalls += frame.apiCalls;
+      stateCalls += frame.stateCalls;
+      drawCalls += frame.drawCalls;
+      indices += frame.indexCount;
+      bytes += frame.bytesUploaded;
+    }
+    std::sort(times.begin(), times.end());
+    const size_t p95 = (std::min)(frameCount - 1, (size_t)(frameCount * 0.95));
+
+    wss << label.c_str() << L": " << frameCount << L" frames, CPU ms avg "
+      << totalMs / frameCount << L" min " << times.front() << L" max " << times.back()
+      << L" p95 " << times[p95];
+    MESSAGE(L"NullBackend", L"report", wss.str());
+    wss.str(L"");
+
+    wss << L"  per frame: " << (double)apiCalls / frameCount << L" API calls ("
+      << (double)stateCalls / frameCount << L" state, "
+      << (double)drawCalls / frameCount << L" draws, "
+      << (double)indices / frameCount << L" indices, "
+      << (double)bytes / frameCount << L" bytes uploaded)";
+    MESSAGE(L"NullBackend", L"report", wss.str());
+    wss.str(L"");
+  }
+  else {
+    wss << label.c_str() << L": no frames recorded";
+    MESSAGE(L"NullBackend", L"report", wss.str());
+    wss.str(L"");
+  }
+
+  for (int i = 0; i < CMD_COUNT; ++i) {
+    if (m_callCounts[i] == 0) {
+      continue;
+    }
+    wss << L"  " << commandName((CommandType)i) << L": " << m_callCounts[i];
+    MESSAGE(L"NullBackend", L"report", wss.str());
+    wss.str(L"");
+  }
+
+  wss << L"  recorded commands: " << m_commands.size();
+  MESSAGE(L"NullBackend", L"report", wss.str());
+}
+
+bool
+NullBackend::reportLiveObjects(const std::string& label) const {
+  if (m_liveObjects != 0) {
+    ERROR(L"NullBackend", L"reportLiveObjects",
+      label.c_str() << L": " << m_liveObjects << L" live objects after teardown");
+    return false;
+  }
+  std::wostringstream wss;
+  wss << label.c_str() << L": 0 live objects after teardown";
+  MESSAGE(L"NullBackend", L"reportLiveObjects", wss.str());
+  return true;
+}
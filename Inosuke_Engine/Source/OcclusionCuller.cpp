@@ -0,0 +1,679 @@
+#include "OcclusionCuller.h"
+#include "MeshComponent.h"
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <emmintrin.h>
+
+namespace {
+  /// Tringulos por hilo a partir de los cuales conviene repartir las franjas.
+  const unsigned int kTrianglesPerThread = 256;
+
+  /// v * m con v = (x, y, z, 1) y m en convencin de vector fila.
+  inline XMFLOAT4
+  transformPoint(const XMFLOAT4X4& m, float x, float y, float z) {
+    return XMFLOAT4(x * m._11 + y * m._21 + z * m._31 + m._41,
+                    x * m._12 + y * m._22 + z * m._32 + m._42,
+                    x * m._13 + y * m._23 + z * m._33 + m._43,
+                    x * m._14 + y * m._24 + z * m._34 + m._44);
+  }
+
+  /// Punto del segmento (in, outside) sobre el plano cercano z = 0 de D3D.
+  inline XMFLOAT4
+  clipNear(const XMFLOAT4& in, const XMFLOAT4& outside) {
+    const float t = in.z / (in.z - outside.z);
+    return XMFLOAT4(in.x + (outside.x - in.x) * t,
+                    in.y + (outside.y - in.y) * t,
+                    0.0f,
+                    in.w + (outside.w - in.w) * t);
+  }
+
+  /// xorshift32: el benchmark usa la misma escena en cada corrida.
+  inline unsigned int nextRandom(unsigned int& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+  inline float randomRange(unsigned int& state, float minimum, float maximum) {
+    return minimum + (maximum - minimum) * ((nextRandom(state) & 0xffffff) / 16777215.0f);
+  }
+
+  inline double elapsedMs(const std::chrono::high_resolution_clock::time_point& start) {
+    return std::chrono::duration<double, std::milli>(
+      std::chrono::high_resolution_clock::now() - start).count();
+  }
+}
+
+HRESULT
+OcclusionCuller::init(unsigned int width, unsigned int height, unsigned int threads) {
+  if (width == 0 || height == 0) {
+    ERROR("OcclusionCuller", "init", "Width and height must be greater than zero");
+    return E_INVALIDARG;
+  }
+  destroy();
+
+  m_width = width;
+  m_height = height;
+  m_tilesX = (width + kTileWidth - 1) / kTileWidth;
+  m_bands = (height + kTileHeight - 1) / kTileHeight;
+  m_pitch = m_tilesX * kTileWidth;
+  m_depth.assign((size_t)m_pitch * m_bands * kTileHeight, 1.0f);
+  m_tileMax.assign((size_t)m_tilesX * m_bands, 1.0f);
+  m_bins.assign(m_bands, std::vector<unsigned int>());
+  m_threads = threads == 0 ? (std::max)(1u, std::thread::hardware_concurrency()) : threads;
+  m_stats = Stats();
+  beginFrame(XMMatrixIdentity());
+
+  std::wostringstream wss;
+  wss << width << L"x" << height << L", " << m_tilesX * m_bands << L" tiles, " << m_threads << L" threads";
+  MESSAGE(L"OcclusionCuller", L"init", wss.str());
+  return S_OK;
+}
+
+void
+OcclusionCuller::destroy() {
+  m_width = 0;
+  m_height = 0;
+  m_pitch = 0;
+  m_tilesX = 0;
+  m_bands = 0;
+  m_depth.clear();
+  m_tileMax.clear();
+  m_triangles.clear();
+  m_bins.clear();
+  m_clip.clear();
+}
+
+void
+OcclusionCuller::beginFrame(const XMMATRIX& viewProjection) {
+  XMStoreFloat4x4(&m_viewProjection, viewProjection);
+  m_triangles.clear();
+}
+
+void
+OcclusionCuller::addOccluder(const MeshComponent& mesh, const XMMATRIX& world, unsigned int lod) {
+  if (!isValid()) {
+    ERROR("OcclusionCuller", "addOccluder", "Call init() first");
+    return;
+  }
+  unsigned int indexOffset = 0;
+  unsigned int indexCount = (unsigned int)(std::max)(0, mesh.m_numIndex);
+  if (!mesh.m_lods.empty()) {
+    const MeshLod& level = mesh.m_lods[(std::min)(lod, (unsigned int)mesh.m_lods.size() - 1)];
+    indexOffset = level.indexOffset;
+    indexCount = level.indexCount;
+  }
+  indexCount = (std::min)(indexCount, (unsigned int)mesh.m_index.size() - (std::min)(indexOffset, (unsigned int)mesh.m_index.size()));
+
+  XMFLOAT4X4 transform;
+  XMStoreFloat4x4(&transform, world * XMLoadFloat4x4(&m_viewProjection));
+  m_clip.resize(mesh.m_vertex.size());
+  for (size_t i = 0; i < mesh.m_vertex.size(); ++i) {
+    const XMFLOAT3& p = mesh.m_vertex[i].Pos;
+    m_clip[i] = transformPoint(transform, p.x, p.y, p.z);
+  }
+
+  const unsigned int* indices = mesh.m_index.data() + indexOffset;
+  const size_t vertexCount = m_clip.size();
+  for (unsigned int i = 0; i + 2 < indexCount; i += 3) {
+    if (indices[i] >= vertexCount || indices[i + 1] >= vertexCount || indices[i + 2] >= vertexCount) {
+      continue;
+    }
+    const XMFLOAT4* vertex[3] = { &m_clip[indices[i]], &m_clip[indices[i + 1]], &m_clip[indices[i + 2]] };
+
+    // Descartar rpido los que quedan por completo fuera de un lado del frustum
+    if ((vertex[0]->x > vertex[0]->w && vertex[1]->x > vertex[1]->w && vertex[2]->x > vertex[2]->w) ||
+        (vertex[0]->x < -vertex[0]->w && vertex[1]->x < -vertex[1]->w && vertex[2]->x < -vertex[2]->w) ||
+        (vertex[0]->y > vertex[0]->w && vertex[1]->y > vertex[1]->w && vertex[2]->y > vertex[2]->w) ||
+        (vertex[0]->y < -vertex[0]->w && vertex[1]->y < -vertex[1]->w && vertex[2]->y < -vertex[2]->w)) {
+      continue;
+    }
+
+    const bool inside[3] = { vertex[0]->z >= 0.0f, vertex[1]->z >= 0.0f, vertex[2]->z >= 0.0f };
+    const int insideCount = (int)inside[0] + (int)inside[1] + (int)inside[2];
+    if (insideCount == 3) {
+      addTriangle(*vertex[0], *vertex[1], *vertex[2]);
+    }
+    else if (insideCount > 0) {
+      XMFLOAT4 polygon[4];
+      int polygonSize = 0;
+      for (int k = 0; k < 3; ++k) {
+        const int next = (k + 1) % 3;
+        if (inside[k]) {
+          polygon[polygonSize++] = *vertex[k];
+        }
+        if (inside[k] != inside[next]) {
+          polygon[polygonSize++] = inside[k]
+            ? clipNear(*vertex[k], *vertex[next])
+            : clipNear(*vertex[next], *vertex[k]);
+        }
+      }
+      for (int k = 1; k + 1 < polygonSize; ++k) {
+        addTriangle(polygon[0], polygon[k], polygon[k + 1]);
+      }
+    }
+  }
+  ++m_stats.occluders;
+  m_stats.triangles += indexCount / 3;
+}
+
+void
+OcclusionCuller::addTriangle(const XMFLOAT4& v0, const XMFLOAT4& v1, const XMFLOAT4& v2) {
+  const XMFLOAT4* vertex[3] = { &v0, &v1, &v2 };
+  float x[3], y[3], z[3];
+  for (int k = 0; k < 3; ++k) {
+    const float rcpW = 1.0f / vertex[k]->w;
+    // Centro del pixel en coordenadas enteras (igual que SoftwareRasterizer)
+    x[k] = (vertex[k]->x * rcpW * 0.5f + 0.5f) * m_width - 0.5f;
+    y[k] = (0.5f - vertex[k]->y * rcpW * 0.5f) * m_height - 0.5f;
+    z[k] = vertex[k]->z * rcpW;
+  }
+
+  // Positiva para tringulos horarios en pantalla (frente en D3D11); descarta traseros y NaN
+  const float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+  if (!(area > 0.0f)) {
+    return;
+  }
+
+  const float minX = (std::max)((std::min)({ x[0], x[1], x[2] }), 0.0f);
+  const float maxX = (std::min)((std::max)({ x[0], x[1], x[2] }), (float)(m_width - 1));
+  const float minY = (std::max)((std::min)({ y[0], y[1], y[2] }), 0.0f);
+  const float maxY = (std::min)((std::max)({ y[0], y[1], y[2] }), (float)(m_height - 1));
+  if (!(minX <= maxX) || !(minY <= maxY)) {
+    return;
+  }
+
+  Triangle triangle;
+  triangle.minX = (int)ceilf(minX);
+  triangle.maxX = (int)floorf(maxX);
+  triangle.minY = (int)ceilf(minY);
+  triangle.maxY = (int)floorf(maxY);
+  if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) {
+    return;
+  }
+
+  // E(p) >= 0 adentro; restar medio pixel en la direccin de la normal deja solo
+  // los pixeles que el tringulo cubre por completo
+  for (int edge = 0; edge < 3; ++edge) {
+    const int a = edge;
+    const int b = (edge + 1) % 3;
+    const float edgeA = -(y[b] - y[a]);
+    const float edgeB = x[b] - x[a];
+    triangle.edgeA[edge] = edgeA;
+    triangle.edgeB[edge] = edgeB;
+    triangle.edgeC[edge] = -(edgeA * x[a] + edgeB * y[a]) - 0.5f * (fabsf(edgeA) + fabsf(edgeB));
+  }
+
+  // Plano de z; medio pixel en la direccin de la pendiente da el valor ms lejano del pixel
+  const float invArea = 1.0f / area;
+  triangle.zA = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) * invArea;
+  triangle.zB = ((x[1] - x[0]) * (z[2] - z[0]) - (x[2] - x[0]) * (z[1] - z[0])) * invArea;
+  triangle.zC = z[0] - triangle.zA * x[0] - triangle.zB * y[0] + 0.5f * (fabsf(triangle.zA) + fabsf(triangle.zB));
+  triangle.zMax = (std::max)({ z[0], z[1], z[2] });
+
+  m_triangles.push_back(triangle);
+}
+
+void
+OcclusionCuller::rasterize(Path path, JobSystem* jobs) {
+  if (!isValid()) {
+    ERROR("OcclusionCuller", "rasterize", "Call init() first");
+    return;
+  }
+  const auto start = std::chrono::high_resolution_clock::now();
+
+  for (std::vector<unsigned int>& bin : m_bins) {
+    bin.clear();
+  }
+  for (unsigned int i = 0; i < (unsigned int)m_triangles.size(); ++i) {
+    const Triangle& triangle = m_triangles[i];
+    for (unsigned int band = triangle.minY / kTileHeight; band <= (unsigned int)triangle.maxY / kTileHeight; ++band) {
+      m_bins[band].push_back(i);
+    }
+  }
+
+  // Las franjas no comparten pixeles: cada hilo toma la siguiente libre
+  const unsigned int threads = (std::min)({ jobs ? jobs->getThreadCount() : m_threads, m_bands,
+    1u + (unsigned int)m_triangles.size() / kTrianglesPerThread });
+  if (jobs && threads > 1) {
+    jobs->parallelFor(m_bands, 1, [&](unsigned int begin, unsigned int end) {
+      for (unsigned int band = begin; band < end; ++band) {
+        rasterizeBand(band, path);
+      }
+    });
+  }
+  else {
+    std::atomic<unsigned int> nextBand(0);
+    auto worker = [&]() {
+      for (unsigned int band = nextBand++; band < m_bands; band = nextBand++) {
+        rasterizeBand(band, path);
+      }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+  }
+
+  ++m_stats.frames;
+  m_stats.trianglesRasterized += m_triangles.size();
+  m_stats.rasterMs += elapsedMs(start);
+}
+
+void
+OcclusionCuller::rasterizeBand(unsigned int band, Path path) {
+  const unsigned int y0 = band * kTileHeight;
+  const unsigned int y1 = (std::min)(y0 + kTileHeight, m_height);
+
+  // Pixeles reales en lejos; el relleno en 0 para que no suba el mximo del tile
+  float* bandDepth = m_depth.data() + (size_t)y0 * m_pitch;
+  for (unsigned int y = 0; y < kTileHeight; ++y) {
+    float* row = bandDepth + (size_t)y * m_pitch;
+    const unsigned int realWidth = y0 + y < y1 ? m_width : 0;
+    std::fill(row, row + realWidth, 1.0f);
+    std::fill(row + realWidth, row + m_pitch, 0.0f);
+  }
+
+  // Ambos caminos evalan las mismas operaciones en el mismo orden, as que
+  // escriben exactamente la misma profundidad
+  for (unsigned int index : m_bins[band]) {
+    const Triangle& t = m_triangles[index];
+    const int rowBegin = (std::max)((int)y0, t.minY);
+    const int rowEnd = (std::min)((int)y1 - 1, t.maxY);
+    for (int py = rowBegin; py <= rowEnd; ++py) {
+      float* row = m_depth.data() + (size_t)py * m_pitch;
+      const float fy = (float)py;
+      if (path == PATH_SCALAR) {
+        for (int px = t.minX; px <= t.maxX; ++px) {
+          const float fx = (float)px;
+          const float e0 = t.edgeA[0] * fx + t.edgeB[0] * fy + t.edgeC[0];
+          const float e1 = t.edgeA[1] * fx + t.edgeB[1] * fy + t.edgeC[1];
+          const float e2 = t.edgeA[2] * fx + t.edgeB[2] * fy + t.edgeC[2];
+          if (e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f) {
+            const float z = (std::min)(t.zA * fx + t.zB * fy + t.zC, t.zMax);
+            row[px] = (std::min)(row[px], z);
+          }
+        }
+        continue;
+      }
+
+      const __m128 y4 = _mm_set1_ps(fy);
+      const __m128 eBy0 = _mm_mul_ps(_mm_set1_ps(t.edgeB[0]), y4);
+      const __m128 eBy1 = _mm_mul_ps(_mm_set1_ps(t.edgeB[1]), y4);
+      const __m128 eBy2 = _mm_mul_ps(_mm_set1_ps(t.edgeB[2]), y4);
+      const __m128 zBy = _mm_mul_ps(_mm_set1_ps(t.zB), y4);
+      const __m128 zero = _mm_setzero_ps();
+      const __m128 far4 = _mm_set1_ps(INFINITY);
+      const __m128 maxX = _mm_set1_ps((float)t.maxX);
+      for (int px = t.minX & ~3; px <= t.maxX; px += 4) {
+        const __m128 x4 = _mm_add_ps(_mm_set1_ps((float)px), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+        const __m128 e0 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.edgeA[0]), x4), eBy0), _mm_set1_ps(t.edgeC[0]));
+        const __m128 e1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.edgeA[1]), x4), eBy1), _mm_set1_ps(t.edgeC[1]));
+        const __m128 e2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.edgeA[2]), x4), eBy2), _mm_set1_ps(t.edgeC[2]));
+        // Los pixeles fuera de la caja no pasan las aristas, salvo en el relleno a la derecha
+        const __m128 mask = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+          _mm_and_ps(_mm_cmpge_ps(e2, zero), _mm_cmple_ps(x4, maxX)));
+        if (_mm_movemask_ps(mask) == 0) {
+          continue;
+        }
+        const __m128 z = _mm_min_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.zA), x4), zBy), _mm_set1_ps(t.zC)),
+          _mm_set1_ps(t.zMax));
+        const __m128 masked = _mm_or_ps(_mm_and_ps(mask, z), _mm_andnot_ps(mask, far4));
+        _mm_storeu_ps(row + px, _mm_min_ps(_mm_loadu_ps(row + px), masked));
+      }
+    }
+  }
+
+  // Profundidad mxima de cada tile de la franja
+  for (unsigned int tile = 0; tile < m_tilesX; ++tile) {
+    float tileMax = 0.0f;
+    if (path == PATH_SCALAR) {
+      for (unsigned int y = 0; y < kTileHeight; ++y) {
+        const float* row = bandDepth + (size_t)y * m_pitch + tile * kTileWidth;
+        for (unsigned int x = 0; x < kTileWidth; ++x) {
+          tileMax = (std::max)(tileMax, row[x]);
+        }
+      }
+    }
+    else {
+      __m128 max4 = _mm_setzero_ps();
+      for (unsigned int y = 0; y < kTileHeight; ++y) {
+        const float* row = bandDepth + (size_t)y * m_pitch + tile * kTileWidth;
+        for (unsigned int x = 0; x < kTileWidth; x += 4) {
+          max4 = _mm_max_ps(max4, _mm_loadu_ps(row + x));
+        }
+      }
+      max4 = _mm_max_ps(max4, _mm_shuffle_ps(max4, max4, _MM_SHUFFLE(1, 0, 3, 2)));
+      max4 = _mm_max_ps(max4, _mm_shuffle_ps(max4, max4, _MM_SHUFFLE(2, 3, 0, 1)));
+      tileMax = _mm_cvtss_f32(max4);
+    }
+    m_tileMax[band * m_tilesX + tile] = tileMax;
+  }
+}
+
+bool
+OcclusionCuller::isVisible(const XMFLOAT3& center, const XMFLOAT3& extents, Path path) const {
+  ++m_stats.occludeesTested;
+
+  // Rectngulo en pantalla y profundidad ms cercana de las 8 esquinas. Cada
+  // esquina es el centro transformado ms o menos cada semieje transformado
+  const XMFLOAT4X4& m = m_viewProjection;
+  const float clipCenter[4] = {
+    center.x * m._11 + center.y * m._21 + center.z * m._31 + m._41,
+    center.x * m._12 + center.y * m._22 + center.z * m._32 + m._42,
+    center.x * m._13 + center.y * m._23 + center.z * m._33 + m._43,
+    center.x * m._14 + center.y * m._24 + center.z * m._34 + m._44 };
+  const float axisX[4] = { extents.x * m._11, extents.x * m._12, extents.x * m._13, extents.x * m._14 };
+  const float axisY[4] = { extents.y * m._21, extents.y * m._22, extents.y * m._23, extents.y * m._24 };
+  const float axisZ[4] = { extents.z * m._31, extents.z * m._32, extents.z * m._33, extents.z * m._34 };
+
+  float minX, maxX, minY, maxY, minZ;
+  if (path == PATH_SCALAR) {
+    minX = INFINITY, maxX = -INFINITY, minY = INFINITY, maxY = -INFINITY, minZ = INFINITY;
+    for (int corner = 0; corner < 8; ++corner) {
+      const float sx = (corner & 1) ? 1.0f : -1.0f;
+      const float sy = (corner & 2) ? 1.0f : -1.0f;
+      const float sz = (corner & 4) ? 1.0f : -1.0f;
+      float clip[4];
+      for (int k = 0; k < 4; ++k) {
+        clip[k] = clipCenter[k] + sx * axisX[k] + sy * axisY[k] + sz * axisZ[k];
+      }
+      if (!(clip[2] >= 0.0f) || !(clip[3] > 0.0f)) {
+        return true;   // Cruza el plano cercano
+      }
+      const float rcpW = 1.0f / clip[3];
+      const float x = (clip[0] * rcpW * 0.5f + 0.5f) * m_width - 0.5f;
+      const float y = (0.5f - clip[1] * rcpW * 0.5f) * m_height - 0.5f;
+      minX = (std::min)(minX, x);
+      maxX = (std::max)(maxX, x);
+      minY = (std::min)(minY, y);
+      maxY = (std::max)(maxY, y);
+      minZ = (std::min)(minZ, clip[2] * rcpW);
+    }
+  }
+  else {
+    // Las 8 esquinas en dos grupos de 4 (estructura de arreglos: x, y, z, w por separado)
+    const __m128 signX = _mm_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f);
+    const __m128 signY = _mm_setr_ps(-1.0f, -1.0f, 1.0f, 1.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 width = _mm_set1_ps((float)m_width);
+    const __m128 height = _mm_set1_ps((float)m_height);
+    __m128 minX4 = _mm_set1_ps(INFINITY), maxX4 = _mm_set1_ps(-INFINITY);
+    __m128 minY4 = minX4, maxY4 = maxX4, minZ4 = minX4;
+    __m128 behind = _mm_setzero_ps();
+    for (int group = 0; group < 2; ++group) {
+      const __m128 signZ = _mm_set1_ps(group ? 1.0f : -1.0f);
+      __m128 clip[4];
+      for (int k = 0; k < 4; ++k) {
+        clip[k] = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_set1_ps(clipCenter[k]),
+          _mm_mul_ps(signX, _mm_set1_ps(axisX[k]))), _mm_mul_ps(signY, _mm_set1_ps(axisY[k]))),
+          _mm_mul_ps(signZ, _mm_set1_ps(axisZ[k])));
+      }
+      // NaN tambin cuenta como cruce: cmpnge/cmpnle son verdaderos si no hay orden
+      behind = _mm_or_ps(behind, _mm_or_ps(_mm_cmpnge_ps(clip[2], _mm_setzero_ps()),
+        _mm_cmpngt_ps(clip[3], _mm_setzero_ps())));
+      const __m128 rcpW = _mm_div_ps(_mm_set1_ps(1.0f), clip[3]);
+      const __m128 x = _mm_sub_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(clip[0], rcpW), half), half), width), half);
+      const __m128 y = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(half, _mm_mul_ps(_mm_mul_ps(clip[1], rcpW), half)), height), half);
+      minX4 = _mm_min_ps(minX4, x);
+      maxX4 = _mm_max_ps(maxX4, x);
+      minY4 = _mm_min_ps(minY4, y);
+      maxY4 = _mm_max_ps(maxY4, y);
+      minZ4 = _mm_min_ps(minZ4, _mm_mul_ps(clip[2], rcpW));
+    }
+    if (_mm_movemask_ps(behind) != 0) {
+      return true;   // Cruza el plano cercano
+    }
+    float lanes[5][4];
+    _mm_storeu_ps(lanes[0], minX4);
+    _mm_storeu_ps(lanes[1], maxX4);
+    _mm_storeu_ps(lanes[2], minY4);
+    _mm_storeu_ps(lanes[3], maxY4);
+    _mm_storeu_ps(lanes[4], minZ4);
+    minX = (std::min)((std::min)(lanes[0][0], lanes[0][1]), (std::min)(lanes[0][2], lanes[0][3]));
+    maxX = (std::max)((std::max)(lanes[1][0], lanes[1][1]), (std::max)(lanes[1][2], lanes[1][3]));
+    minY = (std::min)((std::min)(lanes[2][0], lanes[2][1]), (std::min)(lanes[2][2], lanes[2][3]));
+    maxY = (std::max)((std::max)(lanes[3][0], lanes[3][1]), (std::max)(lanes[3][2], lanes[3][3]));
+    minZ = (std::min)((std::min)(lanes[4][0], lanes[4][1]), (std::min)(lanes[4][2], lanes[4][3]));
+  }
+
+  // Pixeles cuyo cuadrado toca el rectngulo
+  const int x0 = (int)(std::max)(ceilf(minX - 0.5f), 0.0f);
+  const int x1 = (int)(std::min)(floorf(maxX + 0.5f), (float)(m_width - 1));
+  const int y0 = (int)(std::max)(ceilf(minY - 0.5f), 0.0f);
+  const int y1 = (int)(std::min)(floorf(maxY + 0.5f), (float)(m_height - 1));
+  if (x0 > x1 || y0 > y1) {
+    ++m_stats.occludeesCulled;   // Fuera de pantalla
+    return false;
+  }
+
+  const __m128 minZ4 = _mm_set1_ps(minZ);
+  const __m128 x0f = _mm_set1_ps((float)x0);
+  const __m128 x1f = _mm_set1_ps((float)x1);
+  for (int tileY = y0 / (int)kTileHeight; tileY <= y1 / (int)kTileHeight; ++tileY) {
+    for (int tileX = x0 / (int)kTileWidth; tileX <= x1 / (int)kTileWidth; ++tileX) {
+      if (m_tileMax[tileY * m_tilesX + tileX] < minZ) {
+        ++m_stats.tilesRejected;   // Todos los pixeles del tile estn delante de la caja
+        continue;
+      }
+      const int rowBegin = (std::max)(y0, tileY * (int)kTileHeight);
+      const int rowEnd = (std::min)(y1, tileY * (int)kTileHeight + (int)kTileHeight - 1);
+      const int colBegin = (std::max)(x0, tileX * (int)kTileWidth);
+      const int colEnd = (std::min)(x1, tileX * (int)kTileWidth + (int)kTileWidth - 1);
+      for (int py = rowBegin; py <= rowEnd; ++py) {
+        const float* row = m_depth.data() + (size_t)py * m_pitch;
+        if (path == PATH_SCALAR) {
+          for (int px = colBegin; px <= colEnd; ++px) {
+            if (row[px] >= minZ) {
+              return true;
+            }
+          }
+          continue;
+        }
+        for (int px = colBegin & ~3; px <= colEnd; px += 4) {
+          const __m128 x4 = _mm_add_ps(_mm_set1_ps((float)px), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+          const __m128 inRange = _mm_and_ps(_mm_cmpge_ps(x4, x0f), _mm_cmple_ps(x4, x1f));
+          if (_mm_movemask_ps(_mm_and_ps(inRange, _mm_cmpge_ps(_mm_loadu_ps(row + px), minZ4))) != 0) {
+            return true;
+          }
+        }
+      }
+    }
+  }
+  ++m_stats.occludeesCulled;
+  return false;
+}
+
+void
+OcclusionCuller::report(const std::string& label) const {
+  std::wostringstream wss;
+  const double frames = (double)(std::max)(1ull, m_stats.frames);
+  wss << label.c_str() << L": " << m_width << L"x" << m_height << L", " << m_threads << L" threads, "
+    << m_stats.frames << L" frames, raster ms avg " << m_stats.rasterMs / frames;
+  MESSAGE(L"OcclusionCuller", L"report", wss.str());
+  wss.str(L"");
+
+  wss << L"  occluders " << m_stats.occluders << L", triangles " << m_stats.triangles << L" ("
+    << m_stats.trianglesRasterized << L" rasterized), occludees " << m_stats.occludeesTested << L" (culled "
+    << m_stats.occludeesCulled << L"), tiles rejected " << m_stats.tilesRejected;
+  MESSAGE(L"OcclusionCuller", L"report", wss.str());
+}
+
+bool
+OcclusionCuller::benchmark(unsigned int occludeeCount, int iterations) {
+  if (iterations < 1) iterations = 1;
+
+  // Caja unitaria con caras horarias vistas desde afuera (frente en D3D11)
+  MeshComponent box;
+  for (int corner = 0; corner < 8; ++corner) {
+    SimpleVertex vertex;
+    vertex.Pos = XMFLOAT3((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f);
+    vertex.Tex = XMFLOAT2(0.0f, 0.0f);
+    box.m_vertex.push_back(vertex);
+  }
+  const unsigned int faces[6][4] = {
+    { 0, 2, 3, 1 }, { 4, 5, 7, 6 }, { 0, 1, 5, 4 }, { 2, 6, 7, 3 }, { 0, 4, 6, 2 }, { 1, 3, 7, 5 }
+  };
+  for (const unsigned int* face : faces) {
+    const unsigned int quad[6] = { face[0], face[1], face[2], face[0], face[2], face[3] };
+    for (int i = 0; i < 6; i += 3) {
+      const XMFLOAT3& a = box.m_vertex[quad[i]].Pos;
+      const XMFLOAT3& b = box.m_vertex[quad[i + 1]].Pos;
+      const XMFLOAT3& c = box.m_vertex[quad[i + 2]].Pos;
+      // (b - a) x (c - a) apuntando hacia afuera = horario con la mano izquierda
+      const float nx = (b.y - a.y) * (c.z - a.z) - (b.z - a.z) * (c.y - a.y);
+      const float ny = (b.z - a.z) * (c.x - a.x) - (b.x - a.x) * (c.z - a.z);
+      const float nz = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+      const bool outward = nx * (a.x + b.x + c.x) + ny * (a.y + b.y + c.y) + nz * (a.z + b.z + c.z) > 0.0f;
+      box.m_index.push_back(quad[i]);
+      box.m_index.push_back(outward ? quad[i + 1] : quad[i + 2]);
+      box.m_index.push_back(outward ? quad[i + 2] : quad[i + 1]);
+    }
+  }
+  box.m_numVertex = (int)box.m_vertex.size();
+  box.m_numIndex = (int)box.m_index.size();
+
+  // Dos filas de paredes delante de la cmara con huecos entre ellas
+  struct Wall {
+    XMFLOAT3 center, extents;
+  };
+  std::vector<Wall> walls;
+  for (int i = 0; i < 11; ++i) {
+    walls.push_back({ XMFLOAT3(-150.0f + i * 30.0f, 0.0f, 40.0f), XMFLOAT3(13.0f, 12.0f, 0.5f) });
+    walls.push_back({ XMFLOAT3(-135.0f + i * 30.0f, 4.0f, 70.0f), XMFLOAT3(10.0f, 16.0f, 0.5f) });
+  }
+
+  const XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f),
+    XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+  const XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000.0f);
+  const XMMATRIX viewProjection = view * projection;
+
+  // Objetos detrs y delante de las paredes; solo los que pasan el frustum llegan a la prueba
+  std::vector<XMFLOAT3> centers(occludeeCount), extents(occludeeCount);
+  FrustumCuller frustumCuller;
+  unsigned int seed = 0x5eed0cc1u;
+  for (unsigned int i = 0; i < occludeeCount; ++i) {
+    centers[i] = XMFLOAT3(randomRange(seed, -250.0f, 250.0f), randomRange(seed, -40.0f, 40.0f), randomRange(seed, 2.0f, 400.0f));
+    extents[i] = XMFLOAT3(randomRange(seed, 0.3f, 1.5f), randomRange(seed, 0.3f, 1.5f), randomRange(seed, 0.3f, 1.5f));
+    frustumCuller.add(centers[i], extents[i], 0.0f);
+  }
+  const FrustumCuller::Frustum frustum = FrustumCuller::extractFrustum(viewProjection);
+  std::vector<unsigned int> candidates;
+  frustumCuller.cull(frustum, candidates, FrustumCuller::TEST_AABB);
+
+  OcclusionCuller culler;
+  if (FAILED(culler.init(256, 144))) {
+    return false;
+  }
+  auto drawOccluders = [&](Path path) {
+    culler.beginFrame(viewProjection);
+    for (const Wall& wall : walls) {
+      culler.addOccluder(box, XMMatrixScaling(wall.extents.x, wall.extents.y, wall.extents.z) *
+        XMMatrixTranslation(wall.center.x, wall.center.y, wall.center.z));
+    }
+    culler.rasterize(path);
+  };
+
+  bool ok = true;
+  const wchar_t* pathNames[2] = { L"sse", L"scalar" };
+  std::vector<float> referenceDepth;
+  std::vector<unsigned int> referenceVisible;
+  for (int p = PATH_SCALAR; p >= PATH_SSE; --p) {
+    const Path path = (Path)p;
+    culler.resetStats();
+    for (int i = 0; i < iterations; ++i) {
+      drawOccluders(path);
+    }
+    const double rasterMs = culler.m_stats.rasterMs / iterations;
+
+    std::vector<unsigned int> visible;
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+      visible.clear();
+      for (unsigned int index : candidates) {
+        if (culler.isVisible(centers[index], extents[index], path)) {
+          visible.push_back(index);
+        }
+      }
+    }
+    const double testNs = elapsedMs(start) * 1.0e6 / ((double)iterations * (std::max)((size_t)1, candidates.size()));
+
+    if (path == PATH_SCALAR) {
+      referenceDepth = culler.m_depth;
+      referenceVisible = visible;
+    }
+    else {
+      ok = ok && culler.m_depth == referenceDepth && visible == referenceVisible;
+    }
+
+    std::wostringstream wss;
+    wss << pathNames[p] << L": raster " << rasterMs << L" ms (" << walls.size() << L" occluders, "
+        << culler.m_stats.trianglesRasterized / iterations << L" triangles), test " << testNs << L" ns/object, "
+        << visible.size() << L"/" << candidates.size() << L" visible after frustum (" << occludeeCount
+        << L" objects), " << culler.m_stats.tilesRejected / iterations << L" tiles rejected";
+    MESSAGE(L"OcclusionCuller", L"benchmark", wss.str().c_str());
+  }
+
+  // Cada objeto descartado debe estar tapado de verdad: el segmento de la cmara
+  // a cualquiera de sus puntos dentro del frustum cruza una pared
+  auto pointHidden = [&](const XMFLOAT3& point) {
+    for (int plane = 0; plane < 6; ++plane) {
+      const XMFLOAT4& f = frustum.planes[plane];
+      if (f.x * point.x + f.y * point.y + f.z * point.z + f.w < 0.0f) {
+        return true;   // Fuera del frustum no se ve
+      }
+    }
+    for (const Wall& wall : walls) {
+      const float o[3] = { 0.0f, 0.0f, 0.0f };
+      const float d[3] = { point.x, point.y, point.z };
+      const float c[3] = { wall.center.x, wall.center.y, wall.center.z };
+      const float e[3] = { wall.extents.x, wall.extents.y, wall.extents.z };
+      float enter = 0.0f, exit = 1.0f;
+      for (int axis = 0; axis < 3 && enter <= exit; ++axis) {
+        float t1 = (c[axis] - e[axis] - o[axis]) / d[axis];
+        float t2 = (c[axis] + e[axis] - o[axis]) / d[axis];
+        if (t1 > t2) std::swap(t1, t2);
+        enter = (std::max)(enter, t1);
+        exit = (std::min)(exit, t2);
+      }
+      if (enter <= exit) {
+        return true;
+      }
+    }
+    return false;
+  };
+  std::vector<char> isVisibleObject(occludeeCount, 0);
+  for (unsigned int index : referenceVisible) isVisibleObject[index] = 1;
+  unsigned int checked = 0, leaks = 0;
+  for (unsigned int index : candidates) {
+    if (isVisibleObject[index]) {
+      continue;
+    }
+    ++checked;
+    const XMFLOAT3& c = centers[index];
+    const XMFLOAT3& e = extents[index];
+    for (int sample = 0; sample < 16; ++sample) {
+      const XMFLOAT3 point = sample < 8
+        ? XMFLOAT3(c.x + ((sample & 1) ? e.x : -e.x), c.y + ((sample & 2) ? e.y : -e.y), c.z + ((sample & 4) ? e.z : -e.z))
+        : XMFLOAT3(c.x + randomRange(seed, -e.x, e.x), c.y + randomRange(seed, -e.y, e.y), c.z + randomRange(seed, -e.z, e.z));
+      if (!pointHidden(point)) {
+        ++leaks;
+        break;
+      }
+    }
+  }
+  ok = ok && leaks == 0;
+
+  std::wostringstream wss;
+  wss << L"  " << checked << L" culled objects checked against the walls, " << leaks << L" with a visible point";
+  MESSAGE(L"OcclusionCuller", L"benchmark", wss.str().c_str());
+  if (!ok) {
+    ERROR(L"OcclusionCuller", L"benchmark", L"SSE differs from the scalar path or a culled object is visible");
+  }
+  return ok;
+}
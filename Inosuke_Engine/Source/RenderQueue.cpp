@@ -0,0 +1,910 @@
+#include "RenderQueue.h"
+#include "Buffer.h"
+#include "CommandList.h"
+#include "ConstantBuffer.h"
+#include "ConstantBufferRing.h"
+#include "Device.h"
+#include "DeviceContext.h"
+#include "HeadlessDevice.h"
+#include "InstanceBuffer.h"
+#include "JobSystem.h"
+#include "NullBackend.h"
+#include "SamplerState.h"
+#include "SoftwareRasterizer.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include "VertexQuantizer.h"
+#include <chrono>
+
+namespace {
+  const unsigned int kDepthBits = 20;
+  const unsigned int kDepthMax = (1u << kDepthBits) - 1;
+  const unsigned int kShaderMask = 0xfff;
+  const unsigned int kTextureMask = 0xfff;
+  const unsigned int kSamplerMask = 0xf;
+  const unsigned int kMeshMask = 0xfff;
+
+  const unsigned int kRadixBits = 8;
+  const unsigned int kRadixBuckets = 1u << kRadixBits;
+  const unsigned int kRadixPasses = 64 / kRadixBits;
+
+  /// xorshift32: el benchmark usa la misma escena en cada corrida.
+  inline unsigned int nextRandom(unsigned int& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+  inline double elapsedMs(const std::chrono::high_resolution_clock::time_point& start) {
+    return std::chrono::duration<double, std::milli>(
+      std::chrono::high_resolution_clock::now() - start).count();
+  }
+}
+
+void
+RenderQueue::setDepthRange(float nearZ, float farZ) {
+  if (!(farZ > nearZ)) {
+    ERROR(L"RenderQueue", L"setDepthRange", L"farZ must be greater than nearZ");
+    return;
+  }
+  m_nearZ = nearZ;
+  m_depthScale = 1.0f / (farZ - nearZ);
+}
+
+void
+RenderQueue::begin() {
+  m_packets.clear();
+  m_entries.clear();
+}
+
+unsigned int
+RenderQueue::lookupId(IdTable& table, const void* object, unsigned int mask) {
+  if (object == table.last) {
+    return table.lastId;
+  }
+  auto it = table.ids.find(object);
+  if (it == table.ids.end()) {
+    it = table.ids.emplace(object, (unsigned int)table.ids.size() & mask).first;
+  }
+  table.last = object;
+  table.lastId = it->second;
+  return it->second;
+}
+
+unsigned long long
+RenderQueue::makeKey(Pass pass,
+  unsigned int depth,
+  unsigned int shaderId,
+  unsigned int textureId,
+  unsigned int samplerId,
+  unsigned int meshId) {
+  const unsigned long long state =
+    ((unsigned long long)shaderId << 28) |
+    ((unsigned long long)textureId << 16) |
+    ((unsigned long long)samplerId << 12) |
+    (unsigned long long)meshId;
+  if (pass == PASS_TRANSPARENT) {
+    // De atrs hacia adelante: la profundidad completa manda sobre el estado
+    return ((unsigned long long)pass << 60) |
+           ((unsigned long long)(kDepthMax - depth) << 40) |
+           state;
+  }
+  return ((unsigned long long)pass << 60) |
+         ((unsigned long long)(depth >> 16) << 56) |
+         (state << 16) |
+         (unsigned long long)(depth & 0xffff);
+}
+
+void
+RenderQueue::submit(const DrawPacket& packet, float viewDepth, Pass pass) {
+  if (!packet.vertexBuffer || !packet.indexBuffer || !packet.shader) {
+    ERROR(L"RenderQueue", L"submit", L"Packet without vertex buffer, index buffer or shader");
+    return;
+  }
+
+  float depth = (viewDepth - m_nearZ) * m_depthScale;
+  depth = depth > 0.0f ? (std::min)(depth, 1.0f) : 0.0f;   // Tambin descarta NaN
+
+  SortEntry entry;
+  entry.key = makeKey(pass,
+    (unsigned int)(depth * kDepthMax),
+    lookupId(m_shaderIds, packet.shader, kShaderMask),
+    lookupId(m_textureIds, packet.texture, kTextureMask),
+    lookupId(m_samplerIds, packet.sampler, kSamplerMask),
+    lookupId(m_meshIds, packet.vertexBuffer, kMeshMask));
+  entry.index = (unsigned int)m_packets.size();
+
+  m_packets.push_back(packet);
+  m_entries.push_back(entry);
+}
+
+void
+RenderQueue::sort() {
+  const auto start = std::chrono::high_resolution_clock::now();
+  const size_t count = m_entries.size();
+  m_stats.packets = (unsigned int)count;
+  m_stats.sortPasses = 0;
+
+  // Un recorrido arma los histogramas de los 8 dgitos
+  std::vector<unsigned int> histograms(kRadixPasses * kRadixBuckets, 0);
+  for (const SortEntry& entry : m_entries) {
+    for (unsigned int pass = 0; pass < kRadixPasses; ++pass) {
+      ++histograms[pass * kRadixBuckets + ((entry.key >> (pass * kRadixBits)) & (kRadixBuckets - 1))];
+    }
+  }
+
+  m_scratch.resize(count);
+  for (unsigned int pass = 0; pass < kRadixPasses; ++pass) {
+    unsigned int* histogram = &histograms[pass * kRadixBuckets];
+    const unsigned int shift = pass * kRadixBits;
+
+    // Si todas las llaves comparten el dgito la pasada no cambia nada
+    if (count == 0 || histogram[(m_entries[0].key >> shift) & (kRadixBuckets - 1)] == count) {
+      continue;
+    }
+
+    unsigned int offset = 0;
+    for (unsigned int bucket = 0; bucket < kRadixBuckets; ++bucket) {
+      const unsigned int bucketCount = histogram[bucket];
+      histogram[bucket] = offset;
+      offset += bucketCount;
+    }
+    for (const SortEntry& entry : m_entries) {
+      m_scratch[histogram[(entry.key >> shift) & (kRadixBuckets - 1)]++] = entry;
+    }
+    m_entries.swap(m_scratch);
+    ++m_stats.sortPasses;
+  }
+  m_stats.sortMs = elapsedMs(start);
+}
+
+void
+RenderQueue::execute(DeviceContext& deviceContext, Buffer& objectConstants) {
+  executePackets(deviceContext, &objectConstants, nullptr, nullptr);
+}
+
+void
+RenderQueue::execute(DeviceContext& deviceContext, ConstantBufferRing& ring) {
+  executePackets(deviceContext, nullptr, &ring, nullptr);
+}
+
+void
+RenderQueue::execute(DeviceContext& deviceContext, ConstantBufferRing& ring, InstanceBuffer& instances) {
+  executePackets(deviceContext, nullptr, &ring, &instances);
+}
+
+void
+RenderQueue::executeDeferred(DeviceContext& deviceContext,
+  std::vector<DeviceContext>& contexts,
+  std::vector<CommandList>& lists,
+  Buffer& objectConstants,
+  JobSystem& jobs,
+  BindFunction bindFrameState,
+  void* data) {
+  const unsigned int listCount = (unsigned int)(std::min)(contexts.size(), lists.size());
+  if (listCount == 0) {
+    ERROR(L"RenderQueue", L"executeDeferred", L"No deferred contexts or command lists");
+    return;
+  }
+  const auto start = std::chrono::high_resolution_clock::now();
+  m_rangeStats.assign(listCount, Stats());
+
+  // El rango i siempre va a la lista i: el orden no depende del hilo que la grabe
+  const size_t packetCount = m_entries.size();
+  jobs.parallelFor(listCount, 1, [&](unsigned int first, unsigned int last) {
+    for (unsigned int i = first; i < last; ++i) {
+      const auto listStart = std::chrono::high_resolution_clock::now();
+      DeviceContext& context = contexts[i];
+      context.beginRecording(lists[i]);
+      if (bindFrameState) {
+        bindFrameState(data, context);
+      }
+      recordPackets(context, packetCount * i / listCount, packetCount * (i + 1) / listCount,
+        &objectConstants, nullptr, nullptr, m_rangeStats[i], m_instanceData);
+      context.finishRecording();
+      m_rangeStats[i].recordMs = elapsedMs(listStart);
+    }
+  });
+  m_stats.recordMs = elapsedMs(start);
+
+  const auto mergeStart = std::chrono::high_resolution_clock::now();
+  for (unsigned int i = 0; i < listCount; ++i) {
+    deviceContext.ExecuteCommandList(lists[i]);
+  }
+  m_stats.mergeMs = elapsedMs(mergeStart);
+
+  m_stats.shaderChanges = 0;
+  m_stats.textureChanges = 0;
+  m_stats.samplerChanges = 0;
+  m_stats.meshChanges = 0;
+  m_stats.drawCalls = 0;
+  m_stats.instancedBatches = 0;
+  m_stats.instancedPackets = 0;
+  m_stats.recordThreadMs = 0.0;
+  for (const Stats& range : m_rangeStats) {
+    m_stats.shaderChanges += range.shaderChanges;
+    m_stats.textureChanges += range.textureChanges;
+    m_stats.samplerChanges += range.samplerChanges;
+    m_stats.meshChanges += range.meshChanges;
+    m_stats.drawCalls += range.drawCalls;
+    m_stats.recordThreadMs += range.recordMs;
+  }
+  m_stats.executeMs = elapsedMs(start);
+}
+
+bool
+RenderQueue::canBatch(const DrawPacket& a, const DrawPacket& b) {
+  return a.instancedShader && a.instancedShader == b.instancedShader && a.shader == b.shader &&
+         a.vertexBuffer == b.vertexBuffer && a.indexBuffer == b.indexBuffer &&
+         a.texture == b.texture && a.sampler == b.sampler &&
+         a.indexCount == b.indexCount && a.startIndex == b.startIndex && a.baseVertex == b.baseVertex;
+}
+
+void
+RenderQueue::executePackets(DeviceContext& deviceContext,
+  Buffer* objectConstants,
+  ConstantBufferRing* ring,
+  InstanceBuffer* instances) {
+  const auto start = std::chrono::high_resolution_clock::now();
+  m_stats.shaderChanges = 0;
+  m_stats.textureChanges = 0;
+  m_stats.samplerChanges = 0;
+  m_stats.meshChanges = 0;
+  m_stats.drawCalls = 0;
+  m_stats.instancedBatches = 0;
+  m_stats.instancedPackets = 0;
+  recordPackets(deviceContext, 0, m_entries.size(), objectConstants, ring, instances, m_stats, m_instanceData);
+  m_stats.executeMs = elapsedMs(start);
+}
+
+void
+RenderQueue::recordPackets(DeviceContext& deviceContext,
+  size_t begin,
+  size_t end,
+  Buffer* objectConstants,
+  ConstantBufferRing* ring,
+  InstanceBuffer* instances,
+  Stats& stats,
+  std::vector<CBChangesEveryFrame>& instanceData) const {
+  if (objectConstants) {
+    objectConstants->render(deviceContext, 2, 1);
+    objectConstants->render(deviceContext, 2, 1, true);
+  }
+  const unsigned int maxBatch = (instances && instances->isValid()) ? instances->capacity() : 1;
+
+  // Lo ltimo enlazado por esta cola; el primer paquete siempre enlaza todo
+  const ShaderProgram* shader = nullptr;
+  const Buffer* vertexBuffer = nullptr;
+  const Buffer* indexBuffer = nullptr;
+  const Texture* texture = nullptr;
+  const SamplerState* sampler = nullptr;
+
+  for (size_t i = begin; i < end;) {
+    const DrawPacket& packet = m_packets[m_entries[i].index];
+
+    // Vecinos agrupables con este paquete
+    size_t runEnd = i + 1;
+    while (runEnd < end && runEnd - i < maxBatch &&
+           canBatch(packet, m_packets[m_entries[runEnd].index])) {
+      ++runEnd;
+    }
+    const unsigned int runLength = (unsigned int)(runEnd - i);
+    const bool instanced = runLength >= kMinBatchSize;
+    if (!instanced) {
+      runEnd = i + 1;
+    }
+
+    ShaderProgram* packetShader = instanced ? packet.instancedShader : packet.shader;
+    if (packetShader != shader) {
+      packetShader->render(deviceContext);
+      shader = packetShader;
+      ++stats.shaderChanges;
+    }
+    if (packet.vertexBuffer != vertexBuffer || packet.indexBuffer != indexBuffer) {
+      packet.vertexBuffer->render(deviceContext, 0, 1);
+      packet.indexBuffer->render(deviceContext, 0, 1);
+      vertexBuffer = packet.vertexBuffer;
+      indexBuffer = packet.indexBuffer;
+      ++stats.meshChanges;
+    }
+    if (packet.texture && packet.texture != texture) {
+      packet.texture->render(deviceContext, 0, 1);
+      texture = packet.texture;
+      ++stats.textureChanges;
+    }
+    if (packet.sampler && packet.sampler != sampler) {
+      packet.sampler->render(deviceContext, 0, 1);
+      sampler = packet.sampler;
+      ++stats.samplerChanges;
+    }
+
+    if (instanced) {
+      instanceData.clear();
+      for (size_t j = i; j < runEnd; ++j) {
+        instanceData.push_back(m_packets[m_entries[j].index].constants);
+      }
+      unsigned int firstInstance = 0;
+      if (instances->push(deviceContext, instanceData.data(), runLength, firstInstance)) {
+        instances->render(deviceContext);
+        deviceContext.DrawIndexedInstanced(packet.indexCount, runLength, packet.startIndex, packet.baseVertex,
+          firstInstance);
+        ++stats.drawCalls;
+        ++stats.instancedBatches;
+        stats.instancedPackets += runLength;
+      }
+      i = runEnd;
+      continue;
+    }
+
+    if (objectConstants) {
+      objectConstants->update(deviceContext, nullptr, 0, nullptr, &packet.constants, 0, 0);
+    }
+    else {
+      ConstantBufferRing::Allocation allocation;
+      if (!ring->push(deviceContext, &packet.constants, sizeof(CBChangesEveryFrame), allocation)) {
+        ++i;
+        continue;
+      }
+      ring->bind(deviceContext, 2, allocation, true);
+    }
+    deviceContext.DrawIndexed(packet.indexCount, packet.startIndex, packet.baseVertex);
+    ++stats.drawCalls;
+    ++i;
+  }
+}
+
+void
+RenderQueue::clear() {
+  begin();
+  m_scratch.clear();
+  m_shaderIds = IdTable();
+  m_textureIds = IdTable();
+  m_samplerIds = IdTable();
+  m_meshIds = IdTable();
+}
+
+bool
+RenderQueue::benchmark(unsigned int packetCount, int frames) {
+  if (frames < 1) frames = 1;
+
+  const unsigned int kShaders = 8, kTextures = 64, kSamplers = 2, kMeshes = 16;
+
+  // Sin GPU: los Set* y draws solo pasan por DeviceContext y NullBackend
+  HeadlessDevice headless;
+  NullBackend& backend = headless.m_backend;
+  Device& device = headless.m_device;
+  DeviceContext& deviceContext = headless.m_deviceContext;
+
+  bool ok = true;
+  std::vector<ShaderProgram> shaders(kShaders);
+  for (ShaderProgram& shader : shaders) {
+    ok = ok && SUCCEEDED(shader.init(device, "Inosuke_Engine.fx",
+      VertexQuantizer::inputLayout(VertexQuantizer::FORMAT_FLOAT)));
+  }
+
+  std::vector<Texture> images(kTextures), textures(kTextures);
+  for (unsigned int i = 0; i < kTextures && ok; ++i) {
+    ok = SUCCEEDED(images[i].init(device, 4, 4, DXGI_FORMAT_R8G8B8A8_UNORM, D3D11_BIND_SHADER_RESOURCE, 1, 0)) &&
+         SUCCEEDED(textures[i].init(device, images[i], DXGI_FORMAT_R8G8B8A8_UNORM));
+  }
+
+  std::vector<SamplerState> samplers(kSamplers);
+  for (SamplerState& sampler : samplers) {
+    ok = ok && SUCCEEDED(sampler.init(device));
+  }
+
+  MeshComponent triangle;
+  triangle.m_vertex = {
+    { XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT2(0.5f, 0.0f) },
+    { XMFLOAT3(1.0f, -1.0f, 0.0f), XMFLOAT2(1.0f, 1.0f) },
+    { XMFLOAT3(-1.0f, -1.0f, 0.0f), XMFLOAT2(0.0f, 1.0f) }
+  };
+  triangle.m_index = { 0, 1, 2 };
+  triangle.m_numVertex = 3;
+  triangle.m_numIndex = 3;
+  triangle.selectIndexFormat();
+  std::vector<Buffer> vertexBuffers(kMeshes), indexBuffers(kMeshes);
+  for (unsigned int i = 0; i < kMeshes && ok; ++i) {
+    ok = SUCCEEDED(vertexBuffers[i].init(device, triangle, D3D11_BIND_VERTEX_BUFFER)) &&
+         SUCCEEDED(indexBuffers[i].init(device, triangle, D3D11_BIND_INDEX_BUFFER));
+  }
+
+  Buffer objectConstants;
+  ok = ok && SUCCEEDED(objectConstants.init(device, sizeof(CBChangesEveryFrame)));
+  ConstantBufferRing ring;
+  ok = ok && SUCCEEDED(ring.init(device, 8 * 1024 * 1024));
+  if (!ok) {
+    ERROR(L"RenderQueue", L"benchmark", L"Failed to create the benchmark resources");
+    return false;
+  }
+
+  // Escena fija: cada objeto toma shader, material y malla al azar
+  struct Object {
+    unsigned int shader, texture, sampler, mesh;
+    float depth;
+    Pass pass;
+  };
+  std::vector<Object> objects(packetCount);
+  unsigned int seed = 0x1234567u;
+  for (Object& object : objects) {
+    object.shader = nextRandom(seed) % kShaders;
+    object.texture = nextRandom(seed) % kTextures;
+    object.sampler = nextRandom(seed) % kSamplers;
+    object.mesh = nextRandom(seed) % kMeshes;
+    object.depth = 1.0f + (nextRandom(seed) % 100000) * 0.001f;
+    object.pass = (nextRandom(seed) % 10) == 0 ? PASS_TRANSPARENT : PASS_OPAQUE;
+  }
+
+  RenderQueue queue;
+  queue.setDepthRange(1.0f, 101.0f);
+  double submitMs = 0.0, sortMs = 0.0, executeMs = 0.0, ringExecuteMs = 0.0;
+  bool sorted = true;
+  for (int frame = 0; frame < frames; ++frame) {
+    deviceContext.beginFrame();
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    queue.begin();
+    for (unsigned int i = 0; i < packetCount; ++i) {
+      const Object& object = objects[i];
+      DrawPacket packet;
+      packet.vertexBuffer = &vertexBuffers[object.mesh];
+      packet.indexBuffer = &indexBuffers[object.mesh];
+      packet.shader = &shaders[object.shader];
+      packet.texture = &textures[object.texture];
+      packet.sampler = &samplers[object.sampler];
+      packet.indexCount = 3;
+      packet.constants.mWorld = XMMatrixTranspose(XMMatrixTranslation(0.0f, 0.0f, object.depth));
+      packet.constants.vMeshColor = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+      queue.submit(packet, object.depth, object.pass);
+    }
+    submitMs += elapsedMs(start);
+
+    queue.sort();
+    sortMs += queue.m_stats.sortMs;
+    for (size_t i = 1; i < queue.size(); ++i) {
+      sorted = sorted && queue.sortedKey(i - 1) <= queue.sortedKey(i);
+    }
+
+    queue.execute(deviceContext, objectConstants);
+    executeMs += queue.m_stats.executeMs;
+
+    // Mismo cuadro con las constantes en el anillo; Present() avanza los fences
+    ring.beginFrame(deviceContext);
+    queue.execute(deviceContext, ring);
+    ringExecuteMs += queue.m_stats.executeMs;
+    ring.endFrame(deviceContext);
+    deviceContext.endFrame();
+    backend.Present();
+  }
+
+  // Cambios de estado si se dibujara en el orden de envo
+  unsigned int unsortedChanges = 0;
+  for (unsigned int i = 0; i < packetCount; ++i) {
+    const Object& object = objects[i];
+    const Object* previous = i > 0 ? &objects[i - 1] : nullptr;
+    unsortedChanges += !previous || previous->shader != object.shader;
+    unsortedChanges += !previous || previous->texture != object.texture;
+    unsortedChanges += !previous || previous->sampler != object.sampler;
+    unsortedChanges += !previous || previous->mesh != object.mesh;
+  }
+  const Stats& stats = queue.m_stats;
+  const unsigned int sortedChanges =
+    stats.shaderChanges + stats.textureChanges + stats.samplerChanges + stats.meshChanges;
+
+  std::wostringstream wss;
+  wss << packetCount << L" packets x " << frames << L" frames: submit " << submitMs / frames
+      << L" ms, sort " << sortMs / frames << L" ms (" << stats.sortPasses << L" radix passes), execute "
+      << executeMs / frames << L" ms (ring " << ringExecuteMs / frames << L" ms) per frame; state changes " << sortedChanges
+      << L" (shader " << stats.shaderChanges << L", texture " << stats.textureChanges
+      << L", sampler " << stats.samplerChanges << L", mesh " << stats.meshChanges
+      << L") vs " << unsortedChanges << L" in submission order";
+  MESSAGE(L"RenderQueue", L"benchmark", wss.str().c_str());
+  deviceContext.reportStateStats("RenderQueue::benchmark");
+  ring.report("RenderQueue::benchmark");
+
+  deviceContext.ClearState();
+  objectConstants.destroy();
+  ring.destroy();
+  for (unsigned int i = 0; i < kMeshes; ++i) {
+    vertexBuffers[i].destroy();
+    indexBuffers[i].destroy();
+  }
+  for (SamplerState& sampler : samplers) sampler.destroy();
+  for (unsigned int i = 0; i < kTextures; ++i) {
+    textures[i].destroy();
+    images[i].destroy();
+  }
+  for (ShaderProgram& shader : shaders) shader.destroy();
+
+  if (!sorted) {
+    ERROR(L"RenderQueue", L"benchmark", L"The queue is not sorted by key");
+    return false;
+  }
+  return true;
+}
+
+bool
+RenderQueue::benchmarkInstancing(unsigned int packetCount, int frames) {
+  if (frames < 1) frames = 1;
+
+  const unsigned int kTextures = 4, kMeshes = 4;
+
+  HeadlessDevice headless;
+  NullBackend& backend = headless.m_backend;
+  Device& device = headless.m_device;
+  DeviceContext& deviceContext = headless.m_deviceContext;
+
+  std::vector<D3D11_INPUT_ELEMENT_DESC> instancedLayout = VertexQuantizer::inputLayout(VertexQuantizer::FORMAT_FLOAT);
+  InstanceBuffer::appendLayout(instancedLayout);
+  ShaderProgram shader, instancedShader;
+  bool ok = SUCCEEDED(shader.init(device, "Inosuke_Engine.fx",
+                        VertexQuantizer::inputLayout(VertexQuantizer::FORMAT_FLOAT))) &&
+            SUCCEEDED(instancedShader.init(device, "Inosuke_Engine_Instanced.fx", instancedLayout, "VSInstanced",
+                                           "PSInstanced"));
+
+  std::vector<Texture> images(kTextures), textures(kTextures);
+  for (unsigned int i = 0; i < kTextures && ok; ++i) {
+    ok = SUCCEEDED(images[i].init(device, 4, 4, DXGI_FORMAT_R8G8B8A8_UNORM, D3D11_BIND_SHADER_RESOURCE, 1, 0)) &&
+         SUCCEEDED(textures[i].init(device, images[i], DXGI_FORMAT_R8G8B8A8_UNORM));
+  }
+  SamplerState sampler;
+  ok = ok && SUCCEEDED(sampler.init(device));
+
+  MeshComponent triangle;
+  triangle.m_vertex = {
+    { XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT2(0.5f, 0.0f) },
+    { XMFLOAT3(1.0f, -1.0f, 0.0f), XMFLOAT2(1.0f, 1.0f) },
+    { XMFLOAT3(-1.0f, -1.0f, 0.0f), XMFLOAT2(0.0f, 1.0f) }
+  };
+  triangle.m_index = { 0, 1, 2 };
+  triangle.m_numVertex = 3;
+  triangle.m_numIndex = 3;
+  triangle.selectIndexFormat();
+  std::vector<Buffer> vertexBuffers(kMeshes), indexBuffers(kMeshes);
+  for (unsigned int i = 0; i < kMeshes && ok; ++i) {
+    ok = SUCCEEDED(vertexBuffers[i].init(device, triangle, D3D11_BIND_VERTEX_BUFFER)) &&
+         SUCCEEDED(indexBuffers[i].init(device, triangle, D3D11_BIND_INDEX_BUFFER));
+  }
+
+  ConstantBuffer<CBNeverChanges> cbView;
+  ConstantBuffer<CBChangeOnResize> cbProjection;
+  ConstantBufferRing ring;
+  InstanceBuffer instances;
+  ok = ok && SUCCEEDED(cbView.init(device, UPDATE_STATIC)) &&
+       SUCCEEDED(cbProjection.init(device, UPDATE_ON_RESIZE)) &&
+       SUCCEEDED(ring.init(device, 8 * 1024 * 1024)) &&
+       SUCCEEDED(instances.init(device, 64 * 1024));
+  if (!ok) {
+    ERROR(L"RenderQueue", L"benchmarkInstancing", L"Failed to create the benchmark resources");
+    return false;
+  }
+
+  auto makePacket = [&](unsigned int index, float x, float y, float z) {
+    DrawPacket packet;
+    packet.vertexBuffer = &vertexBuffers[index % kMeshes];
+    packet.indexBuffer = &indexBuffers[index % kMeshes];
+    packet.shader = &shader;
+    packet.instancedShader = &instancedShader;
+    packet.texture = &textures[(index / kMeshes) % kTextures];
+    packet.sampler = &sampler;
+    packet.indexCount = 3;
+    packet.constants.mWorld = XMMatrixTranspose(XMMatrixScaling(0.4f, 0.4f, 0.4f) * XMMatrixTranslation(x, y, z));
+    packet.constants.vMeshColor = XMFLOAT4((index % 3) * 0.5f, (index % 5) * 0.25f, 1.0f, 1.0f);
+    return packet;
+  };
+
+  // 1) Misma escena sin y con instancias en el rasterizador por software
+  SoftwareRasterizer rasterizer;
+  ok = SUCCEEDED(rasterizer.init(128, 128));
+  backend.m_rasterizer = &rasterizer;
+  CBNeverChanges view;
+  view.mView = XMMatrixTranspose(XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, -10.0f, 0.0f),
+    XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)));
+  CBChangeOnResize projection;
+  projection.mProjection = XMMatrixTranspose(XMMatrixPerspectiveFovLH(XM_PIDIV4, 1.0f, 0.01f, 100.0f));
+  cbView.set(view);
+  cbProjection.set(projection);
+  D3D11_VIEWPORT viewport = { 0.0f, 0.0f, 128.0f, 128.0f, 0.0f, 1.0f };
+
+  RenderQueue queue;
+  queue.setDepthRange(1.0f, 101.0f);
+  unsigned long long checksums[2] = {};
+  for (int path = 0; path < 2 && ok; ++path) {
+    const float clearColor[4] = { 0.0f, 0.125f, 0.3f, 1.0f };
+    rasterizer.clearColor(clearColor);
+    rasterizer.clearDepth(1.0f);
+    deviceContext.RSSetViewports(1, &viewport);
+    cbView.flush(deviceContext);
+    cbProjection.flush(deviceContext);
+    cbView.render(deviceContext, 0);
+    cbProjection.render(deviceContext, 1);
+
+    queue.begin();
+    for (unsigned int i = 0; i < 64; ++i) {
+      const float x = (float)(i % 8) - 3.5f, y = (float)(i / 8) - 3.5f, z = (float)(i % 7) * 0.1f;
+      queue.submit(makePacket(i, x, y, z), 10.0f + z);
+    }
+    queue.sort();
+    if (path == 0) {
+      queue.execute(deviceContext, ring);
+    }
+    else {
+      queue.execute(deviceContext, ring, instances);
+    }
+    checksums[path] = rasterizer.checksum();
+  }
+  const bool imagesMatch = ok && rasterizer.m_stats.pixelsWritten > 0 && checksums[0] == checksums[1];
+  backend.m_rasterizer = nullptr;
+  rasterizer.destroy();
+
+  // 2) Muchas copias de pocas mallas: un draw por paquete contra un draw por lote
+  std::vector<float> depths(packetCount);
+  unsigned int seed = 0x7654321u;
+  for (float& depth : depths) {
+    depth = 1.0f + (nextRandom(seed) % 100000) * 0.001f;
+  }
+  double ringMs = 0.0, instancedMs = 0.0;
+  unsigned long long ringBytes = 0, instancedBytes = 0;
+  unsigned int ringDraws = 0, instancedDraws = 0;
+  for (int frame = 0; frame < frames && ok; ++frame) {
+    deviceContext.beginFrame();
+    queue.begin();
+    for (unsigned int i = 0; i < packetCount; ++i) {
+      queue.submit(makePacket(i, 0.0f, 0.0f, depths[i]), depths[i]);
+    }
+    queue.sort();
+
+    ring.beginFrame(deviceContext);
+    unsigned long long bytes = deviceContext.m_frameStats.uploadBytes;
+    queue.execute(deviceContext, ring);
+    ringMs += queue.m_stats.executeMs;
+    ringDraws = queue.m_stats.drawCalls;
+    ringBytes += deviceContext.m_frameStats.uploadBytes - bytes;
+
+    bytes = deviceContext.m_frameStats.uploadBytes;
+    queue.execute(deviceContext, ring, instances);
+    instancedMs += queue.m_stats.executeMs;
+    instancedDraws = queue.m_stats.drawCalls;
+    instancedBytes += deviceContext.m_frameStats.uploadBytes - bytes;
+    ring.endFrame(deviceContext);
+    deviceContext.endFrame();
+    backend.Present();
+  }
+
+  std::wostringstream wss;
+  wss << packetCount << L" packets x " << frames << L" frames: DrawIndexed " << ringDraws << L" draws, "
+      << ringMs / frames << L" ms, " << ringBytes / frames << L" bytes per frame; instanced "
+      << instancedDraws << L" draws (" << queue.m_stats.instancedBatches << L" batches, "
+      << queue.m_stats.instancedPackets << L" packets), " << instancedMs / frames << L" ms, "
+      << instancedBytes / frames << L" bytes per frame; image check "
+      << (imagesMatch ? L"passed" : L"FAILED");
+  MESSAGE(L"RenderQueue", L"benchmarkInstancing", wss.str().c_str());
+
+  deviceContext.ClearState();
+  instances.destroy();
+  ring.destroy();
+  cbProjection.destroy();
+  cbView.destroy();
+  for (unsigned int i = 0; i < kMeshes; ++i) {
+    vertexBuffers[i].destroy();
+    indexBuffers[i].destroy();
+  }
+  sampler.destroy();
+  for (unsigned int i = 0; i < kTextures; ++i) {
+    textures[i].destroy();
+    images[i].destroy();
+  }
+  instancedShader.destroy();
+  shader.destroy();
+
+  if (!imagesMatch) {
+    ERROR(L"RenderQueue", L"benchmarkInstancing", L"Instanced and per-packet draws produced different images");
+    return false;
+  }
+  return true;
+}
+
+bool
+RenderQueue::benchmarkDeferred(unsigned int packetCount, unsigned int maxThreads, int frames) {
+  if (frames < 1) frames = 1;
+  if (maxThreads == 0) maxThreads = (std::max)(1u, std::thread::hardware_concurrency());
+
+  const unsigned int kShaders = 8, kTextures = 64, kSamplers = 2, kMeshes = 16;
+  // Listas fijas para comparar el stream de comandos grabado con distintos hilos
+  const unsigned int kCompareLists = 8;
+
+  HeadlessDevice headless;
+  NullBackend& backend = headless.m_backend;
+  Device& device = headless.m_device;
+  DeviceContext& deviceContext = headless.m_deviceContext;
+
+  bool ok = true;
+  std::vector<ShaderProgram> shaders(kShaders);
+  for (ShaderProgram& shader : shaders) {
+    ok = ok && SUCCEEDED(shader.init(device, "Inosuke_Engine.fx",
+      VertexQuantizer::inputLayout(VertexQuantizer::FORMAT_FLOAT)));
+  }
+  std::vector<Texture> images(kTextures), textures(kTextures);
+  for (unsigned int i = 0; i < kTextures && ok; ++i) {
+    ok = SUCCEEDED(images[i].init(device, 4, 4, DXGI_FORMAT_R8G8B8A8_UNORM, D3D11_BIND_SHADER_RESOURCE, 1, 0)) &&
+         SUCCEEDED(textures[i].init(device, images[i], DXGI_FORMAT_R8G8B8A8_UNORM));
+  }
+  std::vector<SamplerState> samplers(kSamplers);
+  for (SamplerState& sampler : samplers) {
+    ok = ok && SUCCEEDED(sampler.init(device));
+  }
+  MeshComponent triangle;
+  triangle.m_vertex = {
+    { XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT2(0.5f, 0.0f) },
+    { XMFLOAT3(1.0f, -1.0f, 0.0f), XMFLOAT2(1.0f, 1.0f) },
+    { XMFLOAT3(-1.0f, -1.0f, 0.0f), XMFLOAT2(0.0f, 1.0f) }
+  };
+  triangle.m_index = { 0, 1, 2 };
+  triangle.m_numVertex = 3;
+  triangle.m_numIndex = 3;
+  triangle.selectIndexFormat();
+  std::vector<Buffer> vertexBuffers(kMeshes), indexBuffers(kMeshes);
+  for (unsigned int i = 0; i < kMeshes && ok; ++i) {
+    ok = SUCCEEDED(vertexBuffers[i].init(device, triangle, D3D11_BIND_VERTEX_BUFFER)) &&
+         SUCCEEDED(indexBuffers[i].init(device, triangle, D3D11_BIND_INDEX_BUFFER));
+  }
+  Buffer objectConstants;
+  ok = ok && SUCCEEDED(objectConstants.init(device, sizeof(CBChangesEveryFrame)));
+
+  // Un contexto diferido por lista; en NullBackend graban en el formato del motor
+  auto createContexts = [&device](unsigned int count) {
+    std::vector<DeviceContext> contexts(count);
+    for (DeviceContext& context : contexts) {
+      context.initDeferred(device);
+    }
+    return contexts;
+  };
+  if (!ok) {
+    ERROR(L"RenderQueue", L"benchmarkDeferred", L"Failed to create the benchmark resources");
+    return false;
+  }
+
+  // Misma escena que benchmark(), ya ordenada
+  RenderQueue queue;
+  queue.setDepthRange(1.0f, 101.0f);
+  unsigned int seed = 0x1234567u;
+  queue.begin();
+  for (unsigned int i = 0; i < packetCount; ++i) {
+    DrawPacket packet;
+    packet.shader = &shaders[nextRandom(seed) % kShaders];
+    packet.texture = &textures[nextRandom(seed) % kTextures];
+    packet.sampler = &samplers[nextRandom(seed) % kSamplers];
+    const unsigned int mesh = nextRandom(seed) % kMeshes;
+    packet.vertexBuffer = &vertexBuffers[mesh];
+    packet.indexBuffer = &indexBuffers[mesh];
+    packet.indexCount = 3;
+    const float depth = 1.0f + (nextRandom(seed) % 100000) * 0.001f;
+    packet.constants.mWorld = XMMatrixTranspose(XMMatrixTranslation(0.0f, 0.0f, depth));
+    packet.constants.vMeshColor = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+    queue.submit(packet, depth, (nextRandom(seed) % 10) == 0 ? PASS_TRANSPARENT : PASS_OPAQUE);
+  }
+  queue.sort();
+
+  // 1) Mismos draws que execute() y mismo stream con 1 hilo y con maxThreads
+  //    grabando las mismas kCompareLists listas
+  auto captureDraws = [&backend]() {
+    std::vector<NullBackend::Command> draws;
+    for (const NullBackend::Command& command : backend.m_commands) {
+      if (command.type == NullBackend::CMD_DRAW_INDEXED || command.type == NullBackend::CMD_UPDATE_SUBRESOURCE) {
+        draws.push_back(command);
+      }
+    }
+    return draws;
+  };
+  auto sameCommands = [](const std::vector<NullBackend::Command>& a, const std::vector<NullBackend::Command>& b) {
+    if (a.size() != b.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+      if (a[i].type != b[i].type || a[i].object != b[i].object || a[i].start != b[i].start ||
+          a[i].count != b[i].count || a[i].value != b[i].value || a[i].bytes != b[i].bytes) {
+        return false;
+      }
+    }
+    return true;
+  };
+  std::vector<DeviceContext> compareContexts = createContexts(kCompareLists);
+  std::vector<CommandList> compareLists(kCompareLists);
+
+  // Cada corrida empieza con el contexto inmediato limpio para que filtre igual
+  backend.m_recordCommands = true;
+  deviceContext.ClearState();
+  backend.reset();
+  queue.execute(deviceContext, objectConstants);
+  const std::vector<NullBackend::Command> serialDraws = captureDraws();
+
+  std::vector<NullBackend::Command> streams[2];
+  bool sameDraws = true;
+  for (int run = 0; run < 2; ++run) {
+    JobSystem jobs;
+    jobs.init(run == 0 ? 1 : maxThreads);
+    deviceContext.ClearState();
+    backend.reset();
+    queue.executeDeferred(deviceContext, compareContexts, compareLists, objectConstants, jobs);
+    streams[run] = backend.m_commands;
+    sameDraws = sameDraws && sameCommands(captureDraws(), serialDraws);
+    jobs.destroy();
+  }
+  const bool sameStream = sameCommands(streams[0], streams[1]);
+  backend.m_recordCommands = false;
+  backend.reset();
+  ok = sameDraws && sameStream;
+
+  // 2) Grabacin con una lista por hilo
+  double serialMs = 0.0;
+  for (int frame = 0; frame < frames; ++frame) {
+    queue.execute(deviceContext, objectConstants);
+    serialMs += queue.m_stats.executeMs;
+  }
+  {
+    std::wostringstream wss;
+    wss << packetCount << L" packets: execute() " << serialMs / frames << L" ms per frame; "
+        << kCompareLists << L" lists match execute() " << (sameDraws ? L"yes" : L"NO")
+        << L", same stream with 1 and " << maxThreads << L" threads " << (sameStream ? L"yes" : L"NO");
+    MESSAGE(L"RenderQueue", L"benchmarkDeferred", wss.str());
+  }
+
+  double baseRecordMs = 0.0;
+  for (unsigned int threads = 1; ; threads = (std::min)(threads * 2, maxThreads)) {
+    JobSystem jobs;
+    jobs.init(threads);
+    std::vector<DeviceContext> threadContexts = createContexts(threads);
+    std::vector<CommandList> threadLists(threads);
+
+    double recordMs = 0.0, recordThreadMs = 0.0, mergeMs = 0.0;
+    size_t commands = 0, bytes = 0;
+    for (int frame = 0; frame < frames; ++frame) {
+      queue.executeDeferred(deviceContext, threadContexts, threadLists, objectConstants, jobs);
+      recordMs += queue.m_stats.recordMs;
+      recordThreadMs += queue.m_stats.recordThreadMs;
+      mergeMs += queue.m_stats.mergeMs;
+    }
+    for (const CommandList& list : threadLists) {
+      commands += list.size();
+      bytes += list.dataBytes();
+    }
+    if (threads == 1) {
+      baseRecordMs = recordMs;
+    }
+
+    std::wostringstream wss;
+    wss << threads << L" threads: record " << recordMs / frames << L" ms ("
+        << baseRecordMs / (std::max)(recordMs, 1.0e-6) << L"x), "
+        << commands * frames / (std::max)(recordThreadMs, 1.0e-6) << L" commands/ms per thread, "
+        << commands << L" commands + " << bytes / 1024 << L" KB per frame; merge " << mergeMs / frames << L" ms";
+    MESSAGE(L"RenderQueue", L"benchmarkDeferred", wss.str());
+
+    for (CommandList& list : threadLists) list.destroy();
+    for (DeviceContext& context : threadContexts) context.destroy();
+    jobs.destroy();
+    if (threads == maxThreads) {
+      break;
+    }
+  }
+
+  deviceContext.ClearState();
+  for (CommandList& list : compareLists) list.destroy();
+  for (DeviceContext& context : compareContexts) context.destroy();
+  objectConstants.destroy();
+  for (unsigned int i = 0; i < kMeshes; ++i) {
+    vertexBuffers[i].destroy();
+    indexBuffers[i].destroy();
+  }
+  for (SamplerState& sampler : samplers) sampler.destroy();
+  for (unsigned int i = 0; i < kTextures; ++i) {
+    textures[i].destroy();
+    images[i].destroy();
+  }
+  for (ShaderProgram& shader : shaders) shader.destroy();
+
+  if (!ok) {
+    ERROR(L"RenderQueue", L"benchmarkDeferred", L"Deferred command lists do not reproduce execute()");
+  }
+  return ok;
+}
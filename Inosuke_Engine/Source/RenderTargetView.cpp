@@ -6,7 +6,7 @@
 
 HRESULT
 RenderTargetView::init(Device& device, Texture& backBuffer, DXGI_FORMAT Format) {
-	if (!device.m_device) {
+	if (!device.isValid()) {
 		ERROR("RenderTargetView", "init", "Device is nullptr.");
 		return E_POINTER;
 	}
@@ -26,7 +26,7 @@ RenderTargetView::init(Device& device, Texture& backBuffer, DXGI_FORMAT Format)
 	desc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2DMS;
 
 	// Create the render target view
-	HRESULT hr = device.m_device->CreateRenderTargetView(backBuffer.m_texture,
+	HRESULT hr = device.CreateRenderTargetView(backBuffer.m_texture,
 		&desc,
 		&m_renderTargetView);
 	if (FAILED(hr)) {
@@ -43,7 +43,7 @@ RenderTargetView::init(Device& device,
 	Texture& inTex,
 	D3D11_RTV_DIMENSION ViewDimension,
 	DXGI_FORMAT Format) {
-	if (!device.m_device) {
+	if (!device.isValid()) {
 		ERROR("RenderTargetView", "init", "Device is nullptr.");
 		return E_POINTER;
 	}
@@ -63,7 +63,7 @@ RenderTargetView::init(Device& device,
 	desc.ViewDimension = ViewDimension;
 
 	// Create the render target view
-	HRESULT hr = device.m_device->CreateRenderTargetView(inTex.m_texture,
+	HRESULT hr = device.CreateRenderTargetView(inTex.m_texture,
 		&desc,
 		&m_renderTargetView);
 
@@ -81,7 +81,7 @@ RenderTargetView::render(DeviceContext& deviceContext,
 	DepthStencilView& depthStencilView,
 	unsigned int numViews,
 	const float ClearColor[4]) {
-	if (!deviceContext.m_deviceContext) {
+	if (!deviceContext.isValid()) {
 		ERROR("RenderTargetView", "render", "DeviceContext is nullptr.");
 		return;
 	}
@@ -91,17 +91,17 @@ RenderTargetView::render(DeviceContext& deviceContext,
 	}
 
 	// Clear the render target view
-	deviceContext.m_deviceContext->ClearRenderTargetView(m_renderTargetView, ClearColor);
+	deviceContext.ClearRenderTargetView(m_renderTargetView, ClearColor);
 
 	// Config render target view and depth stencil view
-	deviceContext.m_deviceContext->OMSetRenderTargets(numViews,
+	deviceContext.OMSetRenderTargets(numViews,
 		&m_renderTargetView,
 		depthStencilView.m_depthStencilView);
 }
 
 void
 RenderTargetView::render(DeviceContext& deviceContext, unsigned int numViews) {
-	if (!deviceContext.m_deviceContext) {
+	if (!deviceContext.isValid()) {
 		ERROR("RenderTargetView", "render", "DeviceContext is nullptr.");
 		return;
 	}
@@ -110,7 +110,7 @@ RenderTargetView::render(DeviceContext& deviceContext, unsigned int numViews) {
 		return;
 	}
 	// Config render target view
-	deviceContext.m_deviceContext->OMSetRenderTargets(numViews,
+	deviceContext.OMSetRenderTargets(numViews,
 		&m_renderTargetView,
 		nullptr);
 }
@@ -0,0 +1,264 @@
+#include "ResourceRegistry.h"
+#include "Device.h"
+#include "HeadlessDevice.h"
+#include "NullBackend.h"
+#include <chrono>
+
+namespace {
+  inline double elapsedMs(const std::chrono::high_resolution_clock::time_point& start) {
+    return std::chrono::duration<double, std::milli>(
+      std::chrono::high_resolution_clock::now() - start).count();
+  }
+
+  /// Bytes de una superficie de @p width x @p height (bloques de 4x4 en BC).
+  size_t
+  surfaceBytes(DXGI_FORMAT format, unsigned int width, unsigned int height) {
+    const size_t blocks = (size_t)((width + 3) / 4) * ((height + 3) / 4);
+    switch (format) {
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+    case DXGI_FORMAT_BC4_UNORM:
+    case DXGI_FORMAT_BC4_SNORM:
+      return blocks * 8;
+    case DXGI_FORMAT_BC2_UNORM:
+    case DXGI_FORMAT_BC2_UNORM_SRGB:
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:
+    case DXGI_FORMAT_BC5_UNORM:
+    case DXGI_FORMAT_BC5_SNORM:
+    case DXGI_FORMAT_BC6H_UF16:
+    case DXGI_FORMAT_BC6H_SF16:
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+      return blocks * 16;
+    default:
+      break;
+    }
+
+    unsigned int texelBytes = 4;
+    switch (format) {
+    case DXGI_FORMAT_R32G32B32A32_FLOAT: texelBytes = 16; break;
+    case DXGI_FORMAT_R32G32B32_FLOAT: texelBytes = 12; break;
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+    case DXGI_FORMAT_R16G16B16A16_SNORM:
+    case DXGI_FORMAT_R32G32_FLOAT: texelBytes = 8; break;
+    case DXGI_FORMAT_R8G8_UNORM:
+    case DXGI_FORMAT_R8G8_SNORM:
+    case DXGI_FORMAT_R16_FLOAT:
+    case DXGI_FORMAT_R16_UINT:
+    case DXGI_FORMAT_D16_UNORM: texelBytes = 2; break;
+    case DXGI_FORMAT_R8_UNORM:
+    case DXGI_FORMAT_A8_UNORM: texelBytes = 1; break;
+    default: break;
+    }
+    return (size_t)width * height * texelBytes;
+  }
+
+  template<typename T>
+  void
+  reportPool(const std::string& label, const ResourcePool<T>& pool) {
+    const typename ResourcePool<T>::Stats& stats = pool.stats();
+    std::wostringstream wss;
+    wss << label.c_str() << L": " << pool.name() << L" " << stats.live << L" live, " << stats.pending
+        << L" pending, " << stats.bytes / 1024.0 << L" KB (peak " << stats.peakBytes / 1024.0 << L" KB), "
+        << stats.created << L" created, " << stats.destroyed << L" destroyed, " << stats.staleLookups
+        << L" stale lookups";
+    MESSAGE(L"ResourceRegistry", L"report", wss.str());
+  }
+}
+
+unsigned int
+ResourceRegistry::collect(unsigned long long renderedFrames) {
+  return m_buffers.collect(renderedFrames) + m_textures.collect(renderedFrames) +
+         m_samplers.collect(renderedFrames) + m_shaders.collect(renderedFrames);
+}
+
+void
+ResourceRegistry::destroy() {
+  m_samplers.destroy();
+  m_textures.destroy();
+  m_buffers.destroy();
+  m_shaders.destroy();
+  m_frame = 0;
+}
+
+void
+ResourceRegistry::report(const std::string& label) const {
+  reportPool(label, m_buffers);
+  reportPool(label, m_textures);
+  reportPool(label, m_samplers);
+  reportPool(label, m_shaders);
+}
+
+size_t
+ResourceRegistry::bufferBytes(const Buffer& buffer) {
+  return buffer.getByteWidth();
+}
+
+size_t
+ResourceRegistry::textureBytes(const Texture& texture) {
+  // Las texturas cargadas de archivo solo guardan la vista: el recurso sale de ella
+  ID3D11Resource* resource = texture.m_texture;
+  ID3D11Resource* fromView = nullptr;
+  if (!resource && texture.m_textureFromImg) {
+    texture.m_textureFromImg->GetResource(&fromView);
+    resource = fromView;
+  }
+  if (!resource) {
+    return 0;
+  }
+
+  size_t bytes = 0;
+  D3D11_RESOURCE_DIMENSION dimension = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+  resource->GetType(&dimension);
+  if (dimension == D3D11_RESOURCE_DIMENSION_TEXTURE2D) {
+    D3D11_TEXTURE2D_DESC desc;
+    static_cast<ID3D11Texture2D*>(resource)->GetDesc(&desc);
+    // MipLevels 0 = cadena completa
+    unsigned int mips = desc.MipLevels;
+    if (mips == 0) {
+      for (unsigned int size = (std::max)(desc.Width, desc.Height); size > 0; size >>= 1) {
+        ++mips;
+      }
+    }
+    for (unsigned int mip = 0; mip < mips; ++mip) {
+      bytes += surfaceBytes(desc.Format, (std::max)(1u, desc.Width >> mip), (std::max)(1u, desc.Height >> mip));
+    }
+    bytes *= (std::max)(1u, desc.ArraySize) * (std::max)(1u, desc.SampleDesc.Count);
+  }
+  SAFE_RELEASE(fromView);
+  return bytes;
+}
+
+size_t
+ResourceRegistry::samplerBytes(const SamplerState& sampler) {
+  // Un sampler es solo estado: se cuenta, pero no ocupa memoria de recursos
+  return 0;
+}
+
+size_t
+ResourceRegistry::shaderBytes(const ShaderProgram& shader) {
+  return shader.getBytecodeSize();
+}
+
+bool
+ResourceRegistry::benchmark(unsigned int count, unsigned int frames) {
+  // Render dos cuadros atrs del update, como FramePipeline con latencia 2
+  const unsigned long long kLatency = 2;
+  const unsigned int kBufferBytes = 256;
+
+  HeadlessDevice headless;
+  NullBackend& backend = headless.m_backend;
+  Device& device = headless.m_device;
+  const int baseObjects = backend.m_liveObjects;
+
+  bool ok = true;
+  ResourceRegistry registry;
+  std::vector<BufferHandle> handles(count);
+  for (BufferHandle& handle : handles) {
+    ok = ok && SUCCEEDED(registry.create(handle, device, kBufferBytes));
+  }
+  ok = ok && registry.m_buffers.stats().bytes == (size_t)count * kBufferBytes;
+
+  // Destruccin diferida: lo liberado en el cuadro 0 vive hasta que se renderiza el 0
+  const unsigned int released = (std::max)(count / 8, 1u);
+  BufferHandle stale = handles[0];
+  Buffer* staleBuffer = registry.get(stale);
+  registry.beginFrame(0);
+  for (unsigned int i = 0; i < released; ++i) {
+    registry.release(handles[i]);
+  }
+  const int liveAfterRelease = backend.m_liveObjects;
+  const bool invalidated = registry.get(stale) == nullptr && staleBuffer->getByteWidth() == kBufferBytes;
+  registry.collect(0);
+  const bool kept = backend.m_liveObjects == liveAfterRelease;
+  registry.collect(1);
+  const bool deferred = invalidated && kept && backend.m_liveObjects == liveAfterRelease - (int)released;
+
+  // El lugar se reutiliza con otra generacin: el handle viejo sigue sin resolver
+  for (unsigned int i = 0; i < released; ++i) {
+    ok = ok && SUCCEEDED(registry.create(handles[i], device, kBufferBytes));
+  }
+  const bool generations = registry.get(stale) == nullptr && registry.get(handles[0]) == staleBuffer &&
+                           handles[0] != stale;
+
+  // Churn: cada cuadro libera y recrea 1/8 de los buffers
+  auto start = std::chrono::high_resolution_clock::now();
+  unsigned long long churned = 0;
+  for (unsigned int frame = 1; frame <= frames; ++frame) {
+    registry.beginFrame(frame);
+    const unsigned int first = (frame * released) % count;
+    for (unsigned int i = 0; i < released; ++i) {
+      BufferHandle& handle = handles[(first + i) % count];
+      registry.release(handle);
+      ok = ok && SUCCEEDED(registry.create(handle, device, kBufferBytes));
+    }
+    churned += released;
+    if (frame + 1 > kLatency) {
+      registry.collect(frame + 1 - kLatency);
+    }
+  }
+  const double churnMs = elapsedMs(start);
+  const unsigned int pendingAtEnd = registry.m_buffers.stats().pending;
+
+  // Bsqueda por handle contra puntero directo
+  const unsigned int kRounds = 100;
+  std::vector<Buffer*> pointers(count);
+  for (unsigned int i = 0; i < count; ++i) {
+    pointers[i] = registry.get(handles[i]);
+  }
+  uintptr_t checkHandles = 0, checkPointers = 0, checkIteration = 0;
+  start = std::chrono::high_resolution_clock::now();
+  for (unsigned int round = 0; round < kRounds; ++round) {
+    for (const BufferHandle& handle : handles) {
+      checkHandles += (uintptr_t)registry.get(handle);
+    }
+  }
+  const double getMs = elapsedMs(start);
+  start = std::chrono::high_resolution_clock::now();
+  for (unsigned int round = 0; round < kRounds; ++round) {
+    for (Buffer* buffer : pointers) {
+      checkPointers += (uintptr_t)buffer;
+    }
+  }
+  const double pointerMs = elapsedMs(start);
+  start = std::chrono::high_resolution_clock::now();
+  unsigned long long visited = 0;
+  for (unsigned int round = 0; round < kRounds; ++round) {
+    registry.m_buffers.forEach([&](BufferHandle, Buffer& buffer) {
+      checkIteration += (uintptr_t)&buffer;
+      ++visited;
+    });
+  }
+  const double forEachMs = elapsedMs(start);
+  ok = ok && checkHandles == checkPointers && visited == (unsigned long long)count * kRounds;
+
+  // Memoria por tipo: textura de 64x64 RGBA8 con su vista en el mismo wrapper
+  TextureHandle texture;
+  ok = ok && SUCCEEDED(registry.create(texture, device, 64u, 64u, DXGI_FORMAT_R8G8B8A8_UNORM,
+    (unsigned int)D3D11_BIND_SHADER_RESOURCE, 1u, 0u));
+  Texture* textureObject = registry.get(texture);
+  ok = ok && textureObject && SUCCEEDED(textureObject->init(device, *textureObject, DXGI_FORMAT_R8G8B8A8_UNORM));
+  registry.updateMemory(texture);
+  const bool textureMemory = registry.m_textures.stats().bytes == 64 * 64 * 4;
+
+  registry.report("ResourceRegistry::benchmark");
+  registry.destroy();
+  const bool allReleased = backend.m_liveObjects == baseObjects;
+  ok = ok && deferred && generations && textureMemory && allReleased;
+
+  const double lookups = (double)count * kRounds;
+  std::wostringstream wss;
+  wss << count << L" buffers: create+release " << churnMs * 1.0e6 / (std::max)(churned, 1ull)
+      << L" ns, get() " << getMs * 1.0e6 / lookups << L" ns (pointer " << pointerMs * 1.0e6 / lookups
+      << L" ns), forEach " << forEachMs * 1.0e6 / lookups << L" ns/object; " << pendingAtEnd
+      << L" pending at latency " << kLatency << L"; deferred " << (deferred ? L"yes" : L"NO")
+      << L", stale handles rejected " << (generations ? L"yes" : L"NO") << L", texture memory "
+      << (textureMemory ? L"yes" : L"NO") << L", all released " << (allReleased ? L"yes" : L"NO");
+  MESSAGE(L"ResourceRegistry", L"benchmark", wss.str());
+  if (!ok) {
+    ERROR("ResourceRegistry", "benchmark", "Handle validation or deferred destruction failed");
+  }
+  return ok;
+}
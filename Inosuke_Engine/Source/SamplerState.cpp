@@ -4,7 +4,7 @@
 
 HRESULT
 SamplerState::init(Device& device) {
-  if (!device.m_device) {
+  if (!device.isValid()) {
     ERROR("SamplerState", "init", "Device is nullptr");
     return E_POINTER;
   }
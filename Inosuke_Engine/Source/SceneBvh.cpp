@@ -0,0 +1,741 @@
+#include "SceneBvh.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+  inline float
+  surfaceArea(const XMFLOAT3& minimum, const XMFLOAT3& maximum) {
+    const float dx = maximum.x - minimum.x;
+    const float dy = maximum.y - minimum.y;
+    const float dz = maximum.z - minimum.z;
+    return 2.0f * (dx * dy + dy * dz + dz * dx);
+  }
+
+  inline void
+  combine(const XMFLOAT3& minA, const XMFLOAT3& maxA,
+    const XMFLOAT3& minB, const XMFLOAT3& maxB,
+    XMFLOAT3& outMin, XMFLOAT3& outMax) {
+    outMin = XMFLOAT3((std::min)(minA.x, minB.x), (std::min)(minA.y, minB.y), (std::min)(minA.z, minB.z));
+    outMax = XMFLOAT3((std::max)(maxA.x, maxB.x), (std::max)(maxA.y, maxB.y), (std::max)(maxA.z, maxB.z));
+  }
+
+  inline float
+  combinedArea(const XMFLOAT3& minA, const XMFLOAT3& maxA, const XMFLOAT3& minB, const XMFLOAT3& maxB) {
+    XMFLOAT3 minimum, maximum;
+    combine(minA, maxA, minB, maxB, minimum, maximum);
+    return surfaceArea(minimum, maximum);
+  }
+
+  inline bool
+  contains(const XMFLOAT3& outerMin, const XMFLOAT3& outerMax, const XMFLOAT3& innerMin, const XMFLOAT3& innerMax) {
+    return outerMin.x <= innerMin.x && outerMin.y <= innerMin.y && outerMin.z <= innerMin.z &&
+           innerMax.x <= outerMax.x && innerMax.y <= outerMax.y && innerMax.z <= outerMax.z;
+  }
+
+  inline bool
+  overlaps(const XMFLOAT3& minA, const XMFLOAT3& maxA, const XMFLOAT3& minB, const XMFLOAT3& maxB) {
+    return minA.x <= maxB.x && minB.x <= maxA.x && minA.y <= maxB.y && minB.y <= maxA.y &&
+           minA.z <= maxB.z && minB.z <= maxA.z;
+  }
+
+  /**
+   * Distancia de entrada del rayo a la caja (0 si el origen est dentro) o -1 si
+   * no la toca dentro de [0, maxDistance].
+   */
+  inline float
+  rayBox(const float origin[3], const float inverse[3], const float minimum[3], const float maximum[3], float maxDistance) {
+    float enter = 0.0f;
+    float exit = maxDistance;
+    for (int axis = 0; axis < 3; ++axis) {
+      float t1 = (minimum[axis] - origin[axis]) * inverse[axis];
+      float t2 = (maximum[axis] - origin[axis]) * inverse[axis];
+      if (t1 > t2) std::swap(t1, t2);
+      // Con direccin 0 en el eje, t1/t2 son inf (o NaN en el borde): el NaN no acota
+      enter = t1 > enter ? t1 : enter;
+      exit = t2 < exit ? t2 : exit;
+      if (enter > exit) return -1.0f;
+    }
+    return enter;
+  }
+
+  /// xorshift32: el benchmark usa la misma escena en cada corrida.
+  inline unsigned int nextRandom(unsigned int& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+  inline float randomRange(unsigned int& state, float minimum, float maximum) {
+    return minimum + (maximum - minimum) * ((nextRandom(state) & 0xffffff) / 16777215.0f);
+  }
+
+  inline double elapsedMs(const std::chrono::high_resolution_clock::time_point& start) {
+    return std::chrono::duration<double, std::milli>(
+      std::chrono::high_resolution_clock::now() - start).count();
+  }
+}
+
+int
+SceneBvh::allocateNode() {
+  if (m_freeList == kNullNode) {
+    m_nodes.push_back(Node());
+    m_nodes.back().height = -1;
+    m_freeList = (int)m_nodes.size() - 1;
+    m_nodes.back().parent = kNullNode;
+  }
+  const int node = m_freeList;
+  m_freeList = m_nodes[node].parent;
+  Node& n = m_nodes[node];
+  n.parent = kNullNode;
+  n.child1 = kNullNode;
+  n.child2 = kNullNode;
+  n.height = 0;
+  n.userData = 0;
+  return node;
+}
+
+void
+SceneBvh::freeNode(int node) {
+  m_nodes[node].parent = m_freeList;
+  m_nodes[node].height = -1;
+  m_freeList = node;
+}
+
+int
+SceneBvh::createProxy(const XMFLOAT3& center, const XMFLOAT3& extents, unsigned int userData) {
+  const int proxy = allocateNode();
+  Node& node = m_nodes[proxy];
+  node.minimum = XMFLOAT3(center.x - extents.x - m_margin, center.y - extents.y - m_margin, center.z - extents.z - m_margin);
+  node.maximum = XMFLOAT3(center.x + extents.x + m_margin, center.y + extents.y + m_margin, center.z + extents.z + m_margin);
+  node.userData = userData;
+  insertLeaf(proxy);
+  ++m_proxyCount;
+  return proxy;
+}
+
+void
+SceneBvh::destroyProxy(int proxy) {
+  if (proxy < 0 || proxy >= (int)m_nodes.size() || !m_nodes[proxy].isLeaf() || m_nodes[proxy].height != 0) {
+    ERROR("SceneBvh", "destroyProxy", ("Invalid proxy: " + std::to_string(proxy)).c_str());
+    return;
+  }
+  removeLeaf(proxy);
+  freeNode(proxy);
+  --m_proxyCount;
+}
+
+bool
+SceneBvh::moveProxy(int proxy, const XMFLOAT3& center, const XMFLOAT3& extents, const XMFLOAT3& displacement) {
+  if (proxy < 0 || proxy >= (int)m_nodes.size() || !m_nodes[proxy].isLeaf() || m_nodes[proxy].height != 0) {
+    ERROR("SceneBvh", "moveProxy", ("Invalid proxy: " + std::to_string(proxy)).c_str());
+    return false;
+  }
+  ++m_stats.moves;
+
+  const XMFLOAT3 tightMin(center.x - extents.x, center.y - extents.y, center.z - extents.z);
+  const XMFLOAT3 tightMax(center.x + extents.x, center.y + extents.y, center.z + extents.z);
+  XMFLOAT3 fatMin(tightMin.x - m_margin, tightMin.y - m_margin, tightMin.z - m_margin);
+  XMFLOAT3 fatMax(tightMax.x + m_margin, tightMax.y + m_margin, tightMax.z + m_margin);
+  const float dx = displacement.x * m_displacementScale;
+  const float dy = displacement.y * m_displacementScale;
+  const float dz = displacement.z * m_displacementScale;
+  if (dx < 0.0f) fatMin.x += dx; else fatMax.x += dx;
+  if (dy < 0.0f) fatMin.y += dy; else fatMax.y += dy;
+  if (dz < 0.0f) fatMin.z += dz; else fatMax.z += dz;
+
+  const Node& node = m_nodes[proxy];
+  if (contains(node.minimum, node.maximum, tightMin, tightMax)) {
+    // Sigue dentro; solo se reinserta si la caja gorda qued mucho ms grande
+    // que la necesaria (el objeto fren o se achic)
+    const float slack = 4.0f * m_margin;
+    const XMFLOAT3 hugeMin(fatMin.x - slack, fatMin.y - slack, fatMin.z - slack);
+    const XMFLOAT3 hugeMax(fatMax.x + slack, fatMax.y + slack, fatMax.z + slack);
+    if (contains(hugeMin, hugeMax, node.minimum, node.maximum)) {
+      return false;
+    }
+  }
+
+  removeLeaf(proxy);
+  m_nodes[proxy].minimum = fatMin;
+  m_nodes[proxy].maximum = fatMax;
+  insertLeaf(proxy);
+  ++m_stats.reinserts;
+  return true;
+}
+
+void
+SceneBvh::clear() {
+  m_nodes.clear();
+  m_root = kNullNode;
+  m_freeList = kNullNode;
+  m_proxyCount = 0;
+}
+
+void
+SceneBvh::insertLeaf(int leaf) {
+  if (m_root == kNullNode) {
+    m_root = leaf;
+    m_nodes[leaf].parent = kNullNode;
+    return;
+  }
+
+  // Bajar por el hijo ms barato: rea de la caja combinada ms lo que crecen
+  // los ancestros (costo heredado)
+  const XMFLOAT3 leafMin = m_nodes[leaf].minimum;
+  const XMFLOAT3 leafMax = m_nodes[leaf].maximum;
+  int index = m_root;
+  while (!m_nodes[index].isLeaf()) {
+    const Node& node = m_nodes[index];
+    const float area = surfaceArea(node.minimum, node.maximum);
+    const float combined = combinedArea(node.minimum, node.maximum, leafMin, leafMax);
+
+    // Costo de crear un padre nuevo para esta hoja y este nodo
+    const float cost = 2.0f * combined;
+    // Costo mnimo de bajar la hoja ms abajo
+    const float inheritance = 2.0f * (combined - area);
+
+    float childCost[2];
+    const int children[2] = { node.child1, node.child2 };
+    for (int i = 0; i < 2; ++i) {
+      const Node& child = m_nodes[children[i]];
+      const float childCombined = combinedArea(child.minimum, child.maximum, leafMin, leafMax);
+      childCost[i] = child.isLeaf()
+        ? childCombined + inheritance
+        : childCombined - surfaceArea(child.minimum, child.maximum) + inheritance;
+    }
+
+    if (cost < childCost[0] && cost < childCost[1]) {
+      break;
+    }
+    index = childCost[0] < childCost[1] ? children[0] : children[1];
+  }
+  const int sibling = index;
+
+  // Nuevo padre para la hoja y su hermano
+  const int oldParent = m_nodes[sibling].parent;
+  const int newParent = allocateNode();
+  Node& parent = m_nodes[newParent];
+  parent.parent = oldParent;
+  combine(leafMin, leafMax, m_nodes[sibling].minimum, m_nodes[sibling].maximum, parent.minimum, parent.maximum);
+  parent.height = m_nodes[sibling].height + 1;
+  parent.child1 = sibling;
+  parent.child2 = leaf;
+  if (oldParent != kNullNode) {
+    if (m_nodes[oldParent].child1 == sibling) m_nodes[oldParent].child1 = newParent;
+    else m_nodes[oldParent].child2 = newParent;
+  }
+  else {
+    m_root = newParent;
+  }
+  m_nodes[sibling].parent = newParent;
+  m_nodes[leaf].parent = newParent;
+
+  // Subir reajustando cajas y alturas
+  index = m_nodes[leaf].parent;
+  while (index != kNullNode) {
+    index = balance(index);
+    refit(index);
+    index = m_nodes[index].parent;
+  }
+}
+
+void
+SceneBvh::removeLeaf(int leaf) {
+  if (leaf == m_root) {
+    m_root = kNullNode;
+    return;
+  }
+  const int parent = m_nodes[leaf].parent;
+  const int grandParent = m_nodes[parent].parent;
+  const int sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+  if (grandParent == kNullNode) {
+    m_root = sibling;
+    m_nodes[sibling].parent = kNullNode;
+    freeNode(parent);
+    return;
+  }
+
+  // El hermano toma el lugar del padre
+  if (m_nodes[grandParent].child1 == parent) m_nodes[grandParent].child1 = sibling;
+  else m_nodes[grandParent].child2 = sibling;
+  m_nodes[sibling].parent = grandParent;
+  freeNode(parent);
+
+  int index = grandParent;
+  while (index != kNullNode) {
+    index = balance(index);
+    refit(index);
+    index = m_nodes[index].parent;
+  }
+}
+
+void
+SceneBvh::refit(int node) {
+  Node& n = m_nodes[node];
+  const Node& child1 = m_nodes[n.child1];
+  const Node& child2 = m_nodes[n.child2];
+  combine(child1.minimum, child1.maximum, child2.minimum, child2.maximum, n.minimum, n.maximum);
+  n.height = 1 + (std::max)(child1.height, child2.height);
+}
+
+int
+SceneBvh::balance(int iA) {
+  Node& A = m_nodes[iA];
+  if (A.isLeaf() || A.height < 2) {
+    return iA;
+  }
+  const int iB = A.child1;
+  const int iC = A.child2;
+  Node& B = m_nodes[iB];
+  Node& C = m_nodes[iC];
+  const int difference = C.height - B.height;
+
+  if (difference > 1) {
+    // Subir C: A pasa a ser hijo de C
+    const int iF = C.child1;
+    const int iG = C.child2;
+    Node& F = m_nodes[iF];
+    Node& G = m_nodes[iG];
+
+    C.child1 = iA;
+    C.parent = A.parent;
+    A.parent = iC;
+    if (C.parent != kNullNode) {
+      if (m_nodes[C.parent].child1 == iA) m_nodes[C.parent].child1 = iC;
+      else m_nodes[C.parent].child2 = iC;
+    }
+    else {
+      m_root = iC;
+    }
+
+    // El nieto ms alto queda con C; el otro baja con A
+    if (F.height > G.height) {
+      C.child2 = iF;
+      A.child2 = iG;
+      G.parent = iA;
+      combine(B.minimum, B.maximum, G.minimum, G.maximum, A.minimum, A.maximum);
+      combine(A.minimum, A.maximum, F.minimum, F.maximum, C.minimum, C.maximum);
+      A.height = 1 + (std::max)(B.height, G.height);
+      C.height = 1 + (std::max)(A.height, F.height);
+    }
+    else {
+      C.child2 = iG;
+      A.child2 = iF;
+      F.parent = iA;
+      combine(B.minimum, B.maximum, F.minimum, F.maximum, A.minimum, A.maximum);
+      combine(A.minimum, A.maximum, G.minimum, G.maximum, C.minimum, C.maximum);
+      A.height = 1 + (std::max)(B.height, F.height);
+      C.height = 1 + (std::max)(A.height, G.height);
+    }
+    ++m_stats.rotations;
+    return iC;
+  }
+
+  if (difference < -1) {
+    // Subir B: A pasa a ser hijo de B
+    const int iD = B.child1;
+    const int iE = B.child2;
+    Node& D = m_nodes[iD];
+    Node& E = m_nodes[iE];
+
+    B.child1 = iA;
+    B.parent = A.parent;
+    A.parent = iB;
+    if (B.parent != kNullNode) {
+      if (m_nodes[B.parent].child1 == iA) m_nodes[B.parent].child1 = iB;
+      else m_nodes[B.parent].child2 = iB;
+    }
+    else {
+      m_root = iB;
+    }
+
+    if (D.height > E.height) {
+      B.child2 = iD;
+      A.child1 = iE;
+      E.parent = iA;
+      combine(C.minimum, C.maximum, E.minimum, E.maximum, A.minimum, A.maximum);
+      combine(A.minimum, A.maximum, D.minimum, D.maximum, B.minimum, B.maximum);
+      A.height = 1 + (std::max)(C.height, E.height);
+      B.height = 1 + (std::max)(A.height, D.height);
+    }
+    else {
+      B.child2 = iE;
+      A.child1 = iD;
+      D.parent = iA;
+      combine(C.minimum, C.maximum, D.minimum, D.maximum, A.minimum, A.maximum);
+      combine(A.minimum, A.maximum, E.minimum, E.maximum, B.minimum, B.maximum);
+      A.height = 1 + (std::max)(C.height, D.height);
+      B.height = 1 + (std::max)(A.height, E.height);
+    }
+    ++m_stats.rotations;
+    return iB;
+  }
+  return iA;
+}
+
+int
+SceneBvh::height() const {
+  return m_root == kNullNode ? -1 : m_nodes[m_root].height;
+}
+
+float
+SceneBvh::areaRatio() const {
+  if (m_root == kNullNode) {
+    return 0.0f;
+  }
+  const float rootArea = surfaceArea(m_nodes[m_root].minimum, m_nodes[m_root].maximum);
+  float totalArea = 0.0f;
+  for (const Node& node : m_nodes) {
+    if (node.height > 0) {
+      totalArea += surfaceArea(node.minimum, node.maximum);
+    }
+  }
+  return rootArea > 0.0f ? totalArea / rootArea : 0.0f;
+}
+
+template<typename Allocator>
+void
+SceneBvh::collectLeaves(int node, std::vector<unsigned int, Allocator>& out) const {
+  const size_t base = m_stack.size();
+  m_stack.push_back(node);
+  while (m_stack.size() > base) {
+    const Node& n = m_nodes[m_stack.back()];
+    m_stack.pop_back();
+    if (n.isLeaf()) {
+      out.push_back(n.userData);
+    }
+    else {
+      m_stack.push_back(n.child2);
+      m_stack.push_back(n.child1);
+    }
+  }
+}
+
+template<typename Allocator>
+void
+SceneBvh::queryFrustum(const FrustumCuller::Frustum& frustum, std::vector<unsigned int, Allocator>& out) const {
+  if (m_root == kNullNode) {
+    return;
+  }
+  // La pila guarda pares (nodo, planos que an cortan al padre)
+  m_stack.clear();
+  m_stack.push_back(m_root);
+  m_stack.push_back(0x3f);
+  while (!m_stack.empty()) {
+    unsigned int mask = (unsigned int)m_stack.back();
+    m_stack.pop_back();
+    const int index = m_stack.back();
+    m_stack.pop_back();
+    const Node& node = m_nodes[index];
+    ++m_stats.nodesVisited;
+
+    const float cx = (node.minimum.x + node.maximum.x) * 0.5f;
+    const float cy = (node.minimum.y + node.maximum.y) * 0.5f;
+    const float cz = (node.minimum.z + node.maximum.z) * 0.5f;
+    const float ex = (node.maximum.x - node.minimum.x) * 0.5f;
+    const float ey = (node.maximum.y - node.minimum.y) * 0.5f;
+    const float ez = (node.maximum.z - node.minimum.z) * 0.5f;
+    bool outside = false;
+    for (int p = 0; p < 6 && !outside; ++p) {
+      if (!(mask & (1u << p))) {
+        continue;
+      }
+      const XMFLOAT4& plane = frustum.planes[p];
+      const float dist = plane.x * cx + plane.y * cy + plane.z * cz + plane.w;
+      const float reach = fabsf(plane.x) * ex + fabsf(plane.y) * ey + fabsf(plane.z) * ez;
+      if (dist + reach < 0.0f) {
+        outside = true;
+      }
+      else if (dist - reach >= 0.0f) {
+        mask &= ~(1u << p);   // Todo el subrbol est del lado de adentro de este plano
+      }
+    }
+    if (outside) {
+      continue;
+    }
+    if (mask == 0 || node.isLeaf()) {
+      collectLeaves(index, out);
+      continue;
+    }
+    m_stack.push_back(node.child2);
+    m_stack.push_back((int)mask);
+    m_stack.push_back(node.child1);
+    m_stack.push_back((int)mask);
+  }
+}
+
+template void SceneBvh::queryFrustum(const FrustumCuller::Frustum&, std::vector<unsigned int>&) const;
+template void SceneBvh::queryFrustum(const FrustumCuller::Frustum&, FrameVector<unsigned int>&) const;
+
+void
+SceneBvh::queryBox(const XMFLOAT3& minimum, const XMFLOAT3& maximum, std::vector<unsigned int>& out) const {
+  if (m_root == kNullNode) {
+    return;
+  }
+  m_stack.clear();
+  m_stack.push_back(m_root);
+  while (!m_stack.empty()) {
+    const Node& node = m_nodes[m_stack.back()];
+    m_stack.pop_back();
+    ++m_stats.nodesVisited;
+    if (!overlaps(node.minimum, node.maximum, minimum, maximum)) {
+      continue;
+    }
+    if (node.isLeaf()) {
+      out.push_back(node.userData);
+    }
+    else {
+      m_stack.push_back(node.child2);
+      m_stack.push_back(node.child1);
+    }
+  }
+}
+
+bool
+SceneBvh::rayCast(const XMFLOAT3& origin,
+  const XMFLOAT3& direction,
+  float maxDistance,
+  RayHit& hit,
+  const RayTest& exactTest) const {
+  if (m_root == kNullNode) {
+    return false;
+  }
+  const float o[3] = { origin.x, origin.y, origin.z };
+  const float inverse[3] = { 1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z };
+  float best = maxDistance;
+  bool found = false;
+
+  m_stack.clear();
+  m_stack.push_back(m_root);
+  while (!m_stack.empty()) {
+    const Node& node = m_nodes[m_stack.back()];
+    m_stack.pop_back();
+    ++m_stats.nodesVisited;
+    const float enter = rayBox(o, inverse, &node.minimum.x, &node.maximum.x, best);
+    if (enter < 0.0f) {
+      continue;
+    }
+    if (node.isLeaf()) {
+      const float distance = exactTest ? exactTest(node.userData, enter) : enter;
+      if (distance >= 0.0f && distance <= best) {
+        best = distance;
+        hit.userData = node.userData;
+        hit.distance = distance;
+        found = true;
+      }
+      continue;
+    }
+    // El hijo ms cercano se visita primero para acotar antes el resto
+    const Node& child1 = m_nodes[node.child1];
+    const Node& child2 = m_nodes[node.child2];
+    const float enter1 = rayBox(o, inverse, &child1.minimum.x, &child1.maximum.x, best);
+    const float enter2 = rayBox(o, inverse, &child2.minimum.x, &child2.maximum.x, best);
+    if (enter1 >= 0.0f && enter2 >= 0.0f) {
+      if (enter1 <= enter2) {
+        m_stack.push_back(node.child2);
+        m_stack.push_back(node.child1);
+      }
+      else {
+        m_stack.push_back(node.child1);
+        m_stack.push_back(node.child2);
+      }
+    }
+    else if (enter1 >= 0.0f) {
+      m_stack.push_back(node.child1);
+    }
+    else if (enter2 >= 0.0f) {
+      m_stack.push_back(node.child2);
+    }
+  }
+  return found;
+}
+
+int
+SceneBvh::computeHeight(int node) const {
+  const Node& n = m_nodes[node];
+  if (n.isLeaf()) {
+    return 0;
+  }
+  return 1 + (std::max)(computeHeight(n.child1), computeHeight(n.child2));
+}
+
+bool
+SceneBvh::validateNode(int node) const {
+  const Node& n = m_nodes[node];
+  if (n.isLeaf()) {
+    return n.height == 0;
+  }
+  const Node& child1 = m_nodes[n.child1];
+  const Node& child2 = m_nodes[n.child2];
+  if (child1.parent != node || child2.parent != node) {
+    return false;
+  }
+  if (n.height != 1 + (std::max)(child1.height, child2.height)) {
+    return false;
+  }
+  if (!contains(n.minimum, n.maximum, child1.minimum, child1.maximum) ||
+      !contains(n.minimum, n.maximum, child2.minimum, child2.maximum)) {
+    return false;
+  }
+  return validateNode(n.child1) && validateNode(n.child2);
+}
+
+bool
+SceneBvh::validate() const {
+  if (m_root == kNullNode) {
+    return m_proxyCount == 0;
+  }
+  return m_nodes[m_root].parent == kNullNode && validateNode(m_root) && computeHeight(m_root) == height();
+}
+
+bool
+SceneBvh::benchmark(unsigned int objectCount, int frames) {
+  if (frames < 1) frames = 1;
+  const float kHalfWorld = 500.0f;
+  const float dt = 1.0f / 60.0f;
+
+  struct Object {
+    XMFLOAT3 center;
+    XMFLOAT3 extents;
+    XMFLOAT3 velocity;
+    int proxy;
+  };
+  std::vector<Object> objects(objectCount);
+  unsigned int seed = 0x13579bdu;
+  for (Object& object : objects) {
+    object.center = XMFLOAT3(randomRange(seed, -kHalfWorld, kHalfWorld), randomRange(seed, -kHalfWorld, kHalfWorld),
+      randomRange(seed, -kHalfWorld, kHalfWorld));
+    object.extents = XMFLOAT3(randomRange(seed, 0.5f, 2.0f), randomRange(seed, 0.5f, 2.0f), randomRange(seed, 0.5f, 2.0f));
+    object.velocity = XMFLOAT3(randomRange(seed, -5.0f, 5.0f), randomRange(seed, -5.0f, 5.0f), randomRange(seed, -5.0f, 5.0f));
+  }
+
+  SceneBvh bvh;
+  auto start = std::chrono::high_resolution_clock::now();
+  for (unsigned int i = 0; i < objectCount; ++i) {
+    objects[i].proxy = bvh.createProxy(objects[i].center, objects[i].extents, i);
+  }
+  const double buildMs = elapsedMs(start);
+  bvh.resetStats();
+
+  // Todos los objetos se mueven en cada cuadro y rebotan en los bordes del mundo
+  double updateMs = 0.0;
+  for (int frame = 0; frame < frames; ++frame) {
+    start = std::chrono::high_resolution_clock::now();
+    for (Object& object : objects) {
+      float* position = &object.center.x;
+      float* velocity = &object.velocity.x;
+      for (int axis = 0; axis < 3; ++axis) {
+        position[axis] += velocity[axis] * dt;
+        if (position[axis] < -kHalfWorld || position[axis] > kHalfWorld) {
+          velocity[axis] = -velocity[axis];
+        }
+      }
+      const XMFLOAT3 displacement(object.velocity.x * dt, object.velocity.y * dt, object.velocity.z * dt);
+      bvh.moveProxy(object.proxy, object.center, object.extents, displacement);
+    }
+    updateMs += elapsedMs(start);
+  }
+  const Stats updateStats = bvh.m_stats;
+  bool ok = bvh.validate();
+
+  // Frustum: el rbol contra la prueba plana de FrustumCuller sobre las mismas cajas
+  FrustumCuller culler;
+  for (const Object& object : objects) {
+    culler.add(object.center, object.extents, 0.0f);
+  }
+  const XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f),
+    XMVectorSet(0.3f, 0.1f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+  const XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 400.0f);
+  const FrustumCuller::Frustum frustum = FrustumCuller::extractFrustum(view * projection);
+  const int kQueries = 20;
+
+  std::vector<unsigned int> flatVisible, treeVisible;
+  start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < kQueries; ++i) {
+    culler.cull(frustum, flatVisible, FrustumCuller::TEST_AABB);
+  }
+  const double flatMs = elapsedMs(start) / kQueries;
+
+  bvh.resetStats();
+  start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < kQueries; ++i) {
+    treeVisible.clear();
+    bvh.queryFrustum(frustum, treeVisible);
+  }
+  const double treeMs = elapsedMs(start) / kQueries;
+  const unsigned long long frustumNodes = bvh.m_stats.nodesVisited / kQueries;
+
+  // Las cajas gordas solo agregan objetos: cada visible exacto debe estar en el rbol
+  std::vector<char> inTree(objectCount, 0);
+  for (unsigned int index : treeVisible) inTree[index] = 1;
+  for (unsigned int index : flatVisible) ok = ok && inTree[index];
+
+  // Rayos: con la prueba exacta sobre la caja real el resultado debe coincidir
+  // con la bsqueda lineal
+  const int kRays = 1000;
+  auto exactBox = [&](unsigned int userData, const float o[3], const float inverse[3], float maxDistance) {
+    const Object& object = objects[userData];
+    const float minimum[3] = { object.center.x - object.extents.x, object.center.y - object.extents.y,
+                               object.center.z - object.extents.z };
+    const float maximum[3] = { object.center.x + object.extents.x, object.center.y + object.extents.y,
+                               object.center.z + object.extents.z };
+    return rayBox(o, inverse, minimum, maximum, maxDistance);
+  };
+  double rayMs = 0.0, linearMs = 0.0;
+  unsigned int rayHits = 0;
+  bvh.resetStats();
+  for (int r = 0; r < kRays; ++r) {
+    const XMFLOAT3 origin(randomRange(seed, -kHalfWorld, kHalfWorld), randomRange(seed, -kHalfWorld, kHalfWorld),
+      randomRange(seed, -kHalfWorld, kHalfWorld));
+    XMFLOAT3 direction(randomRange(seed, -1.0f, 1.0f), randomRange(seed, -1.0f, 1.0f), randomRange(seed, -1.0f, 1.0f));
+    const float length = sqrtf(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+    direction = XMFLOAT3(direction.x / length, direction.y / length, direction.z / length);
+    const float o[3] = { origin.x, origin.y, origin.z };
+    const float inverse[3] = { 1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z };
+    const float maxDistance = 1000.0f;
+
+    start = std::chrono::high_resolution_clock::now();
+    RayHit hit;
+    const bool found = bvh.rayCast(origin, direction, maxDistance, hit,
+      [&](unsigned int userData, float) { return exactBox(userData, o, inverse, maxDistance); });
+    rayMs += elapsedMs(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    float best = maxDistance;
+    bool linearFound = false;
+    for (unsigned int i = 0; i < objectCount; ++i) {
+      const float distance = exactBox(i, o, inverse, best);
+      if (distance >= 0.0f && distance <= best) {
+        best = distance;
+        linearFound = true;
+      }
+    }
+    linearMs += elapsedMs(start);
+
+    ok = ok && found == linearFound && (!found || hit.distance == best);
+    rayHits += found ? 1 : 0;
+  }
+  const unsigned long long rayNodes = bvh.m_stats.nodesVisited / kRays;
+
+  std::wostringstream wss;
+  wss << objectCount << L" moving objects x " << frames << L" frames: build " << buildMs << L" ms, update "
+      << updateMs / frames << L" ms/frame (" << updateMs * 1.0e6 / ((double)frames * (objectCount ? objectCount : 1))
+      << L" ns/object), " << (double)updateStats.reinserts / frames << L" reinserts and "
+      << (double)updateStats.rotations / frames << L" rotations per frame; height " << bvh.height()
+      << L", area ratio " << bvh.areaRatio();
+  MESSAGE(L"SceneBvh", L"benchmark", wss.str().c_str());
+  wss.str(L"");
+  wss << L"  frustum: tree " << treeMs << L" ms (" << treeVisible.size() << L" objects, " << frustumNodes
+      << L" nodes) vs flat " << flatMs << L" ms (" << flatVisible.size() << L" objects); rays: "
+      << rayMs * 1000.0 / kRays << L" us/ray (" << rayNodes << L" nodes, " << rayHits << L"/" << kRays
+      << L" hits) vs linear " << linearMs * 1000.0 / kRays << L" us/ray";
+  MESSAGE(L"SceneBvh", L"benchmark", wss.str().c_str());
+
+  if (!ok) {
+    ERROR(L"SceneBvh", L"benchmark", L"Tree validation or a query did not match the reference");
+  }
+  return ok;
+}
@@ -1,13 +1,16 @@
 #include "ShaderProgram.h"
 #include "Device.h"
 #include "DeviceContext.h"
+#include "NullBackend.h"
 
 
 HRESULT
 ShaderProgram::init(Device& device,
 	const std::string& fileName,
-	std::vector<D3D11_INPUT_ELEMENT_DESC> Layout) {
-	if (!device.m_device) {
+	std::vector<D3D11_INPUT_ELEMENT_DESC> Layout,
+	const std::string& vertexEntryPoint,
+	const std::string& pixelEntryPoint) {
+	if (!device.isValid()) {
 		ERROR("ShaderProgram", "init", "Device is null.");
 		return E_POINTER;
 	}
@@ -20,6 +23,8 @@ ShaderProgram::init(Device& device,
 		return E_INVALIDARG;
 	}
 	m_shaderFileName = fileName;
+	m_vertexEntryPoint = vertexEntryPoint;
+	m_pixelEntryPoint = pixelEntryPoint;
 	// Create the Vertex Shader
 	HRESULT hr = CreateShader(device, ShaderType::VERTEX_SHADER);
 	if (FAILED(hr)) {
@@ -35,7 +40,7 @@ ShaderProgram::init(Device& device,
 	}
 
 	// Create the Pixel Shader
-	hr = CreateShader(device, ShaderType::VERTEX_SHADER);
+	hr = CreateShader(device, ShaderType::PIXEL_SHADER);
 	if (FAILED(hr)) {
 		ERROR("ShaderProgram", "init", "Failed to create pixel shader.");
 		return hr;
@@ -51,7 +56,7 @@ ShaderProgram::CreateInputLayout(Device& device,
 		ERROR("ShaderProgram", "CreateInputLayout", "Vertex shader data is null.");
 		return E_POINTER;
 	}
-	if (!device.m_device) {
+	if (!device.isValid()) {
 		ERROR("ShaderProgram", "CreateInputLayout", "Device is null.");
 		return E_POINTER;
 	}
@@ -73,7 +78,7 @@ ShaderProgram::CreateInputLayout(Device& device,
 
 HRESULT
 ShaderProgram::CreateShader(Device& device, ShaderType type) {
-	if (!device.m_device) {
+	if (!device.isValid()) {
 		ERROR("ShaderProgram", "CreateShader", "Device is null.");
 		return E_POINTER;
 	}
@@ -85,14 +90,22 @@ ShaderProgram::CreateShader(Device& device, ShaderType type) {
 	HRESULT hr = S_OK;
 	ID3DBlob* shaderData = nullptr;
 
-	const char* shaderEntryPoint = (type == ShaderType::PIXEL_SHADER) ? "PS" : "VS";
+	const char* shaderEntryPoint = (type == ShaderType::PIXEL_SHADER) ? m_pixelEntryPoint.c_str() : m_vertexEntryPoint.c_str();
 	const char* shaderModel = (type == ShaderType::PIXEL_SHADER) ? "ps_4_0" : "vs_4_0";
 
-	// Compile the shader from file
-	hr = CompileShaderFromFile(m_shaderFileName.data(),
-														shaderEntryPoint,
-														shaderModel,
-														&shaderData);
+	// Compile the shader from file (headless: the backend returns the source as bytecode)
+	if (device.m_nullBackend) {
+		hr = device.m_nullBackend->CompileShaderFromFile(m_shaderFileName,
+																										shaderEntryPoint,
+																										shaderModel,
+																										&shaderData);
+	}
+	else {
+		hr = CompileShaderFromFile(m_shaderFileName.data(),
+															shaderEntryPoint,
+															shaderModel,
+															&shaderData);
+	}
 
 	if (FAILED(hr)) {
 		ERROR("ShaderProgram", "CreateShader",
@@ -121,6 +134,8 @@ ShaderProgram::CreateShader(Device& device, ShaderType type) {
 		return hr;
 	}
 
+	m_bytecodeSize += shaderData->GetBufferSize();
+
 	// Store the compiled shader data
 	if (type == PIXEL_SHADER) {
 		SAFE_RELEASE(m_pixelShaderData);
@@ -138,7 +153,7 @@ HRESULT
 ShaderProgram::CreateShader(Device& device,
 	ShaderType type,
 	const std::string& fileName) {
-	if (!device.m_device) {
+	if (!device.isValid()) {
 		ERROR("ShaderProgram", "init", "Device is null.");
 		return E_POINTER;
 	}
@@ -216,22 +231,22 @@ ShaderProgram::render(DeviceContext& deviceContext) {
 	}
 
 	m_inputLayout.render(deviceContext);
-	deviceContext.m_deviceContext->VSSetShader(m_VertexShader, nullptr, 0);
-	deviceContext.m_deviceContext->PSSetShader(m_PixelShader, nullptr, 0);
+	deviceContext.VSSetShader(m_VertexShader, nullptr, 0);
+	deviceContext.PSSetShader(m_PixelShader, nullptr, 0);
 }
 
 void
 ShaderProgram::render(DeviceContext& deviceContext, ShaderType type) {
-	if (!deviceContext.m_deviceContext) {
+	if (!deviceContext.isValid()) {
 		ERROR("RenderTargetView", "render", "DeviceContext is nullptr.");
 		return;
 	}
 	switch (type) {
 	case VERTEX_SHADER:
-		deviceContext.m_deviceContext->VSSetShader(m_VertexShader, nullptr, 0);
+		deviceContext.VSSetShader(m_VertexShader, nullptr, 0);
 		break;
 	case PIXEL_SHADER:
-		deviceContext.m_deviceContext->PSSetShader(m_PixelShader, nullptr, 0);
+		deviceContext.PSSetShader(m_PixelShader, nullptr, 0);
 		break;
 	default:
 		break;
@@ -245,4 +260,5 @@ ShaderProgram::destroy() {
 	SAFE_RELEASE(m_PixelShader);
 	SAFE_RELEASE(m_vertexShaderData);
 	SAFE_RELEASE(m_pixelShaderData);
+	m_bytecodeSize = 0;
 }
\ No newline at end of file
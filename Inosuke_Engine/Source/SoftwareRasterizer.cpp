@@ -0,0 +1,752 @@
+#include "SoftwareRasterizer.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <emmintrin.h>
+
+namespace {
+  /// Vrtices por trabajo en la fase de vrtices y tringulos por grupo de setup.
+  const unsigned int kVerticesPerJob = 4096;
+  const unsigned int kTrianglesPerJob = 1024;
+
+  /// Matriz en la convencin de XNA (vector fila): p' = p * M.
+  struct Matrix4 {
+    float m[4][4];
+  };
+
+  /// Los constant buffers guardan las matrices transpuestas (ver BaseApp::update).
+  Matrix4
+  loadTransposed(const void* data) {
+    float stored[16];
+    memcpy(stored, data, sizeof(stored));
+    Matrix4 result;
+    for (int row = 0; row < 4; ++row) {
+      for (int col = 0; col < 4; ++col) {
+        result.m[row][col] = stored[col * 4 + row];
+      }
+    }
+    return result;
+  }
+
+  Matrix4
+  multiply(const Matrix4& a, const Matrix4& b) {
+    Matrix4 result;
+    for (int row = 0; row < 4; ++row) {
+      for (int col = 0; col < 4; ++col) {
+        result.m[row][col] = a.m[row][0] * b.m[0][col] + a.m[row][1] * b.m[1][col] +
+          a.m[row][2] * b.m[2][col] + a.m[row][3] * b.m[3][col];
+      }
+    }
+    return result;
+  }
+
+  /// Recorta a [0, 1]; NaN queda en 0.
+  float
+  saturate(float value) {
+    return value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f;
+  }
+
+  unsigned int
+  packColor(float r, float g, float b, float a) {
+    return (unsigned int)(saturate(r) * 255.0f + 0.5f) |
+      ((unsigned int)(saturate(g) * 255.0f + 0.5f) << 8) |
+      ((unsigned int)(saturate(b) * 255.0f + 0.5f) << 16) |
+      ((unsigned int)(saturate(a) * 255.0f + 0.5f) << 24);
+  }
+
+  /// Plano f = a*px + b*py + c que pasa por (x[i], y[i], f[i]).
+  void
+  computePlane(const float x[3], const float y[3], const float f[3], float invArea, float plane[3]) {
+    const float df1 = f[1] - f[0];
+    const float df2 = f[2] - f[0];
+    const float dx1 = x[1] - x[0];
+    const float dx2 = x[2] - x[0];
+    const float dy1 = y[1] - y[0];
+    const float dy2 = y[2] - y[0];
+    plane[0] = (df1 * dy2 - df2 * dy1) * invArea;
+    plane[1] = (df2 * dx1 - df1 * dx2) * invArea;
+    plane[2] = f[0] - plane[0] * x[0] - plane[1] * y[0];
+  }
+
+  /// floor() de 4 floats con SSE2.
+  __m128
+  floor4(__m128 value) {
+    const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(value));
+    return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, value), _mm_set1_ps(1.0f)));
+  }
+
+  /// Texel RGBA8 a 4 floats (0..255).
+  __m128
+  loadTexel(const unsigned char* texel) {
+    int bits;
+    memcpy(&bits, texel, sizeof(bits));
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bytes = _mm_cvtsi32_si128(bits);
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero));
+  }
+
+  /**
+   * Pixel shader de Inosuke_Engine.fx para 4 pixeles: muestreo bilineal con wrap
+   * (el sampler de SamplerState::init) por vMeshColor. Solo escribe los carriles
+   * marcados en @p bits.
+   */
+  void
+  shadePixels(const SoftwareRasterizer::Texture& texture,
+    __m128 u,
+    __m128 v,
+    __m128 meshColor,
+    int bits,
+    unsigned int* out) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 maxColor = _mm_set1_ps(255.0f);
+    if (!texture.texels) {
+      const __m128 color = _mm_min_ps(_mm_max_ps(_mm_mul_ps(meshColor, maxColor), zero), maxColor);
+      const __m128i packed = _mm_cvtps_epi32(color);
+      const unsigned int rgba = (unsigned int)_mm_cvtsi128_si32(
+        _mm_packus_epi16(_mm_packs_epi32(packed, packed), _mm_setzero_si128()));
+      for (int lane = 0; lane < 4; ++lane) {
+        if (bits & (1 << lane)) out[lane] = rgba;
+      }
+      return;
+    }
+
+    const int width = (int)texture.width;
+    const int height = (int)texture.height;
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 fu = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(u, floor4(u)), _mm_set1_ps((float)width)), half);
+    const __m128 fv = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(v, floor4(v)), _mm_set1_ps((float)height)), half);
+    const __m128 flooredU = floor4(fu);
+    const __m128 flooredV = floor4(fv);
+    alignas(16) float tu[4];
+    alignas(16) float tv[4];
+    alignas(16) int x0s[4];
+    alignas(16) int y0s[4];
+    _mm_store_ps(tu, _mm_sub_ps(fu, flooredU));
+    _mm_store_ps(tv, _mm_sub_ps(fv, flooredV));
+    _mm_store_si128((__m128i*)x0s, _mm_cvttps_epi32(flooredU));
+    _mm_store_si128((__m128i*)y0s, _mm_cvttps_epi32(flooredV));
+
+    for (int lane = 0; lane < 4; ++lane) {
+      if (!(bits & (1 << lane))) {
+        continue;
+      }
+      // floor(fu) est en [-1, width - 1]; el clamp protege de u/v no finitos
+      int x0 = x0s[lane] < 0 ? x0s[lane] + width : x0s[lane];
+      int y0 = y0s[lane] < 0 ? y0s[lane] + height : y0s[lane];
+      x0 = (std::min)((std::max)(x0, 0), width - 1);
+      y0 = (std::min)((std::max)(y0, 0), height - 1);
+      const int x1 = x0 + 1 == width ? 0 : x0 + 1;
+      const int y1 = y0 + 1 == height ? 0 : y0 + 1;
+
+      const unsigned char* row0 = texture.texels + (size_t)y0 * width * 4;
+      const unsigned char* row1 = texture.texels + (size_t)y1 * width * 4;
+      const __m128 t00 = loadTexel(row0 + x0 * 4);
+      const __m128 t10 = loadTexel(row0 + x1 * 4);
+      const __m128 t01 = loadTexel(row1 + x0 * 4);
+      const __m128 t11 = loadTexel(row1 + x1 * 4);
+      const __m128 weightU = _mm_set1_ps(tu[lane]);
+      const __m128 top = _mm_add_ps(t00, _mm_mul_ps(_mm_sub_ps(t10, t00), weightU));
+      const __m128 bottom = _mm_add_ps(t01, _mm_mul_ps(_mm_sub_ps(t11, t01), weightU));
+      const __m128 texel = _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), _mm_set1_ps(tv[lane])));
+
+      // max(x, 0) deja NaN en 0 (vMeshColor.w puede no estar inicializado)
+      const __m128 color = _mm_min_ps(_mm_max_ps(_mm_mul_ps(texel, meshColor), zero), maxColor);
+      const __m128i packed = _mm_cvtps_epi32(color);
+      out[lane] = (unsigned int)_mm_cvtsi128_si32(
+        _mm_packus_epi16(_mm_packs_epi32(packed, packed), _mm_setzero_si128()));
+    }
+  }
+
+  void
+  addStats(SoftwareRasterizer::Stats& total, const SoftwareRasterizer::Stats& stats) {
+    total.trianglesCulled += stats.trianglesCulled;
+    total.trianglesClipped += stats.trianglesClipped;
+    total.blocksHiZRejected += stats.blocksHiZRejected;
+    total.blocksFull += stats.blocksFull;
+    total.blocksPartial += stats.blocksPartial;
+    total.pixelsWritten += stats.pixelsWritten;
+  }
+
+  unsigned int
+  bitCount(int mask) {
+    return (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+  }
+}
+
+HRESULT
+SoftwareRasterizer::init(unsigned int width, unsigned int height, JobSystem* jobs) {
+  if (width == 0 || height == 0) {
+    ERROR("SoftwareRasterizer", "init", "Width and height must be greater than zero");
+    return E_INVALIDARG;
+  }
+  destroy();
+
+  m_width = width;
+  m_height = height;
+  m_tilesX = (width + kTileSize - 1) / kTileSize;
+  m_tilesY = (height + kTileSize - 1) / kTileSize;
+  m_pitch = m_tilesX * kTileSize;
+  m_paddedHeight = m_tilesY * kTileSize;
+  m_blocksX = m_pitch / kBlockSize;
+
+  m_color.assign((size_t)m_pitch * m_paddedHeight, 0);
+  m_depth.assign((size_t)m_pitch * m_paddedHeight, 1.0f);
+  m_hiZ.assign((size_t)m_blocksX * (m_paddedHeight / kBlockSize), 1.0f);
+  m_bins.assign((size_t)m_tilesX * m_tilesY, std::vector<unsigned int>());
+  m_stats = Stats();
+  m_jobs = jobs;
+
+  std::wostringstream wss;
+  wss << width << L"x" << height << L", " << m_tilesX * m_tilesY << L" tiles, "
+    << (jobs ? L"JobSystem" : L"single thread");
+  MESSAGE(L"SoftwareRasterizer", L"init", wss.str());
+  return S_OK;
+}
+
+void
+SoftwareRasterizer::destroy() {
+  m_jobs = nullptr;
+  m_color.clear();
+  m_depth.clear();
+  m_hiZ.clear();
+  m_clip.clear();
+  m_setup.clear();
+  m_bins.clear();
+  m_triangles.clear();
+  m_jobStats.clear();
+  m_width = m_height = 0;
+}
+
+unsigned int
+SoftwareRasterizer::getThreadCount() const {
+  return m_jobs && m_jobs->isValid() ? m_jobs->getThreadCount() : 1;
+}
+
+void
+SoftwareRasterizer::runParallel(unsigned int jobCount, const std::function<void(unsigned int)>& job) {
+  if (jobCount == 0) {
+    return;
+  }
+  if (getThreadCount() <= 1 || jobCount == 1) {
+    for (unsigned int i = 0; i < jobCount; ++i) {
+      job(i);
+    }
+    return;
+  }
+  // Cada ndice ya es un tile o un grupo entero: grano 1
+  m_jobs->parallelFor(jobCount, 1, [&job](unsigned int begin, unsigned int end) {
+    for (unsigned int i = begin; i < end; ++i) {
+      job(i);
+    }
+  });
+}
+
+void
+SoftwareRasterizer::clearColor(const float colorRGBA[4]) {
+  if (m_color.empty()) {
+    ERROR("SoftwareRasterizer", "clearColor", "Rasterizer is not initialized");
+    return;
+  }
+  const auto start = std::chrono::high_resolution_clock::now();
+  const unsigned int packed = packColor(colorRGBA[0], colorRGBA[1], colorRGBA[2], colorRGBA[3]);
+  const size_t rowsPerJob = (size_t)kTileSize * m_pitch;
+  runParallel(m_tilesY, [&](unsigned int job) {
+    std::fill(m_color.begin() + job * rowsPerJob, m_color.begin() + (job + 1) * rowsPerJob, packed);
+  });
+  m_stats.clearMs += std::chrono::duration<double, std::milli>(
+    std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void
+SoftwareRasterizer::clearDepth(float depth) {
+  if (m_depth.empty()) {
+    ERROR("SoftwareRasterizer", "clearDepth", "Rasterizer is not initialized");
+    return;
+  }
+  const auto start = std::chrono::high_resolution_clock::now();
+  const size_t rowsPerJob = (size_t)kTileSize * m_pitch;
+  runParallel(m_tilesY, [&](unsigned int job) {
+    std::fill(m_depth.begin() + job * rowsPerJob, m_depth.begin() + (job + 1) * rowsPerJob, depth);
+  });
+  std::fill(m_hiZ.begin(), m_hiZ.end(), depth);
+  m_stats.clearMs += std::chrono::duration<double, std::milli>(
+    std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void
+SoftwareRasterizer::drawIndexed(const DrawCall& draw) {
+  if (m_color.empty()) {
+    ERROR("SoftwareRasterizer", "drawIndexed", "Rasterizer is not initialized");
+    return;
+  }
+  if (!draw.vertices || !draw.indices) {
+    ERROR("SoftwareRasterizer", "drawIndexed", "Vertex or index data is nullptr");
+    return;
+  }
+  if (!draw.neverChanges || !draw.changeOnResize || !draw.changesEveryFrame) {
+    ERROR("SoftwareRasterizer", "drawIndexed", "Constant buffers b0, b1 and b2 must be bound");
+    return;
+  }
+  if ((unsigned long long)draw.startIndex + draw.drawCount > draw.indexCount) {
+    ERROR("SoftwareRasterizer", "drawIndexed", "Index range is outside the index buffer");
+    return;
+  }
+  const auto start = std::chrono::high_resolution_clock::now();
+
+  // Estado del draw: viewport recortado al target, color y textura del pixel shader
+  m_scissor[0] = (std::max)(0, (int)draw.viewport.TopLeftX);
+  m_scissor[1] = (std::max)(0, (int)draw.viewport.TopLeftY);
+  m_scissor[2] = (std::min)((int)m_width, (int)(draw.viewport.TopLeftX + draw.viewport.Width));
+  m_scissor[3] = (std::min)((int)m_height, (int)(draw.viewport.TopLeftY + draw.viewport.Height));
+  memcpy(m_meshColor, (const char*)draw.changesEveryFrame + sizeof(XMMATRIX), sizeof(m_meshColor));
+  m_texture = draw.texture;
+
+  // Vertex shader: Pos * World * View * Projection, Tex sin cambios
+  const Matrix4 transform = multiply(multiply(loadTransposed(draw.changesEveryFrame),
+    loadTransposed(draw.neverChanges)), loadTransposed(draw.changeOnResize));
+  m_clip.resize(draw.vertexCount);
+  runParallel((draw.vertexCount + kVerticesPerJob - 1) / kVerticesPerJob, [&](unsigned int job) {
+    const unsigned int first = job * kVerticesPerJob;
+    const unsigned int last = (std::min)(draw.vertexCount, first + kVerticesPerJob);
+    for (unsigned int i = first; i < last; ++i) {
+      const SimpleVertex& vertex = draw.vertices[i];
+      float* clip = &m_clip[i].x;
+      for (int col = 0; col < 4; ++col) {
+        clip[col] = vertex.Pos.x * transform.m[0][col] + vertex.Pos.y * transform.m[1][col] +
+          vertex.Pos.z * transform.m[2][col] + transform.m[3][col];
+      }
+      m_clip[i].u = vertex.Tex.x;
+      m_clip[i].v = vertex.Tex.y;
+    }
+  });
+
+  // Setup en paralelo por grupos de tringulos
+  const unsigned int triangleCount = draw.drawCount / 3;
+  const unsigned int groupCount = (triangleCount + kTrianglesPerJob - 1) / kTrianglesPerJob;
+  if (m_setup.size() < groupCount) {
+    m_setup.resize(groupCount);
+  }
+  m_jobStats.assign((std::max)((size_t)groupCount, m_bins.size()), Stats());
+  runParallel(groupCount, [&](unsigned int job) {
+    const unsigned int first = job * kTrianglesPerJob;
+    m_setup[job].clear();
+    setupTriangles(draw, first, (std::min)(kTrianglesPerJob, triangleCount - first),
+      m_setup[job], m_jobStats[job]);
+  });
+  for (unsigned int group = 0; group < groupCount; ++group) {
+    addStats(m_stats, m_jobStats[group]);
+    m_jobStats[group] = Stats();
+  }
+
+  // Binning en orden de draw: cada tile ve sus tringulos en el orden original
+  for (std::vector<unsigned int>& bin : m_bins) {
+    bin.clear();
+  }
+  m_triangles.clear();
+  for (unsigned int group = 0; group < groupCount; ++group) {
+    for (const Triangle& triangle : m_setup[group]) {
+      const unsigned int index = (unsigned int)m_triangles.size();
+      m_triangles.push_back(&triangle);
+      const unsigned int tileX0 = triangle.minX / kTileSize;
+      const unsigned int tileX1 = triangle.maxX / kTileSize;
+      const unsigned int tileY0 = triangle.minY / kTileSize;
+      const unsigned int tileY1 = triangle.maxY / kTileSize;
+      for (unsigned int tileY = tileY0; tileY <= tileY1; ++tileY) {
+        for (unsigned int tileX = tileX0; tileX <= tileX1; ++tileX) {
+          m_bins[tileY * m_tilesX + tileX].push_back(index);
+        }
+      }
+      m_stats.binEntries += (tileX1 - tileX0 + 1) * (tileY1 - tileY0 + 1);
+    }
+  }
+
+  // Raster en paralelo por tile
+  runParallel((unsigned int)m_bins.size(), [&](unsigned int tile) {
+    if (!m_bins[tile].empty()) {
+      rasterizeTile(tile, m_jobStats[tile]);
+    }
+  });
+  for (size_t tile = 0; tile < m_bins.size(); ++tile) {
+    addStats(m_stats, m_jobStats[tile]);
+  }
+
+  ++m_stats.draws;
+  m_stats.triangles += triangleCount;
+  m_stats.drawMs += std::chrono::duration<double, std::milli>(
+    std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void
+SoftwareRasterizer::setupTriangles(const DrawCall& draw,
+  unsigned int first,
+  unsigned int count,
+  std::vector<Triangle>& out,
+  Stats& stats) const {
+  const unsigned short* indices16 = static_cast<const unsigned short*>(draw.indices);
+  const unsigned int* indices32 = static_cast<const unsigned int*>(draw.indices);
+
+  // Punto del plano cercano; siempre desde el vrtice de adentro para que una
+  // arista compartida produzca el mismo punto en los dos tringulos.
+  auto clipNear = [](const ClipVertex& in, const ClipVertex& outside) {
+    const float t = in.z / (in.z - outside.z);
+    ClipVertex result;
+    result.x = in.x + (outside.x - in.x) * t;
+    result.y = in.y + (outside.y - in.y) * t;
+    result.z = 0.0f;
+    result.w = in.w + (outside.w - in.w) * t;
+    result.u = in.u + (outside.u - in.u) * t;
+    result.v = in.v + (outside.v - in.v) * t;
+    return result;
+  };
+
+  for (unsigned int triangle = first; triangle < first + count; ++triangle) {
+    const ClipVertex* vertex[3];
+    bool valid = true;
+    for (int k = 0; k < 3; ++k) {
+      const unsigned int slot = draw.startIndex + triangle * 3 + k;
+      const long long index = (long long)(draw.indices16 ? indices16[slot] : indices32[slot]) + draw.baseVertex;
+      if (index < 0 || index >= (long long)draw.vertexCount) {
+        valid = false;
+        break;
+      }
+      vertex[k] = &m_clip[(size_t)index];
+    }
+    if (!valid) {
+      ++stats.trianglesCulled;
+      continue;
+    }
+
+    // Recorte contra el plano cercano (z >= 0 en espacio de recorte)
+    const bool inside[3] = { vertex[0]->z >= 0.0f, vertex[1]->z >= 0.0f, vertex[2]->z >= 0.0f };
+    const int insideCount = (int)inside[0] + (int)inside[1] + (int)inside[2];
+    const size_t before = out.size();
+    if (insideCount == 3) {
+      addTriangle(*vertex[0], *vertex[1], *vertex[2], draw.viewport, out);
+    }
+    else if (insideCount > 0) {
+      ++stats.trianglesClipped;
+      ClipVertex polygon[4];
+      int polygonSize = 0;
+      for (int k = 0; k < 3; ++k) {
+        const int next = (k + 1) % 3;
+        if (inside[k]) {
+          polygon[polygonSize++] = *vertex[k];
+        }
+        if (inside[k] != inside[next]) {
+          polygon[polygonSize++] = inside[k]
+            ? clipNear(*vertex[k], *vertex[next])
+            : clipNear(*vertex[next], *vertex[k]);
+        }
+      }
+      for (int k = 1; k + 1 < polygonSize; ++k) {
+        addTriangle(polygon[0], polygon[k], polygon[k + 1], draw.viewport, out);
+      }
+    }
+    if (out.size() == before) {
+      ++stats.trianglesCulled;
+    }
+  }
+}
+
+bool
+SoftwareRasterizer::addTriangle(const ClipVertex& v0,
+  const ClipVertex& v1,
+  const ClipVertex& v2,
+  const D3D11_VIEWPORT& viewport,
+  std::vector<Triangle>& out) const {
+  const ClipVertex* vertex[3] = { &v0, &v1, &v2 };
+  float x[3], y[3], z[3], invW[3], uOverW[3], vOverW[3];
+  for (int k = 0; k < 3; ++k) {
+    const float rcpW = 1.0f / vertex[k]->w;
+    // Centro del pixel en coordenadas enteras
+    x[k] = viewport.TopLeftX + (vertex[k]->x * rcpW * 0.5f + 0.5f) * viewport.Width - 0.5f;
+    y[k] = viewport.TopLeftY + (0.5f - vertex[k]->y * rcpW * 0.5f) * viewport.Height - 0.5f;
+    z[k] = viewport.MinDepth + vertex[k]->z * rcpW * (viewport.MaxDepth - viewport.MinDepth);
+    invW[k] = rcpW;
+    uOverW[k] = vertex[k]->u * rcpW;
+    vOverW[k] = vertex[k]->v * rcpW;
+  }
+
+  // Positiva para tringulos horarios en pantalla (frente en D3D11); descarta traseros y NaN
+  const float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+  if (!(area > 0.0f)) {
+    return false;
+  }
+
+  Triangle triangle;
+  const float minX = (std::max)((std::min)({ x[0], x[1], x[2] }), (float)m_scissor[0]);
+  const float maxX = (std::min)((std::max)({ x[0], x[1], x[2] }), (float)(m_scissor[2] - 1));
+  const float minY = (std::max)((std::min)({ y[0], y[1], y[2] }), (float)m_scissor[1]);
+  const float maxY = (std::min)((std::max)({ y[0], y[1], y[2] }), (float)(m_scissor[3] - 1));
+  if (!(minX <= maxX) || !(minY <= maxY)) {
+    return false;
+  }
+  triangle.minX = (int)ceilf(minX);
+  triangle.maxX = (int)floorf(maxX);
+  triangle.minY = (int)ceilf(minY);
+  triangle.maxY = (int)floorf(maxY);
+  if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) {
+    return false;
+  }
+
+  for (int edge = 0; edge < 3; ++edge) {
+    const int a = edge;
+    const int b = (edge + 1) % 3;
+    const bool swapped = x[b] < x[a] || (x[b] == x[a] && y[b] < y[a]);
+    const int start = swapped ? b : a;
+    const int end = swapped ? a : b;
+    triangle.edgeX[edge] = x[start];
+    triangle.edgeY[edge] = y[start];
+    triangle.edgeDx[edge] = x[end] - x[start];
+    triangle.edgeDy[edge] = y[end] - y[start];
+    triangle.edgeSign[edge] = swapped ? -1.0f : 1.0f;
+
+    // Top: horizontal con el interior abajo. Left: sube en pantalla.
+    const float dx = x[b] - x[a];
+    const float dy = y[b] - y[a];
+    triangle.edgeTopLeft[edge] = (dy == 0.0f && dx > 0.0f) || dy < 0.0f;
+  }
+
+  const float invArea = 1.0f / area;
+  computePlane(x, y, z, invArea, triangle.zPlane);
+  computePlane(x, y, invW, invArea, triangle.invWPlane);
+  computePlane(x, y, uOverW, invArea, triangle.uPlane);
+  computePlane(x, y, vOverW, invArea, triangle.vPlane);
+  triangle.zMin = (std::min)({ z[0], z[1], z[2] });
+  triangle.zMax = (std::max)({ z[0], z[1], z[2] });
+
+  out.push_back(triangle);
+  return true;
+}
+
+void
+SoftwareRasterizer::rasterizeTile(unsigned int tile, Stats& stats) {
+  const int tileX = (int)(tile % m_tilesX) * kTileSize;
+  const int tileY = (int)(tile / m_tilesX) * kTileSize;
+  const int clipX0 = (std::max)(tileX, m_scissor[0]);
+  const int clipY0 = (std::max)(tileY, m_scissor[1]);
+  const int clipX1 = (std::min)(tileX + (int)kTileSize, m_scissor[2]) - 1;
+  const int clipY1 = (std::min)(tileY + (int)kTileSize, m_scissor[3]) - 1;
+  if (clipX0 > clipX1 || clipY0 > clipY1) {
+    return;
+  }
+
+  const int last = kBlockSize - 1;
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 laneOffsets[2] = { _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f), _mm_setr_ps(4.0f, 5.0f, 6.0f, 7.0f) };
+  const __m128 scissorX0 = _mm_set1_ps((float)clipX0);
+  const __m128 scissorX1 = _mm_set1_ps((float)clipX1);
+  const __m128 meshColor = _mm_loadu_ps(m_meshColor);
+
+  for (unsigned int index : m_bins[tile]) {
+    const Triangle& triangle = *m_triangles[index];
+    const int x0 = (std::max)(triangle.minX, clipX0);
+    const int x1 = (std::min)(triangle.maxX, clipX1);
+    const int y0 = (std::max)(triangle.minY, clipY0);
+    const int y1 = (std::min)(triangle.maxY, clipY1);
+    if (x0 > x1 || y0 > y1) {
+      continue;
+    }
+
+    float stepX[3], stepY[3];
+    __m128 stepXLanes[3][2];
+    for (int edge = 0; edge < 3; ++edge) {
+      stepX[edge] = -triangle.edgeSign[edge] * triangle.edgeDy[edge];
+      stepY[edge] = triangle.edgeSign[edge] * triangle.edgeDx[edge];
+      stepXLanes[edge][0] = _mm_mul_ps(_mm_set1_ps(stepX[edge]), laneOffsets[0]);
+      stepXLanes[edge][1] = _mm_mul_ps(_mm_set1_ps(stepX[edge]), laneOffsets[1]);
+    }
+    const __m128 zStep = _mm_set1_ps(triangle.zPlane[0]);
+    const __m128 invWStep = _mm_set1_ps(triangle.invWPlane[0]);
+    const __m128 uStep = _mm_set1_ps(triangle.uPlane[0]);
+    const __m128 vStep = _mm_set1_ps(triangle.vPlane[0]);
+
+    for (int blockY = y0 & ~last; blockY <= y1; blockY += kBlockSize) {
+      for (int blockX = x0 & ~last; blockX <= x1; blockX += kBlockSize) {
+        // Aristas en la esquina del bloque. E(px, py) = (E0 + stepY*dy) + stepX*dx
+        // es montona en dx y dy, as que sus extremos estn en las 4 esquinas.
+        float origin[3];
+        bool rejected = false;
+        bool full = true;
+        for (int edge = 0; edge < 3 && !rejected; ++edge) {
+          const float s = triangle.edgeSign[edge];
+          origin[edge] = s * (triangle.edgeDx[edge] * ((float)blockY - triangle.edgeY[edge]) -
+            triangle.edgeDy[edge] * ((float)blockX - triangle.edgeX[edge]));
+          const float bottom = origin[edge] + stepY[edge] * last;
+          const float corners[4] = { origin[edge], origin[edge] + stepX[edge] * last,
+            bottom, bottom + stepX[edge] * last };
+          const float cornerMin = (std::min)({ corners[0], corners[1], corners[2], corners[3] });
+          const float cornerMax = (std::max)({ corners[0], corners[1], corners[2], corners[3] });
+          rejected = cornerMax < 0.0f;
+          full = full && cornerMin > 0.0f;
+        }
+        if (rejected) {
+          continue;
+        }
+
+        // Buffer jerrquico: el punto ms cercano del tringulo en el bloque ya est tapado
+        const unsigned int block = (blockY / kBlockSize) * m_blocksX + blockX / kBlockSize;
+        const float zOrigin = triangle.zPlane[0] * blockX + triangle.zPlane[1] * blockY + triangle.zPlane[2];
+        const float zBlockMin = zOrigin + (std::min)(0.0f, triangle.zPlane[0] * last) +
+          (std::min)(0.0f, triangle.zPlane[1] * last);
+        if ((std::max)(zBlockMin, triangle.zMin) >= m_hiZ[block]) {
+          ++stats.blocksHiZRejected;
+          continue;
+        }
+
+        full = full && blockX >= clipX0 && blockX + last <= clipX1 &&
+          blockY >= clipY0 && blockY + last <= clipY1;
+        if (full) {
+          ++stats.blocksFull;
+        }
+        else {
+          ++stats.blocksPartial;
+        }
+
+        bool written = false;
+        for (int dy = 0; dy < (int)kBlockSize; ++dy) {
+          const int py = blockY + dy;
+          if (py < clipY0 || py > clipY1) {
+            continue;
+          }
+          float rowEdge[3];
+          for (int edge = 0; edge < 3; ++edge) {
+            rowEdge[edge] = origin[edge] + stepY[edge] * dy;
+          }
+          const float fy = (float)py;
+          const __m128 zRow = _mm_set1_ps(triangle.zPlane[1] * fy + triangle.zPlane[2]);
+          float* depthRow = &m_depth[(size_t)py * m_pitch + blockX];
+          unsigned int* colorRow = &m_color[(size_t)py * m_pitch + blockX];
+
+          for (int half = 0; half < 2; ++half) {
+            const __m128 px = _mm_add_ps(_mm_set1_ps((float)(blockX + half * 4)), laneOffsets[0]);
+            __m128 mask = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            if (!full) {
+              for (int edge = 0; edge < 3; ++edge) {
+                const __m128 e = _mm_add_ps(_mm_set1_ps(rowEdge[edge]), stepXLanes[edge][half]);
+                __m128 inside = _mm_cmpgt_ps(e, zero);
+                if (triangle.edgeTopLeft[edge]) {
+                  inside = _mm_or_ps(inside, _mm_cmpeq_ps(e, zero));
+                }
+                mask = _mm_and_ps(mask, inside);
+              }
+              mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(px, scissorX0), _mm_cmple_ps(px, scissorX1)));
+              if (_mm_movemask_ps(mask) == 0) {
+                continue;
+              }
+            }
+
+            // Prueba de profundidad LESS con escritura
+            const __m128 z = _mm_add_ps(zRow, _mm_mul_ps(zStep, px));
+            const __m128 depth = _mm_loadu_ps(depthRow + half * 4);
+            mask = _mm_and_ps(mask, _mm_cmplt_ps(z, depth));
+            const int bits = _mm_movemask_ps(mask);
+            if (bits == 0) {
+              continue;
+            }
+            _mm_storeu_ps(depthRow + half * 4, _mm_or_ps(_mm_and_ps(mask, z), _mm_andnot_ps(mask, depth)));
+
+            // Atributos con correccin de perspectiva
+            const __m128 invW = _mm_add_ps(_mm_set1_ps(triangle.invWPlane[1] * fy + triangle.invWPlane[2]),
+              _mm_mul_ps(invWStep, px));
+            const __m128 u = _mm_div_ps(_mm_add_ps(_mm_set1_ps(triangle.uPlane[1] * fy + triangle.uPlane[2]),
+              _mm_mul_ps(uStep, px)), invW);
+            const __m128 v = _mm_div_ps(_mm_add_ps(_mm_set1_ps(triangle.vPlane[1] * fy + triangle.vPlane[2]),
+              _mm_mul_ps(vStep, px)), invW);
+
+            // Pixel shader: txDiffuse.Sample(samLinear, Tex) * vMeshColor
+            shadePixels(m_texture, u, v, meshColor, bits, colorRow + half * 4);
+            stats.pixelsWritten += bitCount(bits);
+            written = true;
+          }
+        }
+
+        // Nueva profundidad mxima del bloque
+        if (written) {
+          const float* depthBlock = &m_depth[(size_t)blockY * m_pitch + blockX];
+          __m128 blockMax = _mm_loadu_ps(depthBlock);
+          for (int dy = 0; dy < (int)kBlockSize; ++dy) {
+            blockMax = _mm_max_ps(blockMax, _mm_loadu_ps(depthBlock + (size_t)dy * m_pitch));
+            blockMax = _mm_max_ps(blockMax, _mm_loadu_ps(depthBlock + (size_t)dy * m_pitch + 4));
+          }
+          blockMax = _mm_max_ps(blockMax, _mm_shuffle_ps(blockMax, blockMax, _MM_SHUFFLE(1, 0, 3, 2)));
+          blockMax = _mm_max_ps(blockMax, _mm_shuffle_ps(blockMax, blockMax, _MM_SHUFFLE(2, 3, 0, 1)));
+          m_hiZ[block] = _mm_cvtss_f32(blockMax);
+        }
+      }
+    }
+  }
+}
+
+bool
+SoftwareRasterizer::saveTGA(const std::string& fileName) const {
+  if (m_color.empty()) {
+    ERROR("SoftwareRasterizer", "saveTGA", "Rasterizer is not initialized");
+    return false;
+  }
+  std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    ERROR("SoftwareRasterizer", "saveTGA", L"Cannot open " << fileName.c_str());
+    return false;
+  }
+
+  unsigned char header[18] = {};
+  header[2] = 2;                                   // Truecolor sin compresin
+  header[12] = (unsigned char)(m_width & 0xff);
+  header[13] = (unsigned char)(m_width >> 8);
+  header[14] = (unsigned char)(m_height & 0xff);
+  header[15] = (unsigned char)(m_height >> 8);
+  header[16] = 24;
+  header[17] = 0x20;                               // Origen arriba a la izquierda
+  file.write((const char*)header, sizeof(header));
+
+  std::vector<unsigned char> row(m_width * 3);
+  for (unsigned int y = 0; y < m_height; ++y) {
+    for (unsigned int x = 0; x < m_width; ++x) {
+      const unsigned int color = pixel(x, y);
+      row[x * 3 + 0] = (unsigned char)(color >> 16);
+      row[x * 3 + 1] = (unsigned char)(color >> 8);
+      row[x * 3 + 2] = (unsigned char)color;
+    }
+    file.write((const char*)row.data(), row.size());
+  }
+  return (bool)file;
+}
+
+unsigned long long
+SoftwareRasterizer::checksum() const {
+  unsigned long long hash = 14695981039346656037ull;
+  for (unsigned int y = 0; y < m_height; ++y) {
+    for (unsigned int x = 0; x < m_width; ++x) {
+      // Solo RGB: el alfa no llega a la pantalla
+      const unsigned int color = pixel(x, y);
+      for (int c = 0; c < 3; ++c) {
+        hash = (hash ^ ((color >> (c * 8)) & 0xff)) * 1099511628211ull;
+      }
+    }
+  }
+  return hash;
+}
+
+void
+SoftwareRasterizer::report(const std::string& label) const {
+  std::wostringstream wss;
+  const double draws = (double)(std::max)(1ull, m_stats.draws);
+  wss << label.c_str() << L": " << m_width << L"x" << m_height << L", " << getThreadCount()
+    << L" threads, " << m_stats.draws << L" draws, draw ms avg " << m_stats.drawMs / draws
+    << L", clear ms avg " << m_stats.clearMs / draws;
+  MESSAGE(L"SoftwareRasterizer", L"report", wss.str());
+  wss.str(L"");
+
+  wss << L"  triangles " << m_stats.triangles << L" (culled " << m_stats.trianglesCulled
+    << L", near-clipped " << m_stats.trianglesClipped << L"), bin entries " << m_stats.binEntries;
+  MESSAGE(L"SoftwareRasterizer", L"report", wss.str());
+  wss.str(L"");
+
+  wss << L"  blocks full " << m_stats.blocksFull << L", partial " << m_stats.blocksPartial
+    << L", hi-z rejected " << m_stats.blocksHiZRejected << L", pixels written " << m_stats.pixelsWritten
+    << L", checksum " << std::hex << checksum();
+  MESSAGE(L"SoftwareRasterizer", L"report", wss.str());
+}
@@ -3,12 +3,40 @@
 #include "DeviceContext.h"
 #include "Texture.h"
 #include "Window.h"
+#include "NullBackend.h"
 
 HRESULT
 SwapChain::init(Device& device,
   DeviceContext& deviceContext,
   Texture& backBuffer,
   Window window) {
+  // Headless: no hay ventana ni adaptador; el back buffer es una textura nula
+  if (device.m_nullBackend) {
+    m_nullBackend = device.m_nullBackend;
+    m_driverType = D3D_DRIVER_TYPE_NULL;
+    m_sampleCount = 4;
+    m_qualityLevels = 1;
+
+    D3D11_TEXTURE2D_DESC desc;
+    memset(&desc, 0, sizeof(desc));
+    desc.Width = window.m_width;
+    desc.Height = window.m_height;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.SampleDesc.Count = m_sampleCount;
+    desc.SampleDesc.Quality = m_qualityLevels - 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_RENDER_TARGET;
+
+    HRESULT hr = device.CreateTexture2D(&desc, nullptr, &backBuffer.m_texture);
+    if (FAILED(hr)) {
+      ERROR("SwapChain", "init",
+        ("Failed to create headless back buffer. HRESULT: " + std::to_string(hr)).c_str());
+    }
+    return hr;
+  }
+
   // Check if Window is valid
   if (!window.m_hWnd) {
     ERROR("SwapChain", "init", "Invalid window handle. (m_hWnd is nullptr)");
@@ -63,6 +91,9 @@ SwapChain::init(Device& device,
     return hr;
   }
 
+  // Constant buffers por offset (D3D 11.1), si el runtime los tiene
+  deviceContext.queryFeatures(device);
+
   // Config the MSAA settings
   m_sampleCount = 4;
   hr = device.m_device->CheckMultisampleQualityLevels(DXGI_FORMAT_R8G8B8A8_UNORM,
@@ -148,11 +179,15 @@ SwapChain::destroy() {
   if (m_dxgiFactory) {
     SAFE_RELEASE(m_dxgiFactory);
   }
+  m_nullBackend = nullptr;
 }
 
 void
 SwapChain::present() {
-  if (m_swapChain) {
+  if (m_nullBackend) {
+    m_nullBackend->Present();
+  }
+  else if (m_swapChain) {
     HRESULT hr = m_swapChain->Present(0, 0);
     if (FAILED(hr)) {
       ERROR("SwapChain", "present",
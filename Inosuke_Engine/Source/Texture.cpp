@@ -6,7 +6,7 @@ HRESULT
 Texture::init(Device& device,
   const std::string& textureName,
   ExtensionType extensionType) {
-  if (!device.m_device) {
+  if (!device.isValid()) {
     ERROR("Texture", "init", "Device is null.");
     return E_POINTER;
   }
@@ -22,14 +22,7 @@ Texture::init(Device& device,
     m_textureName = textureName + ".dds";
 
     // Cargar textura DDS
-    hr = D3DX11CreateShaderResourceViewFromFile(
-      device.m_device,
-      m_textureName.c_str(),
-      nullptr,
-      nullptr,
-      &m_textureFromImg,
-      nullptr
-    );
+    hr = device.CreateShaderResourceViewFromFile(m_textureName, &m_textureFromImg);
 
     if (FAILED(hr)) {
       ERROR("Texture", "init",
@@ -63,7 +56,7 @@ Texture::init(Device& device,
   unsigned int BindFlags,
   unsigned int sampleCount,
   unsigned int qualityLevels) {
-  if (!device.m_device) {
+  if (!device.isValid()) {
     ERROR("Texture", "init", "Device is null.");
     return E_POINTER;
   }
@@ -100,7 +93,7 @@ Texture::init(Device& device,
 
 HRESULT
 Texture::init(Device& device, Texture& textureRef, DXGI_FORMAT format) {
-  if (!device.m_device) {
+  if (!device.isValid()) {
     ERROR("Texture", "init", "Device is null.");
     return E_POINTER;
   }
@@ -115,7 +108,7 @@ Texture::init(Device& device, Texture& textureRef, DXGI_FORMAT format) {
   srvDesc.Texture2D.MipLevels = 1;
   srvDesc.Texture2D.MostDetailedMip = 0;
 
-  HRESULT hr = device.m_device->CreateShaderResourceView(textureRef.m_texture,
+  HRESULT hr = device.CreateShaderResourceView(textureRef.m_texture,
     &srvDesc,
     &m_textureFromImg);
 
@@ -137,7 +130,7 @@ void
 Texture::render(DeviceContext& deviceContext,
   unsigned int StartSlot,
   unsigned int NumViews) {
-  if (!deviceContext.m_deviceContext) {
+  if (!deviceContext.isValid()) {
     ERROR("Texture", "render", "Device Context is null.");
     return;
   }
@@ -149,10 +142,7 @@ Texture::render(DeviceContext& deviceContext,
 
 void
 Texture::destroy() {
-  if (m_texture != nullptr) {
-    SAFE_RELEASE(m_texture);
-  }
-  else if (m_textureFromImg != nullptr) {
-    SAFE_RELEASE(m_textureFromImg);
-  }
+  // Un wrapper puede tener el recurso y su vista a la vez (init con textureRef = *this)
+  SAFE_RELEASE(m_texture);
+  SAFE_RELEASE(m_textureFromImg);
 }
\ No newline at end of file
@@ -0,0 +1,31 @@
+#include "VertexDedupTable.h"
+
+void
+VertexDedupTable::reserve(size_t expectedKeys) {
+  size_t capacity = 16;
+  while (capacity * 7 < expectedKeys * 10) capacity *= 2;
+  if (capacity > m_slots.size()) rehash(capacity);
+}
+
+void
+VertexDedupTable::grow() {
+  rehash(m_slots.empty() ? 16 : m_slots.size() * 2);
+}
+
+void
+VertexDedupTable::rehash(size_t capacity) {
+  std::vector<Slot> old;
+  old.swap(m_slots);
+
+  Slot empty{};
+  empty.key.pos = kEmpty;
+  m_slots.assign(capacity, empty);
+
+  const size_t mask = capacity - 1;
+  for (const Slot& slot : old) {
+    if (slot.key.pos == kEmpty) continue;
+    size_t i = hash(slot.key) & mask;
+    while (m_slots[i].key.pos != kEmpty) i = (i + 1) & mask;
+    m_slots[i] = slot;
+  }
+}
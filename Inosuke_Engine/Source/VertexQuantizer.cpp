@@ -0,0 +1,327 @@
+#include "VertexQuantizer.h"
+#include "MeshComponent.h"
+#include "Buffer.h"
+#include "HeadlessDevice.h"
+#include "ModelLoader.h"
+#include <cmath>
+#include <cstring>
+
+namespace {
+  inline unsigned short packUnorm16(float value) {
+    value = (std::min)((std::max)(value, 0.0f), 1.0f);
+    return (unsigned short)(value * 65535.0f + 0.5f);
+  }
+
+  inline float unpackUnorm16(unsigned short value) {
+    return float(value) / 65535.0f;
+  }
+
+  inline short packSnorm16(float value) {
+    value = (std::min)((std::max)(value, -1.0f), 1.0f);
+    return (short)(value >= 0.0f ? value * 32767.0f + 0.5f : value * 32767.0f - 0.5f);
+  }
+
+  inline float unpackSnorm16(short value) {
+    // -32768 y -32767 representan -1.0 (regla de D3D para SNORM).
+    return (std::max)(float(value) / 32767.0f, -1.0f);
+  }
+
+  inline float signNotZero(float value) {
+    return value >= 0.0f ? 1.0f : -1.0f;
+  }
+
+  inline void normalize(XMFLOAT3& v) {
+    const float length = sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+    if (length > 0.0f) {
+      v.x /= length;
+      v.y /= length;
+      v.z /= length;
+    }
+    else {
+      v = XMFLOAT3(0.0f, 0.0f, 1.0f);
+    }
+  }
+
+  D3D11_INPUT_ELEMENT_DESC makeElement(LPCSTR semantic, DXGI_FORMAT format, unsigned int offset) {
+    D3D11_INPUT_ELEMENT_DESC element;
+    element.SemanticName = semantic;
+    element.SemanticIndex = 0;
+    element.Format = format;
+    element.InputSlot = 0;
+    element.AlignedByteOffset = offset;
+    element.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+    element.InstanceDataStepRate = 0;
+    return element;
+  }
+
+  const wchar_t* const kFormatNames[VertexQuantizer::FORMAT_COUNT] = {
+    L"FLOAT", L"COMPACT", L"COMPACT_NORMAL"
+  };
+}
+
+unsigned int
+VertexQuantizer::strideOf(Format format) {
+  switch (format) {
+  case FORMAT_FLOAT:          return sizeof(SimpleVertex);
+  case FORMAT_COMPACT:        return 12;
+  case FORMAT_COMPACT_NORMAL: return 16;
+  default:                    return 0;
+  }
+}
+
+std::vector<D3D11_INPUT_ELEMENT_DESC>
+VertexQuantizer::inputLayout(Format format) {
+  std::vector<D3D11_INPUT_ELEMENT_DESC> layout;
+  switch (format) {
+  case FORMAT_FLOAT:
+    layout.push_back(makeElement("POSITION", DXGI_FORMAT_R32G32B32_FLOAT, 0));
+    layout.push_back(makeElement("TEXCOORD", DXGI_FORMAT_R32G32_FLOAT, 12));
+    break;
+  case FORMAT_COMPACT:
+  case FORMAT_COMPACT_NORMAL:
+    layout.push_back(makeElement("POSITION", DXGI_FORMAT_R16G16B16A16_UNORM, 0));
+    layout.push_back(makeElement("TEXCOORD", DXGI_FORMAT_R16G16_FLOAT, 8));
+    if (format == FORMAT_COMPACT_NORMAL) {
+      layout.push_back(makeElement("NORMAL", DXGI_FORMAT_R16G16_SNORM, 12));
+    }
+    break;
+  default:
+    ERROR("VertexQuantizer", "inputLayout", "Unknown format");
+    break;
+  }
+  return layout;
+}
+
+XMFLOAT2
+VertexQuantizer::encodeOctahedral(const XMFLOAT3& normal) {
+  // Proyecta sobre el octaedro |x| + |y| + |z| = 1 y pliega la mitad inferior.
+  const float l1 = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+  if (l1 <= 0.0f) return XMFLOAT2(0.0f, 0.0f);
+  float x = normal.x / l1;
+  float y = normal.y / l1;
+  if (normal.z < 0.0f) {
+    const float foldedX = (1.0f - fabsf(y)) * signNotZero(x);
+    const float foldedY = (1.0f - fabsf(x)) * signNotZero(y);
+    x = foldedX;
+    y = foldedY;
+  }
+  return XMFLOAT2(x, y);
+}
+
+XMFLOAT3
+VertexQuantizer::decodeOctahedral(const XMFLOAT2& encoded) {
+  XMFLOAT3 n(encoded.x, encoded.y, 1.0f - fabsf(encoded.x) - fabsf(encoded.y));
+  if (n.z < 0.0f) {
+    const float x = (1.0f - fabsf(n.y)) * signNotZero(n.x);
+    const float y = (1.0f - fabsf(n.x)) * signNotZero(n.y);
+    n.x = x;
+    n.y = y;
+  }
+  normalize(n);
+  return n;
+}
+
+void
+VertexQuantizer::computeNormals(const MeshComponent& mesh, std::vector<XMFLOAT3>& outNormals) {
+  outNormals.assign(mesh.m_vertex.size(), XMFLOAT3(0.0f, 0.0f, 0.0f));
+  for (size_t i = 0; i + 2 < mesh.m_index.size(); i += 3) {
+    const unsigned int ia = mesh.m_index[i + 0];
+    const unsigned int ib = mesh.m_index[i + 1];
+    const unsigned int ic = mesh.m_index[i + 2];
+    if (ia >= mesh.m_vertex.size() || ib >= mesh.m_vertex.size() || ic >= mesh.m_vertex.size()) continue;
+
+    const XMFLOAT3& a = mesh.m_vertex[ia].Pos;
+    const XMFLOAT3& b = mesh.m_vertex[ib].Pos;
+    const XMFLOAT3& c = mesh.m_vertex[ic].Pos;
+    const float e1[3] = { b.x - a.x, b.y - a.y, b.z - a.z };
+    const float e2[3] = { c.x - a.x, c.y - a.y, c.z - a.z };
+    // Producto cruz sin normalizar: su largo es el doble del rea (ponderacin por rea).
+    const XMFLOAT3 n(e1[1] * e2[2] - e1[2] * e2[1],
+                     e1[2] * e2[0] - e1[0] * e2[2],
+                     e1[0] * e2[1] - e1[1] * e2[0]);
+    for (unsigned int v : { ia, ib, ic }) {
+      outNormals[v].x += n.x;
+      outNormals[v].y += n.y;
+      outNormals[v].z += n.z;
+    }
+  }
+  for (XMFLOAT3& n : outNormals) normalize(n);
+}
+
+bool
+VertexQuantizer::quantize(const MeshComponent& mesh, Format format, QuantizedMesh& out) {
+  if (mesh.m_vertex.empty()) {
+    ERROR("VertexQuantizer", "quantize", "Mesh has no vertices");
+    return false;
+  }
+  if (format < FORMAT_FLOAT || format >= FORMAT_COUNT) {
+    ERROR("VertexQuantizer", "quantize", "Unknown format");
+    return false;
+  }
+
+  XMFLOAT3 minBound = mesh.m_vertex[0].Pos;
+  XMFLOAT3 maxBound = mesh.m_vertex[0].Pos;
+  for (const SimpleVertex& v : mesh.m_vertex) {
+    minBound.x = (std::min)(minBound.x, v.Pos.x);
+    minBound.y = (std::min)(minBound.y, v.Pos.y);
+    minBound.z = (std::min)(minBound.z, v.Pos.z);
+    maxBound.x = (std::max)(maxBound.x, v.Pos.x);
+    maxBound.y = (std::max)(maxBound.y, v.Pos.y);
+    maxBound.z = (std::max)(maxBound.z, v.Pos.z);
+  }
+
+  out.format = format;
+  out.stride = strideOf(format);
+  out.vertexCount = (unsigned int)mesh.m_vertex.size();
+  out.data.assign((size_t)out.stride * out.vertexCount, 0);
+  out.constants.PosScale = XMFLOAT4(maxBound.x - minBound.x, maxBound.y - minBound.y, maxBound.z - minBound.z, 0.0f);
+  out.constants.PosOffset = XMFLOAT4(minBound.x, minBound.y, minBound.z, 0.0f);
+
+  if (format == FORMAT_FLOAT) {
+    // Sin cuantizar: escala 1 y offset 0 para que el shader pueda usar las mismas constantes.
+    out.constants.PosScale = XMFLOAT4(1.0f, 1.0f, 1.0f, 0.0f);
+    out.constants.PosOffset = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+    memcpy(out.data.data(), mesh.m_vertex.data(), out.data.size());
+    return true;
+  }
+
+  // Ejes planos (escala 0) se guardan como 0 y se reconstruyen con el offset.
+  const float invScale[3] = {
+    out.constants.PosScale.x > 0.0f ? 1.0f / out.constants.PosScale.x : 0.0f,
+    out.constants.PosScale.y > 0.0f ? 1.0f / out.constants.PosScale.y : 0.0f,
+    out.constants.PosScale.z > 0.0f ? 1.0f / out.constants.PosScale.z : 0.0f
+  };
+
+  std::vector<XMFLOAT3> normals;
+  if (format == FORMAT_COMPACT_NORMAL) computeNormals(mesh, normals);
+
+  for (size_t i = 0; i < mesh.m_vertex.size(); ++i) {
+    const SimpleVertex& v = mesh.m_vertex[i];
+    unsigned char* dst = out.data.data() + i * out.stride;
+
+    const unsigned short position[4] = {
+      packUnorm16((v.Pos.x - minBound.x) * invScale[0]),
+      packUnorm16((v.Pos.y - minBound.y) * invScale[1]),
+      packUnorm16((v.Pos.z - minBound.z) * invScale[2]),
+      0
+    };
+    memcpy(dst, position, sizeof(position));
+
+    const HALF uv[2] = { XMConvertFloatToHalf(v.Tex.x), XMConvertFloatToHalf(v.Tex.y) };
+    memcpy(dst + 8, uv, sizeof(uv));
+
+    if (format == FORMAT_COMPACT_NORMAL) {
+      const XMFLOAT2 oct = encodeOctahedral(normals[i]);
+      const short normal[2] = { packSnorm16(oct.x), packSnorm16(oct.y) };
+      memcpy(dst + 12, normal, sizeof(normal));
+    }
+  }
+  return true;
+}
+
+VertexQuantizer::ErrorStats
+VertexQuantizer::measure(const MeshComponent& mesh, const QuantizedMesh& quantized) {
+  ErrorStats stats;
+  if (quantized.vertexCount != mesh.m_vertex.size() || quantized.stride == 0) return stats;
+
+  std::vector<XMFLOAT3> normals;
+  if (quantized.format == FORMAT_COMPACT_NORMAL) computeNormals(mesh, normals);
+
+  for (size_t i = 0; i < mesh.m_vertex.size(); ++i) {
+    const SimpleVertex& v = mesh.m_vertex[i];
+    const unsigned char* src = quantized.data.data() + i * quantized.stride;
+
+    XMFLOAT3 pos;
+    XMFLOAT2 uv;
+    if (quantized.format == FORMAT_FLOAT) {
+      SimpleVertex stored;
+      memcpy(&stored, src, sizeof(stored));
+      pos = stored.Pos;
+      uv = stored.Tex;
+    }
+    else {
+      unsigned short position[4];
+      HALF half[2];
+      memcpy(position, src, sizeof(position));
+      memcpy(half, src + 8, sizeof(half));
+      const DequantConstants& c = quantized.constants;
+      pos = XMFLOAT3(unpackUnorm16(position[0]) * c.PosScale.x + c.PosOffset.x,
+                     unpackUnorm16(position[1]) * c.PosScale.y + c.PosOffset.y,
+                     unpackUnorm16(position[2]) * c.PosScale.z + c.PosOffset.z);
+      uv = XMFLOAT2(XMConvertHalfToFloat(half[0]), XMConvertHalfToFloat(half[1]));
+    }
+
+    const float dx = pos.x - v.Pos.x, dy = pos.y - v.Pos.y, dz = pos.z - v.Pos.z;
+    stats.maxPositionError = (std::max)(stats.maxPositionError, sqrtf(dx * dx + dy * dy + dz * dz));
+    stats.maxUvError = (std::max)(stats.maxUvError,
+      (std::max)(fabsf(uv.x - v.Tex.x), fabsf(uv.y - v.Tex.y)));
+
+    if (quantized.format == FORMAT_COMPACT_NORMAL) {
+      short packed[2];
+      memcpy(packed, src + 12, sizeof(packed));
+      const XMFLOAT3 n = decodeOctahedral(XMFLOAT2(unpackSnorm16(packed[0]), unpackSnorm16(packed[1])));
+      const XMFLOAT3& reference = normals[i];
+      const float cosine = (std::min)(1.0f, (std::max)(-1.0f,
+        n.x * reference.x + n.y * reference.y + n.z * reference.z));
+      stats.maxNormalErrorDeg = (std::max)(stats.maxNormalErrorDeg, acosf(cosine) * (180.0f / XM_PI));
+    }
+  }
+  return stats;
+}
+
+bool
+VertexQuantizer::report(const MeshComponent& mesh) {
+  if (mesh.m_vertex.empty()) {
+    ERROR("VertexQuantizer", "report", "Mesh has no vertices");
+    return false;
+  }
+
+  std::wstring wname(mesh.m_name.begin(), mesh.m_name.end());
+  for (int f = FORMAT_FLOAT; f < FORMAT_COUNT; ++f) {
+    QuantizedMesh quantized;
+    if (!quantize(mesh, (Format)f, quantized)) return false;
+    const ErrorStats error = measure(mesh, quantized);
+
+    std::wostringstream wss;
+    wss << wname << L" " << kFormatNames[f] << L": " << quantized.stride << L" B/vertex, "
+        << (quantized.data.size() / 1024.0) << L" KB"
+        << L" (" << (100.0 * quantized.stride / sizeof(SimpleVertex)) << L"%)"
+        << L", max error pos " << error.maxPositionError
+        << L" uv " << error.maxUvError;
+    if (f == FORMAT_COMPACT_NORMAL) wss << L" normal " << error.maxNormalErrorDeg << L" deg";
+    MESSAGE(L"VertexQuantizer", L"report", wss.str().c_str());
+  }
+  return true;
+}
+
+bool
+VertexQuantizer::benchmark(const std::string& filename) {
+  MeshComponent mesh;
+  ModelLoader::Options opts;
+  if (!ModelLoader::loadFromFile(filename, mesh, opts)) return false;
+  if (!report(mesh)) return false;
+
+  // Cada formato pasa por el mismo camino que usara el render: Buffer::init + IASetVertexBuffers
+  HeadlessDevice headless;
+  bool ok = true;
+  std::wostringstream wss;
+  wss << L"uploaded";
+  for (int f = FORMAT_FLOAT; f < FORMAT_COUNT && ok; ++f) {
+    QuantizedMesh quantized;
+    Buffer vertexBuffer;
+    ok = quantize(mesh, (Format)f, quantized) &&
+         SUCCEEDED(vertexBuffer.init(headless.m_device, quantized)) &&
+         vertexBuffer.getByteWidth() == quantized.data.size();
+    if (ok) {
+      vertexBuffer.render(headless.m_deviceContext, 0, 1);
+      wss << L" " << kFormatNames[f] << L" " << vertexBuffer.getByteWidth() << L" bytes";
+    }
+    vertexBuffer.destroy();
+  }
+  if (!ok) {
+    ERROR(L"VertexQuantizer", L"benchmark", L"Failed to upload a quantized vertex buffer");
+    return false;
+  }
+  MESSAGE(L"VertexQuantizer", L"benchmark", wss.str().c_str());
+  return true;
+}
@@ -41,7 +41,7 @@ Viewport::init(unsigned int width, unsigned int height) {
 }
 
 void Viewport::render(DeviceContext& deviceContext) {
-	if (!deviceContext.m_deviceContext) {
+	if (!deviceContext.isValid()) {
 		ERROR("Viewport", "render", "Device context is not set.");
 		return;
 	}